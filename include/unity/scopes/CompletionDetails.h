@@ -19,6 +19,7 @@
 #pragma once
 
 #include <unity/scopes/OperationInfo.h>
+#include <unity/scopes/Variant.h>
 
 #include <memory>
 #include <string>
@@ -106,8 +107,43 @@ public:
     */
     std::vector<OperationInfo> info_list() const;
 
+    /**
+    \brief Get the measurements the run time took for the query.
+
+    The map contains the following entries, each of which is present only if the measurement is available.
+    Times are in milliseconds (`double`), counts in `int64_t`.
+
+    Measured by the client:
+     - `first_push_ms`: time from sending the query until the first reply (such as a category, result,
+       or preview widget) was received
+     - `finished_ms`: time from sending the query until the query completed
+     - `push_count`: number of replies received
+
+    Measured by the scope:
+     - `scope_queue_ms`: time the query waited in the scope's query adapter before the scope's `run()` was called
+     - `scope_run_ms`: time spent in the scope's `run()` (up to the point at which the query completed,
+       if the scope completed it from within `run()`)
+     - `scope_push_count`: number of replies pushed by the scope
+     - `scope_bytes_pushed`: size of the replies after marshaling (not present if the replies were delivered
+       within the same process)
+
+    Measured by the scope only if profiling is enabled in the scope's run time configuration
+    (see `Profiling` in CONFIGFILES), once the scope's `run()` has returned:
+     - `scope_lock_waits`: number of times `run()` had to wait for a lock of the run time
+       (present only if the run time was built with lock profiling)
+     - `scope_lock_wait_ms`: total time `run()` spent waiting for locks of the run time
+     - `scope_allocations`: number of allocations made by `run()` with `operator new`
+       (present only if the scope's process preloads the allocation counting library)
+     - `scope_allocated_bytes`: total size of those allocations
+
+    \return The measurements, keyed by name.
+    */
+    VariantMap metrics() const;
+
 private:
     std::unique_ptr<internal::CompletionDetailsImpl> p;
+
+    friend class internal::CompletionDetailsImpl;
 };
 
 /**
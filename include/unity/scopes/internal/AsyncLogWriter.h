@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#pragma once
+
+#include <unity/util/DefinesPtrs.h>
+#include <unity/util/NonCopyable.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+// Writes log messages to a stream on a background thread.
+//
+// Each thread that calls write() gets its own single-producer/single-consumer ring of
+// queue_size messages, so write() does not lock, except for the first message written by a thread.
+// A flusher thread drains the rings at regular intervals (or once a ring is half full) and
+// writes what it finds with a single insertion into the stream. Messages are never split
+// or interleaved, and messages from the same thread appear in the order they were written.
+//
+// If a ring is full, write() discards the message instead of blocking. The flusher
+// reports the number of discarded messages as a warning.
+
+class AsyncLogWriter final
+{
+public:
+    NONCOPYABLE(AsyncLogWriter);
+    UNITY_DEFINES_PTRS(AsyncLogWriter);
+
+    AsyncLogWriter(std::ostream& outstream, std::string const& id, int queue_size);
+    ~AsyncLogWriter();                     // Writes all outstanding messages before returning.
+
+    void write(std::string&& msg) noexcept;  // msg must be a complete message, including the trailing newline.
+    void flush() noexcept;                   // Returns once all previously written messages are in the stream.
+    int64_t dropped() const noexcept;        // Number of messages discarded so far.
+
+private:
+    class Ring;
+
+    Ring* ring_for_this_thread() noexcept;
+    void flusher_thread() noexcept;
+    bool drain(std::string& batch);
+
+    std::ostream& outstream_;
+    std::string const id_;
+    int const queue_size_;
+    uint64_t const instance_id_;          // Identifies this writer in the thread-local ring maps.
+
+    std::vector<std::shared_ptr<Ring>> rings_;
+    std::mutex rings_mutex_;              // Protects rings_
+
+    std::atomic<int64_t> dropped_;
+    int64_t reported_dropped_;            // Only used by the flusher thread
+    std::atomic_bool wake_;               // Set by write() if a ring is half full
+
+    std::mutex mutex_;                    // Protects the remaining members
+    std::condition_variable cond_;
+    uint64_t flush_requests_;
+    uint64_t flushes_done_;
+    bool done_;
+    std::thread flusher_;
+};
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
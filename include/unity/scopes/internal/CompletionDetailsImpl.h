@@ -45,11 +45,16 @@ public:
     std::string message() const;
     void add_info(OperationInfo const& info);
     std::vector<OperationInfo> info_list() const;
+    VariantMap metrics() const;
+
+    // Adds the given metrics to those of details, replacing existing entries with the same name.
+    static void add_metrics(CompletionDetails& details, VariantMap const& metrics);
 
 private:
     CompletionDetails::CompletionStatus status_;
     std::string message_;
     std::vector<OperationInfo> info_list_;
+    VariantMap metrics_;
 };
 
 } // namespace internal
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <unity/scopes/internal/AsyncLogWriter.h>
 #include <unity/util/DefinesPtrs.h>
 #include <unity/util/NonCopyable.h>
 
@@ -37,7 +38,7 @@ namespace internal
 
 enum class LoggerSeverity { Info, Warning, Error, Fatal, Trace };
 
-enum class LoggerChannel { DefaultChannel, IPC, LastChannelEnum_ };
+enum class LoggerChannel { DefaultChannel, IPC, Profile, LastChannelEnum_ };
 
 class Logger;
 
@@ -54,6 +55,7 @@ public:
     LogStream(LogStream&& other)
         : id_(std::move(other.id_))
         , outstream_(other.outstream_)
+        , writer_(other.writer_)
         , severity_(other.severity_)
         , channel_(other.channel_)
     {
@@ -69,6 +71,7 @@ public:
         : std::ostringstream(std::move(other))
         , id_(std::move(other.id_))
         , outstream_(other.outstream_)
+        , writer_(other.writer_)
         , severity_(other.severity_)
         , channel_(other.channel_)
     {
@@ -78,12 +81,14 @@ public:
     LogStream& operator=(LogStream&&) = delete;  // Move assignment is impossible due to reference member.
 
     LogStream();
-    LogStream(std::ostream& outstream, std::string const& id, LoggerSeverity s, LoggerChannel c);
+    LogStream(std::ostream& outstream, std::string const& id, LoggerSeverity s, LoggerChannel c,
+              AsyncLogWriter* writer = nullptr);
     ~LogStream();
 
 private:
     std::string const id_;
     std::ostream& outstream_;
+    AsyncLogWriter* writer_;    // Writes to outstream_ synchronously if null
     LoggerSeverity severity_;
     LoggerChannel channel_;
 };
@@ -98,6 +103,7 @@ public:
     Logger(Logger&& other)
         : id_(move(other.id_))
         , outstream_(other.outstream_)
+        , async_writer_(std::move(other.async_writer_))
     {
         severity_threshold_.exchange(other.severity_threshold_);
         for (unsigned i = 0; i < other.enabled_.size(); ++i)
@@ -120,18 +126,55 @@ public:
     // Returns writer for specified channel.
     LogStream operator()(LoggerChannel c);
 
+    // Return true if a message with the given severity or for the given channel would be logged.
+    // These are cheap (a single atomic load); use them, or UNITY_SCOPES_LOG(), to avoid formatting
+    // a message that would be discarded.
+    bool enabled(LoggerSeverity s) const noexcept
+    {
+        return s >= severity_threshold_.load(std::memory_order_relaxed);
+    }
+
+    bool enabled(LoggerChannel c) const noexcept
+    {
+        return enabled_[int(c)].load(std::memory_order_relaxed);
+    }
+
     LoggerSeverity set_severity_threshold(LoggerSeverity s);
 
     bool set_channel(LoggerChannel c, bool enable);
     bool set_channel(std::string channel_name, bool enable);
 
+    // Hands messages to a background thread for writing, instead of writing them
+    // on the calling thread. Each thread can have up to queue_size messages outstanding;
+    // further messages are dropped until the background thread catches up.
+    // Must be called before the logger is used by more than one thread.
+    void enable_async(int queue_size);
+    void flush();                       // Waits until all messages are written (no-op if not async).
+
+    // Returns the current time as "yyyy-mm-dd hh:mm:ss.mmm".
+    static std::string timestamp();
+
 private:
     std::string const id_;
     std::ostream& outstream_;
+    AsyncLogWriter::UPtr async_writer_;
     std::atomic<LoggerSeverity> severity_threshold_;
     std::array<std::atomic_bool, int(LoggerChannel::LastChannelEnum_)> enabled_;
 };
 
+// Writes to logger(s_or_c), but evaluates the operands of << only if the severity or channel
+// is enabled. The logger expression is evaluated once. For example:
+//
+//     UNITY_SCOPES_LOG(logger(), LoggerChannel::IPC) << "sending request: " << decode_request(r);
+//
+// If IPC tracing is disabled, decode_request() is never called.
+
+#define UNITY_SCOPES_LOG(logger, s_or_c) \
+    for (auto* unity_scopes_log_ = &(logger); \
+         unity_scopes_log_ && unity_scopes_log_->enabled(s_or_c); \
+         unity_scopes_log_ = nullptr) \
+        (*unity_scopes_log_)(s_or_c)
+
 } // namespace internal
 
 } // namespace scopes
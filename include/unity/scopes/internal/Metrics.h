@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#pragma once
+
+#include <unity/util/DefinesPtrs.h>
+#include <unity/util/NonCopyable.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+// Named counters, gauges, and histograms for the run time.
+//
+// Looking up a metric by name locks the registry, so callers on a hot path look up
+// the metric once and keep the reference. Metrics are never removed, so references
+// remain valid for the life time of the registry. Updating a metric is lock-free.
+//
+// to_string() renders all metrics as text, one per line, sorted by name:
+//
+//   counter <name> <value>
+//   gauge <name> <value>
+//   histogram <name> count=<n> mean=<m> p50=<v> p90=<v> p99=<v> max=<v>
+
+class MetricsRegistry final
+{
+public:
+    NONCOPYABLE(MetricsRegistry);
+    UNITY_DEFINES_PTRS(MetricsRegistry);
+
+    // Monotonically increasing count.
+    class Counter final
+    {
+    public:
+        NONCOPYABLE(Counter);
+        Counter();
+
+        void inc(int64_t n = 1) noexcept;
+        int64_t value() const noexcept;
+
+    private:
+        std::atomic<int64_t> value_;
+    };
+
+    // Value that goes up and down.
+    class Gauge final
+    {
+    public:
+        NONCOPYABLE(Gauge);
+        Gauge();
+
+        void set(int64_t v) noexcept;
+        void add(int64_t n) noexcept;
+        int64_t value() const noexcept;
+
+    private:
+        std::atomic<int64_t> value_;
+    };
+
+    // Distribution of non-negative values, such as latencies in microseconds.
+    // Values are counted in log-linear buckets (eight per power of two), so percentiles
+    // are accurate to within 12.5%, whatever the range of the values.
+    class Histogram final
+    {
+    public:
+        NONCOPYABLE(Histogram);
+        Histogram();
+
+        void record(int64_t v) noexcept;                            // Negative values count as 0
+        void record(std::chrono::steady_clock::duration d) noexcept;   // Records microseconds
+
+        int64_t count() const noexcept;
+        int64_t sum() const noexcept;
+        int64_t max() const noexcept;
+        int64_t percentile(double p) const noexcept;                // p in [0, 100]
+
+        static int bucket_index(int64_t v) noexcept;
+        static int64_t bucket_upper_bound(int index) noexcept;
+
+        static constexpr int sub_bucket_bits = 3;
+        static constexpr int num_buckets = (64 - sub_bucket_bits) << sub_bucket_bits;
+
+    private:
+        std::atomic<int64_t> buckets_[num_buckets];
+        std::atomic<int64_t> count_;
+        std::atomic<int64_t> sum_;
+        std::atomic<int64_t> max_;
+    };
+
+    // Measures the time from construction to destruction and records it in a histogram.
+    class Timer final
+    {
+    public:
+        NONCOPYABLE(Timer);
+        explicit Timer(Histogram& h);
+        ~Timer();
+
+    private:
+        Histogram& h_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    MetricsRegistry();
+    ~MetricsRegistry();
+
+    // Return the metric with the given name, creating it if it doesn't exist yet.
+    // A name can be used for only one kind of metric; using it for another kind
+    // throws unity::LogicException.
+    Counter& counter(std::string const& name);
+    Gauge& gauge(std::string const& name);
+    Histogram& histogram(std::string const& name);
+
+    // Adds a gauge whose value is computed by calling f when the metrics are rendered.
+    // f is called without holding any locks of the registry, and must not throw.
+    // Adding a function gauge with the same name again replaces the previous function.
+    void gauge_fn(std::string const& name, std::function<int64_t()> const& f);
+
+    std::string to_string() const;
+
+private:
+    void check_unique(std::string const& name, char const* kind) const;
+
+    std::map<std::string, std::unique_ptr<Counter>> counters_;
+    std::map<std::string, std::unique_ptr<Gauge>> gauges_;
+    std::map<std::string, std::unique_ptr<Histogram>> histograms_;
+    std::map<std::string, std::function<int64_t()>> gauge_fns_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
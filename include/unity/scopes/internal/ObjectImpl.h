@@ -19,6 +19,7 @@
 #pragma once
 
 #include<unity/scopes/internal/MWObjectProxyFwd.h>
+#include<unity/scopes/internal/Profiling.h>
 #include<unity/scopes/Object.h>
 
 #include <mutex>
@@ -56,7 +57,7 @@ protected:
     void set_proxy(MWProxy const& p);  // Allows a derived proxy to replace mw_proxy_ for asynchronous twoway calls.
 
     MWProxy mw_proxy_;
-    std::mutex proxy_mutex_;           // Protects mw_proxy_
+    ProfiledMutex proxy_mutex_;        // Protects mw_proxy_
 
 private:
     void check_proxy();                // Throws from operations if mw_proxy_ is null
@@ -40,6 +40,7 @@ public:
 
     static PreviewWidgetImpl from_json(std::string const& json_text);
     static PreviewWidgetImpl from_json_node(VariantMap const& node);
+    static PreviewWidget create_from_variant_map(VariantMap const& node);
 
     void set_id(std::string const& id);
     void set_widget_type(std::string const &widget_type);
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#pragma once
+
+#include <unity/util/NonCopyable.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+// Opt-in instrumentation of lock contention and memory allocation (see Profiling in CONFIGFILES).
+// Profiling is process-wide.
+//
+// Lock contention is measured only if the library is built with -Dprofiling=ON (which defines
+// UNITY_SCOPES_PROFILING). Otherwise, ProfiledMutex is a std::mutex, so the run time locks
+// cost nothing extra. Allocations are counted only if the process preloads the
+// libunity-scopes-counting-new.so shim (see CountingNew.cpp).
+
+// Replacement for std::mutex for the run time locks that a scope's run() may contend for.
+// Use ProfiledLock and ProfiledCondition to wait on it. While profiling is compiled in and
+// enabled, each lock() that has to wait records the time it waited, both per lock kind and
+// in the QueryProfile of the calling thread, if any.
+
+class ProfiledMutex final
+#ifndef UNITY_SCOPES_PROFILING
+    : public std::mutex
+#endif
+{
+public:
+    NONCOPYABLE(ProfiledMutex);
+
+    enum Kind { Reply, Reaper, Proxy, Adapter, NumKinds };
+
+    explicit ProfiledMutex(Kind kind) noexcept;
+
+#ifdef UNITY_SCOPES_PROFILING
+    void lock();
+    bool try_lock() noexcept;
+    void unlock() noexcept;
+#endif
+
+    // Contention for all locks of a kind while profiling was enabled. (Always zero
+    // unless profiling is compiled in.)
+    static char const* name(Kind kind) noexcept;
+    static int64_t waits(Kind kind) noexcept;          // Number of lock() calls that had to wait
+    static int64_t wait_us(Kind kind) noexcept;        // Total time spent waiting
+
+    static bool compiled_in() noexcept;
+
+private:
+#ifdef UNITY_SCOPES_PROFILING
+    std::mutex m_;
+    Kind const kind_;
+#endif
+};
+
+#ifdef UNITY_SCOPES_PROFILING
+typedef std::unique_lock<ProfiledMutex> ProfiledLock;
+typedef std::condition_variable_any ProfiledCondition;
+#else
+typedef std::unique_lock<std::mutex> ProfiledLock;
+typedef std::condition_variable ProfiledCondition;
+#endif
+
+// Counts the lock waits and allocations made by a thread. A Recorder makes the profile the
+// current profile of the calling thread for the Recorder's lifetime. (If profiling is disabled,
+// a Recorder does nothing.) Recorders nest; the costs are counted only in the innermost profile.
+//
+// A profile must be read only once its Recorder has been destroyed.
+
+class QueryProfile final
+{
+public:
+    NONCOPYABLE(QueryProfile);
+
+    QueryProfile() noexcept;
+
+    class Recorder final
+    {
+    public:
+        NONCOPYABLE(Recorder);
+        explicit Recorder(QueryProfile& profile) noexcept;
+        ~Recorder();
+
+    private:
+        QueryProfile* previous_;
+        bool active_;
+    };
+
+    bool recorded() const noexcept;                    // True if a Recorder was active for this profile
+    int64_t lock_waits() const noexcept;
+    std::chrono::steady_clock::duration lock_wait_time() const noexcept;
+    int64_t allocations() const noexcept;              // Only counted if allocation_counting() is true
+    int64_t allocated_bytes() const noexcept;
+
+    static void enable(bool enabled) noexcept;
+    static bool enabled() noexcept;
+
+    // Allocations are counted only if the program replaces operator new with a version that
+    // calls count_allocation() and calls enable_allocation_counting() at start-up (as the
+    // libunity-scopes-counting-new.so shim does).
+    static void enable_allocation_counting() noexcept;
+    static bool allocation_counting() noexcept;
+    static void count_allocation(std::size_t size) noexcept;
+
+private:
+    bool recorded_;
+    int64_t lock_waits_;
+    std::chrono::steady_clock::duration lock_wait_time_;
+    int64_t allocations_;
+    int64_t allocated_bytes_;
+
+    friend class ProfiledMutex;
+};
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
@@ -20,9 +20,13 @@
 
 #include <unity/scopes/internal/MWReplyProxyFwd.h>
 #include <unity/scopes/internal/MWQueryCtrlProxyFwd.h>
+#include <unity/scopes/internal/Profiling.h>
 #include <unity/scopes/internal/QueryObjectBase.h>
 #include <unity/scopes/ReplyProxyFwd.h>
 
+#include <chrono>
+#include <mutex>
+
 namespace unity
 {
 
@@ -65,7 +69,11 @@ public:
     // and we can pass the shared_ptr to the ReplyImpl.
     void set_self(QueryObjectBase::SPtr const& self) noexcept override;
 
+    virtual VariantMap metrics() const override;                               // Called locally, by ReplyImpl
+
 protected:
+    void run_ended(InvokeInfo const& info) noexcept;  // Called by run() once the scope's run() has returned.
+
     std::shared_ptr<QueryBase> query_base_;
     MWReplyProxy const reply_;
     std::weak_ptr<unity::scopes::Reply> reply_proxy_;
@@ -73,6 +81,10 @@ protected:
     bool pushable_;
     QueryObjectBase::SPtr self_;
     int cardinality_;
+    std::chrono::steady_clock::time_point const created_;   // For the time spent waiting for run()
+    std::chrono::steady_clock::time_point run_begin_;       // Default-constructed until run() is called
+    std::chrono::steady_clock::time_point run_end_;         // Default-constructed until run() returns
+    QueryProfile profile_;                                  // Lock waits and allocations of the scope's run()
     mutable std::mutex mutex_;
 };
 
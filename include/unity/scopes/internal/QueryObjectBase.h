@@ -20,6 +20,7 @@
 
 #include <unity/scopes/internal/AbstractObject.h>
 #include <unity/scopes/internal/MWReplyProxyFwd.h>
+#include <unity/scopes/Variant.h>
 #include <unity/util/DefinesPtrs.h>
 
 namespace unity
@@ -47,6 +48,12 @@ public:
     // Used to hold the reference count high until the run call arrives via the middleware,
     // and we can pass the shared_ptr to the ReplyImpl.
     virtual void set_self(SPtr const& self) noexcept = 0;
+
+    // Measurements for CompletionDetails::metrics(), called locally, by ReplyImpl.
+    virtual VariantMap metrics() const
+    {
+        return VariantMap();
+    }
 };
 
 } // namespace internal
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <unity/scopes/internal/Profiling.h>
 #include <unity/util/DefinesPtrs.h>
 #include <unity/util/NonCopyable.h>
 
@@ -192,11 +193,11 @@ private:
     DestroyPolicy policy_;                  // Whether to invoke cb on entries still present when reaper is destroyed
     reaper_private::Reaplist list_;         // Items in LRU order, most recently refreshed one at the front.
 
-    mutable std::mutex mutex_;              // Protects list_. Also used by ReapItem to serialize updates to list_.
+    mutable ProfiledMutex mutex_;           // Protects list_. Also used by ReapItem to serialize updates to list_.
 
     std::thread reap_thread_;               // Reaper thread scans list_ and issues callbacks for timed-out entries
     std::thread::id reap_thread_id_;        // ID of reaper thread (used to prevent deadlock in callbacks)
-    std::condition_variable do_work_;       // Reaper thread waits on this
+    ProfiledCondition do_work_;             // Reaper thread waits on this
     bool finish_;                           // Set when reaper thread needs to terminate
 
     bool reap_in_progress_;                      // True while a reaping pass is happening
@@ -76,6 +76,13 @@ public:
     bool remove_local_scope(std::string const& scope_id);
     void set_remote_registry(MWRegistryProxy const& remote_registry);
 
+    // While an update batch is open, the registry-update notification that
+    // add_local_scope() and remove_local_scope() would normally send is deferred.
+    // A single notification is sent when the outermost batch ends, provided
+    // that at least one scope was added or removed in the meantime.
+    void begin_update_batch();
+    void end_update_batch();
+
     StateReceiverObject::SPtr state_receiver();
 
     static std::string desktop_files_dir();
@@ -89,6 +96,9 @@ private:
 
     void ss_list_update();
 
+    // Must be called with mutex_ locked.
+    void registry_updated_unlocked();
+
     class ScopeProcess
     {
     public:
@@ -138,6 +148,9 @@ private:
 private:
     std::unique_ptr<unity::scopes::internal::Logger> test_logger_;
     unity::scopes::internal::Logger& logger_;
+    MetricsRegistry::UPtr test_metrics_;
+    MetricsRegistry::Histogram& locate_histogram_;
+    MetricsRegistry::Histogram& exec_histogram_;
 
     core::posix::ChildProcess::DeathObserver& death_observer_;
     core::ScopedConnection death_observer_connection_;
@@ -152,6 +165,8 @@ private:
     ProcessMap scope_processes_;
     MWRegistryProxy remote_registry_;
     mutable std::mutex mutex_;
+    int update_batch_depth_ = 0;
+    bool update_pending_ = false;
 
     MWPublisher::SPtr publisher_;
     MWSubscriber::SPtr ss_list_update_subscriber_;
@@ -56,8 +56,12 @@ protected:
     MWReplyProxy fwd();
 
 private:
+    // Returns completion details with the metrics of the query attached.
+    CompletionDetails completion_details(CompletionDetails::CompletionStatus status, std::string const& message);
+
     std::shared_ptr<QueryObjectBase> qo_;
     std::atomic_bool finished_;
+    std::atomic<int64_t> push_count_;
 };
 
 } // namespace internal
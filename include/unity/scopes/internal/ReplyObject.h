@@ -18,12 +18,14 @@
 
 #pragma once
 
+#include <unity/scopes/internal/Profiling.h>
 #include <unity/scopes/internal/ReplyObjectBase.h>
 #include <unity/scopes/internal/Reaper.h>
 #include <unity/scopes/ListenerBase.h>
 #include <unity/scopes/Variant.h>
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 
 namespace unity
@@ -55,6 +57,12 @@ public:
 
     std::string origin_proxy() const;
 
+    // Sets the ID that identifies the query in tracepoints (the identity of the reply proxy).
+    // The ID is known only once the reply object has been added to the middleware, so it
+    // cannot be passed to the constructor. query_id_ is protected by mutex_, because the
+    // reaper can fire (and push() or finished() can arrive) before this is called.
+    void set_query_id(std::string const& query_id);
+
     // Remote operation implementations
     void push(VariantMap const& result) noexcept override;
     void finished(CompletionDetails const& details) noexcept override;
@@ -68,11 +76,15 @@ private:
     ListenerBase::SPtr listener_base_;
     ReapItem::SPtr reap_item_;
     std::atomic_bool finished_;
-    std::mutex mutex_;
-    std::condition_variable idle_;
+    ProfiledMutex mutex_;
+    ProfiledCondition idle_;
     std::string origin_proxy_;
+    std::string query_id_;                               // Protected by mutex_
     int num_push_;
     std::vector<OperationInfo> info_list_;
+    std::chrono::steady_clock::time_point const start_;  // For CompletionDetails::metrics()
+    std::chrono::steady_clock::time_point first_push_;   // Default-constructed until the first push()
+    int64_t push_count_;
 };
 
 } // namespace internal
@@ -48,6 +48,9 @@ public:
     std::string app_directory() const;
     std::string config_directory() const;
     std::vector<std::string> trace_channels() const;
+    bool log_async() const;
+    int log_async_queue_size() const;
+    bool profiling() const;
 
     static std::string default_cache_directory();
     static std::string default_app_directory();
@@ -66,6 +69,9 @@ private:
     std::string app_directory_;
     std::string config_directory_;
     std::vector<std::string> trace_channels_;
+    bool log_async_;
+    int log_async_queue_size_;
+    bool profiling_;
 };
 
 } // namespace internal
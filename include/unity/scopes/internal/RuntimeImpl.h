@@ -19,6 +19,7 @@
 #pragma once
 
 #include <unity/scopes/internal/Logger.h>
+#include <unity/scopes/internal/Metrics.h>
 #include <unity/scopes/internal/MiddlewareBase.h>
 #include <unity/scopes/internal/MiddlewareFactory.h>
 #include <unity/scopes/internal/Reaper.h>
@@ -54,6 +55,7 @@ public:
     ThreadPool::SPtr async_pool() const;
     ThreadSafeQueue<std::future<void>>::SPtr future_queue() const;
     unity::scopes::internal::Logger& logger() const;
+    MetricsRegistry& metrics() const;
     void run_scope(ScopeBase* scope_base,
                    std::string const& scope_ini_file,
                    std::promise<void> ready_promise = std::promise<void>());
@@ -95,6 +97,7 @@ private:
     std::string log_dir_;
     std::string config_dir_;
     Logger::UPtr logger_;
+    MetricsRegistry::UPtr metrics_;
     mutable Reaper::SPtr reply_reaper_;
     mutable ThreadPool::SPtr async_pool_;  // Pool of invocation threads for async query creation
     mutable ThreadSafeQueue<std::future<void>>::SPtr future_queue_;
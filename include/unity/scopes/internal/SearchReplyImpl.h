@@ -25,6 +25,7 @@
 #include <unity/scopes/internal/CategoryRegistry.h>
 #include <unity/scopes/internal/MWReplyProxyFwd.h>
 #include <unity/scopes/internal/ObjectImpl.h>
+#include <unity/scopes/internal/Profiling.h>
 #include <unity/scopes/internal/ReplyImpl.h>
 #include <unity/scopes/SearchReply.h>
 
@@ -97,7 +98,7 @@ private:
     Department::SCPtr cached_departments_;
     unity::scopes::Filters cached_filters_;
     std::vector<unity::scopes::CategorisedResult> cached_results_;
-    std::mutex mutex_;
+    ProfiledMutex mutex_;
 };
 
 } // namespace internal
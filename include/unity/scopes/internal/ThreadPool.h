@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <unity/scopes/internal/Metrics.h>
 #include <unity/scopes/internal/ThreadSafeQueue.h>
 #include <unity/scopes/internal/TaskWrapper.h>
 
@@ -35,6 +36,8 @@ namespace internal
 // Simple thread pool that runs tasks on a number of worker threads.
 // submit() accepts an arbitrary functor and returns a future that
 // the calling thread can use to wait for the task to complete.
+// If a backlog gauge is passed to the constructor, the pool keeps it
+// up to date with the number of tasks that are queued but not yet running.
 
 class ThreadPool final
 {
@@ -42,7 +45,8 @@ public:
     NONCOPYABLE(ThreadPool);
     UNITY_DEFINES_PTRS(ThreadPool);
 
-    ThreadPool(int num_threads);         // Create pool with specified number of threads
+    // Create pool with specified number of threads
+    ThreadPool(int num_threads, MetricsRegistry::Gauge* backlog = nullptr);
     ~ThreadPool();
 
     void destroy() noexcept;             // Destroys whether queue is empty or not; waits for threads to exit.
@@ -57,6 +61,7 @@ private:
 
     typedef ThreadSafeQueue<unity::scopes::internal::TaskWrapper> TaskQueue;
     std::unique_ptr<TaskQueue> queue_;
+    MetricsRegistry::Gauge* backlog_;
     std::vector<std::thread> threads_;
     std::mutex mutex_;
     std::condition_variable cond_;
@@ -79,6 +84,10 @@ std::future<typename std::result_of<F()>::type> ThreadPool::submit(F f)
     std::packaged_task<ResultType()> task(std::move(f));
     std::future<ResultType> result(task.get_future());
     queue_->push(move(task));
+    if (backlog_)
+    {
+        backlog_->add(1);
+    }
     return result;
 }
 
@@ -33,10 +33,113 @@
 #pragma clang diagnostic ignored "-Wmissing-field-initializers"
 #endif
 
+/*
+ * Query lifecycle
+ *
+ * Every query event carries the query ID, which is the identity of the reply object that the
+ * client creates for the query. The client passes the reply proxy to the scope, so the ID is
+ * the same on both sides of the query. The sub-queries of an aggregator have IDs of their own.
+ */
+
+SIMPLE_TRACEPOINT(
+  query_sent,                   /* Client: ScopeImpl is about to send the query */
+  TRACE_INFO,
+  stp_string(query_id),
+  stp_string(scope),
+  stp_string(op)
+)
+
+SIMPLE_TRACEPOINT(
+  query_received,               /* Scope: ScopeObject received the query */
+  TRACE_INFO,
+  stp_string(query_id),
+  stp_string(scope),
+  stp_string(op)
+)
+
+SIMPLE_TRACEPOINT(
+  query_run_begin,              /* Scope: QueryObject calls the scope's run() */
+  TRACE_INFO,
+  stp_string(query_id)
+)
+
+SIMPLE_TRACEPOINT(
+  query_run_end,                /* Scope: the scope's run() returned (replies may still be outstanding) */
+  TRACE_INFO,
+  stp_string(query_id)
+)
+
+SIMPLE_TRACEPOINT(
+  query_cancelled,              /* Scope: the query was cancelled */
+  TRACE_INFO,
+  stp_string(query_id)
+)
+
+SIMPLE_TRACEPOINT(
+  reply_push,                   /* Scope: the scope pushed a reply (category, result, widget, ...) */
+  TRACE_DEBUG,
+  stp_string(query_id)
+)
+
+SIMPLE_TRACEPOINT(
+  reply_finished,               /* Scope: the scope finished the query; status is a CompletionStatus */
+  TRACE_INFO,
+  stp_string(query_id),
+  stp_integer(int, status)
+)
+
+SIMPLE_TRACEPOINT(
+  listener_push,                /* Client: ReplyObject passes a reply to the listener */
+  TRACE_DEBUG,
+  stp_string(query_id)
+)
+
+SIMPLE_TRACEPOINT(
+  listener_finished,            /* Client: ReplyObject passes finished() to the listener */
+  TRACE_INFO,
+  stp_string(query_id),
+  stp_integer(int, status)
+)
+
+SIMPLE_TRACEPOINT(
+  reply_expired,                /* Client: the reaper expired the query for lack of activity */
+  TRACE_WARNING,
+  stp_string(query_id)
+)
+
+/*
+ * Middleware
+ *
+ * id is the identity of the target object. For operations on a reply object (push,
+ * finished, info), this is the query ID.
+ */
+
+SIMPLE_TRACEPOINT(
+  request_sent,                 /* ZmqObjectProxy is about to send a request */
+  TRACE_DEBUG,
+  stp_string(id),
+  stp_string(op),
+  stp_integer(int, oneway)
+)
+
+SIMPLE_TRACEPOINT(
+  request_received,             /* ObjectAdapter worker starts dispatching a request */
+  TRACE_DEBUG,
+  stp_string(adapter),
+  stp_string(id),
+  stp_string(op)
+)
+
+SIMPLE_TRACEPOINT(
+  adapter_saturated,            /* All workers are busy; further requests wait in the adapter's socket */
+  TRACE_DEBUG,
+  stp_string(adapter)
+)
+
 SIMPLE_TRACEPOINT(
-  trace,
+  adapter_resumed,              /* A worker became free after the adapter was saturated */
   TRACE_DEBUG,
-  stp_integer(int, value)
+  stp_string(adapter)
 )
 
 #if __clang__
@@ -21,6 +21,9 @@
 #include <unity/util/DefinesPtrs.h>
 #include <unity/util/NonCopyable.h>
 
+#include <algorithm>
+#include <cctype>
+#include <exception>
 #include <future>
 #include <string>
 #include <functional>
@@ -43,6 +46,25 @@ class HttpResponseHandle;
 
 typedef std::list<std::pair<std::string, std::string>> HttpHeaders;
 
+// Status and headers of a response. The client fills these in before the response completes.
+
+struct HttpResponseInfo
+{
+    int status = 0;
+    HttpHeaders headers;
+};
+
+// Whether a request counts against the client's limit of concurrent requests per host.
+// Streaming searches are Unlimited: they hold their connection until the last result
+// arrives, so queueing them would add the whole run time of earlier searches to the wait,
+// and they would take the slots that short requests, such as previews, need.
+
+enum class HttpConcurrency
+{
+    Limited,
+    Unlimited
+};
+
 class HttpClientInterface : public std::enable_shared_from_this<HttpClientInterface>
 {
 public:
@@ -52,9 +74,14 @@ public:
     HttpClientInterface() = default;
     virtual ~HttpClientInterface() = default;
 
+    // If completed is set, it is called once the response is complete (and its future is ready),
+    // with the error, if any. It is called on the client's own thread, never from within
+    // get() or cancel().
     virtual std::shared_ptr<HttpResponseHandle> get(std::string const& request_url,
             std::function<void(std::string const&)> const& line_data = [](std::string const&) {},
-            HttpHeaders const& headers = HttpHeaders()) = 0;
+            HttpHeaders const& headers = HttpHeaders(),
+            std::function<void(std::exception_ptr const&)> const& completed = nullptr,
+            HttpConcurrency concurrency = HttpConcurrency::Limited) = 0;
 
     virtual std::string to_percent_encoding(std::string const& string) = 0;
 
@@ -70,10 +97,14 @@ public:
     NONCOPYABLE(HttpResponseHandle);
     UNITY_DEFINES_PTRS(HttpResponseHandle);
 
-    HttpResponseHandle(HttpClientInterface::SPtr client, unsigned int session_id, std::shared_future<void> future)
+    HttpResponseHandle(HttpClientInterface::SPtr client,
+                       unsigned int session_id,
+                       std::shared_future<void> future,
+                       std::shared_ptr<HttpResponseInfo> info = std::make_shared<HttpResponseInfo>())
         : client_(client)
         , session_id_(session_id)
         , future_(future)
+        , info_(info)
     {
     }
 
@@ -97,10 +128,32 @@ public:
         client_->cancel_get(session_id_);
     }
 
+    // The status and headers are valid only once get() has returned.
+
+    int status() const
+    {
+        return info_->status;
+    }
+
+    // Header names are case-insensitive. Returns the empty string if there is no such header.
+    std::string header(std::string const& name) const
+    {
+        auto equal = [](char a, char b) { return std::tolower(a) == std::tolower(b); };
+        for (auto const& h : info_->headers)
+        {
+            if (h.first.size() == name.size() && std::equal(h.first.begin(), h.first.end(), name.begin(), equal))
+            {
+                return h.second;
+            }
+        }
+        return "";
+    }
+
 private:
     std::shared_ptr<HttpClientInterface> client_;
     unsigned int session_id_;
     std::shared_future<void> future_;
+    std::shared_ptr<HttpResponseInfo> info_;
 };
 
 }  // namespace smartscopes
@@ -20,6 +20,7 @@
 #define UNITY_SCOPES_INTERNAL_SMARTSCOPES_HTTPCLIENTNETCPP_H
 
 #include <unity/scopes/internal/smartscopes/HttpClientInterface.h>
+#include <unity/scopes/internal/smartscopes/HttpHostLimiter.h>
 
 #include <memory>
 #include <thread>
@@ -50,20 +51,33 @@ namespace smartscopes
 class HttpClientNetCpp : public HttpClientInterface
 {
 public:
+    // At most max_connections_per_host requests to the same host run at a time, so that
+    // further requests wait for and reuse a kept-alive connection instead of opening a new one.
+    // A request that waits for longer than queue_timeout seconds fails (-1 waits indefinitely).
+    // HttpConcurrency::Unlimited requests start immediately and don't take a slot.
+    // The first constructor uses the defaults for smartscopesproxy (see CONFIGFILES).
     explicit HttpClientNetCpp(unsigned int no_reply_timeout);
+    HttpClientNetCpp(unsigned int no_reply_timeout, unsigned int max_connections_per_host, int queue_timeout);
     ~HttpClientNetCpp();
 
     HttpResponseHandle::SPtr get(std::string const& request_url,
                                  std::function<void(std::string const&)> const& line_data = [](std::string const&) {},
-                                 HttpHeaders const& headers = HttpHeaders()) override;
+                                 HttpHeaders const& headers = HttpHeaders(),
+                                 std::function<void(std::exception_ptr const&)> const& completed = nullptr,
+                                 HttpConcurrency concurrency = HttpConcurrency::Limited) override;
 
     std::string to_percent_encoding(std::string const& string) override;
 
+    // Counts only the requests that went through the limiter. Connection reuse itself isn't
+    // visible here, because net-cpp doesn't report which requests reused a connection.
+    HttpHostLimiter::Stats stats() const;
+
 private:
     void cancel_get(unsigned int session_id) override;
 
     unsigned int no_reply_timeout;
     std::shared_ptr<core::net::http::StreamingClient> client;
+    HttpHostLimiter::SPtr limiter_;
     std::thread worker;
 };
 
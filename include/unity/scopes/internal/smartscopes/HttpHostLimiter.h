@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#pragma once
+
+#include <unity/scopes/internal/Reaper.h>
+#include <unity/util/DefinesPtrs.h>
+#include <unity/util/NonCopyable.h>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace smartscopes
+{
+
+// Limits the number of concurrent requests to each host.
+//
+// This is a concurrency limit, not a connection pool: the connections themselves are kept alive
+// and reused by the HTTP client (HTTP/1.1 keep-alive). Without a limit, a burst of requests opens
+// a new connection (and does a new TLS handshake) for every request that finds no idle
+// connection. With a limit, the requests over the limit wait for a running request to
+// finish and then reuse its connection.
+//
+// A request that waits for longer than queue_timeout seconds is removed from the queue and its
+// timed_out function is called. A queue_timeout of -1 means that requests wait indefinitely.
+//
+// Hosts without running or waiting requests are forgotten after idle_expiry.
+
+class HttpHostLimiter final
+{
+public:
+    NONCOPYABLE(HttpHostLimiter);
+    UNITY_DEFINES_PTRS(HttpHostLimiter);
+
+    struct Stats
+    {
+        uint64_t requests;      // Requests submitted
+        uint64_t queued;        // Requests that had to wait for a free slot
+        uint64_t timed_out;     // Requests that were removed from the queue by the queue timeout
+        uint64_t max_active;    // Highest number of concurrent requests to a single host
+        size_t hosts;           // Hosts currently known
+    };
+
+    HttpHostLimiter(unsigned int max_per_host,
+                    std::chrono::steady_clock::duration idle_expiry,
+                    int queue_timeout = -1);
+    ~HttpHostLimiter();
+
+    // Calls start() immediately if fewer than max_per_host requests to host are running,
+    // otherwise once enough of them have called release(). start() returns true if it
+    // started the request, in which case it must eventually be followed by release().
+    // If start() returns false (because the request was abandoned while it was waiting),
+    // the slot passes on to the next waiting request.
+    //
+    // If the request is still waiting after queue_timeout, timed_out() is called instead
+    // of start(). start() and timed_out() are called without any lock held.
+    void submit(std::string const& host,
+                std::function<bool()> const& start,
+                std::function<void()> const& timed_out = nullptr);
+    void release(std::string const& host);
+
+    Stats stats() const;
+
+    // Returns scheme://host[:port] of url, which identifies the connections that can be shared.
+    static std::string host_of(std::string const& url);
+
+private:
+    struct Waiter
+    {
+        std::function<bool()> start;
+        std::function<void()> timed_out;
+        ReapItem::SPtr reap_item;
+    };
+
+    struct Host
+    {
+        unsigned int active;
+        std::deque<std::shared_ptr<Waiter>> waiting;
+        std::chrono::steady_clock::time_point last_used;
+    };
+
+    void expire_idle_hosts(std::chrono::steady_clock::time_point now);   // Call with mutex_ locked
+    void expire_waiter(std::string const& host, std::weak_ptr<Waiter> const& w);
+
+    unsigned int const max_per_host_;
+    std::chrono::steady_clock::duration const idle_expiry_;
+    std::map<std::string, Host> hosts_;
+    Stats stats_;
+    mutable std::mutex mutex_;
+    Reaper::SPtr queue_reaper_;     // Last, so it is destroyed (and stops calling back) first
+};
+
+}  // namespace smartscopes
+
+}  // namespace internal
+
+}  // namespace scopes
+
+}  // namespace unity
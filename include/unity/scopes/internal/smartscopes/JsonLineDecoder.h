@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#pragma once
+
+#include <unity/scopes/Variant.h>
+#include <unity/UnityExceptions.h>
+#include <unity/util/NonCopyable.h>
+
+#include <string>
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace smartscopes
+{
+
+// Streaming decoder for a single line of a smart scopes server response.
+//
+// The decoder walks the text once, front to back, and decodes values straight into
+// Variants, without building a JSON tree first. Each SmartScopesClient query creates its
+// own decoder for each line, so concurrent queries do not share any parser state.
+//
+// Objects are read member by member:
+//
+//     JsonLineDecoder d(line);
+//     d.begin_object();
+//     std::string name;
+//     while (d.next_member(name))
+//     {
+//         // Must consume the member value with value(), string_value(), or skip_value().
+//     }
+//     d.finish();
+//
+// mark() and text_since() return the verbatim text of a value, so callers that need
+// both the decoded members and the original JSON do not have to serialize it again.
+//
+// The decoder does not copy the text passed to the constructor, which must outlive it.
+// All parse errors throw unity::ResourceException.
+
+class JsonLineDecoder final
+{
+public:
+    NONCOPYABLE(JsonLineDecoder);
+
+    JsonLineDecoder(char const* data, std::size_t size);
+    explicit JsonLineDecoder(std::string const& json);
+
+    void begin_object();
+    bool next_member(std::string& name);
+
+    Variant value();
+    std::string string_value();
+    void skip_value();
+
+    std::string::size_type mark();
+    std::string text_since(std::string::size_type mark) const;
+
+    void finish();      // Throws if anything other than white space follows
+
+private:
+    void skip_ws() noexcept;
+    char peek() const;
+    void expect(char c);
+    void expect_literal(char const* literal);
+    void decode_string(std::string* s);     // nullptr skips the string
+    void decode_value(Variant* v);          // nullptr skips the value
+    void decode_number(Variant* v);
+    unsigned long decode_hex4();
+    unity::ResourceException error(std::string const& msg) const;
+
+    char const* data_;
+    std::size_t size_;
+    std::string::size_type pos_;
+    bool first_member_;
+    int depth_;
+};
+
+} // namespace smartscopes
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#pragma once
+
+#include <unity/util/NonCopyable.h>
+
+#include <functional>
+#include <string>
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace smartscopes
+{
+
+// Splits the chunks of a streamed smart scopes server response into lines.
+//
+// The server sends a series of "\r\n"-delimited lines, each containing one JSON object,
+// and HTTP chunk boundaries can fall anywhere within a line. Lines that are complete within
+// a chunk are passed to the handler in place, without copying. Only a partial line at the
+// end of a chunk is kept, until the chunk that completes it arrives.
+//
+// The trailing "\r" is stripped, and empty lines are not passed to the handler. The pointer
+// passed to the handler is valid only for the duration of the call.
+//
+// feed() with an empty chunk marks the end of the response and passes any partial
+// line that remains to the handler. If the handler throws, the exception propagates
+// from feed() and the remainder of that chunk is discarded.
+
+class NdjsonFramer final
+{
+public:
+    NONCOPYABLE(NdjsonFramer);
+
+    typedef std::function<void(char const* line, std::size_t size)> LineHandler;
+
+    explicit NdjsonFramer(LineHandler const& handler);
+
+    void feed(std::string const& chunk);
+
+    std::size_t buffered() const noexcept;      // Size of the partial line held back
+
+private:
+    void deliver(char const* line, std::size_t size);
+
+    LineHandler handler_;
+    std::string tail_;
+};
+
+} // namespace smartscopes
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#pragma once
+
+#include <unity/scopes/internal/smartscopes/SmartScopesClient.h>
+
+#include <string>
+#include <vector>
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace smartscopes
+{
+
+// Binary copy of the remote scopes cache (remote-scopes.json).
+//
+// The file holds the RemoteScope records in a flat, versioned format. read() maps the file
+// into memory and builds the records straight from the mapping, so loading the cache
+// doesn't involve parsing (other than for the appearance of scopes that have one).
+//
+// The JSON file remains the primary cache. The binary file records the size and modification
+// time of the JSON file it was written for, and read() rejects it if the JSON file has changed
+// since, or if it was written with a different format version.
+
+class RemoteScopesCache final
+{
+public:
+    // Writes the file atomically (via a temporary file and a rename).
+    // Throws ResourceException if the file cannot be written.
+    static void write(std::string const& path, std::string const& json_path, std::vector<RemoteScope> const& scopes);
+
+    // Returns false (and leaves scopes unchanged) if the file does not exist,
+    // is damaged, has a different version, or is out of date with respect to json_path.
+    static bool read(std::string const& path, std::string const& json_path, std::vector<RemoteScope>& scopes);
+
+    // Returns true if the file exists and its header matches the format version and json_path.
+    // Only the header of the file is read.
+    static bool is_current(std::string const& path, std::string const& json_path);
+};
+
+}  // namespace smartscopes
+
+}  // namespace internal
+
+}  // namespace scopes
+
+}  // namespace unity
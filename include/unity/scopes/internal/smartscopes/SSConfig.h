@@ -39,15 +39,25 @@ public:
     ~SSConfig();
 
     int http_reply_timeout() const;             // seconds
+    int http_connections_per_host() const;
+    int http_queue_timeout() const;             // seconds
     int reg_refresh_rate() const;               // seconds
     int reg_refresh_fail_timeout() const;       // seconds
     std::string scope_identity() const;
+    int search_cache_size() const;              // entries
+    std::string search_cache_dir() const;
+    int search_cache_dir_size() const;          // files
 
 private:
     int http_reply_timeout_;
+    int http_connections_per_host_;
+    int http_queue_timeout_;
     int reg_refresh_rate_;
     int reg_refresh_fail_timeout_;
     std::string scope_identity_;
+    int search_cache_size_;
+    std::string search_cache_dir_;
+    int search_cache_dir_size_;
 };
 
 } // namespace smartscopes
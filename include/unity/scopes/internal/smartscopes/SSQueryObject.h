@@ -89,9 +89,12 @@ public:
                    MWReplyProxy const& reply);
 
 private:
-    void run_query(SSQuery::SPtr query, MWReplyProxy const& reply);
-    void run_preview(SSQuery::SPtr query, MWReplyProxy const& reply);
+    // run_query() and run_preview() return true if the query is still running, in which
+    // case query_done() is called once it is complete.
+    bool run_query(SSQuery::SPtr query, MWReplyProxy const& reply);
+    bool run_preview(SSQuery::SPtr query, MWReplyProxy const& reply);
     void run_activation(SSQuery::SPtr query, MWReplyProxy const& reply);
+    void query_done(std::string const& reply_id);
 
 private:
     mutable std::mutex queries_mutex_;
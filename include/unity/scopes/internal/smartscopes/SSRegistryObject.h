@@ -21,6 +21,7 @@
 #include <unity/scopes/internal/MiddlewareBase.h>
 #include <unity/scopes/internal/RegistryObjectBase.h>
 #include <unity/scopes/internal/SettingsDB.h>
+#include <unity/scopes/internal/smartscopes/SearchCache.h>
 #include <unity/scopes/internal/smartscopes/SmartScopesClient.h>
 #include <unity/scopes/internal/smartscopes/SSConfig.h>
 
@@ -60,6 +61,7 @@ public:
     bool has_scope(std::string const& scope_id) const;
     std::string get_base_url(std::string const& scope_id) const;
     SmartScopesClient::SPtr get_ssclient() const;
+    SearchCache::SPtr get_search_cache() const;
 
     SettingsDB::SPtr get_settings_db(std::string const& scope_id) const;
 
@@ -78,9 +80,11 @@ private:
     };
 
     SmartScopesClient::SPtr ssclient_;
+    SearchCache::SPtr search_cache_;
 
     MetadataMap scopes_;
     std::map<std::string, std::string> base_urls_;
+    std::map<std::string, RemoteScope> remote_scopes_;      // What scopes_ was built from
     std::map<std::string, SSSettingsDef> settings_defs_;
     mutable std::mutex scopes_mutex_;
 
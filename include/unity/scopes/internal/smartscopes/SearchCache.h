@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#pragma once
+
+#include <unity/scopes/internal/smartscopes/SmartScopesClient.h>
+#include <unity/scopes/ScopeMetadata.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace smartscopes
+{
+
+// The replies of a single remote search, in the order in which they arrived.
+
+class SearchRecording final
+{
+public:
+    UNITY_DEFINES_PTRS(SearchRecording);
+
+    void add(std::shared_ptr<SearchCategory> const& category);
+    void add(SearchResult const& result);
+    void add(std::shared_ptr<DepartmentInfo> const& departments);
+    void add(Filters const& filters);
+    void add(FilterState const& filter_state);
+
+    void replay(SearchReplyHandler& handler) const;
+
+    // Wraps the callbacks of handler so that the replies passed to them are recorded as well.
+    static SPtr record(SearchReplyHandler& handler);
+
+    Variant serialize() const;
+    static SPtr deserialize(Variant const& var);
+
+private:
+    enum class Kind { Category, Result, Departments, Filters, FilterState };
+    struct Reply
+    {
+        Kind kind;
+        std::shared_ptr<SearchCategory> category;
+        SearchResult result;
+        std::shared_ptr<DepartmentInfo> departments;
+        Filters filters;
+        FilterState filter_state;
+    };
+    std::vector<Reply> replies_;
+};
+
+// LRU cache of the replies to remote searches, keyed on the search parameters.
+//
+// Entries expire according to the results TTL of the scope: Small means a minute,
+// Medium means five minutes, and Large means an hour. The results of scopes with
+// a TTL of None are not cached.
+//
+// If cache_dir is not empty, entries are also written to disk, so they survive
+// a restart of smartscopesproxy. Entries that are evicted from memory are still
+// found on disk until they expire. The directory holds at most about max_files
+// entries: expired files are removed on construction and whenever the limit is
+// exceeded, and the files that expire soonest are removed if that is not enough.
+
+class SearchCache final
+{
+public:
+    NONCOPYABLE(SearchCache);
+    UNITY_DEFINES_PTRS(SearchCache);
+
+    struct Stats
+    {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        uint64_t bytes;         // Serialized size of the entries in memory
+        size_t entries;
+    };
+
+    SearchCache(size_t max_entries, std::string const& cache_dir = "", size_t max_files = 1000);
+
+    // Location is rounded to about 100 m, so nearby locations share cache entries.
+    // The session and query IDs are not part of the key.
+    static std::string make_key(std::string const& base_url,
+                                std::string const& query,
+                                std::string const& department_id,
+                                std::string const& platform,
+                                VariantMap const& settings,
+                                VariantMap const& filter_state,
+                                std::string const& locale,
+                                LocationInfo const& location,
+                                std::string const& user_agent,
+                                unsigned int limit);
+
+    static std::chrono::seconds ttl(ScopeMetadata::ResultsTtlType ttl_type);
+
+    // Returns null if there is no unexpired entry for key.
+    SearchRecording::SCPtr find(std::string const& key);
+
+    void add(std::string const& key, SearchRecording::SCPtr const& recording, std::chrono::seconds ttl);
+
+    Stats stats() const;
+
+private:
+    struct Entry
+    {
+        SearchRecording::SCPtr recording;
+        std::chrono::steady_clock::time_point expiry;
+        size_t bytes;
+        std::list<std::string>::iterator lru_pos;
+    };
+
+    void add_to_memory(std::string const& key,
+                       SearchRecording::SCPtr const& recording,
+                       std::chrono::steady_clock::time_point expiry,
+                       size_t bytes);                                   // Call with mutex_ locked
+    void remove_from_memory(std::unordered_map<std::string, Entry>::iterator it);   // Call with mutex_ locked
+    std::string file_name(std::string const& key) const;
+    SearchRecording::SCPtr read_file(std::string const& key,
+                                     std::chrono::seconds& remaining,
+                                     size_t& bytes) const;
+    bool write_file(std::string const& key, std::string const& json, std::chrono::seconds ttl);
+    void sweep_files(bool remove_tmp_files);                           // Call with files_mutex_ locked
+
+    size_t const max_entries_;
+    std::string const cache_dir_;
+    size_t const max_files_;
+
+    std::unordered_map<std::string, Entry> entries_;
+    std::list<std::string> lru_;                        // Most recently used at the front
+    Stats stats_;
+    mutable std::mutex mutex_;
+
+    size_t files_;                                      // Approximate number of files in cache_dir_
+    std::atomic<unsigned> tmp_counter_;
+    std::mutex files_mutex_;
+};
+
+} // namespace smartscopes
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
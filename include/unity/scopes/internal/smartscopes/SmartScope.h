@@ -19,6 +19,9 @@
 #include <unity/scopes/internal/smartscopes/SSRegistryObject.h>
 #include <unity/scopes/ScopeBase.h>
 
+#include <functional>
+#include <mutex>
+
 namespace unity
 {
 
@@ -40,15 +43,36 @@ public:
     virtual void cancelled() override;
     virtual void run(SearchReplyProxy const& reply) override;
 
+    // Starts the search and returns without waiting for it to complete. Once the query
+    // is complete and its reply released, done is called on the HTTP client's thread
+    // (or on the calling thread if the query was answered from the cache).
+    void run_async(SearchReplyProxy const& reply, std::function<void()> const& done);
+
     Department::SCPtr create_department(std::shared_ptr<DepartmentInfo const> const& deptinfo);
 
 private:
+    // Call these with mutex_ locked.
+    bool start(SearchReplyProxy const& reply, bool async);  // Returns false if answered from the cache
+    void finish();
+    void release();
+
+    void search_finished(std::exception_ptr const& error);
+
     std::string scope_id_;
     CannedQuery query_;
-    SearchHandle::UPtr search_handle_;
     SmartScopesClient::SPtr ss_client_;
     std::string base_url_;
     SearchMetadata hints_;
+    SearchCache::SPtr search_cache_;
+    std::chrono::seconds results_ttl_;
+
+    std::mutex mutex_;                          // Protects the members below
+    SearchHandle::UPtr search_handle_;
+    SearchReplyHandler handler_;
+    SearchReplyProxy reply_;
+    std::string cache_key_;
+    SearchRecording::SPtr recording_;
+    std::function<void()> done_;
 };
 
 class SmartPreview : public PreviewQueryBase
@@ -60,13 +84,26 @@ public:
     virtual void cancelled() override;
     virtual void run(PreviewReplyProxy const& reply) override;
 
+    // As for SmartQuery::run_async().
+    void run_async(PreviewReplyProxy const& reply, std::function<void()> const& done);
+
 private:
+    // Call these with mutex_ locked.
+    void start(PreviewReplyProxy const& reply, bool async);
+    void release();
+
+    void preview_finished(std::exception_ptr const& error);
+
     std::string scope_id_;
-    PreviewHandle::UPtr preview_handle_;
     Result result_;
     SmartScopesClient::SPtr ss_client_;
     std::string base_url_;
     ActionMetadata hints_;
+
+    std::mutex mutex_;                          // Protects the members below
+    PreviewHandle::UPtr preview_handle_;
+    PreviewReplyProxy reply_;
+    std::function<void()> done_;
 };
 
 class SmartActivation : public ActivationQueryBase
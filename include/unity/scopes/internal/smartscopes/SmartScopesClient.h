@@ -25,9 +25,12 @@
 #include <unity/scopes/internal/Logger.h>
 #include <unity/scopes/internal/smartscopes/HttpClientInterface.h>
 #include <unity/scopes/internal/UniqueID.h>
+#include <unity/scopes/PreviewWidget.h>
+#include <unity/scopes/ScopeMetadata.h>
 
 #include <unity/util/NonCopyable.h>
 
+#include <exception>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -67,8 +70,13 @@ struct RemoteScope
     bool invisible = false;
     int version;
     std::set<std::string> keywords;             // optional
+    ScopeMetadata::ResultsTtlType results_ttl_type = ScopeMetadata::ResultsTtlType::None;  // optional
 };
 
+// Optional fields compare equal if both are absent or both are present with equal values.
+bool operator==(RemoteScope const& lhs, RemoteScope const& rhs);
+bool operator!=(RemoteScope const& lhs, RemoteScope const& rhs);
+
 struct SearchCategory
 {
     std::string id;
@@ -81,7 +89,7 @@ struct SearchResult
 {
     std::string json;
     std::string uri;
-    std::map<std::string, JsonNodeInterface::SPtr > other_params;
+    VariantMap other_params;
     std::string category_id;
 };
 
@@ -133,7 +141,6 @@ public:
     ~PreviewHandle();
 
     using Columns = std::vector<std::vector<std::vector<std::string>>>;
-    using Widgets = std::vector<std::string>;
 
     void wait();
     void cancel_preview();
@@ -147,6 +154,11 @@ private:
     std::shared_ptr<SmartScopesClient> ssc_;
 };
 
+// If finished_handler is set, the search or preview completes asynchronously: there is no need
+// to call wait() on the handle, and finished_handler is called exactly once, on the HTTP client's
+// thread, when the request completes or fails or after the search or preview is cancelled.
+// Its argument is null on success, and the error otherwise. The handle must be kept until then.
+
 struct SearchReplyHandler
 {
     std::function<void(SearchResult const&)> result_handler;
@@ -154,14 +166,21 @@ struct SearchReplyHandler
     std::function<void(std::shared_ptr<DepartmentInfo> const&)> departments_handler;
     std::function<void(Filters const&)> filters_handler;
     std::function<void(FilterState const&)> filter_state_handler;
+    std::function<void(std::exception_ptr const&)> finished_handler;
 
     std::map<std::string, FilterGroup::SCPtr> filter_groups;
 };
 
+// Widgets that arrive together (in the same chunk of the HTTP response) are
+// passed to widgets_handler as a single list. Invalid widgets are dropped
+// individually. If widgets_handler throws for a list, its widgets are
+// passed again one at a time.
+
 struct PreviewReplyHandler
 {
-    std::function<void(std::string const&)> widget_handler;
+    std::function<void(PreviewWidgetList const&)> widgets_handler;
     std::function<void(PreviewHandle::Columns const&)> columns_handler;
+    std::function<void(std::exception_ptr const&)> finished_handler;
 };
 
 class SmartScopesClient : public std::enable_shared_from_this<SmartScopesClient>
@@ -221,17 +240,24 @@ private:
     Filters parse_filters(JsonNodeInterface::SPtr node, std::map<std::string, FilterGroup::SCPtr> const& filter_groups);
     FilterState parse_filter_state(JsonNodeInterface::SPtr node);
 
-    std::string handle_chunk(const std::string& chunk, std::function<void(const std::string&)> line_handler);
-    void handle_line(std::string const& json, SearchReplyHandler& handler);
-    void handle_line(std::string const& json, PreviewReplyHandler const& handler);
-
-    std::vector<std::string> extract_json_stream(std::string const& json_stream);
+    void handle_line(char const* json, std::size_t size, SearchReplyHandler& handler);
+    void handle_line(char const* json, std::size_t size, PreviewReplyHandler const& handler, PreviewWidgetList& widgets);
+    void push_widgets(PreviewReplyHandler const& handler, PreviewWidgetList const& widgets);
 
     void cancel_query(unsigned int query_id);
 
+    // Identical searches (same URI and headers) that are in flight at the same time share
+    // a single HTTP request. The replies are fanned out to the handlers of all searches,
+    // and the request is cancelled only once every search that shares it is cancelled.
+    struct SharedSearch;
+
+    void complete_search(std::shared_ptr<SharedSearch> const& search, std::exception_ptr const& error);
+
     void write_cache(std::string const& scopes_json);
     std::string read_cache();
+    void write_binary_cache(std::vector<RemoteScope> const& scopes);
 
+    std::string encoded_settings(std::string const& base_url, VariantMap const& settings);
     std::string stringify_settings(VariantMap const& settings);
 
     HttpClientInterface::SPtr http_client_;
@@ -240,14 +266,33 @@ private:
     unity::scopes::internal::Logger& logger_;
     std::string url_;
 
-    std::map<unsigned int, HttpResponseHandle::SPtr> query_results_;
+    std::map<unsigned int, HttpResponseHandle::SPtr> query_results_;           // Previews
+    std::map<unsigned int, std::shared_ptr<SharedSearch>> search_results_;     // Searches
+    std::map<std::string, std::shared_ptr<SharedSearch>> shared_searches_;     // In-flight searches by URI and headers
 
-    std::mutex json_node_mutex_;
-    std::mutex query_results_mutex_;
+    std::mutex json_node_mutex_;                // Protects json_node_, used only by get_remote_scopes()
+    std::mutex query_results_mutex_;            // Protects query_results_, search_results_, and shared_searches_
 
     std::string cached_scopes_;
     bool have_latest_cache_;
 
+    // Validators and parsed contents of the last remote scopes response, so the next
+    // request can be conditional. If the server replies 304, we return the same scopes
+    // without parsing or writing the cache again.
+    std::string remote_scopes_request_;         // URI and headers of the request the validators apply to
+    std::string remote_scopes_etag_;
+    std::string remote_scopes_last_modified_;
+    std::vector<RemoteScope> remote_scopes_;
+    std::mutex remote_scopes_mutex_;
+
+    struct EncodedSettings
+    {
+        VariantMap settings;
+        std::string encoded;                    // Percent-encoded JSON
+    };
+    std::map<std::string, EncodedSettings> encoded_settings_;  // By base URL
+    std::mutex encoded_settings_mutex_;
+
     unsigned int query_counter_;
     std::string partner_file_;
 };
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace smartscopes
+{
+
+// Builds the URI of a smart scopes server request by appending to a single string.
+//
+// The URI starts out as base + resource + "?", and each parameter adds "name=value",
+// preceded by "&" for all but the first. Names are appended as given. Values passed
+// to param() are percent-encoded; values passed to raw_param() must not need encoding.
+//
+// Numbers are always formatted with "." as the decimal point, whatever the locale.
+
+class UriBuilder final
+{
+public:
+    UriBuilder(std::string const& base, std::string const& resource);
+
+    UriBuilder& param(char const* name, std::string const& value);
+    UriBuilder& raw_param(char const* name, std::string const& value);
+    UriBuilder& param(char const* name, int64_t value);
+    UriBuilder& param(char const* name, double value, int precision);   // Fixed-point
+
+    std::string const& str() const noexcept;
+
+    // Percent-encodes everything except the unreserved characters of RFC 3986
+    // (letters, digits, '-', '.', '_', and '~'), in the same way as curl_easy_escape().
+    static void percent_encode(std::string const& s, std::string& out);
+    static std::string percent_encode(std::string const& s);
+
+private:
+    void begin_param(char const* name);
+
+    std::string uri_;
+    bool first_;
+};
+
+} // namespace smartscopes
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
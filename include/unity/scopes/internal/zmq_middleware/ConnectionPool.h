@@ -24,6 +24,7 @@
 
 #include <zmqpp/socket.hpp>
 
+#include <atomic>
 #include <string>
 #include <unordered_map>
 
@@ -63,6 +64,8 @@ public:
                          std::shared_ptr<zmqpp::socket> const& socket,
                          bool idle_timeout = true);
 
+    static int64_t total_connections() noexcept;  // Number of sockets in all pools of this process
+
 private:
     struct PoolEntry
     {
@@ -80,6 +83,8 @@ private:
     Reaper::SPtr reaper_;        // Removes connection from the pool after close_after_idle_seconds of idle time.
     std::mutex mutex_;
     std::thread::id thread_id_;  // For debug build, to assert that pool is used as thread_local static only.
+
+    static std::atomic<int64_t> total_connections_;
 };
 
 } // namespace zmq_middleware
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#pragma once
+
+#include <unity/util/NonCopyable.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+class AbstractObject;
+
+namespace zmq_middleware
+{
+
+class ObjectAdapter;
+class ZmqMiddleware;
+
+// Process-wide table of the objects that are hosted by a middleware in this process, keyed
+// by endpoint and identity. Proxies consult the table before marshaling a request; if the target
+// is in the table, they call the servant's delegate directly instead of going through zmq.
+//
+// The table holds weak references only, so it never keeps an object or adapter alive.
+// Middleware instances remove their objects when the objects are disconnected and when
+// the middleware stops.
+
+class LocalObjects final
+{
+public:
+    NONCOPYABLE(LocalObjects);
+
+    struct Target
+    {
+        ZmqMiddleware* mw;                          // Middleware that hosts the object
+        std::shared_ptr<ObjectAdapter> adapter;
+        std::shared_ptr<AbstractObject> object;
+
+        explicit operator bool() const noexcept
+        {
+            return object != nullptr;
+        }
+    };
+
+    static LocalObjects& instance();
+
+    void add(std::string const& endpoint,
+             std::string const& identity,
+             ZmqMiddleware* mw,
+             std::shared_ptr<ObjectAdapter> const& adapter,
+             std::shared_ptr<AbstractObject> const& object);
+    void remove(std::string const& endpoint, std::string const& identity) noexcept;
+    void remove_all(ZmqMiddleware* mw) noexcept;
+
+    // Returns an empty target if the object is not hosted in this process (or no longer exists).
+    Target find(std::string const& endpoint, std::string const& identity) const;
+
+private:
+    LocalObjects();
+
+    struct Entry
+    {
+        ZmqMiddleware* mw;
+        std::weak_ptr<ObjectAdapter> adapter;
+        std::weak_ptr<AbstractObject> object;
+    };
+
+    static std::string key(std::string const& endpoint, std::string const& identity);
+
+    std::unordered_map<std::string, Entry> objects_;
+    std::atomic<size_t> size_;                     // Allows find() to avoid locking if the table is empty
+    mutable std::mutex mutex_;
+};
+
+} // namespace zmq_middleware
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
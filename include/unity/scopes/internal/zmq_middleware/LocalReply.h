@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#pragma once
+
+#include <unity/scopes/internal/zmq_middleware/ZmqReply.h>
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace zmq_middleware
+{
+
+// Reply proxy for a reply object in the same process. push(), finished(), and info() hand the
+// data directly to the reply object, on the local reply pool of the middleware that hosts it.
+// That pool has a single thread, so the reply object sees the messages in order, just as it would
+// if they arrived via its (single-threaded) reply adapter. If the reply object no longer exists,
+// the calls fall back to ZmqReply.
+
+class LocalReply final : public ZmqReply
+{
+public:
+    LocalReply(ZmqMiddleware* mw_base,
+               std::string const& endpoint,
+               std::string const& identity,
+               std::string const& category);
+    virtual ~LocalReply();
+
+    virtual void push(VariantMap const& result) override;
+    virtual void finished(CompletionDetails const& details) override;
+    virtual void info(OperationInfo const& op_info) override;
+
+private:
+    template<typename F>
+    bool invoke_local_(F f);
+};
+
+// Returns a LocalReply if the reply object is hosted in this process, and a ZmqReply otherwise.
+ZmqReplyProxy make_reply_proxy(ZmqMiddleware* mw_base,
+                               std::string const& endpoint,
+                               std::string const& identity,
+                               std::string const& category);
+
+} // namespace zmq_middleware
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#pragma once
+
+#include <unity/scopes/internal/Metrics.h>
+#include <unity/scopes/internal/zmq_middleware/StopPublisher.h>
+
+#include <zmqpp/context.hpp>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace zmq_middleware
+{
+
+// Serves the contents of a metrics registry on a reply socket.
+// Each request (whatever its contents) receives a single-part reply
+// with the output of MetricsRegistry::to_string().
+// The constructor throws MiddlewareException if the endpoint cannot be bound.
+
+class MetricsEndpoint final
+{
+public:
+    NONCOPYABLE(MetricsEndpoint);
+    UNITY_DEFINES_PTRS(MetricsEndpoint);
+
+    MetricsEndpoint(zmqpp::context* context, std::string const& endpoint, MetricsRegistry const& metrics);
+    ~MetricsEndpoint();
+
+    std::string endpoint() const;
+
+private:
+    void endpoint_thread();
+
+    enum ThreadState { NotRunning, Running, Failed };
+
+    zmqpp::context* const context_;
+    std::string const endpoint_;
+    MetricsRegistry const& metrics_;
+    StopPublisher stopper_;
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    ThreadState thread_state_;
+    std::exception_ptr thread_exception_;
+};
+
+} // namespace zmq_middleware
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
@@ -19,6 +19,8 @@
 #pragma once
 
 #include <unity/scopes/internal/Logger.h>
+#include <unity/scopes/internal/Profiling.h>
+#include <unity/scopes/internal/ThreadPool.h>
 #include <unity/scopes/internal/zmq_middleware/Current.h>
 #include <unity/scopes/internal/zmq_middleware/ZmqObjectProxy.h>
 #include <unity/scopes/ScopeExceptions.h>
@@ -26,6 +28,8 @@
 
 #include <zmqpp/socket.hpp>
 
+#include <array>
+#include <atomic>
 #include <future>
 #include <memory>
 #include <mutex>
@@ -75,6 +79,17 @@ public:
     void remove_dflt_servant(std::string const& category);
     std::shared_ptr<ServantBase> find_dflt_servant(std::string const& id) const;
 
+    // Called for requests that are dispatched directly to a servant of this adapter
+    // by a proxy in the same process, so such requests count as activity for the idle timeout.
+    void note_activity() noexcept;
+
+    // Runs f for a proxy in the same process that calls a servant of this adapter directly. f runs on a
+    // thread of the adapter, and no more than pool_size requests (direct or via zmq) are dispatched
+    // at a time, so servants see the same concurrency as for requests that arrive via zmq.
+    // Throws MiddlewareException if the adapter is not active.
+    template<typename F>
+    std::future<typename std::result_of<F()>::type> invoke_local(F f);
+
     void activate();
     void shutdown();
     void wait_for_shutdown();
@@ -93,6 +108,7 @@ private:
     // a fatal error condition.
     enum AdapterState { Inactive, Activating, Active, Deactivating, Destroyed, Failed };
     void throw_bad_state(std::string const& label, AdapterState state) const;
+    void throw_if_destroyed(std::string const& label) const;
 
     void run_workers();
 
@@ -104,6 +120,10 @@ private:
 
     void dispatch(zmqpp::socket& s, std::string const& client_address);
 
+    ThreadPool* local_invoker();
+    void acquire_dispatch_slot();
+    void release_dispatch_slot() noexcept;
+
     void cleanup();
     void join_with_all_threads();
 
@@ -120,26 +140,64 @@ private:
     RequestMode mode_;
     int pool_size_;
     int64_t idle_timeout_;
+    std::atomic_bool local_activity_;           // Set by note_activity(), cleared by the pump
+    std::unique_ptr<ThreadPool> local_invoker_; // Runs invoke_local() tasks, created on first use
+    int busy_dispatchers_;                      // Requests being dispatched to a servant, at most pool_size_
+    std::condition_variable dispatch_slot_freed_;
+    std::mutex dispatch_mutex_;                 // Protects busy_dispatchers_
     std::unique_ptr<StopPublisher> stopper_;    // Used to signal threads when it's time to terminate
     std::thread pump_;                          // Load-balancing pump: router-router or pull-router
     std::vector<std::thread> workers_;          // Threads for incoming invocations
     std::exception_ptr exception_;              // Failed threads deposit their exception here
     std::once_flag once_;
 
-    AdapterState state_;
+    std::atomic<AdapterState> state_;           // Modified only with state_mutex_ held; read without lock by find()
     std::condition_variable state_changed_;
     mutable std::mutex state_mutex_;
 
-    // Map of object identity and servant pairs
+    // Map of object identity and servant pairs. Every incoming request looks up its servant, and
+    // servants for queries, query ctrls, and replies are added and removed all the time. To keep
+    // the dispatch threads from contending with each other and with add() and remove(), the
+    // servants are spread over a number of shards, each with its own lock.
     typedef std::unordered_map<std::string, std::shared_ptr<ServantBase>> ServantMap;
-    ServantMap servants_;
+    struct ServantShard
+    {
+        ServantShard() : mutex(ProfiledMutex::Adapter) {}
+        ServantMap servants;
+        mutable ProfiledMutex mutex;
+    };
+    static constexpr size_t num_servant_shards = 16;
+    ServantShard& shard(std::string const& id) const;
+    mutable std::array<ServantShard, num_servant_shards> servant_shards_;
+
     ServantMap dflt_servants_;
-    mutable std::mutex map_mutex_;
+    mutable ProfiledMutex map_mutex_;           // Protects dflt_servants_
 
     // Dummy logger for testing
     std::unique_ptr<unity::scopes::internal::Logger> test_logger_;
 };
 
+template<typename F>
+std::future<typename std::result_of<F()>::type> ObjectAdapter::invoke_local(F f)
+{
+    note_activity();
+    return local_invoker()->submit([this, f]
+    {
+        acquire_dispatch_slot();
+        try
+        {
+            auto r = f();
+            release_dispatch_slot();
+            return r;
+        }
+        catch (...)
+        {
+            release_dispatch_slot();
+            throw;
+        }
+    });
+}
+
 } // namespace zmq_middleware
 
 } // namespace internal
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#pragma once
+
+#include <unity/util/DefinesPtrs.h>
+#include <unity/util/NonCopyable.h>
+
+#include <cstdint>
+#include <string>
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace zmq_middleware
+{
+
+// Cross-process wake-up signal for the consumer of one or more ShmRings, kept in its own
+// shared memory segment. Producers call ring() after writing to a ShmRing. The consumer
+// calls sequence() before checking its rings and, if they are all empty, wait() with the
+// value it obtained. wait() returns immediately if ring() was called in the mean time,
+// so no wake-up is lost.
+//
+// We use a futex on a word in shared memory rather than an eventfd because an eventfd
+// cannot be opened by name. ring() makes a system call only while the consumer is asleep.
+
+class ShmDoorbell final
+{
+public:
+    NONCOPYABLE(ShmDoorbell);
+    UNITY_DEFINES_PTRS(ShmDoorbell);
+
+    // Creates a new segment with the given name. The segment is unlinked when the ShmDoorbell is destroyed.
+    static SPtr create(std::string const& name);
+
+    // Opens an existing segment. Throws if the segment does not exist or is not a valid doorbell.
+    static SPtr open(std::string const& name);
+
+    ~ShmDoorbell();
+
+    std::string name() const;
+
+    // Producer side.
+    void ring() noexcept;
+
+    // Consumer side.
+    uint32_t sequence() const noexcept;
+    void wait(uint32_t seen_sequence, int64_t timeout_ms) noexcept;
+
+    // Returns the segment name of the doorbell for the reply adapter with the given endpoint.
+    static std::string doorbell_name(std::string const& endpoint);
+
+private:
+    struct Header;
+
+    ShmDoorbell(std::string const& name, int fd, bool owner);
+
+    std::string name_;
+    bool owner_;
+    Header* header_;
+};
+
+} // namespace zmq_middleware
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#pragma once
+
+#include <unity/scopes/internal/Logger.h>
+#include <unity/scopes/internal/zmq_middleware/ShmDoorbell.h>
+#include <unity/scopes/internal/zmq_middleware/ShmRing.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace zmq_middleware
+{
+
+class ServantBase;
+
+// Client-side receiver for reply messages that arrive via shared memory instead of the reply adapter.
+//
+// For each reply servant added, the dispatcher creates a ShmRing that a scope on the same host can
+// open by name (derived from the reply adapter endpoint and the servant identity). A single thread
+// waits on the doorbell for the reply adapter, reads messages in place from the rings, and dispatches
+// them to the servants, exactly as the reply adapter would for messages that arrive via zmq.
+//
+// The servant remains registered with the reply adapter, so scopes that do not support shared
+// memory (or cannot open the ring) continue to reach it via zmq.
+
+class ShmReplyDispatcher final
+{
+public:
+    NONCOPYABLE(ShmReplyDispatcher);
+    UNITY_DEFINES_PTRS(ShmReplyDispatcher);
+
+    ShmReplyDispatcher(std::string const& endpoint, unity::scopes::internal::Logger& logger);
+    ~ShmReplyDispatcher();
+
+    void add(std::string const& id, std::shared_ptr<ServantBase> const& servant);
+    void remove(std::string const& id) noexcept;
+
+    void shutdown() noexcept;
+
+private:
+    struct Entry
+    {
+        ShmRing::SPtr ring;
+        std::shared_ptr<ServantBase> servant;
+    };
+
+    void run();
+    void dispatch(std::string const& id, Entry const& entry, kj::ArrayPtr<capnp::word const> message);
+
+    std::string const endpoint_;
+    unity::scopes::internal::Logger& logger_;
+    ShmDoorbell::SPtr doorbell_;
+    std::map<std::string, std::shared_ptr<Entry>> entries_;
+    bool done_;
+    std::mutex mutex_;
+    std::thread thread_;
+};
+
+} // namespace zmq_middleware
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
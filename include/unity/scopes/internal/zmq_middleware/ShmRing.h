@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#pragma once
+
+#include <unity/util/DefinesPtrs.h>
+#include <unity/util/NonCopyable.h>
+
+#include <capnp/common.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace zmq_middleware
+{
+
+// Single-producer/single-consumer ring buffer of Cap'n Proto messages in a POSIX shared memory segment.
+// Used to deliver oneway reply messages (push(), finished(), info()) from a scope to a client on the
+// same host without going through a socket.
+//
+// The consumer (the client that owns the reply object) creates the segment; the producer (the scope)
+// opens it by name. Each message is written into the ring once, in Cap'n Proto flat array format,
+// and the consumer reads it in place. The consumer advances the read position only after it has
+// finished with a message, so the producer cannot overwrite a message that is still being dispatched.
+//
+// Messages larger than max_message_size() do not fit and must be sent some other way.
+//
+// A ShmRing does not signal the consumer when a message arrives; that is done by ShmDoorbell.
+
+class ShmRing final
+{
+public:
+    NONCOPYABLE(ShmRing);
+    UNITY_DEFINES_PTRS(ShmRing);
+
+    // Creates a new segment with the given name. The segment is unlinked when the ShmRing is destroyed.
+    static SPtr create(std::string const& name, std::size_t capacity = default_capacity);
+
+    // Opens an existing segment. Throws if the segment does not exist or is not a valid ring.
+    static SPtr open(std::string const& name);
+
+    ~ShmRing();
+
+    std::string name() const;
+    std::size_t max_message_size() const noexcept;
+
+    // Producer side. Writes the message into the ring, waiting for up to timeout_ms
+    // milliseconds for space to become available (-1 waits indefinitely).
+    // Returns false if the message was not written because the consumer has closed
+    // the ring, the timeout expired, or the message is larger than max_message_size().
+    bool write(kj::ArrayPtr<kj::ArrayPtr<capnp::word const> const> segments, int64_t timeout_ms);
+
+    // Producer side. Waits until the consumer has dispatched all messages in the ring,
+    // or the consumer has closed the ring. Returns false if the timeout expired.
+    bool wait_until_empty(int64_t timeout_ms) const;
+
+    // Consumer side. If a message is available, calls func with the message and returns true.
+    // The memory passed to func is valid only for the duration of the call.
+    bool read(std::function<void(kj::ArrayPtr<capnp::word const>)> const& func);
+
+    // Consumer side. Once closed, all further writes fail.
+    void close() noexcept;
+    bool closed() const noexcept;
+
+    // Returns the segment name of the ring for the reply object with the given endpoint and identity.
+    static std::string ring_name(std::string const& endpoint, std::string const& identity);
+
+    static constexpr std::size_t default_capacity = 256 * 1024;
+
+private:
+    struct Header;
+
+    ShmRing(std::string const& name, int fd, bool owner);
+
+    std::string name_;
+    bool owner_;
+    std::size_t size_;         // Size of the mapping in bytes
+    std::size_t capacity_;     // Size of the data area, validated once; never re-read from the segment
+    void* addr_;
+    Header* header_;
+    char* data_;
+};
+
+} // namespace zmq_middleware
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
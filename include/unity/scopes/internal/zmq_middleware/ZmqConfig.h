@@ -42,6 +42,8 @@ public:
     int child_scopes_timeout() const;
     std::string registry_endpoint_dir() const;
     std::string ss_registry_endpoint_dir() const;
+    bool shm_replies() const;
+    bool metrics_endpoint() const;
 
 private:
     std::string endpoint_dir_;
@@ -51,6 +53,8 @@ private:
     int child_scopes_timeout_;
     std::string registry_endpoint_dir_;
     std::string ss_registry_endpoint_dir_;
+    bool shm_replies_;
+    bool metrics_endpoint_;
 };
 
 } // namespace internal
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <unity/scopes/internal/Logger.h>
+#include <unity/scopes/internal/Metrics.h>
 #include <unity/scopes/internal/MiddlewareBase.h>
 #include <unity/scopes/internal/MWRegistryProxyFwd.h>
 #include <unity/scopes/internal/MWReplyProxyFwd.h>
@@ -46,8 +47,10 @@ class RuntimeImpl;
 namespace zmq_middleware
 {
 
+class MetricsEndpoint;
 class ObjectAdapter;
 class ServantBase;
+class ShmReplyDispatcher;
 
 class ZmqMiddleware final : public MiddlewareBase
 {
@@ -90,11 +93,21 @@ public:
     virtual std::string get_query_ctrl_endpoint() override;
 
     zmqpp::context* context() const noexcept;
+    MetricsRegistry& metrics() const noexcept;
+
+    // Metrics for invocations. The metrics for the twoway operations of the scopes API
+    // are looked up only once, so these don't lock the registry on the invocation path.
+    MetricsRegistry::Histogram& twoway_latency(char const* op_name);
+    MetricsRegistry::Counter& twoway_timeouts(char const* op_name);
+    MetricsRegistry::Counter& oneway_send_failures() const noexcept;
     ThreadPool* oneway_pool();
     ThreadPool* twoway_pool();
+    ThreadPool* local_reply_pool();
+    ThreadPool* local_query_pool();
     int64_t locate_timeout() const noexcept;
     int64_t registry_timeout() const noexcept;
     int64_t child_scopes_timeout() const noexcept;
+    bool shm_replies() const noexcept;
 
 private:
     ObjectProxy make_typed_proxy(std::string const& endpoint,
@@ -111,6 +124,16 @@ private:
                       std::string const& identity,
                       std::shared_ptr<ServantBase> const& servant);
 
+    void add_local(std::function<void()>& disconnect_func,
+                   std::shared_ptr<ObjectAdapter> const& adapter,
+                   ZmqProxy const& proxy,
+                   std::shared_ptr<AbstractObject> const& object);
+
+    void add_shm_reply(std::function<void()>& disconnect_func,
+                       std::string const& endpoint,
+                       std::string const& identity,
+                       std::shared_ptr<ServantBase> const& servant);
+
     std::function<void()> safe_dflt_add(std::shared_ptr<ObjectAdapter> const& adapter,
                                         std::string const& category,
                                         std::shared_ptr<ServantBase> const& servant);
@@ -124,8 +147,12 @@ private:
     AdapterMap am_;
     std::unique_ptr<ThreadPool> oneway_invoker_;
     std::unique_ptr<ThreadPool> twoway_invokers_;
+    std::unique_ptr<ThreadPool> local_reply_invoker_;
+    std::unique_ptr<ThreadPool> local_query_invoker_;
+    std::shared_ptr<ShmReplyDispatcher> shm_reply_dispatcher_;
+    std::unique_ptr<MetricsEndpoint> metrics_endpoint_;
 
-    mutable std::mutex data_mutex_;             // Protects am_ and the invokers
+    mutable std::mutex data_mutex_;             // Protects am_, invokers, shm_reply_dispatcher_, metrics_endpoint_
 
     UniqueID unique_id_;
 
@@ -136,11 +163,23 @@ private:
     std::atomic_bool shutdown_flag_;
     std::unique_ptr<unity::scopes::internal::Logger> test_logger_;
     unity::scopes::internal::Logger& logger_;
+    MetricsRegistry::UPtr test_metrics_;
+    MetricsRegistry& metrics_;
+
+    struct OpMetrics
+    {
+        std::atomic<MetricsRegistry::Histogram*> latency;
+        std::atomic<MetricsRegistry::Counter*> timeouts;
+    };
+    std::unique_ptr<OpMetrics[]> op_metrics_;   // Indexed like twoway_op_names in ZmqMiddleware.cpp
+    MetricsRegistry::Counter& oneway_send_failures_;
 
     int64_t twoway_timeout_;                    // Default timeout for twoway invocations
     int64_t locate_timeout_;                    // Timeout for registry locate()
     int64_t registry_timeout_;                  // Timeout for registry operations other than locate()
     int64_t child_scopes_timeout_;              // Timeout for child_scopes() and set_child_scopes() methods
+    std::atomic_bool shm_replies_;              // Deliver replies via shared memory where possible
+    bool serve_metrics_;                        // Serve the run time's metrics on a metrics endpoint
 
     std::string public_endpoint_dir_;
     std::string private_endpoint_dir_;
@@ -73,6 +73,7 @@ protected:
     capnproto::Request::Builder make_request_(capnp::MessageBuilder& b, std::string const& operation_name) const;
 
     void invoke_oneway_(capnp::MessageBuilder& in_params);
+    void trace_request_(capnp::MessageBuilder& request);
 
     // Holds both the receiver for the unmarshaling buffer (which allocates memory)
     // and the reader that decodes the memory from the unmarshaling buffer.
@@ -100,7 +101,6 @@ private:
     TwowayOutParams invoke_twoway__(capnp::MessageBuilder& request, int64_t timeout);
 
     std::string decode_request_(capnp::MessageBuilder& request);
-    void trace_request_(capnp::MessageBuilder& request);
 
     std::string decode_reply_(capnp::MessageBuilder& request, capnp::MessageReader& reply);
     void trace_reply_(capnp::MessageBuilder& request, capnp::MessageReader& reply);
@@ -18,10 +18,15 @@
 
 #pragma once
 
+#include <unity/scopes/internal/zmq_middleware/ShmDoorbell.h>
+#include <unity/scopes/internal/zmq_middleware/ShmRing.h>
 #include <unity/scopes/internal/zmq_middleware/ZmqObjectProxy.h>
 #include <unity/scopes/internal/zmq_middleware/ZmqReplyProxyFwd.h>
 #include <unity/scopes/internal/MWReply.h>
 
+#include <atomic>
+#include <mutex>
+
 namespace unity
 {
 
@@ -46,6 +51,19 @@ public:
     virtual void push(VariantMap const& result) override;
     virtual void finished(CompletionDetails const& details) override;
     virtual void info(OperationInfo const& op_info) override;
+
+private:
+    bool invoke_shm_(capnp::MessageBuilder& request);
+
+    // Whether the reply is delivered via shared memory. Once a message has been sent via zmq,
+    // we never go back to shared memory, so the client sees messages in the order they were sent.
+    enum ShmState { Untried, Active, Unavailable };
+    ShmState shm_state_;
+    ShmRing::SPtr shm_ring_;
+    ShmDoorbell::SPtr shm_doorbell_;
+    std::mutex shm_mutex_;
+
+    std::atomic<int64_t> bytes_pushed_;     // Marshaled size of the replies, for CompletionDetails::metrics()
 };
 
 } // namespace zmq_middleware
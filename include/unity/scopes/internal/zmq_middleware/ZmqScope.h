@@ -20,8 +20,12 @@
 
 #include <unity/scopes/internal/zmq_middleware/ZmqObjectProxy.h>
 #include <unity/scopes/internal/zmq_middleware/ZmqScopeProxyFwd.h>
+#include <unity/scopes/internal/InvokeInfo.h>
+#include <unity/scopes/internal/MWQueryCtrlProxyFwd.h>
 #include <unity/scopes/internal/MWScope.h>
 
+#include <functional>
+
 namespace unity
 {
 
@@ -31,6 +35,8 @@ namespace scopes
 namespace internal
 {
 
+class ScopeObjectBase;
+
 namespace zmq_middleware
 {
 
@@ -74,6 +80,12 @@ public:
                                                   MWReplyProxy const& reply) override;
 
 private:
+    typedef std::function<MWQueryCtrlProxy(ScopeObjectBase&, MWReplyProxy const&, InvokeInfo const&)> LocalQueryFunc;
+    QueryCtrlProxy invoke_local_(std::string const& op_name,
+                                 MWReplyProxy const& reply,
+                                 LocalQueryFunc const& create_query,
+                                 bool& dispatched);
+
     ZmqObjectProxy::TwowayOutParams invoke_scope_(capnp::MessageBuilder& in_params);
     ZmqObjectProxy::TwowayOutParams invoke_scope_(capnp::MessageBuilder& in_params, int64_t timeout);
     std::mutex debug_mode_mutex_;
@@ -124,6 +124,14 @@ public:
                     double std_dev,
                     double alpha = 0.05) const;
 
+            /**
+             * \brief Computes a percentile of the raw sample, using the nearest-rank method.
+             * \throw std::logic_error if the sample is empty or p is not in the range (0, 100].
+             * \param p The percentile, for example 50 for the median or 99.9.
+             * \return The smallest observation that is not less than p percent of the sample.
+             */
+            Seconds percentile(double p) const;
+
             /** Minimum execution time for the benchmarked operation. */
             Seconds min{Seconds::min()};
             /** Maximum execution time for the benchmarked operation. */
@@ -169,6 +177,20 @@ public:
          * \param out The stream to write to.
          */
         void save_to_xml(std::ostream& out);
+
+        /**
+         * \brief load_from_json restores a result stored as json from the given input stream.
+         * \throw std::runtime_error in case of issues.
+         * \param in The stream to read from.
+         */
+        void load_from_json(std::istream& in);
+
+        /**
+         * \brief save_to_json stores a result as json to the given output stream.
+         * \throw std::runtime_error in case of issues.
+         * \param out The stream to write to.
+         */
+        void save_to_json(std::ostream& out);
     };
 
     /**
@@ -287,6 +309,81 @@ public:
         TrialConfiguration trial_configuration;
     };
 
+    /**
+     * \brief The LoadConfiguration struct contains all options controlling the
+     * benchmark of a scope's query performance under concurrent load.
+     *
+     * trial_configuration.trial_count sets the total number of queries, and
+     * trial_configuration.per_trial_timeout sets how long to wait for each query to finish.
+     */
+    struct LoadConfiguration
+    {
+        /** How queries are started. */
+        enum class Mode
+        {
+            /** A fixed number of workers each run one query after another. */
+            closed_loop,
+            /**
+             * Queries are scheduled to start at a fixed rate, regardless of how many are still running.
+             * They are run by a fixed number of workers; a query that is due while all workers are
+             * busy starts late, and the delay counts towards its latency.
+             */
+            open_loop
+        };
+
+        /**
+         * The sampling function instance for choosing a query configuration.
+         * Has to be set to an actual instance. It may be called from several threads at once.
+         */
+        QueryConfiguration::Sampler sampler{};
+        /** The way in which queries are started. */
+        Mode mode{Mode::closed_loop};
+        /** Number of workers, that is, the maximum number of queries that run at the same time. */
+        std::size_t concurrency{1};
+        /** Number of queries started per second in open_loop mode. */
+        double target_qps{10};
+        /** fold in trial configuration options into the overall setup. */
+        TrialConfiguration trial_configuration{};
+    };
+
+    /**
+     * \brief The LoadResult struct encapsulates all of the result gathered from one
+     * benchmark run under concurrent load (see InProcessBenchmark::for_query_load()).
+     */
+    struct LoadResult
+    {
+        /**
+         * Time from the start of each query until it finished.
+         * Queries that time out are not part of the sample.
+         */
+        Result finished{};
+        /**
+         * Time from the start of each query until its first result arrived.
+         * Queries that push no results are not part of the sample.
+         */
+        Result first_result{};
+        /** Number of queries that finished per second of wall-clock time. */
+        double queries_per_second{0};
+        /** Number of results received per second of wall-clock time. */
+        double results_per_second{0};
+        /** Number of queries that did not finish within the per-trial timeout. */
+        std::size_t timeouts{0};
+
+        /**
+         * \brief load_from_json restores a result stored as json from the given input stream.
+         * \throw std::runtime_error in case of issues.
+         * \param in The stream to read from.
+         */
+        void load_from_json(std::istream& in);
+
+        /**
+         * \brief save_to_json stores a result as json to the given output stream.
+         * \throw std::runtime_error in case of issues.
+         * \param out The stream to write to.
+         */
+        void save_to_json(std::ostream& out);
+    };
+
     /** \cond */
     virtual ~Benchmark() = default;
     Benchmark(const Benchmark&) = delete;
@@ -346,6 +443,8 @@ protected:
 
 bool operator==(const Benchmark::Result& lhs, const Benchmark::Result& rhs);
 
+bool operator==(const Benchmark::LoadResult& lhs, const Benchmark::LoadResult& rhs);
+
 std::ostream& operator<<(std::ostream&, const Benchmark::Result&);
 
 } // namespace testing
@@ -67,6 +67,22 @@ public:
 
     virtual Result for_action(const std::shared_ptr<unity::scopes::ScopeBase>& scope,
                               ActionConfiguration activation_configuration) override;
+
+    /**
+     * \brief for_query_load executes a benchmark to measure the scope's query performance
+     * while several queries run concurrently.
+     *
+     * The start of a query is the time at which it was scheduled to start (in open_loop mode)
+     * or at which a worker started it (in closed_loop mode), so queries that are delayed by
+     * an overloaded scope are not under-reported.
+     * Queries that time out are counted in LoadResult::timeouts and are not part of the timing samples.
+     * \throw std::logic_error in case of misconfiguration.
+     * \param scope The scope instance to benchmark.
+     * \param load_configuration Options controlling the experiment.
+     * \return An instance of LoadResult.
+     */
+    LoadResult for_query_load(const std::shared_ptr<unity::scopes::ScopeBase>& scope,
+                              LoadConfiguration load_configuration);
 };
 
 } // namespace testing
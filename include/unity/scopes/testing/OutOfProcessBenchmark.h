@@ -73,6 +73,15 @@ public:
 
     Result for_action(const std::shared_ptr<unity::scopes::ScopeBase>& scope,
                       ActionConfiguration activation_configuration) override;
+
+    /**
+     * \brief for_query_load executes InProcessBenchmark::for_query_load() in another process.
+     *
+     * Note that for_query_load() is not virtual: calling it through a reference to
+     * an InProcessBenchmark runs the benchmark in the calling process.
+     */
+    LoadResult for_query_load(const std::shared_ptr<unity::scopes::ScopeBase>& scope,
+                              LoadConfiguration load_configuration);
 };
 
 } // namespace testing
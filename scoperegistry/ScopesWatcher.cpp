@@ -25,6 +25,8 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
+
 #include <sys/stat.h>
 
 using namespace unity::scopes::internal;
@@ -35,17 +37,32 @@ namespace scoperegistry
 
 ScopesWatcher::ScopesWatcher(RegistryObject::SPtr registry,
                              std::function<void(std::pair<std::string, std::string> const&)> ini_added_callback,
-                             Logger& logger)
+                             Logger& logger,
+                             std::chrono::milliseconds batch_window)
     : DirWatcher(logger)
     , registry_(registry)
     , ini_added_callback_(ini_added_callback)
     , logger_(logger)
+    , batch_window_(batch_window)
+    , max_batch_delay_(batch_window * 10)
+    , suppressed_events_(0)
+    , batch_done_(false)
 {
+    batch_thread_ = std::thread(&ScopesWatcher::batch_thread, this);
 }
 
 ScopesWatcher::~ScopesWatcher()
 {
     cleanup();
+
+    // No more events can arrive now. Changes that are still pending are discarded,
+    // because the registry is shutting down.
+    {
+        std::lock_guard<std::mutex> lock(batch_mutex_);
+        batch_done_ = true;
+    }
+    batch_cond_.notify_all();
+    batch_thread_.join();
 }
 
 void ScopesWatcher::add_install_dir(std::string const& dir)
@@ -109,6 +126,11 @@ void ScopesWatcher::add_install_dir(std::string const& dir)
     }
 }
 
+int64_t ScopesWatcher::suppressed_events() const
+{
+    return suppressed_events_;
+}
+
 std::string ScopesWatcher::parent_dir(std::string const& child_dir)
 {
     std::string parent;
@@ -194,10 +216,8 @@ void ScopesWatcher::add_scope_dir(std::string const& dir)
                 sdir_to_ini_map_[dir] = config.second;
             }
 
-            // New config found, execute callback
-            ini_added_callback_(config);
-            logger_(LoggerSeverity::Info) << "ScopesWatcher: scope: \"" << config.first
-                                          << "\" installed to: \"" << dir << "\"";
+            // New config found, schedule the callback
+            queue_change(dir, PendingChange{PendingChange::Install, config.first, config.second});
         }
     }
     catch (std::exception const& e)
@@ -223,18 +243,155 @@ void ScopesWatcher::remove_scope_dir(std::string const& dir)
         std::string ini_path = sdir_to_ini_map_.at(dir);
         sdir_to_ini_map_.erase(dir);
 
-        // Inform the registry that this scope has been removed
+        // Schedule informing the registry that this scope has been removed
         filesystem::path p(ini_path);
         std::string scope_id = p.stem().native();
-        registry_->remove_local_scope(scope_id);
-        logger_(LoggerSeverity::Info) << "ScopesWatcher: scope: \"" << scope_id
-                                      << "\" uninstalled from: \"" << dir << "\"";
+        queue_change(dir, PendingChange{PendingChange::Uninstall, scope_id, ini_path});
     }
 
     // Remove the watch for this directory
     remove_watch(dir);
 }
 
+void ScopesWatcher::queue_change(std::string const& scope_dir, PendingChange change)
+{
+    {
+        std::lock_guard<std::mutex> lock(batch_mutex_);
+
+        auto const now = std::chrono::steady_clock::now();
+        if (pending_changes_.empty())
+        {
+            batch_start_ = now;
+        }
+        last_event_ = now;
+
+        // Only the most recent change for a scope matters. Because add_local_scope() replaces
+        // an existing entry and remove_local_scope() ignores unknown scopes, applying just the
+        // last change for a scope id gives the same end result as applying all of them in sequence.
+        // Changes are keyed by scope id as well as directory, so if a directory's .ini file is
+        // replaced by one with a different name, the old scope is still removed.
+        auto key = std::make_pair(scope_dir, change.scope_id);
+        auto it = pending_changes_.find(key);
+        if (it != pending_changes_.end())
+        {
+            it->second = std::move(change);
+            ++suppressed_events_;
+        }
+        else
+        {
+            pending_changes_.emplace(std::move(key), std::move(change));
+        }
+    }
+    batch_cond_.notify_all();
+}
+
+void ScopesWatcher::batch_thread()
+{
+    std::unique_lock<std::mutex> lock(batch_mutex_);
+    while (true)
+    {
+        batch_cond_.wait(lock, [this]{ return batch_done_ || !pending_changes_.empty(); });
+        if (batch_done_)
+        {
+            return;
+        }
+
+        // Wait until the directories have been quiet for batch_window_, but no longer
+        // than max_batch_delay_ after the first change in this batch.
+        auto deadline = std::min(last_event_ + batch_window_, batch_start_ + max_batch_delay_);
+        while (!batch_done_ && std::chrono::steady_clock::now() < deadline)
+        {
+            batch_cond_.wait_until(lock, deadline);
+            deadline = std::min(last_event_ + batch_window_, batch_start_ + max_batch_delay_);
+        }
+        if (batch_done_)
+        {
+            return;
+        }
+
+        PendingChanges changes;
+        changes.swap(pending_changes_);
+
+        lock.unlock();
+        apply_changes(changes);
+        lock.lock();
+    }
+}
+
+namespace
+{
+
+// Ends the registry update batch even if applying a change throws.
+
+class UpdateBatch
+{
+public:
+    UpdateBatch(RegistryObject& registry, Logger& logger)
+        : registry_(registry)
+        , logger_(logger)
+    {
+        registry_.begin_update_batch();
+    }
+
+    ~UpdateBatch()
+    {
+        try
+        {
+            registry_.end_update_batch();
+        }
+        catch (std::exception const& e)
+        {
+            logger_() << "ScopesWatcher: cannot end registry update batch: " << e.what();
+        }
+        catch (...)
+        {
+            logger_() << "ScopesWatcher: cannot end registry update batch: unknown exception";
+        }
+    }
+
+private:
+    RegistryObject& registry_;
+    Logger& logger_;
+};
+
+}
+
+void ScopesWatcher::apply_changes(PendingChanges const& changes)
+{
+    UpdateBatch batch(*registry_, logger_);
+    for (auto const& c : changes)
+    {
+        auto const& scope_dir = c.first.first;
+        auto const& change = c.second;
+        try
+        {
+            if (change.type == PendingChange::Install)
+            {
+                ini_added_callback_(std::make_pair(change.scope_id, change.ini_path));
+                logger_(LoggerSeverity::Info) << "ScopesWatcher: scope: \"" << change.scope_id
+                                              << "\" installed to: \"" << scope_dir << "\"";
+            }
+            else
+            {
+                registry_->remove_local_scope(change.scope_id);
+                logger_(LoggerSeverity::Info) << "ScopesWatcher: scope: \"" << change.scope_id
+                                              << "\" uninstalled from: \"" << scope_dir << "\"";
+            }
+        }
+        catch (std::exception const& e)
+        {
+            logger_() << "ScopesWatcher::apply_changes(): scope: \"" << change.scope_id << "\": " << e.what();
+        }
+        catch (...)
+        {
+            logger_() << "ScopesWatcher::apply_changes(): scope: \"" << change.scope_id << "\": unknown exception";
+        }
+    }
+
+    logger_(LoggerSeverity::Info) << "ScopesWatcher: applied " << changes.size() << " scope change(s), "
+                                  << suppressed_events_.load() << " superseded change(s) suppressed so far";
+}
+
 void ScopesWatcher::watch_event(DirWatcher::EventType event_type,
                                 DirWatcher::FileType file_type,
                                 std::string const& path)
@@ -272,18 +429,14 @@ void ScopesWatcher::watch_event(DirWatcher::EventType event_type,
             if (non_empty)
             {
                 sdir_to_ini_map_[parent_path] = path;
-                ini_added_callback_(std::make_pair(scope_id, path));
-                logger_(LoggerSeverity::Info) << "scopeswatcher: scope: \"" << scope_id
-                                              << "\" .ini installed: \"" << path << "\"";
+                queue_change(parent_path, PendingChange{PendingChange::Install, scope_id, path});
             }
         }
         // a .ini has been removed
         else if (event_type == DirWatcher::Removed)
         {
             sdir_to_ini_map_.erase(parent_path);
-            registry_->remove_local_scope(scope_id);
-            logger_(LoggerSeverity::Info) << "scopeswatcher: scope: \"" << scope_id
-                                          << "\" .ini uninstalled: \"" << path << "\"";
+            queue_change(parent_path, PendingChange{PendingChange::Uninstall, scope_id, path});
         }
     }
     else
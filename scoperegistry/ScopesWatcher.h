@@ -22,25 +22,56 @@
 
 #include <unity/scopes/internal/RegistryObject.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <set>
+
 namespace scoperegistry
 {
 
 // ScopesWatcher watches the scope install directories specified by calls to add_install_dir() for
 // the installation / uninstallation of scopes. If a scope is removed, the registry is informed
 // accordingly. If a scope is added, a user callback (provided on construction) is executed.
+//
+// Installing or removing a package typically produces a burst of inotify events for the same
+// scope directory. Rather than acting on each event, ScopesWatcher records the net change per
+// scope (scope directory and scope id) and applies the accumulated changes once no further events have arrived for
+// batch_window (or after at most max_batch_delay, so a steady stream of events cannot starve the
+// registry). All changes in a batch are applied inside a single registry update batch, so the
+// registry publishes one update notification per batch.
 
 class ScopesWatcher : public DirWatcher
 {
 public:
     ScopesWatcher(unity::scopes::internal::RegistryObject::SPtr registry,
                   std::function<void(std::pair<std::string, std::string> const&)> ini_added_callback,
-                  unity::scopes::internal::Logger& logger);
+                  unity::scopes::internal::Logger& logger,
+                  std::chrono::milliseconds batch_window = std::chrono::milliseconds(200));
 
     ~ScopesWatcher();
 
     void add_install_dir(std::string const& dir);
 
+    // Number of scope changes that were superseded by a later change for the same
+    // scope before the batch they belonged to was applied.
+    int64_t suppressed_events() const;
+
 private:
+    struct PendingChange
+    {
+        enum ChangeType
+        {
+            Install,
+            Uninstall
+        };
+
+        ChangeType type;
+        std::string scope_id;
+        std::string ini_path;
+    };
+    typedef std::map<std::pair<std::string, std::string>, PendingChange> PendingChanges;  // Keyed by scope dir and id
+
     unity::scopes::internal::RegistryObject::SPtr const registry_;
     std::function<void(std::pair<std::string, std::string> const&)> const ini_added_callback_;
     unity::scopes::internal::Logger& logger_;
@@ -48,6 +79,17 @@ private:
     std::map<std::string, std::set<std::string>> idir_to_sdirs_map_;
     std::mutex mutex_;
 
+    std::chrono::milliseconds const batch_window_;
+    std::chrono::milliseconds const max_batch_delay_;
+    PendingChanges pending_changes_;
+    std::chrono::steady_clock::time_point batch_start_;
+    std::chrono::steady_clock::time_point last_event_;
+    std::atomic<int64_t> suppressed_events_;
+    bool batch_done_;
+    std::mutex batch_mutex_;
+    std::condition_variable batch_cond_;
+    std::thread batch_thread_;
+
     static std::string parent_dir(std::string const& child_dir);
 
     void remove_install_dir(std::string const& dir);
@@ -55,6 +97,10 @@ private:
     void add_scope_dir(std::string const& dir);
     void remove_scope_dir(std::string const& dir);
 
+    void queue_change(std::string const& scope_dir, PendingChange change);
+    void batch_thread();
+    void apply_changes(PendingChanges const& changes);
+
     void watch_event(DirWatcher::EventType event_type,
                      DirWatcher::FileType file_type,
                      std::string const& path) override;
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+// Replaces the global operator new so allocations made by a query's run() can be counted
+// when profiling is enabled (see Profiling in CONFIGFILES). This is built as a separate
+// library that must be preloaded, for example:
+//
+//     LD_PRELOAD=/usr/lib/<arch>/unity-scopes/libunity-scopes-counting-new.so scoperunner ...
+//
+// Processes that do not preload the library use the default operator new.
+
+#include <unity/scopes/internal/Profiling.h>
+
+#include <cstdlib>
+#include <new>
+
+using unity::scopes::internal::QueryProfile;
+
+namespace
+{
+
+struct EnableAllocationCounting
+{
+    EnableAllocationCounting()
+    {
+        QueryProfile::enable_allocation_counting();
+    }
+} enable_allocation_counting;
+
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    QueryProfile::count_allocation(size);
+    for (;;)
+    {
+        void* p = std::malloc(size != 0 ? size : 1);
+        if (p)
+        {
+            return p;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+        {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept
+{
+    try
+    {
+        return operator new(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept
+{
+    try
+    {
+        return operator new(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::nothrow_t const&) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::nothrow_t const&) noexcept
+{
+    std::free(p);
+}
@@ -82,6 +82,11 @@ std::vector<OperationInfo> CompletionDetails::info_list() const
     return p->info_list();
 }
 
+VariantMap CompletionDetails::metrics() const
+{
+    return p->metrics();
+}
+
 // Possibly overkill, but safer than using the enum as the index into an array,
 // in case the enumeration is ever added to or the enumerators get re-ordered.
 
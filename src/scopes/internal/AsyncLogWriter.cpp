@@ -0,0 +1,292 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/AsyncLogWriter.h>
+
+#include <unity/scopes/internal/Logger.h>
+#include <unity/UnityExceptions.h>
+
+#include <chrono>
+#include <unordered_map>
+
+using namespace std;
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace
+{
+
+chrono::milliseconds const flush_interval(20);
+
+atomic<uint64_t> next_instance_id(1);
+
+}  // namespace
+
+// Single-producer/single-consumer ring of messages. head_ and tail_ count
+// the messages taken and added so far; slot i % size holds message i.
+
+class AsyncLogWriter::Ring final
+{
+public:
+    NONCOPYABLE(Ring);
+
+    explicit Ring(size_t size)
+        : slots_(size)
+        , head_(0)
+        , tail_(0)
+    {
+    }
+
+    // Called by the producer. Returns the number of messages in the ring, or -1 if the ring is full.
+    int64_t push(string&& msg) noexcept
+    {
+        size_t const t = tail_.load(memory_order_relaxed);
+        size_t const h = head_.load(memory_order_acquire);
+        if (t - h == slots_.size())
+        {
+            return -1;
+        }
+        slots_[t % slots_.size()] = move(msg);
+        tail_.store(t + 1, memory_order_release);
+        return int64_t(t + 1 - h);
+    }
+
+    // Called by the consumer. Appends all messages in the ring to batch.
+    bool pop_all(string& batch)
+    {
+        size_t h = head_.load(memory_order_relaxed);
+        size_t const t = tail_.load(memory_order_acquire);
+        if (h == t)
+        {
+            return false;
+        }
+        for (; h != t; ++h)
+        {
+            string& slot = slots_[h % slots_.size()];
+            batch += slot;
+            slot.clear();
+        }
+        head_.store(t, memory_order_release);
+        return true;
+    }
+
+    size_t size() const noexcept
+    {
+        return slots_.size();
+    }
+
+private:
+    vector<string> slots_;
+    atomic<size_t> head_;
+    atomic<size_t> tail_;
+};
+
+AsyncLogWriter::AsyncLogWriter(ostream& outstream, string const& id, int queue_size)
+    : outstream_(outstream)
+    , id_(id)
+    , queue_size_(queue_size)
+    , instance_id_(next_instance_id++)
+    , dropped_(0)
+    , reported_dropped_(0)
+    , wake_(false)
+    , flush_requests_(0)
+    , flushes_done_(0)
+    , done_(false)
+{
+    if (queue_size < 1)
+    {
+        throw InvalidArgumentException("AsyncLogWriter(): invalid queue size: " + std::to_string(queue_size));
+    }
+    flusher_ = thread(&AsyncLogWriter::flusher_thread, this);
+}
+
+AsyncLogWriter::~AsyncLogWriter()
+{
+    {
+        lock_guard<mutex> lock(mutex_);
+        done_ = true;
+    }
+    cond_.notify_all();
+    flusher_.join();
+}
+
+// Rings are owned jointly by the writer and the thread that writes into them.
+// Each thread finds its ring for a writer in a thread-local map. We cache the most
+// recently used ring, because most threads only ever write to one logger.
+
+AsyncLogWriter::Ring* AsyncLogWriter::ring_for_this_thread() noexcept
+{
+    thread_local uint64_t last_id = 0;
+    thread_local Ring* last_ring = nullptr;
+    thread_local unordered_map<uint64_t, shared_ptr<Ring>> rings;
+
+    if (last_id == instance_id_)
+    {
+        return last_ring;
+    }
+    try
+    {
+        auto& r = rings[instance_id_];
+        if (!r)
+        {
+            r = make_shared<Ring>(queue_size_);
+            lock_guard<mutex> lock(rings_mutex_);
+            rings_.push_back(r);
+        }
+        last_id = instance_id_;
+        last_ring = r.get();
+        return last_ring;
+    }
+    catch (...)
+    {
+        return nullptr;  // LCOV_EXCL_LINE  // Out of memory, caller drops the message.
+    }
+}
+
+void AsyncLogWriter::write(string&& msg) noexcept
+{
+    Ring* r = ring_for_this_thread();
+    int64_t const count = r ? r->push(move(msg)) : -1;
+    if (count == -1)
+    {
+        dropped_.fetch_add(1, memory_order_relaxed);
+    }
+    else if (size_t(count) == r->size() / 2 + 1)
+    {
+        // Ring is filling up, don't wait for the flush interval.
+        wake_.store(true, memory_order_relaxed);
+        cond_.notify_all();
+    }
+}
+
+void AsyncLogWriter::flush() noexcept
+{
+    unique_lock<mutex> lock(mutex_);
+    uint64_t const request = ++flush_requests_;
+    cond_.notify_all();
+    cond_.wait(lock, [this, request] { return flushes_done_ >= request || done_; });
+}
+
+int64_t AsyncLogWriter::dropped() const noexcept
+{
+    return dropped_.load(memory_order_relaxed);
+}
+
+// Appends the contents of all rings to batch. Rings of threads that have
+// finished are removed once they are empty.
+
+bool AsyncLogWriter::drain(string& batch)
+{
+    vector<shared_ptr<Ring>> rings;
+    {
+        lock_guard<mutex> lock(rings_mutex_);
+        rings = rings_;
+    }
+
+    bool found = false;
+    bool abandoned = false;
+    for (auto const& r : rings)
+    {
+        found = r->pop_all(batch) || found;
+        // Two references are ours (rings and rings_). If there are no others, the thread has gone away.
+        abandoned = abandoned || r.use_count() == 2;
+    }
+    if (abandoned)
+    {
+        lock_guard<mutex> lock(rings_mutex_);
+        rings.clear();
+        auto it = rings_.begin();
+        while (it != rings_.end())
+        {
+            if (it->use_count() == 1)
+            {
+                string rest;
+                (*it)->pop_all(rest);
+                batch += rest;
+                found = found || !rest.empty();
+                it = rings_.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    int64_t const dropped = dropped_.load(memory_order_relaxed);
+    if (dropped != reported_dropped_)
+    {
+        batch += "[" + Logger::timestamp() + "] WARNING: " + id_ + ": log queue overflow: "
+                 + std::to_string(dropped - reported_dropped_) + " message(s) dropped\n";
+        reported_dropped_ = dropped;
+        found = true;
+    }
+    return found;
+}
+
+void AsyncLogWriter::flusher_thread() noexcept
+{
+    string batch;
+    unique_lock<mutex> lock(mutex_);
+    for (;;)
+    {
+        bool const done = done_;
+        uint64_t const request = flush_requests_;
+        lock.unlock();
+
+        try
+        {
+            batch.clear();
+            if (drain(batch))
+            {
+                // Single insertion, so we don't interleave with anyone else who writes to the same stream.
+                outstream_ << batch;
+                outstream_.flush();
+            }
+        }
+        catch (...)  // LCOV_EXCL_LINE
+        {
+            // Nowhere to report this; we try again with the next batch.
+        }
+
+        lock.lock();
+        flushes_done_ = request;
+        cond_.notify_all();
+        if (done)
+        {
+            return;  // Messages written after done_ was set were drained by the final pass above.
+        }
+        cond_.wait_for(lock, flush_interval, [this, request]
+        {
+            return done_ || flush_requests_ != request || wake_.exchange(false, memory_order_relaxed);
+        });
+    }
+}
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
@@ -58,6 +58,19 @@ std::vector<OperationInfo> CompletionDetailsImpl::info_list() const
     return info_list_;
 }
 
+VariantMap CompletionDetailsImpl::metrics() const
+{
+    return metrics_;
+}
+
+void CompletionDetailsImpl::add_metrics(CompletionDetails& details, VariantMap const& metrics)
+{
+    for (auto const& m : metrics)
+    {
+        details.p->metrics_[m.first] = m.second;
+    }
+}
+
 } // namespace internal
 
 } // namespace scopes
@@ -22,7 +22,8 @@
 
 #include <cassert>
 #include <chrono>
-#include <iomanip>
+#include <cstring>
+#include <ctime>
 
 using namespace std;
 
@@ -43,7 +44,8 @@ static array<string, 5> const severities = {{"INFO", "WARNING", "ERROR", "FATAL"
 static array<pair<string, LoggerChannel>, int(LoggerChannel::LastChannelEnum_)> const channel_names =
 { {
     pair<string, LoggerChannel>{"", LoggerChannel::DefaultChannel},
-    pair<string, LoggerChannel>{"IPC", LoggerChannel::IPC}
+    pair<string, LoggerChannel>{"IPC", LoggerChannel::IPC},
+    pair<string, LoggerChannel>{"Profile", LoggerChannel::Profile}
 } };
 
 }  // namespace
@@ -68,27 +70,27 @@ Logger::Logger(string const& id, ostream& outstream)
 
 LogStream Logger::operator()()
 {
-    if (LoggerSeverity::Error >= severity_threshold_)
+    if (enabled(LoggerSeverity::Error))
     {
-        return LogStream(outstream_, id_, LoggerSeverity::Error, LoggerChannel::DefaultChannel);
+        return LogStream(outstream_, id_, LoggerSeverity::Error, LoggerChannel::DefaultChannel, async_writer_.get());
     }
     return LogStream();  // Null writer
 }
 
 LogStream Logger::operator()(LoggerSeverity s)
 {
-    if (s >= severity_threshold_)
+    if (enabled(s))
     {
-        return LogStream(outstream_, id_, s, LoggerChannel::DefaultChannel);
+        return LogStream(outstream_, id_, s, LoggerChannel::DefaultChannel, async_writer_.get());
     }
     return LogStream();  // Null writer
 }
 
 LogStream Logger::operator()(LoggerChannel c)
 {
-    if (enabled_[int(c)])
+    if (enabled(c))
     {
-        return LogStream(outstream_, id_, LoggerSeverity::Trace, c);
+        return LogStream(outstream_, id_, LoggerSeverity::Trace, c, async_writer_.get());
     }
     return LogStream();  // Null writer
 }
@@ -115,6 +117,51 @@ LoggerSeverity Logger::set_severity_threshold(LoggerSeverity s)
     return severity_threshold_.exchange(s);
 }
 
+void Logger::enable_async(int queue_size)
+{
+    if (async_writer_)
+    {
+        throw LogicException("Logger::enable_async(): logger is asynchronous already");
+    }
+    async_writer_.reset(new AsyncLogWriter(outstream_, id_, queue_size));
+}
+
+void Logger::flush()
+{
+    if (async_writer_)
+    {
+        async_writer_->flush();
+    }
+}
+
+string Logger::timestamp()
+{
+    auto now = chrono::system_clock::now();
+    auto curr_t = chrono::system_clock::to_time_t(now);
+    auto millisecs = chrono::duration_cast<chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+
+    // localtime_r() and strftime() are expensive, so each thread remembers
+    // the formatted date and time for the most recent second.
+    thread_local time_t cached_t = -1;
+    thread_local char cached_time[]{"yyyy-mm-dd hh:mm:ss"};
+    if (curr_t != cached_t)
+    {
+        struct tm result;
+        localtime_r(&curr_t, &result);
+        strftime(cached_time, sizeof(cached_time), "%F %T", &result);
+        cached_t = curr_t;
+    }
+
+    char buf[]{"yyyy-mm-dd hh:mm:ss.mmm"};
+    size_t const len = strlen(cached_time);
+    memcpy(buf, cached_time, len);
+    buf[len] = '.';
+    buf[len + 1] = char('0' + millisecs / 100);
+    buf[len + 2] = char('0' + millisecs / 10 % 10);
+    buf[len + 3] = char('0' + millisecs % 10);
+    return string(buf, len + 4);
+}
+
 namespace
 {
 
@@ -140,41 +187,22 @@ static ostream null_stream(&null_buf);
 LogStream::LogStream()  // Doesn't log anything
     : id_(null_id)
     , outstream_(null_stream)
+    , writer_(nullptr)
     , severity_(static_cast<LoggerSeverity>(0))
     , channel_(static_cast<LoggerChannel>(0))
 {
 }
 
-LogStream::LogStream(ostream& outstream, string const& id, LoggerSeverity s, LoggerChannel c)
+LogStream::LogStream(ostream& outstream, string const& id, LoggerSeverity s, LoggerChannel c,
+                     AsyncLogWriter* writer)
     : id_(id)
     , outstream_(outstream)
+    , writer_(writer)
     , severity_(s)
     , channel_(c)
 {
 }
 
-namespace
-{
-
-string get_time()
-{
-    auto now = chrono::system_clock::now();
-    auto curr_t = chrono::system_clock::to_time_t(now);
-    auto millisecs = chrono::duration_cast<chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
-
-    struct tm result;
-    localtime_r(&curr_t, &result);
-
-    // Should use std::put_time(&result, "%F %T') here, but gcc 4.9 doesn't provide it.
-    char buf[]{"yyyy-mm-dd hh:mm:ss"};
-    strftime(buf, sizeof(buf), "%F %T", &result);
-    stringstream s;
-    s << buf << "." << setw(3) << setfill('0') << millisecs;
-    return s.str();
-}
-
-}  // namespace
-
 LogStream::~LogStream()
 {
     string msg = str();
@@ -183,10 +211,30 @@ LogStream::~LogStream()
         return;
     }
     // Something was logged. Accumulate all the details in an output string.
-    string prefix = channel_ != LoggerChannel::DefaultChannel
-                        ? channel_names[int(channel_)].first
-                        : severities[int(severity_)];
-    string output = "[" + get_time() + "] " + prefix + ": " + id_ + ": " + msg + "\n";
+    string const& prefix = channel_ != LoggerChannel::DefaultChannel
+                               ? channel_names[int(channel_)].first
+                               : severities[int(severity_)];
+    string output;
+    output.reserve(sizeof("[yyyy-mm-dd hh:mm:ss.mmm] ") + prefix.size() + id_.size() + msg.size() + 5);
+    output += '[';
+    output += Logger::timestamp();
+    output += "] ";
+    output += prefix;
+    output += ": ";
+    output += id_;
+    output += ": ";
+    output += msg;
+    output += '\n';
+
+    if (writer_)
+    {
+        writer_->write(std::move(output));
+        if (severity_ == LoggerSeverity::Fatal && channel_ == LoggerChannel::DefaultChannel)
+        {
+            writer_->flush();  // Make sure the message gets out, we may be about to die.
+        }
+        return;
+    }
 
     // Write contents with a single insertion to avoid interleaving of messages from different threads.
     outstream_ << output;
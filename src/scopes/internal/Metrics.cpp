@@ -0,0 +1,314 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/Metrics.h>
+
+#include <unity/UnityExceptions.h>
+
+#include <cassert>
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+MetricsRegistry::Counter::Counter()
+    : value_(0)
+{
+}
+
+void MetricsRegistry::Counter::inc(int64_t n) noexcept
+{
+    value_.fetch_add(n, memory_order_relaxed);
+}
+
+int64_t MetricsRegistry::Counter::value() const noexcept
+{
+    return value_.load(memory_order_relaxed);
+}
+
+MetricsRegistry::Gauge::Gauge()
+    : value_(0)
+{
+}
+
+void MetricsRegistry::Gauge::set(int64_t v) noexcept
+{
+    value_.store(v, memory_order_relaxed);
+}
+
+void MetricsRegistry::Gauge::add(int64_t n) noexcept
+{
+    value_.fetch_add(n, memory_order_relaxed);
+}
+
+int64_t MetricsRegistry::Gauge::value() const noexcept
+{
+    return value_.load(memory_order_relaxed);
+}
+
+constexpr int MetricsRegistry::Histogram::sub_bucket_bits;
+constexpr int MetricsRegistry::Histogram::num_buckets;
+
+MetricsRegistry::Histogram::Histogram()
+    : count_(0)
+    , sum_(0)
+    , max_(0)
+{
+    for (auto& b : buckets_)
+    {
+        b.store(0, memory_order_relaxed);
+    }
+}
+
+// Values below 2^sub_bucket_bits have a bucket each. Above that, each power of two
+// is split into 2^sub_bucket_bits buckets of equal width.
+
+int MetricsRegistry::Histogram::bucket_index(int64_t v) noexcept
+{
+    int64_t const sub_buckets = int64_t(1) << sub_bucket_bits;
+    if (v < sub_buckets)
+    {
+        return v < 0 ? 0 : int(v);
+    }
+    int const exponent = 63 - __builtin_clzll(static_cast<unsigned long long>(v));
+    int const shift = exponent - sub_bucket_bits;
+    int const sub = int((v >> shift) & (sub_buckets - 1));
+    return ((shift + 1) << sub_bucket_bits) + sub;
+}
+
+int64_t MetricsRegistry::Histogram::bucket_upper_bound(int index) noexcept
+{
+    assert(index >= 0 && index < num_buckets);
+    int64_t const sub_buckets = int64_t(1) << sub_bucket_bits;
+    if (index < sub_buckets)
+    {
+        return index;
+    }
+    int const shift = (index >> sub_bucket_bits) - 1;
+    int64_t const sub = index & (sub_buckets - 1);
+    int64_t const lower = (sub_buckets + sub) << shift;
+    return lower + ((int64_t(1) << shift) - 1);
+}
+
+void MetricsRegistry::Histogram::record(int64_t v) noexcept
+{
+    if (v < 0)
+    {
+        v = 0;
+    }
+    buckets_[bucket_index(v)].fetch_add(1, memory_order_relaxed);
+    count_.fetch_add(1, memory_order_relaxed);
+    sum_.fetch_add(v, memory_order_relaxed);
+    int64_t m = max_.load(memory_order_relaxed);
+    while (v > m && !max_.compare_exchange_weak(m, v, memory_order_relaxed))
+    {
+    }
+}
+
+void MetricsRegistry::Histogram::record(chrono::steady_clock::duration d) noexcept
+{
+    record(int64_t(chrono::duration_cast<chrono::microseconds>(d).count()));
+}
+
+int64_t MetricsRegistry::Histogram::count() const noexcept
+{
+    return count_.load(memory_order_relaxed);
+}
+
+int64_t MetricsRegistry::Histogram::sum() const noexcept
+{
+    return sum_.load(memory_order_relaxed);
+}
+
+int64_t MetricsRegistry::Histogram::max() const noexcept
+{
+    return max_.load(memory_order_relaxed);
+}
+
+// Returns the upper bound of the bucket that contains the value at the given percentile,
+// capped at the largest recorded value. Concurrent updates may be partially visible,
+// so the result is approximate while values are being recorded.
+
+int64_t MetricsRegistry::Histogram::percentile(double p) const noexcept
+{
+    int64_t total = 0;
+    int64_t counts[num_buckets];
+    for (int i = 0; i < num_buckets; ++i)
+    {
+        counts[i] = buckets_[i].load(memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0)
+    {
+        return 0;
+    }
+    p = p < 0 ? 0 : (p > 100 ? 100 : p);
+    int64_t rank = int64_t(ceil(p / 100 * total));
+    rank = rank < 1 ? 1 : rank;
+    int64_t seen = 0;
+    for (int i = 0; i < num_buckets; ++i)
+    {
+        seen += counts[i];
+        if (seen >= rank)
+        {
+            int64_t const upper = bucket_upper_bound(i);
+            int64_t const m = max();
+            return upper < m ? upper : m;
+        }
+    }
+    return max();  // LCOV_EXCL_LINE
+}
+
+MetricsRegistry::Timer::Timer(Histogram& h)
+    : h_(h)
+    , start_(chrono::steady_clock::now())
+{
+}
+
+MetricsRegistry::Timer::~Timer()
+{
+    h_.record(chrono::steady_clock::now() - start_);
+}
+
+MetricsRegistry::MetricsRegistry() = default;
+
+MetricsRegistry::~MetricsRegistry() = default;
+
+void MetricsRegistry::check_unique(string const& name, char const* kind) const
+{
+    assert(!mutex_.try_lock());  // Must be called with mutex_ locked.
+
+    size_t uses = counters_.count(name) + gauges_.count(name) + histograms_.count(name) + gauge_fns_.count(name);
+    if (uses != 0)
+    {
+        throw LogicException(string("MetricsRegistry: cannot add ") + kind + " \"" + name
+                             + "\": name is in use for a different metric");
+    }
+}
+
+MetricsRegistry::Counter& MetricsRegistry::counter(string const& name)
+{
+    lock_guard<mutex> lock(mutex_);
+    auto it = counters_.find(name);
+    if (it != counters_.end())
+    {
+        return *it->second;
+    }
+    check_unique(name, "counter");
+    return *counters_.emplace(name, unique_ptr<Counter>(new Counter)).first->second;
+}
+
+MetricsRegistry::Gauge& MetricsRegistry::gauge(string const& name)
+{
+    lock_guard<mutex> lock(mutex_);
+    auto it = gauges_.find(name);
+    if (it != gauges_.end())
+    {
+        return *it->second;
+    }
+    check_unique(name, "gauge");
+    return *gauges_.emplace(name, unique_ptr<Gauge>(new Gauge)).first->second;
+}
+
+MetricsRegistry::Histogram& MetricsRegistry::histogram(string const& name)
+{
+    lock_guard<mutex> lock(mutex_);
+    auto it = histograms_.find(name);
+    if (it != histograms_.end())
+    {
+        return *it->second;
+    }
+    check_unique(name, "histogram");
+    return *histograms_.emplace(name, unique_ptr<Histogram>(new Histogram)).first->second;
+}
+
+void MetricsRegistry::gauge_fn(string const& name, function<int64_t()> const& f)
+{
+    assert(f);
+
+    lock_guard<mutex> lock(mutex_);
+    auto it = gauge_fns_.find(name);
+    if (it != gauge_fns_.end())
+    {
+        it->second = f;
+        return;
+    }
+    check_unique(name, "gauge");
+    gauge_fns_.emplace(name, f);
+}
+
+string MetricsRegistry::to_string() const
+{
+    // Collect the lines into a map, so the output is sorted by name.
+    map<string, string> lines;
+    vector<pair<string, function<int64_t()>>> fns;
+    {
+        lock_guard<mutex> lock(mutex_);
+        for (auto const& c : counters_)
+        {
+            lines[c.first] = "counter " + c.first + " " + std::to_string(c.second->value());
+        }
+        for (auto const& g : gauges_)
+        {
+            lines[g.first] = "gauge " + g.first + " " + std::to_string(g.second->value());
+        }
+        for (auto const& h : histograms_)
+        {
+            auto const& hist = *h.second;
+            int64_t const count = hist.count();
+            ostringstream s;
+            s << "histogram " << h.first
+              << " count=" << count
+              << " mean=" << (count == 0 ? 0 : hist.sum() / count)
+              << " p50=" << hist.percentile(50)
+              << " p90=" << hist.percentile(90)
+              << " p99=" << hist.percentile(99)
+              << " max=" << hist.max();
+            lines[h.first] = s.str();
+        }
+        fns.assign(gauge_fns_.begin(), gauge_fns_.end());
+    }
+    for (auto const& f : fns)
+    {
+        lines[f.first] = "gauge " + f.first + " " + std::to_string(f.second());
+    }
+
+    string result;
+    for (auto const& l : lines)
+    {
+        result += l.second;
+        result += '\n';
+    }
+    return result;
+}
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
@@ -36,6 +36,7 @@ namespace internal
 {
 
 ObjectImpl::ObjectImpl(MWProxy const& mw_proxy)
+    : proxy_mutex_(ProfiledMutex::Proxy)
 {
     mw_proxy_ = mw_proxy;
 }
@@ -81,21 +82,21 @@ void ObjectImpl::ping()
 
 MWProxy ObjectImpl::proxy()
 {
-    lock_guard<mutex> lock(proxy_mutex_);
+    lock_guard<ProfiledMutex> lock(proxy_mutex_);
     return mw_proxy_;
 }
 
 void ObjectImpl::set_proxy(MWProxy const& p)
 {
     assert(p);
-    lock_guard<mutex> lock(proxy_mutex_);
+    lock_guard<ProfiledMutex> lock(proxy_mutex_);
     assert(!mw_proxy_);
     mw_proxy_ = p;
 }
 
 void ObjectImpl::check_proxy()
 {
-    lock_guard<mutex> lock(proxy_mutex_);
+    lock_guard<ProfiledMutex> lock(proxy_mutex_);
     if (!mw_proxy_)
     {
         throw MiddlewareException("Cannot invoke on null proxy");
@@ -18,6 +18,7 @@
 
 #include <unity/scopes/internal/PreviewQueryObject.h>
 
+#include <unity/scopes/internal/lttng/UnityScopes_tp.h>
 #include <unity/scopes/internal/MWQueryCtrl.h>
 #include <unity/scopes/internal/MWReply.h>
 #include <unity/scopes/internal/PreviewReplyImpl.h>
@@ -78,6 +79,8 @@ void PreviewQueryObject::run(MWReplyProxy const& reply, InvokeInfo const& info)
     self_ = nullptr;
     disconnect();
 
+    run_begin_ = chrono::steady_clock::now();
+
     try
     {
         lock.unlock();
@@ -86,6 +89,8 @@ void PreviewQueryObject::run(MWReplyProxy const& reply, InvokeInfo const& info)
         // On return, replies for the preview may still be outstanding.
         auto preview_query = dynamic_pointer_cast<PreviewQueryBase>(query_base_);
         assert(preview_query);
+        simple_tracepoint(unity_scopes, query_run_begin, reply_->identity().c_str());
+        QueryProfile::Recorder recorder(profile_);
         preview_query->run(reply_proxy);
     }
     catch (std::exception const& e)
@@ -106,6 +111,8 @@ void PreviewQueryObject::run(MWReplyProxy const& reply, InvokeInfo const& info)
         info.mw->runtime()->logger()() << "PreviewQueryBase::run(): unknown exception";
         reply_->finished(CompletionDetails(CompletionDetails::Error, "PreviewQueryBase::run(): unknown exception"));
     }
+    simple_tracepoint(unity_scopes, query_run_end, reply_->identity().c_str());
+    run_ended(info);
 }
 
 } // namespace internal
@@ -160,6 +160,11 @@ PreviewWidget PreviewWidgetImpl::create(VariantMap const& var)
     return PreviewWidget(new PreviewWidgetImpl(var));
 }
 
+PreviewWidget PreviewWidgetImpl::create_from_variant_map(VariantMap const& node)
+{
+    return PreviewWidget(new PreviewWidgetImpl(from_json_node(node)));
+}
+
 void PreviewWidgetImpl::set_id(std::string const& id)
 {
     throw_on_empty("id", id);
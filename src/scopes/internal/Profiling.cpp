@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/Profiling.h>
+
+#include <atomic>
+#include <cassert>
+
+using namespace std;
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace
+{
+
+atomic_bool profiling_enabled(false);
+atomic_bool allocation_counting_enabled(false);
+
+// Plain pointer, so access does not need a TLS wrapper function. This matters because
+// count_allocation() is called for every allocation, including those made during thread start-up.
+thread_local QueryProfile* current_profile = nullptr;
+
+struct LockStats
+{
+    atomic<int64_t> waits;
+    atomic<int64_t> wait_us;
+};
+
+LockStats lock_stats[ProfiledMutex::NumKinds];  // Static storage, so zero-initialized.
+
+char const* const lock_names[ProfiledMutex::NumKinds] = { "reply", "reaper", "proxy", "adapter" };
+
+}  // namespace
+
+ProfiledMutex::ProfiledMutex(Kind kind) noexcept
+#ifdef UNITY_SCOPES_PROFILING
+    : kind_(kind)
+#endif
+{
+    assert(kind >= 0 && kind < NumKinds);
+    static_cast<void>(kind);
+}
+
+#ifdef UNITY_SCOPES_PROFILING
+
+void ProfiledMutex::lock()
+{
+    if (!profiling_enabled.load(memory_order_relaxed))
+    {
+        m_.lock();
+        return;
+    }
+    if (m_.try_lock())
+    {
+        return;
+    }
+
+    auto const start = chrono::steady_clock::now();
+    m_.lock();
+    auto const waited = chrono::steady_clock::now() - start;
+
+    auto& stats = lock_stats[kind_];
+    stats.waits.fetch_add(1, memory_order_relaxed);
+    stats.wait_us.fetch_add(chrono::duration_cast<chrono::microseconds>(waited).count(), memory_order_relaxed);
+    if (QueryProfile* p = current_profile)
+    {
+        ++p->lock_waits_;
+        p->lock_wait_time_ += waited;
+    }
+}
+
+bool ProfiledMutex::try_lock() noexcept
+{
+    return m_.try_lock();
+}
+
+void ProfiledMutex::unlock() noexcept
+{
+    m_.unlock();
+}
+
+#endif
+
+char const* ProfiledMutex::name(Kind kind) noexcept
+{
+    assert(kind >= 0 && kind < NumKinds);
+    return lock_names[kind];
+}
+
+int64_t ProfiledMutex::waits(Kind kind) noexcept
+{
+    assert(kind >= 0 && kind < NumKinds);
+    return lock_stats[kind].waits.load(memory_order_relaxed);
+}
+
+int64_t ProfiledMutex::wait_us(Kind kind) noexcept
+{
+    assert(kind >= 0 && kind < NumKinds);
+    return lock_stats[kind].wait_us.load(memory_order_relaxed);
+}
+
+bool ProfiledMutex::compiled_in() noexcept
+{
+#ifdef UNITY_SCOPES_PROFILING
+    return true;
+#else
+    return false;
+#endif
+}
+
+QueryProfile::QueryProfile() noexcept
+    : recorded_(false)
+    , lock_waits_(0)
+    , lock_wait_time_(0)
+    , allocations_(0)
+    , allocated_bytes_(0)
+{
+}
+
+QueryProfile::Recorder::Recorder(QueryProfile& profile) noexcept
+    : previous_(current_profile)
+    , active_(profiling_enabled.load(memory_order_relaxed))
+{
+    if (active_)
+    {
+        profile.recorded_ = true;
+        current_profile = &profile;
+    }
+}
+
+QueryProfile::Recorder::~Recorder()
+{
+    if (active_)
+    {
+        current_profile = previous_;
+    }
+}
+
+bool QueryProfile::recorded() const noexcept
+{
+    return recorded_;
+}
+
+int64_t QueryProfile::lock_waits() const noexcept
+{
+    return lock_waits_;
+}
+
+chrono::steady_clock::duration QueryProfile::lock_wait_time() const noexcept
+{
+    return lock_wait_time_;
+}
+
+int64_t QueryProfile::allocations() const noexcept
+{
+    return allocations_;
+}
+
+int64_t QueryProfile::allocated_bytes() const noexcept
+{
+    return allocated_bytes_;
+}
+
+void QueryProfile::enable(bool enabled) noexcept
+{
+    profiling_enabled.store(enabled, memory_order_relaxed);
+}
+
+bool QueryProfile::enabled() noexcept
+{
+    return profiling_enabled.load(memory_order_relaxed);
+}
+
+void QueryProfile::enable_allocation_counting() noexcept
+{
+    allocation_counting_enabled.store(true, memory_order_relaxed);
+}
+
+bool QueryProfile::allocation_counting() noexcept
+{
+    return allocation_counting_enabled.load(memory_order_relaxed);
+}
+
+void QueryProfile::count_allocation(size_t size) noexcept
+{
+    // No need to check profiling_enabled: current_profile is set only while profiling is enabled.
+    if (QueryProfile* p = current_profile)
+    {
+        ++p->allocations_;
+        p->allocated_bytes_ += size;
+    }
+}
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
@@ -20,6 +20,8 @@
 
 #include <unity/Exception.h>
 #include <unity/scopes/ActivationQueryBase.h>
+#include <unity/scopes/internal/lttng/UnityScopes_tp.h>
+#include <unity/scopes/internal/Logger.h>
 #include <unity/scopes/internal/MWQueryCtrl.h>
 #include <unity/scopes/internal/MWReply.h>
 #include <unity/scopes/internal/QueryBaseImpl.h>
@@ -31,6 +33,7 @@
 #include <unity/scopes/SearchQueryBase.h>
 
 #include <cassert>
+#include <sstream>
 
 using namespace std;
 using namespace unity::scopes::internal;
@@ -60,6 +63,7 @@ QueryObject::QueryObject(std::shared_ptr<QueryBase> const& query_base,
     , ctrl_(ctrl)
     , pushable_(true)
     , cardinality_(cardinality)
+    , created_(chrono::steady_clock::now())
 {
 }
 
@@ -114,12 +118,16 @@ void QueryObject::run(MWReplyProxy const& reply, InvokeInfo const& info) noexcep
     self_ = nullptr;
     disconnect();
 
+    run_begin_ = chrono::steady_clock::now();
+
     try
     {
         lock.unlock();
 
         // Synchronous call into scope implementation.
         // On return, replies for the query may still be outstanding.
+        simple_tracepoint(unity_scopes, query_run_begin, reply_->identity().c_str());
+        QueryProfile::Recorder recorder(profile_);
         search_query->run(reply_proxy);
     }
     catch (std::exception const& e)
@@ -140,6 +148,8 @@ void QueryObject::run(MWReplyProxy const& reply, InvokeInfo const& info) noexcep
         info.mw->runtime()->logger()() << "QueryBase::run(): unknown exception";
         reply_->finished(CompletionDetails(CompletionDetails::Error, "QueryBase::run(): unknown exception"));
     }
+    simple_tracepoint(unity_scopes, query_run_end, reply_->identity().c_str());
+    run_ended(info);
 }
 
 void QueryObject::cancel(InvokeInfo const& info)
@@ -154,6 +164,8 @@ void QueryObject::cancel(InvokeInfo const& info)
         pushable_ = false;
     }  // Release lock
 
+    simple_tracepoint(unity_scopes, query_cancelled, reply_->identity().c_str());
+
     try
     {
         // Forward the cancellation to the query base (which in turn will forward it to any subqueries).
@@ -200,6 +212,98 @@ int QueryObject::cardinality(InvokeInfo const& /* info */) const noexcept
     return cardinality_;
 }
 
+namespace
+{
+
+double to_ms(chrono::steady_clock::duration d)
+{
+    return chrono::duration<double, milli>(d).count();
+}
+
+// Lock waits and allocations, for whichever of them is being measured.
+
+string profile_summary(QueryProfile const& profile)
+{
+    ostringstream s;
+    if (ProfiledMutex::compiled_in())
+    {
+        s << ", " << profile.lock_waits() << " lock wait(s) (" << to_ms(profile.lock_wait_time()) << " ms)";
+    }
+    if (QueryProfile::allocation_counting())
+    {
+        s << ", " << profile.allocations() << " allocation(s) (" << profile.allocated_bytes() << " bytes)";
+    }
+    return s.str();
+}
+
+}  // namespace
+
+VariantMap QueryObject::metrics() const
+{
+    lock_guard<mutex> lock(mutex_);
+
+    VariantMap m;
+    if (run_begin_ != chrono::steady_clock::time_point())
+    {
+        auto end = run_end_ != chrono::steady_clock::time_point() ? run_end_ : chrono::steady_clock::now();
+        m["scope_queue_ms"] = Variant(to_ms(run_begin_ - created_));
+        m["scope_run_ms"] = Variant(to_ms(end - run_begin_));
+    }
+    if (run_end_ != chrono::steady_clock::time_point() && profile_.recorded())
+    {
+        if (ProfiledMutex::compiled_in())
+        {
+            m["scope_lock_waits"] = Variant(profile_.lock_waits());
+            m["scope_lock_wait_ms"] = Variant(to_ms(profile_.lock_wait_time()));
+        }
+        if (QueryProfile::allocation_counting())
+        {
+            m["scope_allocations"] = Variant(profile_.allocations());
+            m["scope_allocated_bytes"] = Variant(profile_.allocated_bytes());
+        }
+    }
+    return m;
+}
+
+void QueryObject::run_ended(InvokeInfo const& info) noexcept
+{
+    chrono::steady_clock::duration run_time;
+    {
+        lock_guard<mutex> lock(mutex_);
+        run_end_ = chrono::steady_clock::now();
+        run_time = run_end_ - run_begin_;
+    }
+
+    // The profile is no longer written to once the scope's run() has returned,
+    // so we can read it without holding the lock.
+    auto runtime = info.mw->runtime();
+    if (!profile_.recorded() || !runtime)
+    {
+        return;
+    }
+    try
+    {
+        auto& metrics = runtime->metrics();
+        if (ProfiledMutex::compiled_in())
+        {
+            metrics.histogram("query.run.lock_waits").record(profile_.lock_waits());
+            metrics.histogram("query.run.lock_wait_us").record(profile_.lock_wait_time());
+        }
+        if (QueryProfile::allocation_counting())
+        {
+            metrics.histogram("query.run.allocations").record(profile_.allocations());
+            metrics.histogram("query.run.allocated_bytes").record(profile_.allocated_bytes());
+        }
+
+        UNITY_SCOPES_LOG(runtime->logger(), LoggerChannel::Profile)
+            << "run() for " << reply_->identity() << ": " << to_ms(run_time) << " ms" << profile_summary(profile_);
+    }
+    catch (...)
+    {
+        // Profiling must not affect the query.
+    }
+}
+
 // The point of keeping a shared_ptr to ourselves is to make sure this QueryObject cannot
 // go out of scope in between being created by the Scope, and the first ReplyProxy for this
 // query being created in QueryObject::run(). If the scope's run() method returns immediately,
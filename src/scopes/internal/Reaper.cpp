@@ -55,7 +55,7 @@ void ReapItem::refresh() noexcept
     if (reaper)
     {
         std::lock(mutex_, reaper->mutex_);
-        lock_guard<mutex> reaper_lock(reaper->mutex_, adopt_lock);
+        lock_guard<ProfiledMutex> reaper_lock(reaper->mutex_, adopt_lock);
         lock_guard<mutex> item_lock(mutex_, adopt_lock);
 
         if (cancelled_)
@@ -106,7 +106,7 @@ void ReapItem::cancel() noexcept
         }
 
         // Remove our Item from the reaper's list.
-        lock_guard<mutex> lock(reaper->mutex_);
+        lock_guard<ProfiledMutex> lock(reaper->mutex_);
         assert(it_ != reaper->list_.end());
         reaper->list_.erase(it_);
         it_ = reaper->list_.end();
@@ -123,6 +123,7 @@ Reaper::Reaper(int reap_interval, int expiry_interval, DestroyPolicy p) :
     reap_interval_(chrono::seconds(reap_interval)),
     expiry_interval_(chrono::seconds(expiry_interval)),
     policy_(p),
+    mutex_(ProfiledMutex::Reaper),
     finish_(false),
     reap_in_progress_(false)
 {
@@ -180,7 +181,7 @@ void Reaper::destroy()
 {
     // Let the reaper thread know that it needs to stop doing things
     {
-        lock_guard<mutex> lock(mutex_);
+        lock_guard<ProfiledMutex> lock(mutex_);
         if (finish_)
         {
             return;
@@ -211,7 +212,7 @@ ReapItem::SPtr Reaper::add(ReaperCallback const& cb)
         throw unity::InvalidArgumentException("Reaper: invalid null callback passed to add().");
     }
 
-    unique_lock<mutex> lock(mutex_);
+    ProfiledLock lock(mutex_);
 
     if (finish_)
     {
@@ -238,7 +239,7 @@ ReapItem::SPtr Reaper::add(ReaperCallback const& cb)
 
 size_t Reaper::size() const noexcept
 {
-    lock_guard<mutex> lock(mutex_);
+    lock_guard<ProfiledMutex> lock(mutex_);
     return list_.size();
 }
 
@@ -246,7 +247,7 @@ size_t Reaper::size() const noexcept
 
 void Reaper::reap_func()
 {
-    unique_lock<mutex> lock(mutex_);
+    ProfiledLock lock(mutex_);
     for (;;)
     {
         if (list_.empty())
@@ -342,7 +343,7 @@ void Reaper::remove_zombies(reaper_private::Reaplist const& zombies) noexcept
         }
 
         {
-            lock_guard<mutex> lock(mutex_);
+            lock_guard<ProfiledMutex> lock(mutex_);
             assert(ri->it_ != list_.end());
             list_.erase(ri->it_);
             ri->it_ = list_.end();
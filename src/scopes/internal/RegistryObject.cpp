@@ -51,9 +51,14 @@ RegistryObject::RegistryObject(core::posix::ChildProcess::DeathObserver& death_o
                                Executor::SPtr const& executor,
                                MiddlewareBase::SPtr middleware,
                                bool generate_desktop_files)
-    // Substitute logger for testing. (Some of tests mock out the middleware and run time.)
+    // Substitute logger and metrics for testing. (Some of tests mock out the middleware and run time.)
     : test_logger_(middleware ? nullptr : new Logger("RegistryObject_test")),
       logger_(middleware ? middleware->runtime()->logger() : *test_logger_),
+      test_metrics_(middleware ? nullptr : new MetricsRegistry),
+      locate_histogram_((middleware ? middleware->runtime()->metrics() : *test_metrics_)
+                        .histogram("registry.locate_us")),
+      exec_histogram_((middleware ? middleware->runtime()->metrics() : *test_metrics_)
+                      .histogram("registry.exec_us")),
       death_observer_(death_observer),
       death_observer_connection_
       {
@@ -191,6 +196,8 @@ MetadataMap RegistryObject::list() const
 
 ObjectProxy RegistryObject::locate(std::string const& identity)
 {
+    MetricsRegistry::Timer locate_timer(locate_histogram_);
+
     // If the id is empty, it was sent as empty by the remote client.
     if (identity.empty())
     {
@@ -219,7 +226,13 @@ ObjectProxy RegistryObject::locate(std::string const& identity)
 
     // Exec after unlocking, so we can start processing another locate()
     assert(proc);
+    bool const was_running = proc->state() == ScopeProcess::ProcessState::Running;
+    auto const exec_start = chrono::steady_clock::now();
     proc->exec(death_observer_, executor_);
+    if (!was_running)
+    {
+        exec_histogram_.record(chrono::steady_clock::now() - exec_start);  // Only count actual process starts.
+    }
 
     return proxy;
 }
@@ -263,11 +276,7 @@ bool RegistryObject::add_local_scope(std::string const& scope_id, ScopeMetadata
     scopes_.insert(make_pair(scope_id, metadata));
     scope_processes_.insert(make_pair(scope_id, make_shared<ScopeProcess>(exec_data, publisher_, logger_)));
 
-    if (publisher_)
-    {
-        // Send a blank message to subscribers to inform them that the registry has been updated
-        publisher_->send_message("");
-    }
+    registry_updated_unlocked();
 
     create_desktop_file(metadata);
     return return_value;
@@ -316,15 +325,10 @@ bool RegistryObject::remove_local_scope(std::string const& scope_id)
         if (erased)
         {
             remove_desktop_file(scope_id);
+            registry_updated_unlocked();
         }
     }
 
-    if (publisher_ && erased)
-    {
-        // Send a blank message to subscribers to inform them that the registry has been updated
-        publisher_->send_message("");
-    }
-
     if (ex)
     {
         rethrow_exception(ex);
@@ -339,6 +343,27 @@ void RegistryObject::set_remote_registry(MWRegistryProxy const& remote_registry)
     remote_registry_ = remote_registry;
 }
 
+void RegistryObject::begin_update_batch()
+{
+    lock_guard<decltype(mutex_)> lock(mutex_);
+    ++update_batch_depth_;
+}
+
+void RegistryObject::end_update_batch()
+{
+    lock_guard<decltype(mutex_)> lock(mutex_);
+
+    if (update_batch_depth_ == 0)
+    {
+        throw unity::LogicException("RegistryObject::end_update_batch(): no update batch in progress");
+    }
+    if (--update_batch_depth_ == 0 && update_pending_)
+    {
+        update_pending_ = false;
+        registry_updated_unlocked();
+    }
+}
+
 StateReceiverObject::SPtr RegistryObject::state_receiver()
 {
     return state_receiver_;
@@ -451,6 +476,22 @@ void RegistryObject::remove_desktop_file(std::string const& scope_id)
     }
 }
 
+void RegistryObject::registry_updated_unlocked()
+{
+    if (update_batch_depth_ > 0)
+    {
+        // Coalesce with any other changes made before the batch ends.
+        update_pending_ = true;
+        return;
+    }
+
+    if (publisher_)
+    {
+        // Send a blank message to subscribers to inform them that the registry has been updated
+        publisher_->send_message("");
+    }
+}
+
 void RegistryObject::ss_list_update()
 {
     if (publisher_)
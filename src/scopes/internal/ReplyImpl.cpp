@@ -18,6 +18,8 @@
 
 #include <unity/scopes/internal/ReplyImpl.h>
 
+#include <unity/scopes/internal/CompletionDetailsImpl.h>
+#include <unity/scopes/internal/lttng/UnityScopes_tp.h>
 #include <unity/scopes/internal/MiddlewareBase.h>
 #include <unity/scopes/internal/MWReply.h>
 #include <unity/scopes/internal/QueryObjectBase.h>
@@ -42,6 +44,7 @@ ReplyImpl::ReplyImpl(MWReplyProxy const& mw_proxy, std::shared_ptr<QueryObjectBa
     : ObjectImpl(mw_proxy)
     , qo_(qo)
     , finished_(false)
+    , push_count_(0)
 {
     assert(mw_proxy);
 }
@@ -73,7 +76,9 @@ bool ReplyImpl::push(VariantMap const& variant_map)
 
     try
     {
+        simple_tracepoint(unity_scopes, reply_push, fwd()->identity().c_str());
         fwd()->push(variant_map);
+        ++push_count_;
     }
     catch (std::exception const&)
     {
@@ -90,7 +95,8 @@ void ReplyImpl::finished()
     {
         try
         {
-            fwd()->finished(CompletionDetails(CompletionDetails::OK));  // Oneway, can't block
+            simple_tracepoint(unity_scopes, reply_finished, fwd()->identity().c_str(), static_cast<int>(CompletionDetails::OK));
+            fwd()->finished(completion_details(CompletionDetails::OK, ""));  // Oneway, can't block
         }
         catch (std::exception const&)
         {
@@ -125,7 +131,8 @@ void ReplyImpl::error(exception_ptr ex)
 
     try
     {
-        fwd()->finished(CompletionDetails(CompletionDetails::Error, error_message));  // Oneway, can't block
+        simple_tracepoint(unity_scopes, reply_finished, fwd()->identity().c_str(), static_cast<int>(CompletionDetails::Error));
+        fwd()->finished(completion_details(CompletionDetails::Error, error_message));  // Oneway, can't block
     }
     catch (std::exception const&)
     {
@@ -150,6 +157,15 @@ void ReplyImpl::info(OperationInfo const& op_info)
     }
 }
 
+CompletionDetails ReplyImpl::completion_details(CompletionDetails::CompletionStatus status, string const& message)
+{
+    CompletionDetails details(status, message);
+    auto metrics = qo_->metrics();
+    metrics["scope_push_count"] = Variant(int64_t(push_count_));
+    CompletionDetailsImpl::add_metrics(details, metrics);
+    return details;
+}
+
 MWReplyProxy ReplyImpl::fwd()
 {
     return dynamic_pointer_cast<MWReply>(proxy());
@@ -25,6 +25,8 @@
 #include <unity/scopes/Category.h>
 #include <unity/scopes/CategorisedResult.h>
 #include <unity/scopes/internal/CategorisedResultImpl.h>
+#include <unity/scopes/internal/CompletionDetailsImpl.h>
+#include <unity/scopes/internal/lttng/UnityScopes_tp.h>
 
 #include <cassert>
 
@@ -47,16 +49,24 @@ ReplyObject::ReplyObject(ListenerBase::SPtr const& receiver_base,
     : runtime_(runtime)
     , listener_base_(receiver_base)
     , finished_(false)
+    , mutex_(ProfiledMutex::Reply)
     , origin_proxy_(scope_proxy)
     , num_push_(0)
+    , start_(chrono::steady_clock::now())
+    , push_count_(0)
 {
     assert(receiver_base);
     assert(runtime);
 
     if (!dont_reap)
     {
-        unique_lock<mutex> lock(mutex_);  // Make sure that when lambda fires, it sees current values.
+        ProfiledLock lock(mutex_);  // Make sure that when lambda fires, it sees current values.
         reap_item_ = runtime->reply_reaper()->add([this] {
+            {
+                ProfiledLock lock(this->mutex_);
+                simple_tracepoint(unity_scopes, reply_expired, this->query_id_.c_str());
+            }
+            this->runtime_->metrics().counter("reply.expired").inc();
             string msg = "No activity on ReplyObject for scope " + this->origin_proxy_ + ": ReplyObject destroyed";
             this->finished(CompletionDetails(CompletionDetails::Error, msg));
         });
@@ -102,9 +112,14 @@ void ReplyObject::push(VariantMap const& result) noexcept
     }
 
     {
-        unique_lock<mutex> lock(mutex_);
+        ProfiledLock lock(mutex_);
+        simple_tracepoint(unity_scopes, listener_push, query_id_.c_str());
         assert(num_push_ >= 0);
         ++num_push_;
+        if (push_count_++ == 0)
+        {
+            first_push_ = chrono::steady_clock::now();
+        }
     }  // Forward invocations to application outside synchronization
 
     bool stop = false;
@@ -125,7 +140,7 @@ void ReplyObject::push(VariantMap const& result) noexcept
     // Decrement number of pushes before potentially calling finished(),
     // because finished() waits for concurrent push() calls to complete.
     {
-        unique_lock<mutex> lock(mutex_);
+        ProfiledLock lock(mutex_);
         if (--num_push_ == 0)
         {
             idle_.notify_one();
@@ -159,8 +174,9 @@ void ReplyObject::finished(CompletionDetails const& details) noexcept
 
     ReapItem::SPtr ri;
     {
-        unique_lock<mutex> lock(mutex_);  // If finished() is called by reaper, the
-        ri = reap_item_;                  // callback needs to see the current value of reap_item_.
+        ProfiledLock lock(mutex_);  // If finished() is called by reaper, the
+        ri = reap_item_;            // callback needs to see the current value of reap_item_.
+        simple_tracepoint(unity_scopes, listener_finished, query_id_.c_str(), static_cast<int>(details.status()));
     }
     if (ri)
     {
@@ -168,7 +184,7 @@ void ReplyObject::finished(CompletionDetails const& details) noexcept
     }
 
     // Wait until all currently executing calls to push() have completed.
-    unique_lock<mutex> lock(mutex_);
+    ProfiledLock lock(mutex_);
     assert(num_push_ >= 0);
     idle_.wait(lock, [this] { return num_push_ == 0; });
     try
@@ -178,6 +194,15 @@ void ReplyObject::finished(CompletionDetails const& details) noexcept
         {
             details_with_info.add_info(info);
         }
+        VariantMap metrics;
+        auto to_ms = [](chrono::steady_clock::duration d) { return chrono::duration<double, milli>(d).count(); };
+        if (push_count_ != 0)
+        {
+            metrics["first_push_ms"] = Variant(to_ms(first_push_ - start_));
+        }
+        metrics["finished_ms"] = Variant(to_ms(chrono::steady_clock::now() - start_));
+        metrics["push_count"] = Variant(push_count_);
+        CompletionDetailsImpl::add_metrics(details_with_info, metrics);
         lock.unlock(); // Inform the application code that the query is complete outside synchronization.
         listener_base_->finished(details_with_info);
     }
@@ -212,7 +237,7 @@ void ReplyObject::info(OperationInfo const& op_info) noexcept
     try
     {
         {
-            unique_lock<mutex> lock(mutex_);
+            ProfiledLock lock(mutex_);
             info_list_.push_back(op_info);
         }
         listener_base_->info(op_info);
@@ -232,6 +257,12 @@ std::string ReplyObject::origin_proxy() const
     return origin_proxy_;
 }
 
+void ReplyObject::set_query_id(std::string const& query_id)
+{
+    ProfiledLock lock(mutex_);
+    query_id_ = query_id;
+}
+
 RuntimeImpl const* ReplyObject::runtime() const
 {
     return runtime_;
@@ -54,6 +54,9 @@ const string cache_dir_key = "CacheDir";
 const string app_dir_key = "AppDir";
 const string config_dir_key = "ConfigDir";
 const string trace_channels_key = "Log.TraceChannels";
+const string log_async_key = "Log.Async";
+const string log_async_queue_size_key = "Log.Async.QueueSize";
+const string profiling_key = "Profiling";
 
 }  // namespace
 
@@ -73,6 +76,9 @@ RuntimeConfig::RuntimeConfig(string const& configfile) :
         cache_directory_ = default_cache_directory();
         app_directory_ = default_app_directory();
         config_directory_ = default_config_directory();
+        log_async_ = false;
+        log_async_queue_size_ = DFLT_LOG_ASYNC_QUEUE_SIZE;
+        profiling_ = false;
     }
     else
     {
@@ -146,6 +152,31 @@ RuntimeConfig::RuntimeConfig(string const& configfile) :
             // No TraceChannels configured.
         }
 
+        try
+        {
+            log_async_ = parser()->get_boolean(runtime_config_group, log_async_key);
+        }
+        catch (LogicException const&)
+        {
+            log_async_ = false;
+        }
+        log_async_queue_size_ = get_optional_int(runtime_config_group, log_async_queue_size_key,
+                                                 DFLT_LOG_ASYNC_QUEUE_SIZE);
+        if (log_async_queue_size_ < 16 || log_async_queue_size_ > 65536)
+        {
+            throw_ex("Illegal value (" + to_string(log_async_queue_size_) + ") for " + log_async_queue_size_key
+                     + ": value must be 16-65536");
+        }
+
+        try
+        {
+            profiling_ = parser()->get_boolean(runtime_config_group, profiling_key);
+        }
+        catch (LogicException const&)
+        {
+            profiling_ = false;
+        }
+
         // Check if we have an override for the trace channels.
         char const* tc = getenv("UNITY_SCOPES_LOG_TRACECHANNELS");
         if (tc && *tc != '\0')
@@ -170,7 +201,10 @@ RuntimeConfig::RuntimeConfig(string const& configfile) :
                                                 cache_dir_key,
                                                 app_dir_key,
                                                 config_dir_key,
-                                                trace_channels_key
+                                                trace_channels_key,
+                                                log_async_key,
+                                                log_async_queue_size_key,
+                                                profiling_key
                                              }
                                           }
                                        };
@@ -241,6 +275,21 @@ vector<string> RuntimeConfig::trace_channels() const
     return trace_channels_;
 }
 
+bool RuntimeConfig::log_async() const
+{
+    return log_async_;
+}
+
+int RuntimeConfig::log_async_queue_size() const
+{
+    return log_async_queue_size_;
+}
+
+bool RuntimeConfig::profiling() const
+{
+    return profiling_;
+}
+
 string RuntimeConfig::default_cache_directory()
 {
     char const* home = getenv("HOME");
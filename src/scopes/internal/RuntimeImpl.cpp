@@ -22,6 +22,7 @@
 #include <unity/scopes/internal/DfltConfig.h>
 #include <unity/scopes/internal/Logger.h>
 #include <unity/scopes/internal/MWStateReceiver.h>
+#include <unity/scopes/internal/Profiling.h>
 #include <unity/scopes/internal/RegistryConfig.h>
 #include <unity/scopes/internal/RegistryImpl.h>
 #include <unity/scopes/internal/RuntimeConfig.h>
@@ -75,6 +76,7 @@ RuntimeImpl::RuntimeImpl(string const& scope_id, string const& configfile)
 
         // By default, we use a logger that writes to std::clog.
         logger_.reset(new Logger(scope_id_));
+        metrics_.reset(new MetricsRegistry);
 
         // Create the middleware factory and get the registry identity and config filename.
         runtime_configfile_ = configfile;
@@ -93,6 +95,25 @@ RuntimeImpl::RuntimeImpl(string const& scope_id, string const& configfile)
             }
         }
 
+        // Switch to the background log writer before any other threads start logging.
+        if (config.log_async())
+        {
+            logger_->enable_async(config.log_async_queue_size());
+        }
+
+        // Profiling is process-wide, so we never turn it off again once a run time has enabled it.
+        if (config.profiling())
+        {
+            QueryProfile::enable(true);
+            for (int i = 0; ProfiledMutex::compiled_in() && i < ProfiledMutex::NumKinds; ++i)
+            {
+                auto const kind = ProfiledMutex::Kind(i);
+                string const prefix = string("lock.") + ProfiledMutex::name(kind);
+                metrics_->gauge_fn(prefix + ".waits", [kind]{ return ProfiledMutex::waits(kind); });
+                metrics_->gauge_fn(prefix + ".wait_us", [kind]{ return ProfiledMutex::wait_us(kind); });
+            }
+        }
+
         string default_middleware = config.default_middleware();
         string middleware_configfile = config.default_middleware_configfile();
         middleware_factory_.reset(new MiddlewareFactory(this));
@@ -106,7 +127,8 @@ RuntimeImpl::RuntimeImpl(string const& scope_id, string const& configfile)
         middleware_ = middleware_factory_->create(scope_id_, default_middleware, middleware_configfile);
         middleware_->start();
 
-        async_pool_ = make_shared<ThreadPool>(1); // TODO: configurable pool size
+        // TODO: configurable pool size
+        async_pool_ = make_shared<ThreadPool>(1, &metrics_->gauge("runtime.async_pool.backlog"));
         future_queue_ = make_shared<ThreadSafeQueue<future<void>>>();
         waiter_thread_ = std::thread([this]{ waiter_thread(future_queue_); });
 
@@ -309,6 +331,11 @@ internal::Logger& RuntimeImpl::logger() const
     return *logger_;
 }
 
+MetricsRegistry& RuntimeImpl::metrics() const
+{
+    return *metrics_;  // Immutable
+}
+
 namespace
 {
 
@@ -20,8 +20,10 @@
 
 #include <unity/scopes/ActionMetadata.h>
 #include <unity/scopes/internal/ActivationReplyObject.h>
+#include <unity/scopes/internal/lttng/UnityScopes_tp.h>
 #include <unity/scopes/internal/MiddlewareBase.h>
 #include <unity/scopes/internal/MWQueryCtrl.h>
+#include <unity/scopes/internal/MWReply.h>
 #include <unity/scopes/internal/MWScope.h>
 #include <unity/scopes/internal/PreviewReplyObject.h>
 #include <unity/scopes/internal/QueryCtrlImpl.h>
@@ -131,6 +133,7 @@ QueryCtrlProxy ScopeImpl::search(CannedQuery const& query,
 
     ReplyObject::SPtr ro(make_shared<ResultReplyObject>(reply, runtime_, to_string(), metadata.cardinality(), fwd()->debug_mode()));
     MWReplyProxy rp = fwd()->mw_base()->add_reply_object(ro);
+    ro->set_query_id(rp->identity());
 
     // "Fake" QueryCtrlProxy that doesn't have a real MWQueryCtrlProxy yet.
     shared_ptr<QueryCtrlImpl> ctrl = make_shared<QueryCtrlImpl>(nullptr, rp);
@@ -163,6 +166,7 @@ QueryCtrlProxy ScopeImpl::search(CannedQuery const& query,
             context["history"] = Variant(hist);
 
             // Forward the (synchronous) search() method across the bus.
+            simple_tracepoint(unity_scopes, query_sent, rp->identity().c_str(), impl->to_string().c_str(), "search");
             auto real_ctrl = dynamic_pointer_cast<QueryCtrlImpl>(impl->fwd()->search(query,
                                                                                      metadata.serialize(),
                                                                                      context,
@@ -206,6 +210,7 @@ QueryCtrlProxy ScopeImpl::activate(Result const& result,
 
     ReplyObject::SPtr ro(make_shared<ActivationReplyObject>(reply, runtime_, to_string(), fwd()->debug_mode()));
     MWReplyProxy rp = fwd()->mw_base()->add_reply_object(ro);
+    ro->set_query_id(rp->identity());
 
     shared_ptr<QueryCtrlImpl> ctrl = make_shared<QueryCtrlImpl>(nullptr, rp);
 
@@ -215,6 +220,7 @@ QueryCtrlProxy ScopeImpl::activate(Result const& result,
     {
         try
         {
+            simple_tracepoint(unity_scopes, query_sent, rp->identity().c_str(), impl->to_string().c_str(), "activate");
             auto real_ctrl = dynamic_pointer_cast<QueryCtrlImpl>(impl->fwd()->activate(result.p->activation_target(),
                                                                                        metadata.serialize(),
                                                                                        rp));
@@ -254,6 +260,7 @@ QueryCtrlProxy ScopeImpl::perform_action(Result const& result,
 
     ReplyObject::SPtr ro(make_shared<ActivationReplyObject>(reply, runtime_, to_string(), fwd()->debug_mode()));
     MWReplyProxy rp = fwd()->mw_base()->add_reply_object(ro);
+    ro->set_query_id(rp->identity());
 
     shared_ptr<QueryCtrlImpl> ctrl = make_shared<QueryCtrlImpl>(nullptr, rp);
 
@@ -263,6 +270,7 @@ QueryCtrlProxy ScopeImpl::perform_action(Result const& result,
     {
         try
         {
+            simple_tracepoint(unity_scopes, query_sent, rp->identity().c_str(), impl->to_string().c_str(), "perform_action");
             auto real_ctrl = dynamic_pointer_cast<QueryCtrlImpl>(impl->fwd()->perform_action(
                                                                                result.p->activation_target(),
                                                                                metadata.serialize(),
@@ -303,6 +311,7 @@ QueryCtrlProxy ScopeImpl::preview(Result const& result,
 
     ReplyObject::SPtr ro(make_shared<PreviewReplyObject>(reply, runtime_, to_string(), fwd()->debug_mode()));
     MWReplyProxy rp = fwd()->mw_base()->add_reply_object(ro);
+    ro->set_query_id(rp->identity());
 
     shared_ptr<QueryCtrlImpl> ctrl = make_shared<QueryCtrlImpl>(nullptr, rp);
 
@@ -312,6 +321,7 @@ QueryCtrlProxy ScopeImpl::preview(Result const& result,
     {
         try
         {
+            simple_tracepoint(unity_scopes, query_sent, rp->identity().c_str(), impl->to_string().c_str(), "preview");
             auto real_ctrl = dynamic_pointer_cast<QueryCtrlImpl>(impl->fwd()->preview(result.p->activation_target(),
                                                                                       hints.serialize(),
                                                                                       rp));
@@ -350,6 +360,7 @@ QueryCtrlProxy ScopeImpl::activate_result_action(Result const& result,
 
     ReplyObject::SPtr ro(make_shared<ActivationReplyObject>(reply, runtime_, to_string(), fwd()->debug_mode()));
     MWReplyProxy rp = fwd()->mw_base()->add_reply_object(ro);
+    ro->set_query_id(rp->identity());
 
     shared_ptr<QueryCtrlImpl> ctrl = make_shared<QueryCtrlImpl>(nullptr, rp);
 
@@ -359,6 +370,7 @@ QueryCtrlProxy ScopeImpl::activate_result_action(Result const& result,
     {
         try
         {
+            simple_tracepoint(unity_scopes, query_sent, rp->identity().c_str(), impl->to_string().c_str(), "activate_result_action");
             auto real_ctrl = dynamic_pointer_cast<QueryCtrlImpl>(impl->fwd()->activate_result_action(
                                                                                result.p->activation_target(),
                                                                                metadata.serialize(),
@@ -19,6 +19,7 @@
 #include <unity/scopes/internal/ScopeObject.h>
 
 #include <unity/scopes/internal/ActivationQueryObject.h>
+#include <unity/scopes/internal/lttng/UnityScopes_tp.h>
 #include <unity/scopes/internal/MWQuery.h>
 #include <unity/scopes/internal/MWReply.h>
 #include <unity/scopes/internal/PreviewQueryObject.h>
@@ -76,6 +77,9 @@ MWQueryCtrlProxy ScopeObject::query(MWReplyProxy const& reply,
                              + method + " called with null reply proxy");
     }
 
+    simple_tracepoint(unity_scopes, query_received, reply->identity().c_str(),
+                      mw_base->runtime()->scope_id().c_str(), method.c_str());
+
     // Ask scope to instantiate a new query.
     QueryBase::SPtr query_base;
     try
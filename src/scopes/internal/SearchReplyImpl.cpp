@@ -62,6 +62,7 @@ SearchReplyImpl::SearchReplyImpl(MWReplyProxy const& mw_proxy,
     , finished_(false)
     , query_string_(query_string)
     , current_department_(current_department_id)
+    , mutex_(ProfiledMutex::Reply)
 {
 }
 
@@ -84,7 +85,7 @@ void SearchReplyImpl::register_departments(Department::SCPtr const& parent)
 
     if (query_string_.empty())
     {
-        lock_guard<mutex> lock(mutex_);
+        lock_guard<ProfiledMutex> lock(mutex_);
         cached_departments_ = parent;
     }
 
@@ -152,7 +153,7 @@ bool SearchReplyImpl::push(unity::scopes::CategorisedResult const& result)
     // we can replay the results of the last successful surfacing query.
     if (query_string_.empty())
     {
-        lock_guard<mutex> lock(mutex_);
+        lock_guard<ProfiledMutex> lock(mutex_);
         cached_results_.push_back(result);
     }
 
@@ -189,7 +190,7 @@ bool SearchReplyImpl::push(unity::scopes::Filters const& filters)
 
     if (query_string_.empty())
     {
-        lock_guard<mutex> lock(mutex_);
+        lock_guard<ProfiledMutex> lock(mutex_);
         cached_filters_ = filters;
     }
 
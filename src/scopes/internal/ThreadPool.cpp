@@ -33,8 +33,9 @@ namespace scopes
 namespace internal
 {
 
-ThreadPool::ThreadPool(int num_threads)
+ThreadPool::ThreadPool(int num_threads, MetricsRegistry::Gauge* backlog)
     : queue_(new TaskQueue)
+    , backlog_(backlog)
     , state_(Created)
 {
     if (num_threads < 1)
@@ -101,6 +102,12 @@ void ThreadPool::destroy() noexcept
         threads[i].join();
     }
 
+    // Tasks that are still queued will never run.
+    if (backlog_)
+    {
+        backlog_->add(-int64_t(queue_->size()));
+    }
+
     lock_guard<mutex> lock(mutex_);
     state_ = Destroyed;
     cond_.notify_all();              // Wake up everyone else waiting for destruction to complete.
@@ -152,6 +159,10 @@ void ThreadPool::run()
         {
             return; // wait_and_pop() throws if the queue is destroyed while threads are blocked on it.
         }
+        if (backlog_)
+        {
+            backlog_->add(-1);
+        }
         task();
     }
 }
@@ -18,6 +18,7 @@
 
 #include <unity/scopes/internal/smartscopes/HttpClientNetCpp.h>
 
+#include <unity/scopes/internal/DfltConfig.h>
 #include <unity/UnityExceptions.h>
 
 #include <core/net/http/streaming_client.h>
@@ -26,6 +27,7 @@
 #include <core/net/http/status.h>
 
 #include <iostream>
+#include <set>
 #include <unordered_map>
 
 namespace net = core::net;
@@ -44,6 +46,10 @@ struct Cancelable
     void cancel()
     {
         cancelled.store(true);
+        if (on_cancel)
+        {
+            on_cancel();
+        }
     }
 
     bool is_cancelled() const
@@ -52,6 +58,7 @@ struct Cancelable
     }
 
     std::atomic<bool> cancelled{false};
+    std::function<void()> on_cancel;    // Set before the id is handed out
 };
 
 struct CancellationRegistry
@@ -101,8 +108,16 @@ struct CancellationRegistry
 }
 
 HttpClientNetCpp::HttpClientNetCpp(unsigned int no_reply_timeout)
+    : HttpClientNetCpp(no_reply_timeout, DFLT_SS_HTTP_CONNECTIONS_PER_HOST, DFLT_SS_HTTP_QUEUE_TIMEOUT)
+{
+}
+
+HttpClientNetCpp::HttpClientNetCpp(unsigned int no_reply_timeout,
+                                   unsigned int max_connections_per_host,
+                                   int queue_timeout)
     : no_reply_timeout{no_reply_timeout},
       client{http::make_streaming_client()},
+      limiter_{std::make_shared<HttpHostLimiter>(max_connections_per_host, std::chrono::minutes(5), queue_timeout)},
       worker([this]() { client->run(); })
 {
 }
@@ -119,7 +134,9 @@ HttpClientNetCpp::~HttpClientNetCpp()
 
 HttpResponseHandle::SPtr HttpClientNetCpp::get(std::string const& request_url,
                                                std::function<void(std::string const&)> const& line_data,
-                                               HttpHeaders const& headers)
+                                               HttpHeaders const& headers,
+                                               std::function<void(std::exception_ptr const&)> const& completed,
+                                               HttpConcurrency concurrency)
 {
     auto http_config = http::Request::Configuration::from_uri_as_string(request_url);
     http::Header http_header;
@@ -135,25 +152,55 @@ HttpResponseHandle::SPtr HttpClientNetCpp::get(std::string const& request_url,
     auto promise = std::make_shared<std::promise<void>>();
     std::shared_future<void> future(promise->get_future());
 
+    auto info = std::make_shared<HttpResponseInfo>();
+
     auto id_and_cancelable = CancellationRegistry::instance().add();
 
-    request->async_execute(
-                http::Request::Handler()
+    // Every request that was started gives its slot back exactly once, whichever way it ends.
+    // Unlimited requests don't have a slot to give back.
+    auto host = HttpHostLimiter::host_of(request_url);
+    auto limiter = concurrency == HttpConcurrency::Limited ? limiter_ : nullptr;
+    auto released = std::make_shared<std::atomic<bool>>(false);
+    auto release = [limiter, host, released]()
+    {
+        if (limiter && !released->exchange(true))
+        {
+            limiter->release(host);
+        }
+    };
+
+    auto handler = http::Request::Handler()
                     .on_progress([id_and_cancelable](const http::Request::Progress&)
                     {
                         return id_and_cancelable.second->is_cancelled() ?
                                     http::Request::Progress::Next::abort_operation :
                                     http::Request::Progress::Next::continue_operation;
                     })
-                    .on_response([line_data, promise](const http::Response& response)
+                    .on_response([line_data, promise, info, release, completed](const http::Response& response)
                     {
-                        if (response.status != http::Status::ok)
+                        info->status = static_cast<int>(response.status);
+                        response.header.enumerate([&info](std::string const& key, std::set<std::string> const& values)
+                        {
+                            for (auto const& value : values)
+                            {
+                                info->headers.push_back(std::make_pair(key, value));
+                            }
+                        });
+
+                        std::exception_ptr error;
+                        if (response.status == http::Status::not_modified)
+                        {
+                            // Reply to a conditional request, there is no body.
+                            promise->set_value();
+                        }
+                        else if (response.status != http::Status::ok)
                         {
                             std::ostringstream msg;
                             msg << "HTTP request failed with: " << response.status << std::endl << response.body;
                             unity::ResourceException e(msg.str());
 
-                            promise->set_exception(std::make_exception_ptr(e));
+                            error = std::make_exception_ptr(e);
+                            promise->set_exception(error);
                         }
                         else
                         {
@@ -161,21 +208,92 @@ HttpResponseHandle::SPtr HttpClientNetCpp::get(std::string const& request_url,
                             line_data("");
                             promise->set_value();
                         }
+                        release();
+                        if (completed)
+                        {
+                            completed(error);
+                        }
                     })
-                    .on_error([promise](const net::Error& e)
+                    .on_error([promise, release, completed](const net::Error& e)
                     {
                         unity::ResourceException re(e.what());
-                        promise->set_exception(std::make_exception_ptr(re));
-                    }),
-                [line_data](const std::string& const_data)
-                {
-                    line_data(const_data);
-                });
+                        auto error = std::make_exception_ptr(re);
+                        promise->set_exception(error);
+                        release();
+                        if (completed)
+                        {
+                            completed(error);
+                        }
+                    });
+
+    // A request that is waiting for a free slot fails as soon as it is cancelled or its
+    // queue timeout expires. The state decides whether the request starts or fails, so
+    // exactly one of the two happens. For a cancelled request, completed is called only
+    // once the slot comes up, so that it doesn't run inside cancel().
+    enum { Waiting, Started, Cancelled };
+    auto state = std::make_shared<std::atomic<int>>(Waiting);
+    id_and_cancelable.second->on_cancel = [state, promise]()
+    {
+        int expected = Waiting;
+        if (state->compare_exchange_strong(expected, Cancelled))
+        {
+            unity::ResourceException e("HTTP request cancelled");
+            promise->set_exception(std::make_exception_ptr(e));
+        }
+    };
+
+    auto start = [request, handler, line_data, state, completed]()
+    {
+        int expected = Waiting;
+        if (!state->compare_exchange_strong(expected, Started))
+        {
+            if (completed)
+            {
+                unity::ResourceException e("HTTP request cancelled");
+                completed(std::make_exception_ptr(e));
+            }
+            return false;  // The limiter passes the slot on to the next request.
+        }
+        request->async_execute(handler, [line_data](const std::string& const_data)
+        {
+            line_data(const_data);
+        });
+        return true;
+    };
+    auto timed_out = [state, promise, completed, host]()
+    {
+        unity::ResourceException e("HTTP request timed out waiting for a connection to " + host);
+        auto error = std::make_exception_ptr(e);
+        int expected = Waiting;
+        if (state->compare_exchange_strong(expected, Cancelled))
+        {
+            promise->set_exception(error);
+        }
+        // The limiter has dropped the request, so start() won't run, even if the request was cancelled.
+        if (completed)
+        {
+            completed(error);
+        }
+    };
+    if (limiter)
+    {
+        limiter->submit(host, start, timed_out);
+    }
+    else
+    {
+        start();
+    }
 
     return std::make_shared<HttpResponseHandle>(
                 shared_from_this(),
                 id_and_cancelable.first,
-                future);
+                future,
+                info);
+}
+
+HttpHostLimiter::Stats HttpClientNetCpp::stats() const
+{
+    return limiter_->stats();
 }
 
 void HttpClientNetCpp::cancel_get(unsigned int id)
@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/smartscopes/HttpHostLimiter.h>
+
+#include <unity/UnityExceptions.h>
+
+#include <algorithm>
+#include <cctype>
+
+using namespace std;
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace smartscopes
+{
+
+HttpHostLimiter::HttpHostLimiter(unsigned int max_per_host,
+                                 chrono::steady_clock::duration idle_expiry,
+                                 int queue_timeout)
+    : max_per_host_(max_per_host)
+    , idle_expiry_(idle_expiry)
+    , stats_{ 0, 0, 0, 0, 0 }
+{
+    if (max_per_host == 0)
+    {
+        throw unity::InvalidArgumentException("HttpHostLimiter(): max_per_host must be > 0");
+    }
+    if (queue_timeout < 1 && queue_timeout != -1)
+    {
+        throw unity::InvalidArgumentException("HttpHostLimiter(): queue_timeout must be > 0 or -1");
+    }
+    if (queue_timeout != -1)
+    {
+        queue_reaper_ = Reaper::create(1, queue_timeout);
+    }
+}
+
+HttpHostLimiter::~HttpHostLimiter()
+{
+    // Make sure that no timeout callback is running or can start once we go away.
+    if (queue_reaper_)
+    {
+        queue_reaper_->destroy();
+    }
+}
+
+void HttpHostLimiter::submit(string const& host, function<bool()> const& start, function<void()> const& timed_out)
+{
+    {
+        lock_guard<mutex> lock(mutex_);
+
+        auto const now = chrono::steady_clock::now();
+        expire_idle_hosts(now);
+
+        auto& h = hosts_[host];     // Value-initialized if new
+        h.last_used = now;
+        ++stats_.requests;
+        if (h.active >= max_per_host_)
+        {
+            ++stats_.queued;
+            auto w = make_shared<Waiter>();
+            w->start = start;
+            w->timed_out = timed_out;
+            if (queue_reaper_)
+            {
+                // The reaper never calls back with its own lock held, so this can't deadlock with expire_waiter().
+                weak_ptr<Waiter> weak_w(w);
+                w->reap_item = queue_reaper_->add([this, host, weak_w] { expire_waiter(host, weak_w); });
+            }
+            h.waiting.push_back(move(w));
+            return;
+        }
+        ++h.active;
+        stats_.max_active = max<uint64_t>(stats_.max_active, h.active);
+    }
+    if (!start())
+    {
+        release(host);
+    }
+}
+
+void HttpHostLimiter::release(string const& host)
+{
+    // The slot passes straight to the next waiting request, so active doesn't change.
+    // If that request was abandoned, the slot passes on to the one after it, and so on.
+    for (;;)
+    {
+        shared_ptr<Waiter> next;    // Destroyed (which cancels its reap item) without the lock held
+        {
+            lock_guard<mutex> lock(mutex_);
+
+            auto it = hosts_.find(host);
+            if (it == hosts_.end() || it->second.active == 0)
+            {
+                return;  // LCOV_EXCL_LINE  // Unbalanced release()
+            }
+            auto& h = it->second;
+            h.last_used = chrono::steady_clock::now();
+            if (h.waiting.empty())
+            {
+                --h.active;
+                return;
+            }
+            next = move(h.waiting.front());
+            h.waiting.pop_front();
+        }
+        if (next->reap_item)
+        {
+            next->reap_item->cancel();
+        }
+        if (next->start())
+        {
+            return;
+        }
+    }
+}
+
+void HttpHostLimiter::expire_waiter(string const& host, weak_ptr<Waiter> const& weak_w)
+{
+    shared_ptr<Waiter> w = weak_w.lock();   // Destroyed without the lock held
+    if (!w)
+    {
+        return;  // LCOV_EXCL_LINE
+    }
+    {
+        lock_guard<mutex> lock(mutex_);
+        auto it = hosts_.find(host);
+        if (it == hosts_.end())
+        {
+            return;  // LCOV_EXCL_LINE
+        }
+        auto& waiting = it->second.waiting;
+        auto pos = find(waiting.begin(), waiting.end(), w);
+        if (pos == waiting.end())
+        {
+            return;  // Started by release() just before it timed out.
+        }
+        waiting.erase(pos);
+        ++stats_.timed_out;
+    }
+    if (w->timed_out)
+    {
+        w->timed_out();
+    }
+}
+
+HttpHostLimiter::Stats HttpHostLimiter::stats() const
+{
+    lock_guard<mutex> lock(mutex_);
+    Stats s = stats_;
+    s.hosts = hosts_.size();
+    return s;
+}
+
+string HttpHostLimiter::host_of(string const& url)
+{
+    auto const scheme_end = url.find("://");
+    auto const host_begin = scheme_end == string::npos ? 0 : scheme_end + 3;
+    auto const host_end = url.find_first_of("/?#", host_begin);
+    string host = url.substr(0, host_end);
+    // Host names are case-insensitive.
+    transform(host.begin(), host.end(), host.begin(), [](char c) { return tolower(c); });
+    return host;
+}
+
+void HttpHostLimiter::expire_idle_hosts(chrono::steady_clock::time_point now)
+{
+    for (auto it = hosts_.begin(); it != hosts_.end(); )
+    {
+        if (it->second.active == 0 && it->second.waiting.empty() && now - it->second.last_used > idle_expiry_)
+        {
+            it = hosts_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+}  // namespace smartscopes
+
+}  // namespace internal
+
+}  // namespace scopes
+
+}  // namespace unity
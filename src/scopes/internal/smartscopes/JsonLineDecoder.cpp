@@ -0,0 +1,586 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/smartscopes/JsonLineDecoder.h>
+
+#include <cstdint>
+#include <locale>
+#include <sstream>
+
+using namespace std;
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace smartscopes
+{
+
+namespace
+{
+
+// Guards against stack exhaustion for maliciously nested input.
+const int max_depth = 256;
+
+void append_utf8(string& s, unsigned long cp)
+{
+    if (cp < 0x80)
+    {
+        s += char(cp);
+    }
+    else if (cp < 0x800)
+    {
+        s += char(0xc0 | (cp >> 6));
+        s += char(0x80 | (cp & 0x3f));
+    }
+    else if (cp < 0x10000)
+    {
+        s += char(0xe0 | (cp >> 12));
+        s += char(0x80 | ((cp >> 6) & 0x3f));
+        s += char(0x80 | (cp & 0x3f));
+    }
+    else
+    {
+        s += char(0xf0 | (cp >> 18));
+        s += char(0x80 | ((cp >> 12) & 0x3f));
+        s += char(0x80 | ((cp >> 6) & 0x3f));
+        s += char(0x80 | (cp & 0x3f));
+    }
+}
+
+bool is_digit(char c) noexcept
+{
+    return c >= '0' && c <= '9';
+}
+
+} // namespace
+
+JsonLineDecoder::JsonLineDecoder(char const* data, size_t size)
+    : data_(data)
+    , size_(size)
+    , pos_(0)
+    , first_member_(false)
+    , depth_(0)
+{
+}
+
+JsonLineDecoder::JsonLineDecoder(string const& json)
+    : JsonLineDecoder(json.data(), json.size())
+{
+}
+
+void JsonLineDecoder::begin_object()
+{
+    skip_ws();
+    expect('{');
+    first_member_ = true;
+}
+
+// Reads the name of the next member of the current object and the colon that follows it,
+// or the closing brace if there are no more members.
+
+bool JsonLineDecoder::next_member(string& name)
+{
+    skip_ws();
+    if (peek() == '}')
+    {
+        ++pos_;
+        first_member_ = false;
+        return false;
+    }
+    if (!first_member_)
+    {
+        expect(',');
+        skip_ws();
+    }
+    first_member_ = false;
+    if (peek() != '"')
+    {
+        throw error("expected member name");
+    }
+    name.clear();
+    decode_string(&name);
+    skip_ws();
+    expect(':');
+    return true;
+}
+
+Variant JsonLineDecoder::value()
+{
+    Variant v;
+    decode_value(&v);
+    return v;
+}
+
+string JsonLineDecoder::string_value()
+{
+    skip_ws();
+    if (peek() != '"')
+    {
+        throw error("expected string");
+    }
+    string s;
+    decode_string(&s);
+    return s;
+}
+
+void JsonLineDecoder::skip_value()
+{
+    decode_value(nullptr);
+}
+
+string::size_type JsonLineDecoder::mark()
+{
+    skip_ws();
+    return pos_;
+}
+
+string JsonLineDecoder::text_since(string::size_type mark) const
+{
+    return string(data_ + mark, pos_ - mark);
+}
+
+void JsonLineDecoder::finish()
+{
+    skip_ws();
+    if (pos_ != size_)
+    {
+        throw error("unexpected trailing characters");
+    }
+}
+
+void JsonLineDecoder::skip_ws() noexcept
+{
+    while (pos_ < size_)
+    {
+        char c = data_[pos_];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r')
+        {
+            break;
+        }
+        ++pos_;
+    }
+}
+
+char JsonLineDecoder::peek() const
+{
+    if (pos_ >= size_)
+    {
+        throw error("unexpected end of input");
+    }
+    return data_[pos_];
+}
+
+void JsonLineDecoder::expect(char c)
+{
+    if (peek() != c)
+    {
+        throw error(string("expected '") + c + "'");
+    }
+    ++pos_;
+}
+
+void JsonLineDecoder::expect_literal(char const* literal)
+{
+    auto const start = pos_;
+    for (char const* p = literal; *p; ++p)
+    {
+        if (pos_ >= size_ || data_[pos_] != *p)
+        {
+            pos_ = start;
+            throw error("invalid literal");
+        }
+        ++pos_;
+    }
+}
+
+void JsonLineDecoder::decode_value(Variant* v)
+{
+    skip_ws();
+    switch (peek())
+    {
+        case '{':
+        {
+            if (++depth_ > max_depth)
+            {
+                throw error("nesting too deep");
+            }
+            VariantMap vm;
+            begin_object();
+            string name;
+            while (next_member(name))
+            {
+                if (v)
+                {
+                    Variant member;
+                    decode_value(&member);
+                    vm[name] = std::move(member);
+                }
+                else
+                {
+                    decode_value(nullptr);
+                }
+            }
+            --depth_;
+            if (v)
+            {
+                *v = Variant(std::move(vm));
+            }
+            break;
+        }
+        case '[':
+        {
+            if (++depth_ > max_depth)
+            {
+                throw error("nesting too deep");
+            }
+            ++pos_;
+            VariantArray va;
+            skip_ws();
+            if (peek() == ']')
+            {
+                ++pos_;
+            }
+            else
+            {
+                for (;;)
+                {
+                    if (v)
+                    {
+                        va.emplace_back();
+                        decode_value(&va.back());
+                    }
+                    else
+                    {
+                        decode_value(nullptr);
+                    }
+                    skip_ws();
+                    if (peek() == ']')
+                    {
+                        ++pos_;
+                        break;
+                    }
+                    expect(',');
+                }
+            }
+            --depth_;
+            if (v)
+            {
+                *v = Variant(std::move(va));
+            }
+            break;
+        }
+        case '"':
+        {
+            if (v)
+            {
+                string s;
+                decode_string(&s);
+                *v = Variant(std::move(s));
+            }
+            else
+            {
+                decode_string(nullptr);
+            }
+            break;
+        }
+        case 't':
+        {
+            expect_literal("true");
+            if (v)
+            {
+                *v = Variant(true);
+            }
+            break;
+        }
+        case 'f':
+        {
+            expect_literal("false");
+            if (v)
+            {
+                *v = Variant(false);
+            }
+            break;
+        }
+        case 'n':
+        {
+            expect_literal("null");
+            if (v)
+            {
+                *v = Variant::null();
+            }
+            break;
+        }
+        default:
+        {
+            decode_number(v);
+            break;
+        }
+    }
+}
+
+// Decodes the string that starts at the current position (at the opening quote).
+// Runs of unescaped characters are appended in one go.
+
+void JsonLineDecoder::decode_string(string* s)
+{
+    ++pos_;  // Opening quote
+    for (;;)
+    {
+        auto run_start = pos_;
+        while (pos_ < size_)
+        {
+            unsigned char c = data_[pos_];
+            if (c == '"' || c == '\\' || c < 0x20)
+            {
+                break;
+            }
+            ++pos_;
+        }
+        if (s && pos_ != run_start)
+        {
+            s->append(data_ + run_start, pos_ - run_start);
+        }
+
+        char c = peek();
+        ++pos_;
+        if (c == '"')
+        {
+            return;
+        }
+        if (c != '\\')
+        {
+            --pos_;
+            throw error("control character in string");
+        }
+
+        char esc = peek();
+        ++pos_;
+        char decoded = esc;  // Correct for \", \\, and \/
+        switch (esc)
+        {
+            case '"':
+            case '\\':
+            case '/':
+                break;
+            case 'b':
+                decoded = '\b';
+                break;
+            case 'f':
+                decoded = '\f';
+                break;
+            case 'n':
+                decoded = '\n';
+                break;
+            case 'r':
+                decoded = '\r';
+                break;
+            case 't':
+                decoded = '\t';
+                break;
+            case 'u':
+            {
+                unsigned long cp = decode_hex4();
+                if (cp >= 0xd800 && cp <= 0xdbff)
+                {
+                    // High surrogate, must be followed by a low surrogate.
+                    if (pos_ + 1 >= size_ || data_[pos_] != '\\' || data_[pos_ + 1] != 'u')
+                    {
+                        throw error("unpaired surrogate in \\u escape");
+                    }
+                    pos_ += 2;
+                    unsigned long low = decode_hex4();
+                    if (low < 0xdc00 || low > 0xdfff)
+                    {
+                        throw error("unpaired surrogate in \\u escape");
+                    }
+                    cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+                }
+                else if (cp >= 0xdc00 && cp <= 0xdfff)
+                {
+                    throw error("unpaired surrogate in \\u escape");
+                }
+                if (s)
+                {
+                    append_utf8(*s, cp);
+                }
+                continue;
+            }
+            default:
+            {
+                pos_ -= 2;
+                throw error("invalid escape sequence");
+            }
+        }
+        if (s)
+        {
+            *s += decoded;
+        }
+    }
+}
+
+unsigned long JsonLineDecoder::decode_hex4()
+{
+    if (size_ - pos_ < 4)
+    {
+        throw error("truncated \\u escape");
+    }
+    unsigned long cp = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        char c = data_[pos_++];
+        cp <<= 4;
+        if (is_digit(c))
+        {
+            cp |= c - '0';
+        }
+        else if (c >= 'a' && c <= 'f')
+        {
+            cp |= c - 'a' + 10;
+        }
+        else if (c >= 'A' && c <= 'F')
+        {
+            cp |= c - 'A' + 10;
+        }
+        else
+        {
+            throw error("invalid \\u escape");
+        }
+    }
+    return cp;
+}
+
+// Integers that fit into 32 bits become Int variants, integers that fit into 64 bits become
+// Int64 variants, and everything else becomes a Double. This matches JsonCppNode::to_variant().
+
+void JsonLineDecoder::decode_number(Variant* v)
+{
+    auto const start = pos_;
+    bool negative = false;
+    if (pos_ < size_ && data_[pos_] == '-')
+    {
+        negative = true;
+        ++pos_;
+    }
+    auto const int_start = pos_;
+    while (pos_ < size_ && is_digit(data_[pos_]))
+    {
+        ++pos_;
+    }
+    if (pos_ == int_start)
+    {
+        pos_ = start;
+        throw error("invalid value");
+    }
+    bool is_integer = true;
+    if (pos_ < size_ && data_[pos_] == '.')
+    {
+        is_integer = false;
+        auto const frac_start = ++pos_;
+        while (pos_ < size_ && is_digit(data_[pos_]))
+        {
+            ++pos_;
+        }
+        if (pos_ == frac_start)
+        {
+            throw error("invalid number");
+        }
+    }
+    if (pos_ < size_ && (data_[pos_] == 'e' || data_[pos_] == 'E'))
+    {
+        is_integer = false;
+        ++pos_;
+        if (pos_ < size_ && (data_[pos_] == '+' || data_[pos_] == '-'))
+        {
+            ++pos_;
+        }
+        auto const exp_start = pos_;
+        while (pos_ < size_ && is_digit(data_[pos_]))
+        {
+            ++pos_;
+        }
+        if (pos_ == exp_start)
+        {
+            throw error("invalid number");
+        }
+    }
+    if (!v)
+    {
+        return;
+    }
+
+    if (is_integer)
+    {
+        // Accumulate the magnitude as unsigned, so the value can be as small as INT64_MIN.
+        uint64_t const limit = negative ? uint64_t(INT64_MAX) + 1 : uint64_t(INT64_MAX);
+        uint64_t magnitude = 0;
+        bool overflow = false;
+        for (auto i = int_start; i < pos_ && !overflow; ++i)
+        {
+            unsigned const digit = data_[i] - '0';
+            if (magnitude > (limit - digit) / 10)
+            {
+                overflow = true;
+            }
+            else
+            {
+                magnitude = magnitude * 10 + digit;
+            }
+        }
+        if (!overflow)  // Integers outside the int64_t range become a Double below.
+        {
+            int64_t val64 = negative && magnitude != 0 ? -int64_t(magnitude - 1) - 1 : int64_t(magnitude);
+            if (val64 < INT32_MIN || val64 > INT32_MAX)
+            {
+                *v = Variant(val64);
+            }
+            else
+            {
+                *v = Variant(int(val64));
+            }
+            return;
+        }
+    }
+
+    // Don't use strtod(), which depends on the LC_NUMERIC locale.
+    istringstream s(string(data_ + start, pos_ - start));
+    s.imbue(locale::classic());
+    double d;
+    s >> d;
+    *v = Variant(d);
+}
+
+unity::ResourceException JsonLineDecoder::error(string const& msg) const
+{
+    ostringstream s;
+    s << "JsonLineDecoder: parse error at offset " << pos_ << ": " << msg;
+    return unity::ResourceException(s.str());
+}
+
+} // namespace smartscopes
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/smartscopes/NdjsonFramer.h>
+
+#include <cassert>
+#include <cstring>
+
+using namespace std;
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace smartscopes
+{
+
+NdjsonFramer::NdjsonFramer(LineHandler const& handler)
+    : handler_(handler)
+{
+    assert(handler_);
+}
+
+void NdjsonFramer::feed(string const& chunk)
+{
+    if (chunk.empty())
+    {
+        // End of response.
+        string line;
+        line.swap(tail_);
+        deliver(line.data(), line.size());
+        return;
+    }
+
+    char const* begin = chunk.data();
+    char const* const end = begin + chunk.size();
+    char const* nl = static_cast<char const*>(memchr(begin, '\n', end - begin));
+
+    if (!tail_.empty())
+    {
+        if (!nl)
+        {
+            tail_.append(begin, end);
+            return;
+        }
+        // Complete the line that the previous chunk started.
+        string line;
+        line.swap(tail_);
+        line.append(begin, nl);
+        begin = nl + 1;
+        deliver(line.data(), line.size());
+        nl = static_cast<char const*>(memchr(begin, '\n', end - begin));
+    }
+
+    while (nl)
+    {
+        deliver(begin, nl - begin);
+        begin = nl + 1;
+        nl = static_cast<char const*>(memchr(begin, '\n', end - begin));
+    }
+
+    tail_.assign(begin, end);
+}
+
+size_t NdjsonFramer::buffered() const noexcept
+{
+    return tail_.size();
+}
+
+void NdjsonFramer::deliver(char const* line, size_t size)
+{
+    if (size != 0 && line[size - 1] == '\r')
+    {
+        --size;
+    }
+    if (size != 0)
+    {
+        handler_(line, size);
+    }
+}
+
+} // namespace smartscopes
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
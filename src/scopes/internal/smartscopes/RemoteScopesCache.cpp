@@ -0,0 +1,434 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/smartscopes/RemoteScopesCache.h>
+
+#include <unity/UnityExceptions.h>
+#include <unity/util/NonCopyable.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace smartscopes
+{
+
+namespace
+{
+
+// File layout (native byte order; byte_order detects a file copied from a different architecture):
+//
+//   Header
+//   count records, each:
+//     uint32 flags, int32 version, uint32 results_ttl_type,
+//     strings id, name, description, author, base_url,
+//     optional strings icon, art, appearance (JSON), settings (JSON), as indicated by flags,
+//     uint32 keyword count, followed by the keyword strings.
+//
+// A string is a uint32 length followed by that many bytes, without terminator or padding.
+// Integers are not aligned and are copied out of the mapping with memcpy().
+
+char const magic[8] = { 'U', 'S', 'C', 'R', 'S', 'C', 'B', 'N' };
+uint32_t const format_version = 1;
+uint32_t const byte_order_mark = 0x01020304;
+uint64_t const min_record_size = 3 * sizeof(uint32_t) + 5 * sizeof(uint32_t) + sizeof(uint32_t);
+
+struct Header
+{
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t version;
+    uint64_t size;              // Size of the whole file
+    uint64_t count;             // Number of records
+    uint64_t json_size;         // Size and modification time of the JSON file
+    int64_t json_mtime_sec;
+    int64_t json_mtime_nsec;
+};
+
+// Record flags
+uint32_t const HasIcon = 1 << 0;
+uint32_t const HasArt = 1 << 1;
+uint32_t const HasAppearance = 1 << 2;
+uint32_t const HasSettings = 1 << 3;
+uint32_t const HasNeedsLocationData = 1 << 4;
+uint32_t const NeedsLocationData = 1 << 5;
+uint32_t const Invisible = 1 << 6;
+
+bool stat_json(string const& json_path, Header& h)
+{
+    struct stat st;
+    if (::stat(json_path.c_str(), &st) != 0)
+    {
+        return false;
+    }
+    h.json_size = st.st_size;
+    h.json_mtime_sec = st.st_mtim.tv_sec;
+    h.json_mtime_nsec = st.st_mtim.tv_nsec;
+    return true;
+}
+
+bool header_ok(Header const& h, uint64_t file_size, string const& json_path)
+{
+    Header json;
+    return memcmp(h.magic, magic, sizeof(magic)) == 0
+           && h.byte_order == byte_order_mark
+           && h.version == format_version
+           && h.size == file_size
+           && h.count <= (file_size - sizeof(Header)) / min_record_size
+           && stat_json(json_path, json)
+           && h.json_size == json.json_size
+           && h.json_mtime_sec == json.json_mtime_sec
+           && h.json_mtime_nsec == json.json_mtime_nsec;
+}
+
+template<typename T>
+void put(string& buf, T val)
+{
+    buf.append(reinterpret_cast<char const*>(&val), sizeof(val));
+}
+
+void put(string& buf, string const& s)
+{
+    put(buf, uint32_t(s.size()));
+    buf.append(s);
+}
+
+// Reads values from the mapped file. Every read is bounds-checked, so a damaged
+// file makes a read fail instead of reading past the end of the mapping.
+
+class Cursor
+{
+public:
+    Cursor(char const* pos, char const* end)
+        : pos_(pos)
+        , end_(end)
+    {
+    }
+
+    template<typename T>
+    bool get(T& val)
+    {
+        if (size_t(end_ - pos_) < sizeof(val))
+        {
+            return false;
+        }
+        memcpy(&val, pos_, sizeof(val));
+        pos_ += sizeof(val);
+        return true;
+    }
+
+    bool get(string& s)
+    {
+        uint32_t len;
+        if (!get(len) || size_t(end_ - pos_) < len)
+        {
+            return false;
+        }
+        s.assign(pos_, len);
+        pos_ += len;
+        return true;
+    }
+
+    bool at_end() const
+    {
+        return pos_ == end_;
+    }
+
+private:
+    char const* pos_;
+    char const* end_;
+};
+
+bool get_optional(Cursor& c, uint32_t flags, uint32_t flag, shared_ptr<string>& s)
+{
+    if (flags & flag)
+    {
+        s = make_shared<string>();
+        return c.get(*s);
+    }
+    return true;
+}
+
+bool get_scope(Cursor& c, RemoteScope& scope)
+{
+    uint32_t flags;
+    int32_t version;
+    uint32_t ttl_type;
+    if (!c.get(flags) || !c.get(version) || !c.get(ttl_type)
+        || ttl_type > uint32_t(ScopeMetadata::ResultsTtlType::Large))
+    {
+        return false;
+    }
+    scope.version = version;
+    scope.results_ttl_type = static_cast<ScopeMetadata::ResultsTtlType>(ttl_type);
+    scope.invisible = flags & Invisible;
+    if (flags & HasNeedsLocationData)
+    {
+        scope.needs_location_data = make_shared<bool>(flags & NeedsLocationData);
+    }
+
+    if (!c.get(scope.id) || !c.get(scope.name) || !c.get(scope.description) || !c.get(scope.author)
+        || !c.get(scope.base_url) || !get_optional(c, flags, HasIcon, scope.icon)
+        || !get_optional(c, flags, HasArt, scope.art))
+    {
+        return false;
+    }
+
+    if (flags & HasAppearance)
+    {
+        string json;
+        if (!c.get(json))
+        {
+            return false;
+        }
+        try
+        {
+            scope.appearance = make_shared<VariantMap>(Variant::deserialize_json(json).get_dict());
+        }
+        catch (std::exception const&)
+        {
+            return false;
+        }
+    }
+
+    if (!get_optional(c, flags, HasSettings, scope.settings))
+    {
+        return false;
+    }
+
+    uint32_t keyword_count;
+    if (!c.get(keyword_count))
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < keyword_count; ++i)
+    {
+        string keyword;
+        if (!c.get(keyword))
+        {
+            return false;
+        }
+        scope.keywords.insert(move(keyword));
+    }
+    return true;
+}
+
+// Maps a file read-only and unmaps it again on destruction.
+
+class MappedFile
+{
+public:
+    NONCOPYABLE(MappedFile);
+
+    explicit MappedFile(string const& path)
+        : addr_(MAP_FAILED)
+        , size_(0)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+        {
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(Header))
+        {
+            size_ = st.st_size;
+            addr_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);  // The mapping stays valid.
+    }
+
+    ~MappedFile()
+    {
+        if (addr_ != MAP_FAILED)
+        {
+            munmap(addr_, size_);
+        }
+    }
+
+    bool valid() const
+    {
+        return addr_ != MAP_FAILED;
+    }
+
+    char const* data() const
+    {
+        return static_cast<char const*>(addr_);
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+private:
+    void* addr_;
+    size_t size_;
+};
+
+}  // namespace
+
+void RemoteScopesCache::write(string const& path, string const& json_path, vector<RemoteScope> const& scopes)
+{
+    Header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, magic, sizeof(magic));
+    h.byte_order = byte_order_mark;
+    h.version = format_version;
+    h.count = scopes.size();
+    if (!stat_json(json_path, h))
+    {
+        throw unity::ResourceException("RemoteScopesCache::write(): cannot stat " + json_path);
+    }
+
+    string buf(sizeof(Header), '\0');
+    for (auto const& scope : scopes)
+    {
+        uint32_t flags = 0;
+        flags |= scope.icon ? HasIcon : 0u;
+        flags |= scope.art ? HasArt : 0u;
+        flags |= scope.appearance ? HasAppearance : 0u;
+        flags |= scope.settings ? HasSettings : 0u;
+        flags |= scope.needs_location_data ? HasNeedsLocationData : 0u;
+        flags |= scope.needs_location_data && *scope.needs_location_data ? NeedsLocationData : 0u;
+        flags |= scope.invisible ? Invisible : 0u;
+
+        put(buf, flags);
+        put(buf, int32_t(scope.version));
+        put(buf, uint32_t(scope.results_ttl_type));
+        put(buf, scope.id);
+        put(buf, scope.name);
+        put(buf, scope.description);
+        put(buf, scope.author);
+        put(buf, scope.base_url);
+        if (scope.icon)
+        {
+            put(buf, *scope.icon);
+        }
+        if (scope.art)
+        {
+            put(buf, *scope.art);
+        }
+        if (scope.appearance)
+        {
+            put(buf, Variant(*scope.appearance).serialize_json());
+        }
+        if (scope.settings)
+        {
+            put(buf, *scope.settings);
+        }
+        put(buf, uint32_t(scope.keywords.size()));
+        for (auto const& keyword : scope.keywords)
+        {
+            put(buf, keyword);
+        }
+    }
+    h.size = buf.size();
+    memcpy(&buf[0], &h, sizeof(h));
+
+    auto const tmp_path = path + ".tmp";
+    {
+        ofstream f(tmp_path, ios::binary | ios::trunc);
+        f.write(buf.data(), buf.size());
+        f.close();
+        if (!f)
+        {
+            ::remove(tmp_path.c_str());
+            throw unity::ResourceException("RemoteScopesCache::write(): cannot write " + tmp_path);
+        }
+    }
+    // Rename is atomic, so a concurrent reader never sees a partially written file.
+    if (::rename(tmp_path.c_str(), path.c_str()) != 0)
+    {
+        ::remove(tmp_path.c_str());
+        throw unity::ResourceException("RemoteScopesCache::write(): cannot rename " + tmp_path + " to " + path);
+    }
+}
+
+bool RemoteScopesCache::read(string const& path, string const& json_path, vector<RemoteScope>& scopes)
+{
+    MappedFile file(path);
+    if (!file.valid())
+    {
+        return false;
+    }
+
+    Header h;
+    memcpy(&h, file.data(), sizeof(h));
+    if (!header_ok(h, file.size(), json_path))
+    {
+        return false;
+    }
+
+    Cursor c(file.data() + sizeof(h), file.data() + file.size());
+    vector<RemoteScope> result;
+    result.reserve(h.count);
+    for (uint64_t i = 0; i < h.count; ++i)
+    {
+        RemoteScope scope;
+        if (!get_scope(c, scope))
+        {
+            return false;
+        }
+        result.push_back(move(scope));
+    }
+    if (!c.at_end())
+    {
+        return false;
+    }
+
+    scopes.swap(result);
+    return true;
+}
+
+bool RemoteScopesCache::is_current(string const& path, string const& json_path)
+{
+    ifstream f(path, ios::binary);
+    Header h;
+    if (!f.read(reinterpret_cast<char*>(&h), sizeof(h)))
+    {
+        return false;
+    }
+    f.seekg(0, ios::end);
+    return header_ok(h, uint64_t(f.tellg()), json_path);
+}
+
+}  // namespace smartscopes
+
+}  // namespace internal
+
+}  // namespace scopes
+
+}  // namespace unity
@@ -41,9 +41,14 @@ namespace
 {
     const string ss_config_group = "Smartscopes";
     const string http_reply_timeout_key = "Http.Reply.Timeout";
+    const string http_connections_per_host_key = "Http.Connections.Per.Host";
+    const string http_queue_timeout_key = "Http.Queue.Timeout";
     const string reg_refresh_rate_key = "Registry.Refresh.Rate";
     const string reg_refresh_fail_timeout_key = "Registry.Refresh.Fail.Timeout";
     const string scope_identity_key = "Scope.Identity";
+    const string search_cache_size_key = "Search.Cache.Size";
+    const string search_cache_dir_key = "Search.Cache.Dir";
+    const string search_cache_dir_size_key = "Search.Cache.Dir.Size";
 }
 
 SSConfig::SSConfig(string const& configfile) :
@@ -52,9 +57,13 @@ SSConfig::SSConfig(string const& configfile) :
     if (configfile.empty())
     {
         http_reply_timeout_ = DFLT_SS_HTTP_TIMEOUT;
+        http_connections_per_host_ = DFLT_SS_HTTP_CONNECTIONS_PER_HOST;
+        http_queue_timeout_ = DFLT_SS_HTTP_QUEUE_TIMEOUT;
         reg_refresh_rate_ = DFLT_SS_REG_REFRESH_RATE;
         reg_refresh_fail_timeout_ = DFLT_SS_REG_REFRESH_FAIL_TIMEOUT;
         scope_identity_ = DFLT_SS_SCOPE_IDENTITY;
+        search_cache_size_ = DFLT_SS_SEARCH_CACHE_SIZE;
+        search_cache_dir_size_ = DFLT_SS_SEARCH_CACHE_DIR_SIZE;
     }
     else
     {
@@ -65,6 +74,23 @@ SSConfig::SSConfig(string const& configfile) :
                      http_reply_timeout_key + ": value must be 10 - 60");
         }
 
+        http_connections_per_host_ = get_optional_int(ss_config_group,
+                                                      http_connections_per_host_key,
+                                                http_queue_timeout_key,
+                                                      DFLT_SS_HTTP_CONNECTIONS_PER_HOST);
+        if (http_connections_per_host_ < 1)
+        {
+            throw_ex("Illegal value (" + to_string(http_connections_per_host_) + ") for " +
+                     http_connections_per_host_key + ": value must be >= 1");
+        }
+
+        http_queue_timeout_ = get_optional_int(ss_config_group, http_queue_timeout_key, DFLT_SS_HTTP_QUEUE_TIMEOUT);
+        if (http_queue_timeout_ < 1 || http_queue_timeout_ > 60)
+        {
+            throw_ex("Illegal value (" + to_string(http_queue_timeout_) + ") for " +
+                     http_queue_timeout_key + ": value must be 1 - 60");
+        }
+
         reg_refresh_rate_ = get_optional_int(ss_config_group, reg_refresh_rate_key, DFLT_SS_REG_REFRESH_RATE);
         if (reg_refresh_rate_ < 60)
         {
@@ -82,15 +108,37 @@ SSConfig::SSConfig(string const& configfile) :
         }
 
         scope_identity_ = get_optional_string(ss_config_group, scope_identity_key, DFLT_SS_SCOPE_IDENTITY);
+
+        search_cache_size_ = get_optional_int(ss_config_group, search_cache_size_key, DFLT_SS_SEARCH_CACHE_SIZE);
+        if (search_cache_size_ < 0)
+        {
+            throw_ex("Illegal value (" + to_string(search_cache_size_) + ") for " +
+                     search_cache_size_key + ": value must be >= 0");
+        }
+
+        search_cache_dir_ = get_optional_string(ss_config_group, search_cache_dir_key);
+
+        search_cache_dir_size_ = get_optional_int(ss_config_group,
+                                                  search_cache_dir_size_key,
+                                                  DFLT_SS_SEARCH_CACHE_DIR_SIZE);
+        if (search_cache_dir_size_ < 1)
+        {
+            throw_ex("Illegal value (" + to_string(search_cache_dir_size_) + ") for " +
+                     search_cache_dir_size_key + ": value must be >= 1");
+        }
     }
 
     const KnownEntries known_entries = {
                                           {  ss_config_group,
                                              {
                                                 http_reply_timeout_key,
+                                                http_connections_per_host_key,
                                                 reg_refresh_rate_key,
                                                 reg_refresh_fail_timeout_key,
                                                 scope_identity_key,
+                                                search_cache_size_key,
+                                                search_cache_dir_key,
+                                                search_cache_dir_size_key,
                                              }
                                           }
                                        };
@@ -106,6 +154,16 @@ int SSConfig::http_reply_timeout() const
     return http_reply_timeout_;
 }
 
+int SSConfig::http_connections_per_host() const
+{
+    return http_connections_per_host_;
+}
+
+int SSConfig::http_queue_timeout() const
+{
+    return http_queue_timeout_;
+}
+
 int SSConfig::reg_refresh_rate() const
 {
     return reg_refresh_rate_;
@@ -121,6 +179,21 @@ string SSConfig::scope_identity() const
     return scope_identity_;
 }
 
+int SSConfig::search_cache_size() const
+{
+    return search_cache_size_;
+}
+
+string SSConfig::search_cache_dir() const
+{
+    return search_cache_dir_;
+}
+
+int SSConfig::search_cache_dir_size() const
+{
+    return search_cache_dir_size_;
+}
+
 } // namespace smartscopes
 
 } // namespace internal
@@ -24,6 +24,7 @@
 #include <unity/scopes/internal/PreviewReplyImpl.h>
 #include <unity/scopes/internal/RuntimeImpl.h>
 #include <unity/scopes/internal/SearchReplyImpl.h>
+#include <unity/scopes/internal/smartscopes/SmartScope.h>
 #include <unity/scopes/PreviewQueryBase.h>
 #include <unity/scopes/PreviewReply.h>
 #include <unity/scopes/ScopeExceptions.h>
@@ -58,7 +59,10 @@ SSQueryObject::~SSQueryObject()
 
 void SSQueryObject::run(MWReplyProxy const& reply, InvokeInfo const& info) noexcept
 {
-    decltype(queries_.begin()) query_it;
+    // The query may complete (and be removed from queries_) on another thread
+    // while we are still here, so we hold on to it.
+    SSQuery::SPtr query;
+    bool pending = false;
 
     try
     {
@@ -66,27 +70,28 @@ void SSQueryObject::run(MWReplyProxy const& reply, InvokeInfo const& info) noexc
             std::lock_guard<std::mutex> lock(queries_mutex_);
 
             // find the targeted query according to InvokeInfo
-            query_it = queries_.find(reply->identity());
+            auto query_it = queries_.find(reply->identity());
 
             if (query_it == end(queries_))
             {
                 throw ObjectNotExistException("Query does not exist", reply->identity());
             }
+            query = query_it->second;
         }
 
-        if (query_it->second->q_pushable)
+        if (query->q_pushable)
         {
-            if (query_it->second->q_type == SSQuery::Query)
+            if (query->q_type == SSQuery::Query)
             {
-                run_query(query_it->second, reply);
+                pending = run_query(query, reply);
             }
-            else if (query_it->second->q_type == SSQuery::Preview)
+            else if (query->q_type == SSQuery::Preview)
             {
-                run_preview(query_it->second, reply);
+                pending = run_preview(query, reply);
             }
-            else if (query_it->second->q_type == SSQuery::Activation)
+            else if (query->q_type == SSQuery::Activation)
             {
-                run_activation(query_it->second, reply);
+                run_activation(query, reply);
             }
         }
     }
@@ -94,7 +99,10 @@ void SSQueryObject::run(MWReplyProxy const& reply, InvokeInfo const& info) noexc
     {
         std::lock_guard<std::mutex> lock(queries_mutex_);
 
-        query_it->second->q_pushable = false;
+        if (query)
+        {
+            query->q_pushable = false;
+        }
         info.mw->runtime()->logger()() << "SSQueryObject::run(): " << e.what();
         reply->finished(CompletionDetails(CompletionDetails::Error, e.what()));  // Oneway, can't block
     }
@@ -102,22 +110,24 @@ void SSQueryObject::run(MWReplyProxy const& reply, InvokeInfo const& info) noexc
     {
         std::lock_guard<std::mutex> lock(queries_mutex_);
 
-        query_it->second->q_pushable = false;
+        if (query)
+        {
+            query->q_pushable = false;
+        }
         info.mw->runtime()->logger()() << "SSQueryObject::run(): unknown exception";
         reply->finished(CompletionDetails(CompletionDetails::Error, "unknown exception"));  // Oneway, can't block
     }
 
+    if (!pending)
     {
-        std::lock_guard<std::mutex> lock(queries_mutex_);
-
         // the query is complete so this is no longer needed
-        queries_.erase(reply->identity());
+        query_done(reply->identity());
     }
 }
 
 void SSQueryObject::cancel(InvokeInfo const& info)
 {
-    std::lock_guard<std::mutex> lock(queries_mutex_);
+    std::unique_lock<std::mutex> lock(queries_mutex_);
 
     std::string reply_id = info.id;
     reply_id.resize(reply_id.size() - 2);  // remove the ".c" suffix
@@ -130,7 +140,7 @@ void SSQueryObject::cancel(InvokeInfo const& info)
         throw ObjectNotExistException("Query does not exist", info.id);
     }
 
-    QueryBase::SPtr const& q_base = query_it->second->q_base;
+    QueryBase::SPtr q_base = query_it->second->q_base;
     MWReplyProxy const& q_reply = query_it->second->q_reply;
 
     // this query is cancelled so replies are no longer pushable
@@ -146,6 +156,8 @@ void SSQueryObject::cancel(InvokeInfo const& info)
 
     // Forward the cancellation to the query base (which in turn will forward it to any subqueries).
     // The query base also calls the cancelled() callback to inform the application code.
+    // Replies that are being pushed concurrently need the lock for pushable(), so we release it first.
+    lock.unlock();
     q_base->cancel();
 }
 
@@ -194,7 +206,13 @@ void SSQueryObject::add_query(SSQuery::QueryType query_type,
     add_query(query_type, query_base, 0, reply);
 }
 
-void SSQueryObject::run_query(SSQuery::SPtr query, MWReplyProxy const& reply)
+void SSQueryObject::query_done(std::string const& reply_id)
+{
+    std::lock_guard<std::mutex> lock(queries_mutex_);
+    queries_.erase(reply_id);
+}
+
+bool SSQueryObject::run_query(SSQuery::SPtr query, MWReplyProxy const& reply)
 {
     SearchQueryBase::SPtr q_base;
     SearchReplyProxy q_reply_proxy;
@@ -215,12 +233,27 @@ void SSQueryObject::run_query(SSQuery::SPtr query, MWReplyProxy const& reply)
     search_query = dynamic_pointer_cast<SearchQueryBase>(q_base);
     assert(search_query);
 
+    // Remote searches complete asynchronously, so no thread waits for the HTTP response.
+    // The query stays in queries_ (for pushable() and cancel()) until it is done.
+    auto smart_query = dynamic_pointer_cast<SmartQuery>(search_query);
+    if (smart_query)
+    {
+        auto self = shared_from_this();
+        auto reply_id = reply->identity();
+        smart_query->run_async(q_reply_proxy, [self, query, reply_id]
+        {
+            self->query_done(reply_id);
+        });
+        return true;
+    }
+
     // Synchronous call into scope implementation.
     // On return, replies for the query may still be outstanding.
     search_query->run(q_reply_proxy);
+    return false;
 }
 
-void SSQueryObject::run_preview(SSQuery::SPtr query, MWReplyProxy const& reply)
+bool SSQueryObject::run_preview(SSQuery::SPtr query, MWReplyProxy const& reply)
 {
     QueryBase::SPtr q_base;
     PreviewReplyProxy q_reply_proxy;
@@ -237,9 +270,22 @@ void SSQueryObject::run_preview(SSQuery::SPtr query, MWReplyProxy const& reply)
     preview_query = dynamic_pointer_cast<PreviewQueryBase>(q_base);
     assert(preview_query);
 
+    auto smart_preview = dynamic_pointer_cast<SmartPreview>(preview_query);
+    if (smart_preview)
+    {
+        auto self = shared_from_this();
+        auto reply_id = reply->identity();
+        smart_preview->run_async(q_reply_proxy, [self, query, reply_id]
+        {
+            self->query_done(reply_id);
+        });
+        return true;
+    }
+
     // Synchronous call into scope implementation.
     // On return, replies for the query may still be outstanding.
     preview_query->run(q_reply_proxy);
+    return false;
 }
 
 void SSQueryObject::run_activation(SSQuery::SPtr query, MWReplyProxy const& reply)
@@ -48,10 +48,15 @@ SSRegistryObject::SSRegistryObject(MiddlewareBase::SPtr middleware,
                                    std::string const& sss_url,
                                    bool caching_enabled)
     : ssclient_(std::make_shared<SmartScopesClient>(
-                    std::make_shared<HttpClientNetCpp>(ss_config.http_reply_timeout() * 1000),  // need millisecs
+                    std::make_shared<HttpClientNetCpp>(ss_config.http_reply_timeout() * 1000,  // need millisecs
+                                                       ss_config.http_connections_per_host(),
+                                                       ss_config.http_queue_timeout()),
                     std::make_shared<JsonCppNode>(),
                     middleware->runtime(),
                     sss_url))
+    , search_cache_(std::make_shared<SearchCache>(ss_config.search_cache_size(),
+                                                  ss_config.search_cache_dir(),
+                                                  ss_config.search_cache_dir_size()))
     , refresh_stopped_(false)
     , middleware_(middleware)
     , ss_scope_endpoint_(ss_scope_endpoint)
@@ -181,6 +186,11 @@ SmartScopesClient::SPtr SSRegistryObject::get_ssclient() const
     return ssclient_;
 }
 
+SearchCache::SPtr SSRegistryObject::get_search_cache() const
+{
+    return search_cache_;
+}
+
 SettingsDB::SPtr SSRegistryObject::get_settings_db(std::string const& scope_id) const
 {
     std::lock_guard<std::mutex> lock(scopes_mutex_);
@@ -242,10 +252,24 @@ void SSRegistryObject::get_remote_scopes()
     bool changed = false;
     MetadataMap new_scopes_;
     std::map<std::string, std::string> new_base_urls_;
+    std::map<std::string, RemoteScope> new_remote_scopes_;
 
     // loop through all available scopes and add() each visible scope
     for (RemoteScope const& scope : remote_scopes)
     {
+        // A scope that hasn't changed since the last refresh keeps its metadata.
+        {
+            std::lock_guard<std::mutex> lock(scopes_mutex_);
+            auto prev = remote_scopes_.find(scope.id);
+            auto meta = scopes_.find(scope.id);
+            if (prev != remote_scopes_.end() && prev->second == scope && meta != scopes_.end())
+            {
+                add(scope, meta->second, new_scopes_, new_base_urls_);
+                new_remote_scopes_[scope.id] = scope;
+                continue;
+            }
+        }
+
         try
         {
             // construct a ScopeMetadata with remote scope info
@@ -342,6 +366,8 @@ void SSRegistryObject::get_remote_scopes()
 
             metadata->set_keywords(scope.keywords);
 
+            metadata->set_results_ttl_type(scope.results_ttl_type);
+
             ScopeProxy proxy = ScopeImpl::create(middleware_->create_scope_proxy(scope.id, ss_scope_endpoint_),
                                                  scope.id);
 
@@ -351,6 +377,10 @@ void SSRegistryObject::get_remote_scopes()
 
             // add scope info to collection
             add(scope, std::move(meta), new_scopes_, new_base_urls_);
+            new_remote_scopes_[scope.id] = scope;
+
+            // new or modified scope
+            changed = true;
         }
         catch (std::exception const& e)
         {
@@ -363,10 +393,8 @@ void SSRegistryObject::get_remote_scopes()
     {
         std::lock_guard<std::mutex> lock(scopes_mutex_);
 
-        // check if base urls or list of available scopes has changed.
-        // the urls is a map of (string, string), so rely on == operator.
-        // when comparing scopes maps, only check if scope ids are same, i.e.
-        // changes to scope metadata attributes are not detected.
+        // new and modified scopes were detected above, so all that's left
+        // to check is whether any scopes were removed.
         if (new_base_urls_ != base_urls_ ||
             new_scopes_.size() != scopes_.size())
         {
@@ -387,6 +415,7 @@ void SSRegistryObject::get_remote_scopes()
         // replace current collection of remote scopes
         base_urls_ = new_base_urls_;
         scopes_ = new_scopes_;
+        remote_scopes_ = new_remote_scopes_;
     }
 
     if (changed && publisher_)
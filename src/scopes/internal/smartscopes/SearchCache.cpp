@@ -0,0 +1,661 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/smartscopes/SearchCache.h>
+
+#include <unity/scopes/internal/FilterBaseImpl.h>
+#include <unity/scopes/internal/FilterGroupImpl.h>
+#include <unity/scopes/internal/Utils.h>
+#include <unity/UnityExceptions.h>
+#include <unity/util/FileIO.h>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include <unistd.h>
+
+using namespace std;
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace smartscopes
+{
+
+namespace
+{
+
+Variant department_to_variant(DepartmentInfo const& dept)
+{
+    VariantMap vm;
+    vm["label"] = dept.label;
+    vm["alternate_label"] = dept.alternate_label;
+    vm["canned_query"] = dept.canned_query;
+    vm["has_subdepartments"] = dept.has_subdepartments;
+    VariantArray subdepts;
+    for (auto const& d : dept.subdepartments)
+    {
+        subdepts.push_back(department_to_variant(*d));
+    }
+    vm["subdepartments"] = subdepts;
+    return Variant(vm);
+}
+
+shared_ptr<DepartmentInfo> variant_to_department(Variant const& var)
+{
+    auto vm = var.get_dict();
+    auto dept = make_shared<DepartmentInfo>();
+    dept->label = vm.at("label").get_string();
+    dept->alternate_label = vm.at("alternate_label").get_string();
+    dept->canned_query = vm.at("canned_query").get_string();
+    dept->has_subdepartments = vm.at("has_subdepartments").get_bool();
+    for (auto const& d : vm.at("subdepartments").get_array())
+    {
+        dept->subdepartments.push_back(variant_to_department(d));
+    }
+    return dept;
+}
+
+// JSON integers that fit into 32 bits come back as Int, not Int64.
+int64_t get_int64(Variant const& var)
+{
+    return var.which() == Variant::Int ? var.get_int() : var.get_int64_t();
+}
+
+// File names must be the same across restarts, so we don't use std::hash.
+uint64_t fnv1a(string const& s)
+{
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : s)
+    {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+int64_t seconds_since_epoch()
+{
+    return chrono::duration_cast<chrono::seconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+//-- SearchRecording
+
+void SearchRecording::add(shared_ptr<SearchCategory> const& category)
+{
+    Reply r{ Kind::Category, category, {}, nullptr, {}, {} };
+    replies_.push_back(r);
+}
+
+void SearchRecording::add(SearchResult const& result)
+{
+    Reply r{ Kind::Result, nullptr, result, nullptr, {}, {} };
+    replies_.push_back(r);
+}
+
+void SearchRecording::add(shared_ptr<DepartmentInfo> const& departments)
+{
+    Reply r{ Kind::Departments, nullptr, {}, departments, {}, {} };
+    replies_.push_back(r);
+}
+
+void SearchRecording::add(Filters const& filters)
+{
+    Reply r{ Kind::Filters, nullptr, {}, nullptr, filters, {} };
+    replies_.push_back(r);
+}
+
+void SearchRecording::add(FilterState const& filter_state)
+{
+    Reply r{ Kind::FilterState, nullptr, {}, nullptr, {}, filter_state };
+    replies_.push_back(r);
+}
+
+void SearchRecording::replay(SearchReplyHandler& handler) const
+{
+    for (auto const& r : replies_)
+    {
+        switch (r.kind)
+        {
+            case Kind::Category:
+                if (handler.category_handler)
+                {
+                    handler.category_handler(r.category);
+                }
+                break;
+            case Kind::Result:
+                if (handler.result_handler)
+                {
+                    handler.result_handler(r.result);
+                }
+                break;
+            case Kind::Departments:
+                if (handler.departments_handler)
+                {
+                    handler.departments_handler(r.departments);
+                }
+                break;
+            case Kind::Filters:
+                if (handler.filters_handler)
+                {
+                    handler.filters_handler(r.filters);
+                }
+                break;
+            case Kind::FilterState:
+                if (handler.filter_state_handler)
+                {
+                    handler.filter_state_handler(r.filter_state);
+                }
+                break;
+            default:
+                abort();  // LCOV_EXCL_LINE  // Impossible
+        }
+    }
+}
+
+SearchRecording::SPtr SearchRecording::record(SearchReplyHandler& handler)
+{
+    auto rec = make_shared<SearchRecording>();
+
+    auto category_handler = handler.category_handler;
+    handler.category_handler = [rec, category_handler](shared_ptr<SearchCategory> const& category)
+    {
+        rec->add(category);
+        if (category_handler)
+        {
+            category_handler(category);
+        }
+    };
+    auto result_handler = handler.result_handler;
+    handler.result_handler = [rec, result_handler](SearchResult const& result)
+    {
+        rec->add(result);
+        if (result_handler)
+        {
+            result_handler(result);
+        }
+    };
+    auto departments_handler = handler.departments_handler;
+    handler.departments_handler = [rec, departments_handler](shared_ptr<DepartmentInfo> const& departments)
+    {
+        rec->add(departments);
+        if (departments_handler)
+        {
+            departments_handler(departments);
+        }
+    };
+    auto filters_handler = handler.filters_handler;
+    handler.filters_handler = [rec, filters_handler](Filters const& filters)
+    {
+        rec->add(filters);
+        if (filters_handler)
+        {
+            filters_handler(filters);
+        }
+    };
+    auto filter_state_handler = handler.filter_state_handler;
+    handler.filter_state_handler = [rec, filter_state_handler](FilterState const& filter_state)
+    {
+        rec->add(filter_state);
+        if (filter_state_handler)
+        {
+            filter_state_handler(filter_state);
+        }
+    };
+
+    return rec;
+}
+
+Variant SearchRecording::serialize() const
+{
+    VariantArray va;
+    for (auto const& r : replies_)
+    {
+        VariantMap vm;
+        switch (r.kind)
+        {
+            case Kind::Category:
+            {
+                VariantMap cat;
+                cat["id"] = r.category->id;
+                cat["title"] = r.category->title;
+                cat["icon"] = r.category->icon;
+                cat["render_template"] = r.category->renderer_template;
+                vm["category"] = cat;
+                break;
+            }
+            case Kind::Result:
+            {
+                VariantMap res;
+                res["json"] = r.result.json;
+                res["uri"] = r.result.uri;
+                res["cat_id"] = r.result.category_id;
+                res["other_params"] = r.result.other_params;
+                vm["result"] = res;
+                break;
+            }
+            case Kind::Departments:
+            {
+                vm["departments"] = department_to_variant(*r.departments);
+                break;
+            }
+            case Kind::Filters:
+            {
+                VariantMap filters;
+                filters["filter_groups"] = internal::FilterGroupImpl::serialize_filter_groups(r.filters);
+                filters["filters"] = internal::FilterBaseImpl::serialize_filters(r.filters);
+                vm["filters"] = filters;
+                break;
+            }
+            case Kind::FilterState:
+            {
+                vm["filter_state"] = r.filter_state.serialize();
+                break;
+            }
+            default:
+                abort();  // LCOV_EXCL_LINE  // Impossible
+        }
+        va.push_back(Variant(vm));
+    }
+    return Variant(va);
+}
+
+SearchRecording::SPtr SearchRecording::deserialize(Variant const& var)
+{
+    auto rec = make_shared<SearchRecording>();
+    for (auto const& v : var.get_array())
+    {
+        auto vm = v.get_dict();
+        if (vm.size() != 1)
+        {
+            throw unity::InvalidArgumentException("SearchRecording::deserialize(): invalid reply");
+        }
+        auto const& kind = vm.begin()->first;
+        auto const& data = vm.begin()->second;
+        if (kind == "category")
+        {
+            auto cat = data.get_dict();
+            auto category = make_shared<SearchCategory>();
+            category->id = cat.at("id").get_string();
+            category->title = cat.at("title").get_string();
+            category->icon = cat.at("icon").get_string();
+            category->renderer_template = cat.at("render_template").get_string();
+            rec->add(category);
+        }
+        else if (kind == "result")
+        {
+            auto res = data.get_dict();
+            SearchResult result;
+            result.json = res.at("json").get_string();
+            result.uri = res.at("uri").get_string();
+            result.category_id = res.at("cat_id").get_string();
+            result.other_params = res.at("other_params").get_dict();
+            rec->add(result);
+        }
+        else if (kind == "departments")
+        {
+            rec->add(variant_to_department(data));
+        }
+        else if (kind == "filters")
+        {
+            auto filters = data.get_dict();
+            auto groups = internal::FilterGroupImpl::deserialize_filter_groups(filters.at("filter_groups").get_array());
+            rec->add(internal::FilterBaseImpl::deserialize_filters(filters.at("filters").get_array(), groups));
+        }
+        else if (kind == "filter_state")
+        {
+            rec->add(FilterState::deserialize(data.get_dict()));
+        }
+        else
+        {
+            throw unity::InvalidArgumentException("SearchRecording::deserialize(): invalid reply kind: " + kind);
+        }
+    }
+    return rec;
+}
+
+//-- SearchCache
+
+SearchCache::SearchCache(size_t max_entries, string const& cache_dir, size_t max_files)
+    : max_entries_(max_entries)
+    , cache_dir_(cache_dir)
+    , max_files_(max_files)
+    , stats_{ 0, 0, 0, 0, 0 }
+    , files_(0)
+    , tmp_counter_(0)
+{
+    if (!cache_dir_.empty())
+    {
+        // Remove what expired while smartscopesproxy was not running, and any temporary
+        // files left behind by a crash.
+        lock_guard<mutex> lock(files_mutex_);
+        sweep_files(true);
+    }
+}
+
+string SearchCache::make_key(string const& base_url,
+                             string const& query,
+                             string const& department_id,
+                             string const& platform,
+                             VariantMap const& settings,
+                             VariantMap const& filter_state,
+                             string const& locale,
+                             LocationInfo const& location,
+                             string const& user_agent,
+                             unsigned int limit)
+{
+    VariantArray key
+    {
+        Variant(base_url),
+        Variant(query),
+        Variant(department_id),
+        Variant(platform),
+        Variant(settings),
+        Variant(filter_state),
+        Variant(locale),
+        Variant(user_agent),
+        Variant(int64_t(limit)),
+    };
+    if (location.has_location)
+    {
+        key.push_back(Variant(location.country_code));
+        key.push_back(Variant(int64_t(llround(location.latitude * 1000))));
+        key.push_back(Variant(int64_t(llround(location.longitude * 1000))));
+    }
+    return Variant(key).serialize_json();
+}
+
+chrono::seconds SearchCache::ttl(ScopeMetadata::ResultsTtlType ttl_type)
+{
+    switch (ttl_type)
+    {
+        case ScopeMetadata::ResultsTtlType::Small:
+            return chrono::seconds(60);
+        case ScopeMetadata::ResultsTtlType::Medium:
+            return chrono::seconds(300);
+        case ScopeMetadata::ResultsTtlType::Large:
+            return chrono::seconds(3600);
+        default:
+            return chrono::seconds(0);
+    }
+}
+
+SearchRecording::SCPtr SearchCache::find(string const& key)
+{
+    unique_lock<mutex> lock(mutex_);
+
+    auto it = entries_.find(key);
+    if (it != entries_.end())
+    {
+        if (chrono::steady_clock::now() < it->second.expiry)
+        {
+            lru_.splice(lru_.begin(), lru_, it->second.lru_pos);
+            ++stats_.hits;
+            return it->second.recording;
+        }
+        remove_from_memory(it);
+    }
+
+    if (!cache_dir_.empty())
+    {
+        // Don't hold the lock while reading the file.
+        lock.unlock();
+        chrono::seconds remaining;
+        size_t bytes;
+        auto recording = read_file(key, remaining, bytes);
+        lock.lock();
+        if (recording)
+        {
+            ++stats_.hits;
+            add_to_memory(key, recording, chrono::steady_clock::now() + remaining, bytes);
+            return recording;
+        }
+    }
+
+    ++stats_.misses;
+    return nullptr;
+}
+
+void SearchCache::add(string const& key, SearchRecording::SCPtr const& recording, chrono::seconds ttl)
+{
+    if (ttl <= chrono::seconds(0) || (max_entries_ == 0 && cache_dir_.empty()))
+    {
+        return;
+    }
+
+    string json = recording->serialize().serialize_json();
+    {
+        lock_guard<mutex> lock(mutex_);
+        add_to_memory(key, recording, chrono::steady_clock::now() + ttl, json.size());
+    }
+    if (!cache_dir_.empty() && write_file(key, json, ttl))
+    {
+        lock_guard<mutex> lock(files_mutex_);
+        if (++files_ > max_files_)
+        {
+            sweep_files(false);
+        }
+    }
+}
+
+SearchCache::Stats SearchCache::stats() const
+{
+    lock_guard<mutex> lock(mutex_);
+    Stats s = stats_;
+    s.entries = entries_.size();
+    return s;
+}
+
+void SearchCache::add_to_memory(string const& key,
+                                SearchRecording::SCPtr const& recording,
+                                chrono::steady_clock::time_point expiry,
+                                size_t bytes)
+{
+    if (max_entries_ == 0)
+    {
+        return;
+    }
+
+    auto it = entries_.find(key);
+    if (it != entries_.end())
+    {
+        remove_from_memory(it);
+    }
+
+    lru_.push_front(key);
+    entries_[key] = Entry{ recording, expiry, bytes, lru_.begin() };
+    stats_.bytes += bytes;
+
+    while (entries_.size() > max_entries_)
+    {
+        remove_from_memory(entries_.find(lru_.back()));
+        ++stats_.evictions;
+    }
+}
+
+void SearchCache::remove_from_memory(unordered_map<string, Entry>::iterator it)
+{
+    stats_.bytes -= it->second.bytes;
+    lru_.erase(it->second.lru_pos);
+    entries_.erase(it);
+}
+
+string SearchCache::file_name(string const& key) const
+{
+    ostringstream s;
+    s << cache_dir_ << "/" << hex << setw(16) << setfill('0') << fnv1a(key) << ".json";
+    return s.str();
+}
+
+// Returns null if there is no file for the key, or if the file has expired or is corrupt.
+// Expired and corrupt files are removed.
+
+SearchRecording::SCPtr SearchCache::read_file(string const& key, chrono::seconds& remaining, size_t& bytes) const
+{
+    auto const path = file_name(key);
+    string json;
+    try
+    {
+        json = unity::util::read_text_file(path);
+    }
+    catch (std::exception const&)
+    {
+        return nullptr;  // No such file
+    }
+
+    try
+    {
+        auto vm = Variant::deserialize_json(json).get_dict();
+        if (vm.at("key").get_string() != key)
+        {
+            return nullptr;  // Hash collision, leave the other entry alone
+        }
+        int64_t expiry = get_int64(vm.at("expiry"));
+        int64_t now = seconds_since_epoch();
+        if (expiry > now)
+        {
+            auto recording = SearchRecording::deserialize(vm.at("replies"));
+            remaining = chrono::seconds(expiry - now);
+            bytes = json.size();
+            return recording;
+        }
+    }
+    catch (std::exception const&)
+    {
+        // Corrupt file, remove it below.
+    }
+    ::remove(path.c_str());
+    return nullptr;
+}
+
+// Returns true if the file for the key did not exist yet.
+// The modification time of the file is set to its expiry time, so sweep_files()
+// can find expired files without reading them.
+
+bool SearchCache::write_file(string const& key, string const& json, chrono::seconds ttl)
+{
+    make_directories(cache_dir_, 0700);
+
+    // The replies are already serialized, so we splice them in rather than serializing them again.
+    int64_t const expiry = seconds_since_epoch() + ttl.count();
+    VariantMap header;
+    header["key"] = key;
+    header["expiry"] = Variant(expiry);
+    string header_json = Variant(header).serialize_json();
+    auto const close_pos = header_json.rfind('}');
+    if (close_pos == string::npos)
+    {
+        throw unity::ResourceException("SearchCache: cannot serialize entry header");  // LCOV_EXCL_LINE
+    }
+
+    // Concurrent writers of the same key (in this or another process) each use their own temporary file.
+    auto const path = file_name(key);
+    auto const tmp_path = path + "." + to_string(getpid()) + "-" + to_string(++tmp_counter_) + ".tmp";
+    {
+        ofstream f(tmp_path, ios::binary | ios::trunc);
+        f << header_json.substr(0, close_pos) << ",\"replies\":" << json << "}";
+        f.close();
+        if (!f)
+        {
+            ::remove(tmp_path.c_str());
+            throw unity::ResourceException("SearchCache: cannot write " + tmp_path);
+        }
+    }
+    boost::system::error_code ec;
+    boost::filesystem::last_write_time(tmp_path, time_t(expiry), ec);  // If this fails, the next sweep removes the file.
+
+    bool const is_new = !boost::filesystem::exists(path, ec);
+
+    // Rename is atomic, so a concurrent reader never sees a partially written file.
+    if (::rename(tmp_path.c_str(), path.c_str()) != 0)
+    {
+        ::remove(tmp_path.c_str());
+        throw unity::ResourceException("SearchCache: cannot rename " + tmp_path + " to " + path);
+    }
+    return is_new;
+}
+
+// Removes expired files and, if there are still more than max_files_, the files that
+// expire soonest, down to 90% of max_files_, so we don't sweep again on every add().
+// Errors are ignored: a file we cannot remove now is removed by a later sweep.
+
+void SearchCache::sweep_files(bool remove_tmp_files)
+{
+    namespace fs = boost::filesystem;
+
+    boost::system::error_code ec;
+    time_t const now = time_t(seconds_since_epoch());
+    vector<pair<time_t, fs::path>> files;
+    for (fs::directory_iterator it(cache_dir_, ec), end; !ec && it != end; it.increment(ec))
+    {
+        auto const& path = it->path();
+        if (path.extension() == ".tmp")
+        {
+            if (remove_tmp_files)
+            {
+                fs::remove(path, ec);
+            }
+            continue;
+        }
+        if (path.extension() != ".json")
+        {
+            continue;
+        }
+        time_t const expiry = fs::last_write_time(path, ec);
+        if (ec || expiry <= now)
+        {
+            fs::remove(path, ec);
+            continue;
+        }
+        files.emplace_back(expiry, path);
+    }
+
+    files_ = files.size();
+    if (files_ > max_files_)
+    {
+        size_t const keep = max_files_ - max_files_ / 10;
+        sort(files.begin(), files.end());
+        for (size_t i = 0; i < files_ - keep; ++i)
+        {
+            fs::remove(files[i].second, ec);
+        }
+        files_ = keep;
+    }
+}
+
+} // namespace smartscopes
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
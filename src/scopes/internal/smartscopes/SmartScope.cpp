@@ -33,6 +33,8 @@ SmartQuery::SmartQuery(std::string const& scope_id, SSRegistryObject::SPtr reg,
     , ss_client_(reg->get_ssclient())
     , base_url_(reg->get_base_url(scope_id))
     , hints_(hints)
+    , search_cache_(reg->get_search_cache())
+    , results_ttl_(SearchCache::ttl(reg->get_metadata(scope_id).results_ttl_type()))
 {
 }
 
@@ -42,6 +44,7 @@ SmartQuery::~SmartQuery()
 
 void SmartQuery::cancelled()
 {
+    std::lock_guard<std::mutex> lock(mutex_);
     if (search_handle_ != nullptr)
     {
         search_handle_->cancel_search();
@@ -50,6 +53,65 @@ void SmartQuery::cancelled()
 
 void SmartQuery::run(SearchReplyProxy const& reply)
 {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        try
+        {
+            if (!start(reply, false))
+            {
+                release();
+                return;
+            }
+        }
+        catch (...)
+        {
+            release();
+            throw;
+        }
+    }
+
+    try
+    {
+        search_handle_->wait();
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        release();
+        throw;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    finish();
+    release();
+}
+
+void SmartQuery::run_async(SearchReplyProxy const& reply, std::function<void()> const& done)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        try
+        {
+            if (start(reply, true))
+            {
+                // search_finished() can't get at done_ before we release the lock.
+                done_ = done;
+                return;
+            }
+        }
+        catch (...)
+        {
+            release();
+            throw;
+        }
+        release();
+    }
+    done();
+}
+
+bool SmartQuery::start(SearchReplyProxy const& reply, bool async)
+{
+    // The filters and the filter state are pushed together, once both have arrived.
     struct FiltersHandler
     {
         FiltersHandler(SearchReplyProxy reply, std::string const& scope_id):
@@ -84,30 +146,33 @@ void SmartQuery::run(SearchReplyProxy const& reply)
         bool has_state;
         Filters filters;
         FilterState state;
-    } filters_data(reply, scope_id_);
+    };
+    auto filters_data = std::make_shared<FiltersHandler>(reply, scope_id_);
 
-    SearchReplyHandler handler;
-    handler.filters_handler = [this, &filters_data](Filters const &filters) {
+    reply_ = reply;
+    SearchReplyHandler& handler = handler_;
+    handler = SearchReplyHandler();
+    handler.filters_handler = [this, filters_data](Filters const &filters) {
         try
         {
-            filters_data.set(filters);
+            filters_data->set(filters);
         }
         catch (std::exception const& e)
         {
             ss_client_->logger()()
-                << "SmartScope::run(): Failed to register filters for scope '" << filters_data.scope_id
+                << "SmartScope::run(): Failed to register filters for scope '" << filters_data->scope_id
                 << "': " << e.what();
         }
     };
-    handler.filter_state_handler = [this, &filters_data](FilterState const& state) {
+    handler.filter_state_handler = [this, filters_data](FilterState const& state) {
         try
         {
-            filters_data.set(state);
+            filters_data->set(state);
         }
         catch (std::exception const& e)
         {
             ss_client_->logger()()
-                << "SmartScope::run(): Failed to set filter state for scope '" << filters_data.scope_id
+                << "SmartScope::run(): Failed to set filter state for scope '" << filters_data->scope_id
                 << "': " << e.what();
         }
     };
@@ -132,10 +197,9 @@ void SmartQuery::run(SearchReplyProxy const& reply)
             res.set_uri(result.uri);
             res["result_json"] = result.json;
 
-            auto other_params = result.other_params;
-            for (auto& param : other_params)
+            for (auto const& param : result.other_params)
             {
-                res[param.first] = param.second->to_variant();
+                res[param.first] = param.second;
             }
 
             reply->push(res);
@@ -205,14 +269,90 @@ void SmartQuery::run(SearchReplyProxy const& reply)
         loc.latitude = location.latitude();
     }
 
+    auto const filter_state = query_.filter_state().serialize();
+
+    // The session and query IDs are not part of the cache key, so identical searches
+    // from different sessions share the cached replies.
+    if (results_ttl_ > std::chrono::seconds(0))
+    {
+        cache_key_ = SearchCache::make_key(base_url_, query_.query_string(), query_.department_id(), hints_.form_factor(),
+                                           settings(), filter_state, hints_.locale(), loc, agent, hints_.cardinality());
+        auto cached = search_cache_->find(cache_key_);
+        if (cached)
+        {
+            cached->replay(handler);
+            this->ss_client_->logger()(LoggerSeverity::Info)
+                << "SmartScope: query for \"" << scope_id_ << "\": \"" << query_.query_string() << "\" answered from cache";
+            return false;
+        }
+        recording_ = SearchRecording::record(handler);
+    }
+
+    if (async)
+    {
+        handler.finished_handler = [this](std::exception_ptr const& error)
+        {
+            search_finished(error);
+        };
+    }
+
     search_handle_ = ss_client_->search(handler, base_url_, query_.query_string(), query_.department_id(), session_id, query_id, hints_.form_factor(),
-            settings(), query_.filter_state().serialize(), hints_.locale(), loc, agent, hints_.cardinality());
-    search_handle_->wait();
+            settings(), filter_state, hints_.locale(), loc, agent, hints_.cardinality());
+    return true;
+}
+
+void SmartQuery::finish()
+{
+    // Only complete replies go into the cache.
+    if (recording_ && valid())
+    {
+        try
+        {
+            search_cache_->add(cache_key_, recording_, results_ttl_);
+        }
+        catch (std::exception const& e)
+        {
+            this->ss_client_->logger()()
+                << "SmartScope::run(): Failed to cache replies for scope '" << scope_id_ << "': " << e.what();
+        }
+    }
 
     this->ss_client_->logger()(LoggerSeverity::Info)
         << "SmartScope: query for \"" << scope_id_ << "\": \"" << query_.query_string() << "\" complete";
 }
 
+// Drops the reply (which sends finished() to the client, unless that already happened) and
+// everything else that refers to it.
+
+void SmartQuery::release()
+{
+    search_handle_.reset();
+    handler_ = SearchReplyHandler();
+    reply_.reset();
+    recording_.reset();
+    done_ = nullptr;
+}
+
+void SmartQuery::search_finished(std::exception_ptr const& error)
+{
+    std::function<void()> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!error)
+        {
+            finish();
+        }
+        else if (valid())
+        {
+            // A cancelled query has told the client already.
+            reply_->error(error);
+        }
+        done = done_;
+        release();
+    }
+    done();
+}
+
 Department::SCPtr SmartQuery::create_department(std::shared_ptr<DepartmentInfo const> const& deptinfo)
 {
     CannedQuery const query = CannedQuery::from_uri(deptinfo->canned_query);
@@ -245,14 +385,69 @@ SmartPreview::~SmartPreview()
 
 void SmartPreview::cancelled()
 {
-    preview_handle_->cancel_preview();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (preview_handle_ != nullptr)
+    {
+        preview_handle_->cancel_preview();
+    }
 }
 
 void SmartPreview::run(PreviewReplyProxy const& reply)
 {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        try
+        {
+            start(reply, false);
+        }
+        catch (...)
+        {
+            release();
+            throw;
+        }
+    }
+
+    try
+    {
+        preview_handle_->wait();
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        release();
+        throw;
+    }
+
+    this->ss_client_->logger()(LoggerSeverity::Info)
+        << "SmartScope: preview for \"" << scope_id_ << "\": \"" << result().uri() << "\" complete";
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    release();
+}
+
+void SmartPreview::run_async(PreviewReplyProxy const& reply, std::function<void()> const& done)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    try
+    {
+        start(reply, true);
+    }
+    catch (...)
+    {
+        release();
+        throw;
+    }
+    // preview_finished() can't get at done_ before we release the lock.
+    done_ = done;
+}
+
+void SmartPreview::start(PreviewReplyProxy const& reply, bool async)
+{
+    reply_ = reply;
+
     PreviewReplyHandler handler;
-    handler.widget_handler = [reply](std::string const& widget_json) {
-        reply->push({PreviewWidget(widget_json)});
+    handler.widgets_handler = [reply](PreviewWidgetList const& widgets) {
+        reply->push(widgets);
     };
     handler.columns_handler = [reply](PreviewHandle::Columns const &columns) {
         if (columns.size() > 0)
@@ -296,13 +491,44 @@ void SmartPreview::run(PreviewReplyProxy const& reply)
         agent = metadata["user-agent"].get_string();
     }
 
+    if (async)
+    {
+        handler.finished_handler = [this](std::exception_ptr const& error)
+        {
+            preview_finished(error);
+        };
+    }
+
     preview_handle_ = ss_client_->preview(handler, base_url_, result_["result_json"].get_string(), session_id, hints_.form_factor(), 0, settings(),
             hints_.locale(), "", agent);
+}
 
-    preview_handle_->wait();
+void SmartPreview::release()
+{
+    preview_handle_.reset();
+    reply_.reset();
+    done_ = nullptr;
+}
 
-    this->ss_client_->logger()(LoggerSeverity::Info)
-        << "SmartScope: preview for \"" << scope_id_ << "\": \"" << result().uri() << "\" complete";
+void SmartPreview::preview_finished(std::exception_ptr const& error)
+{
+    std::function<void()> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!error)
+        {
+            this->ss_client_->logger()(LoggerSeverity::Info)
+                << "SmartScope: preview for \"" << scope_id_ << "\": \"" << result().uri() << "\" complete";
+        }
+        else if (valid())
+        {
+            // A cancelled preview has told the client already.
+            reply_->error(error);
+        }
+        done = done_;
+        release();
+    }
+    done();
 }
 
 SmartActivation::SmartActivation(Result const& result, ActionMetadata const& metadata, std::string const& widget_id, std::string const& action_id)
@@ -20,8 +20,15 @@
 #include <unity/scopes/internal/FilterBaseImpl.h>
 #include <unity/scopes/internal/FilterStateImpl.h>
 #include <unity/scopes/internal/FilterGroupImpl.h>
+#include <unity/scopes/internal/JsonCppNode.h>
+#include <unity/scopes/internal/PreviewWidgetImpl.h>
 #include <unity/scopes/internal/RuntimeImpl.h>
+#include <unity/scopes/internal/smartscopes/JsonLineDecoder.h>
+#include <unity/scopes/internal/smartscopes/NdjsonFramer.h>
+#include <unity/scopes/internal/smartscopes/RemoteScopesCache.h>
+#include <unity/scopes/internal/smartscopes/SearchCache.h>
 #include <unity/scopes/internal/smartscopes/SmartScopesClient.h>
+#include <unity/scopes/internal/smartscopes/UriBuilder.h>
 #include <unity/scopes/internal/Utils.h>
 
 #include <unity/scopes/ScopeExceptions.h>
@@ -30,6 +37,7 @@
 
 #include <algorithm>
 #include <array>
+#include <condition_variable>
 #include <cstring>
 #include <fstream>
 #include <future>
@@ -54,11 +62,48 @@ static const std::string c_preview_resource = "/preview";
 
 static const std::string c_scopes_cache_dir = homedir() + "/.cache/unity-scopes/";
 static const std::string c_scopes_cache_filename = "remote-scopes.json";
+static const std::string c_scopes_binary_cache_filename = "remote-scopes.bin";
 static const std::string c_partner_id_file = "/custom/partner-id";
 
 using namespace unity::scopes;
 using namespace unity::scopes::internal::smartscopes;
 
+//-- RemoteScope
+
+namespace
+{
+
+template <typename T>
+bool optional_equal(std::shared_ptr<T> const& lhs, std::shared_ptr<T> const& rhs)
+{
+    return lhs && rhs ? *lhs == *rhs : lhs == rhs;
+}
+
+} // namespace
+
+bool unity::scopes::internal::smartscopes::operator==(RemoteScope const& lhs, RemoteScope const& rhs)
+{
+    return lhs.id == rhs.id
+           && lhs.name == rhs.name
+           && lhs.description == rhs.description
+           && lhs.author == rhs.author
+           && lhs.base_url == rhs.base_url
+           && optional_equal(lhs.icon, rhs.icon)
+           && optional_equal(lhs.art, rhs.art)
+           && optional_equal(lhs.appearance, rhs.appearance)
+           && optional_equal(lhs.settings, rhs.settings)
+           && optional_equal(lhs.needs_location_data, rhs.needs_location_data)
+           && lhs.invisible == rhs.invisible
+           && lhs.version == rhs.version
+           && lhs.keywords == rhs.keywords
+           && lhs.results_ttl_type == rhs.results_ttl_type;
+}
+
+bool unity::scopes::internal::smartscopes::operator!=(RemoteScope const& lhs, RemoteScope const& rhs)
+{
+    return !(lhs == rhs);
+}
+
 //-- SearchHandle
 
 SearchHandle::SearchHandle(unsigned int search_id, SmartScopesClient::SPtr ssc)
@@ -105,6 +150,83 @@ void PreviewHandle::cancel_preview()
     ssc_->cancel_query(preview_id_);
 }
 
+//-- SharedSearch
+
+namespace
+{
+
+// Passes a reply to the corresponding callback of each subscriber. An exception
+// from one subscriber doesn't stop the reply from reaching the others.
+
+template <typename Reply>
+void fan_out(std::map<unsigned int, SearchReplyHandler*> const& subscribers,
+             std::function<void(Reply const&)> SearchReplyHandler::* callback,
+             Reply const& reply,
+             unity::scopes::internal::Logger& logger)
+{
+    for (auto const& s : subscribers)
+    {
+        auto const& f = (*s.second).*callback;
+        if (f)
+        {
+            try
+            {
+                f(reply);
+            }
+            catch (std::exception const& e)
+            {
+                logger() << "SmartScopesClient.search(): reply handler for query " << s.first
+                         << " threw an exception: " << e.what();
+            }
+        }
+    }
+}
+
+} // namespace
+
+struct SmartScopesClient::SharedSearch
+{
+    SharedSearch(std::string const& key, unity::scopes::internal::Logger& logger)
+        : key(key)
+        , done(false)
+    {
+        fanout.result_handler = [this, &logger](SearchResult const& result)
+        {
+            fan_out(subscribers, &SearchReplyHandler::result_handler, result, logger);
+        };
+        fanout.category_handler = [this, &logger](std::shared_ptr<SearchCategory> const& category)
+        {
+            fan_out(subscribers, &SearchReplyHandler::category_handler, category, logger);
+        };
+        fanout.departments_handler = [this, &logger](std::shared_ptr<DepartmentInfo> const& departments)
+        {
+            fan_out(subscribers, &SearchReplyHandler::departments_handler, departments, logger);
+        };
+        fanout.filters_handler = [this, &logger](Filters const& filters)
+        {
+            fan_out(subscribers, &SearchReplyHandler::filters_handler, filters, logger);
+        };
+        fanout.filter_state_handler = [this, &logger](FilterState const& filter_state)
+        {
+            fan_out(subscribers, &SearchReplyHandler::filter_state_handler, filter_state, logger);
+        };
+        recording = SearchRecording::record(fanout);
+    }
+
+    std::string const key;                                  // URI and headers
+    HttpResponseHandle::SPtr response;
+
+    // The remaining members are protected by mutex.
+    SearchReplyHandler fanout;                              // Decoded replies go here
+    SearchRecording::SPtr recording;                        // Replies so far, for searches that join late
+    std::map<unsigned int, SearchReplyHandler*> subscribers;
+    std::vector<std::function<void(std::exception_ptr const&)>> cancelled;   // Of asynchronous searches
+    bool done;                                              // response has completed
+    std::exception_ptr error;                               // Set once done if the response failed
+    std::mutex mutex;
+    std::condition_variable cond;
+};
+
 //-- SmartScopesClient
 
 SmartScopesClient::SmartScopesClient(HttpClientInterface::SPtr http_client,
@@ -128,9 +250,6 @@ SmartScopesClient::SmartScopesClient(HttpClientInterface::SPtr http_client,
 
     // initialise url_
     reset_url(url);
-
-    // initialise cached_scopes_
-    read_cache();
 }
 
 SmartScopesClient::~SmartScopesClient()
@@ -167,6 +286,9 @@ bool SmartScopesClient::get_remote_scopes(std::vector<RemoteScope>& remote_scope
 {
     std::string response_str;
     bool using_cache = false;
+    std::string request;
+    std::string etag;
+    std::string last_modified;
 
     try
     {
@@ -200,6 +322,28 @@ bool SmartScopesClient::get_remote_scopes(std::vector<RemoteScope>& remote_scope
                       << partner_file_ << ": " << e.what();
         }
 
+        request = remote_scopes_uri.str();
+        for (auto const& h : headers)
+        {
+            request += "\n" + h.first + ": " + h.second;
+        }
+
+        // If we have the response to the same request, ask the server to send the scopes only if they changed.
+        {
+            std::lock_guard<std::mutex> lock(remote_scopes_mutex_);
+            if (request == remote_scopes_request_)
+            {
+                if (!remote_scopes_etag_.empty())
+                {
+                    headers.push_back(std::make_pair("If-None-Match", remote_scopes_etag_));
+                }
+                if (!remote_scopes_last_modified_.empty())
+                {
+                    headers.push_back(std::make_pair("If-Modified-Since", remote_scopes_last_modified_));
+                }
+            }
+        }
+
         std::mutex reponse_mutex;
         HttpResponseHandle::SPtr response = http_client_->get(remote_scopes_uri.str(), [&response_str, &reponse_mutex](std::string const& replyLine)
         {
@@ -209,6 +353,18 @@ bool SmartScopesClient::get_remote_scopes(std::vector<RemoteScope>& remote_scope
 
         response->get();
 
+        if (response->status() == 304)
+        {
+            logger_(LoggerSeverity::Info) << "SmartScopesClient.get_remote_scopes(): Remote scopes not modified";
+
+            std::lock_guard<std::mutex> lock(remote_scopes_mutex_);
+            remote_scopes = remote_scopes_;
+            return true;
+        }
+
+        etag = response->header("ETag");
+        last_modified = response->header("Last-Modified");
+
         logger_(LoggerSeverity::Info) << "SmartScopesClient.get_remote_scopes(): Remote scopes:\n" << response_str;
     }
     catch (std::exception const& e)
@@ -220,6 +376,15 @@ bool SmartScopesClient::get_remote_scopes(std::vector<RemoteScope>& remote_scope
         {
             logger_() << "SmartScopesClient.get_remote_scopes(): Using remote scopes from cache";
 
+            // The binary cache is much cheaper to load than the JSON, so we try it first.
+            if (RemoteScopesCache::read(c_scopes_cache_dir + c_scopes_binary_cache_filename,
+                                        c_scopes_cache_dir + c_scopes_cache_filename,
+                                        remote_scopes))
+            {
+                logger_(LoggerSeverity::Info) << "SmartScopesClient.get_remote_scopes(): Retrieved remote scopes from cache";
+                return false;
+            }
+
             response_str = read_cache();
             if (response_str.empty())
             {
@@ -350,6 +515,28 @@ bool SmartScopesClient::get_remote_scopes(std::vector<RemoteScope>& remote_scope
                 }
             }
 
+            if (child_node->has_node("results_ttl_type"))
+            {
+                auto ttl_type = child_node->get_node("results_ttl_type")->as_string();
+                if (ttl_type == "small")
+                {
+                    scope.results_ttl_type = ScopeMetadata::ResultsTtlType::Small;
+                }
+                else if (ttl_type == "medium")
+                {
+                    scope.results_ttl_type = ScopeMetadata::ResultsTtlType::Medium;
+                }
+                else if (ttl_type == "large")
+                {
+                    scope.results_ttl_type = ScopeMetadata::ResultsTtlType::Large;
+                }
+                else if (ttl_type != "none")
+                {
+                    logger_() << "SmartScopesClient.get_remote_scopes(): Scope: \"" << scope.id
+                              << "\" returned an invalid value for \"results_ttl_type\": \"" << ttl_type << "\"";
+                }
+            }
+
             remote_scopes.push_back(scope);
         }
         catch (std::exception const& e)
@@ -366,7 +553,16 @@ bool SmartScopesClient::get_remote_scopes(std::vector<RemoteScope>& remote_scope
     }
     else if (!using_cache)
     {
-        if (caching_enabled)
+        {
+            std::lock_guard<std::mutex> lock(remote_scopes_mutex_);
+            remote_scopes_request_ = request;
+            remote_scopes_etag_ = etag;
+            remote_scopes_last_modified_ = last_modified;
+            remote_scopes_ = remote_scopes;
+        }
+
+        // Don't rewrite the cache if the scopes haven't changed.
+        if (caching_enabled && response_str != read_cache())
         {
             try
             {
@@ -378,12 +574,19 @@ bool SmartScopesClient::get_remote_scopes(std::vector<RemoteScope>& remote_scope
                           << c_scopes_cache_dir << c_scopes_cache_filename << ": " << e.what();
             }
         }
+        if (caching_enabled && have_latest_cache_)
+        {
+            write_binary_cache(remote_scopes);
+        }
 
         logger_(LoggerSeverity::Info) << "SmartScopesClient.get_remote_scopes(): Retrieved remote scopes from uri: "
                                       << url_ << c_remote_scopes_resource;
     }
     else
     {
+        // Next time, the binary cache saves us parsing the JSON again.
+        write_binary_cache(remote_scopes);
+
         logger_(LoggerSeverity::Info) << "SmartScopesClient.get_remote_scopes(): Retrieved remote scopes from cache";
     }
 
@@ -404,83 +607,122 @@ SearchHandle::UPtr SmartScopesClient::search(SearchReplyHandler& handler,
                                              std::string const& user_agent_hdr,
                                              unsigned int limit)
 {
-    std::ostringstream search_uri;
-    search_uri.imbue(std::locale::classic()); // so that doubles use one standard formatting wrt decimal point
-
-    search_uri << base_url << c_search_resource << "?";
+    UriBuilder search_uri(base_url, c_search_resource);
 
     // mandatory parameters
-    search_uri << "q=" << http_client_->to_percent_encoding(query);
-
-    search_uri << "&session_id=" << http_client_->to_percent_encoding(session_id);
-    search_uri << "&query_id=" << std::to_string(query_id);
-    search_uri << "&platform=" << platform;
+    search_uri.param("q", query);
+    search_uri.param("session_id", session_id);
+    search_uri.param("query_id", int64_t(query_id));
+    search_uri.raw_param("platform", platform);
 
     // optional parameters
     if (!department_id.empty())
     {
-        search_uri << "&department=" << http_client_->to_percent_encoding(department_id);
+        search_uri.param("department", department_id);
     }
     if (!settings.empty())
     {
-        std::string settings_str = stringify_settings(settings);
+        std::string settings_str = encoded_settings(base_url, settings);
         if (!settings_str.empty())
         {
-            search_uri << "&settings=" << http_client_->to_percent_encoding(settings_str);
+            search_uri.raw_param("settings", settings_str);
         }
     }
     if (!locale.empty())
     {
-        search_uri << "&locale=" << locale;
+        search_uri.raw_param("locale", locale);
     }
     if (location.has_location)
     {
         if (!location.country_code.empty())
         {
-            search_uri << "&country=" << location.country_code;
+            search_uri.raw_param("country", location.country_code);
         }
-        search_uri << std::fixed << std::setprecision(5) << "&latitude=" << location.latitude << "&longitude=" << location.longitude;
+        search_uri.param("latitude", location.latitude, 5);
+        search_uri.param("longitude", location.longitude, 5);
     }
     if (limit != 0)
     {
-        search_uri << "&limit=" << std::to_string(limit);
+        search_uri.param("limit", int64_t(limit));
     }
     if (!filter_state.empty())
     {
-        search_uri << "&filters=" << http_client_->to_percent_encoding(Variant(filter_state).serialize_json());
+        search_uri.param("filters", Variant(filter_state).serialize_json());
+    }
+
+    HttpHeaders headers;
+    std::string key = search_uri.str();
+    if (!user_agent_hdr.empty())
+    {
+        headers.push_back(std::make_pair("User-Agent", user_agent_hdr));
+        key += "\nUser-Agent: " + user_agent_hdr;
     }
 
     std::lock_guard<std::mutex> lock(query_results_mutex_);
     unsigned int search_id = ++query_counter_;
 
-    logger_(LoggerSeverity::Info) << "SmartScopesClient.search(): GET " << search_uri.str();
+    auto it = shared_searches_.find(key);
+    if (it != shared_searches_.end())
+    {
+        // An identical search is in flight. Pass on whatever it has received so far and
+        // subscribe to the rest. If it has just completed, we make a new request instead.
+        auto search = it->second;
+        std::lock_guard<std::mutex> search_lock(search->mutex);
+        if (!search->done)
+        {
+            logger_(LoggerSeverity::Info) << "SmartScopesClient.search(): joining GET " << search_uri.str();
 
-    HttpHeaders headers;
+            search->recording->replay(handler);
+            search->subscribers[search_id] = &handler;
+            search_results_[search_id] = search;
+            return SearchHandle::UPtr(new SearchHandle(search_id, shared_from_this()));
+        }
+    }
+
+    logger_(LoggerSeverity::Info) << "SmartScopesClient.search(): GET " << search_uri.str();
     if (!user_agent_hdr.empty())
     {
         logger_(LoggerSeverity::Info) << "User agent: " << user_agent_hdr;
-        headers.push_back(std::make_pair("User-Agent", user_agent_hdr));
     }
 
-    auto tmp_data = std::make_shared<std::string>();
-    query_results_[search_id] = http_client_->get(search_uri.str(), [this, tmp_data, &handler](std::string const& chunk)
-    {
-        // prepend any leftover data from the previous handle_chunk call
-        std::string data = *tmp_data + (chunk.empty() ? "\n" : chunk);
+    auto search = std::make_shared<SharedSearch>(key, logger_);
+    search->subscribers[search_id] = &handler;
 
-        // store the leftover data from the handle_chunk call into tmp_data
-        *tmp_data = handle_chunk(data, [this, &handler](const std::string& line)
+    std::weak_ptr<SharedSearch> weak_search(search);
+    auto framer = std::make_shared<NdjsonFramer>([this, weak_search](char const* line, std::size_t size)
+    {
+        auto search = weak_search.lock();
+        if (!search)
         {
-            try
-            {
-                handle_line(line, handler);
-            }
-            catch (unity::Exception const& e)
-            {
-                logger_() << "SmartScopesClient.search(): Failed to parse line: " << e.what();
-            }
-        });
-    }, headers);
+            return;
+        }
+        try
+        {
+            std::lock_guard<std::mutex> search_lock(search->mutex);
+            handle_line(line, size, search->fanout);
+        }
+        catch (std::exception const& e)
+        {
+            logger_() << "SmartScopesClient.search(): Failed to parse line: " << e.what();
+        }
+    });
+    // The completion callback keeps the search alive, so cancelled asynchronous searches still
+    // hear about it. It can't get past query_results_mutex_ before we are done here.
+    std::weak_ptr<SmartScopesClient> weak_self(shared_from_this());
+    search->response = http_client_->get(search_uri.str(), [framer](std::string const& chunk)
+    {
+        framer->feed(chunk);
+    }, headers, [weak_self, search](std::exception_ptr const& error)
+    {
+        auto self = weak_self.lock();
+        if (self)
+        {
+            self->complete_search(search, error);
+        }
+    }, HttpConcurrency::Unlimited);
+
+    shared_searches_[key] = search;
+    search_results_[search_id] = search;
 
     return SearchHandle::UPtr(new SearchHandle(search_id, shared_from_this()));
 }
@@ -496,15 +738,14 @@ PreviewHandle::UPtr SmartScopesClient::preview(PreviewReplyHandler const& handle
                                                std::string const& country,
                                                std::string const& user_agent_hdr)
 {
-    std::ostringstream preview_uri;
-    preview_uri << base_url << c_preview_resource << "?";
+    UriBuilder preview_uri(base_url, c_preview_resource);
 
     // mandatory parameters
 
-    preview_uri << "result=" << http_client_->to_percent_encoding(result);
-    preview_uri << "&session_id=" << http_client_->to_percent_encoding(session_id);
-    preview_uri << "&platform=" << platform;
-    preview_uri << "&widgets_api_version=" << std::to_string(widgets_api_version);
+    preview_uri.param("result", result);
+    preview_uri.param("session_id", session_id);
+    preview_uri.raw_param("platform", platform);
+    preview_uri.param("widgets_api_version", int64_t(widgets_api_version));
 
     HttpHeaders headers;
     if (!user_agent_hdr.empty())
@@ -516,19 +757,19 @@ PreviewHandle::UPtr SmartScopesClient::preview(PreviewReplyHandler const& handle
 
     if (!settings.empty())
     {
-        std::string settings_str = stringify_settings(settings);
+        std::string settings_str = encoded_settings(base_url, settings);
         if (!settings_str.empty())
         {
-            preview_uri << "&settings=" << http_client_->to_percent_encoding(settings_str);
+            preview_uri.raw_param("settings", settings_str);
         }
     }
     if (!locale.empty())
     {
-        preview_uri << "&locale=" << locale;
+        preview_uri.raw_param("locale", locale);
     }
     if (!country.empty())
     {
-        preview_uri << "&country=" << country;
+        preview_uri.raw_param("country", country);
     }
 
     std::lock_guard<std::mutex> lock(query_results_mutex_);
@@ -536,97 +777,142 @@ PreviewHandle::UPtr SmartScopesClient::preview(PreviewReplyHandler const& handle
 
     logger_(LoggerSeverity::Info) << "SmartScopesClient.preview(): GET " << preview_uri.str();
 
-    auto tmp_data = std::make_shared<std::string>();
-    query_results_[preview_id] = http_client_->get(preview_uri.str(), [this, tmp_data, handler](std::string const& chunk)
+    // Widgets are collected while a chunk is split into lines, and passed on together once
+    // the chunk is done, so the reply sees one push per chunk instead of one per widget.
+    auto widgets = std::make_shared<PreviewWidgetList>();
+    auto framer = std::make_shared<NdjsonFramer>([this, handler, widgets](char const* line, std::size_t size)
     {
-        // prepend any leftover data from the previous handle_chunk call
-        std::string data = *tmp_data + (chunk.empty() ? "\n" : chunk);
-
-        // store the leftover data from the handle_chunk call into tmp_data
-        *tmp_data = handle_chunk(data, [this, handler](const std::string& line)
+        try
         {
+            handle_line(line, size, handler, *widgets);
+        }
+        catch (std::exception const& e)
+        {
+            logger_() << "SmartScopesClient.preview(): Failed to parse line: " << e.what();
+        }
+    });
+    std::function<void(std::exception_ptr const&)> completed;
+    if (handler.finished_handler)
+    {
+        std::weak_ptr<SmartScopesClient> weak_self(shared_from_this());
+        auto finished = handler.finished_handler;
+        completed = [weak_self, preview_id, finished](std::exception_ptr const& error)
+        {
+            auto self = weak_self.lock();
+            if (!self)
+            {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(self->query_results_mutex_);
+                self->query_results_.erase(preview_id);
+            }
             try
             {
-                handle_line(line, handler);
+                finished(error);
             }
-            catch (unity::Exception const& e)
+            catch (std::exception const& e)
             {
-                logger_() << "SmartScopesClient.preview(): Failed to parse line: " << e.what();
+                self->logger_() << "SmartScopesClient.preview(): finished handler threw an exception: " << e.what();
             }
-        });
-    }, headers);
+        };
+    }
+    query_results_[preview_id] = http_client_->get(preview_uri.str(), [this, handler, framer, widgets](std::string const& chunk)
+    {
+        framer->feed(chunk);
+        if (widgets->empty())
+        {
+            return;
+        }
+        PreviewWidgetList batch;
+        batch.swap(*widgets);
+        push_widgets(handler, batch);
+    }, headers, completed);
 
     return PreviewHandle::UPtr(new PreviewHandle(preview_id, shared_from_this()));
 }
 
-std::string SmartScopesClient::handle_chunk(const std::string& chunk, std::function<void(const std::string&)> line_handler)
-{
-    // According to the docs, we expect:
-    // The response will have Content-Type
-    // application/json, it will be a chunked response, in practice a series of
-    // “\r\n” delimited lines, each containing one JSON object, with the
-    // possible forms, matching what currently can be pushed into a reply in the
-    // new scopes API
-    static constexpr const char separator{'\n'};
+// If the handler rejects a batch, the widgets are passed on one at a time, so a widget
+// the handler cannot deal with does not take the rest of its batch with it.
 
-    // read data line-by-line calling line_handler() for each
-    auto newline_pos = 0;
-    auto endline_pos = chunk.find(separator);
-    while (endline_pos != std::string::npos)
+void SmartScopesClient::push_widgets(PreviewReplyHandler const& handler, PreviewWidgetList const& widgets)
+{
+    try
+    {
+        handler.widgets_handler(widgets);
+        return;
+    }
+    catch (std::exception const& e)
+    {
+        if (widgets.size() == 1)
+        {
+            logger_() << "SmartScopesClient.preview(): Failed to push widget: " << e.what();
+            return;
+        }
+    }
+    for (auto const& w : widgets)
     {
         try
         {
-            line_handler(chunk.substr(newline_pos, endline_pos - newline_pos));
+            handler.widgets_handler({w});
         }
-        catch (std::exception const &e)
+        catch (std::exception const& e)
         {
-            logger_() << "SmartScopesClient.handle_chunk(): Failed to parse line: " << e.what();
+            logger_() << "SmartScopesClient.preview(): Failed to push widget \"" << w.id() << "\": " << e.what();
         }
-        newline_pos = endline_pos + 1;
-        endline_pos = chunk.find(separator, newline_pos);
     }
-
-    // return the leftover data
-    return chunk.substr(newline_pos, chunk.size() - newline_pos);
 }
 
-void SmartScopesClient::handle_line(std::string const& json, PreviewReplyHandler const& handler)
+// Each line is decoded by its own JsonLineDecoder, so concurrent searches and previews
+// do not contend for a shared parser. Each line is expected to contain a single member;
+// the whole line is validated before the handler is called.
+
+namespace
 {
-    if (json.empty())
+
+void finish_line(JsonLineDecoder& decoder)
+{
+    std::string member;
+    while (decoder.next_member(member))
     {
-        return;
+        decoder.skip_value();
     }
+    decoder.finish();
+}
 
-    JsonNodeInterface::SPtr root_node;
-    JsonNodeInterface::SPtr child_node;
+}  // namespace
+
+void SmartScopesClient::handle_line(char const* json,
+                                    std::size_t size,
+                                    PreviewReplyHandler const& handler,
+                                    PreviewWidgetList& widgets)
+{
+    JsonLineDecoder decoder(json, size);
+    decoder.begin_object();
+    std::string member;
+    if (!decoder.next_member(member))
     {
-        std::lock_guard<std::mutex> lock(json_node_mutex_);
-        json_node_->read_json(json);
-        root_node = json_node_->get_node();
+        return;
     }
 
-    if (root_node->has_node("columns"))
+    if (member == "columns")
     {
         PreviewHandle::Columns columns;
-        child_node = root_node->get_node("columns");
+        Variant columns_var = decoder.value();
+        finish_line(decoder);
 
         // for each column
-        for (int column_i = 0; column_i < child_node->size(); ++column_i)
+        for (auto const& column : columns_var.get_array())
         {
-            auto column_node = child_node->get_node(column_i);
-
             // for each widget layout within the column
             std::vector<std::vector<std::string>> widget_layouts;
-            for (int widget_lo_i = 0; widget_lo_i < column_node->size(); ++widget_lo_i)
+            for (auto const& widget_lo : column.get_array())
             {
-                auto widget_lo_node = column_node->get_node(widget_lo_i);
-
                 // for each widget within the widget layout
                 std::vector<std::string> widget_ids;
-                for (int widget_i = 0; widget_i < widget_lo_node->size(); ++widget_i)
+                for (auto const& widget : widget_lo.get_array())
                 {
-                    auto widget_node = widget_lo_node->get_node(widget_i);
-                    widget_ids.push_back(widget_node->as_string());
+                    widget_ids.push_back(widget.get_string());
                 }
 
                 widget_layouts.push_back(widget_ids);
@@ -634,101 +920,129 @@ void SmartScopesClient::handle_line(std::string const& json, PreviewReplyHandler
 
             columns.push_back(widget_layouts);
         }
+
+        // Widgets that arrived before the layout go out first, to keep them in order.
+        if (!widgets.empty())
+        {
+            PreviewWidgetList batch;
+            batch.swap(widgets);
+            push_widgets(handler, batch);
+        }
         handler.columns_handler(columns);
     }
-    else if (root_node->has_node("widget"))
+    else if (member == "widget")
     {
-        child_node = root_node->get_node("widget");
-        handler.widget_handler(child_node->to_json_string());
+        // The widget is built straight from the decoded value, without going through a JSON string.
+        // A malformed widget is dropped on its own; the widgets collected so far are unaffected.
+        Variant widget_var = decoder.value();
+        finish_line(decoder);
+        try
+        {
+            widgets.push_back(PreviewWidgetImpl::create_from_variant_map(widget_var.get_dict()));
+        }
+        catch (std::exception const& e)
+        {
+            logger_() << "SmartScopesClient.preview(): ignoring invalid widget: " << e.what();
+        }
     }
 }
 
-void SmartScopesClient::handle_line(std::string const& json, SearchReplyHandler& handler)
+void SmartScopesClient::handle_line(char const* json, std::size_t size, SearchReplyHandler& handler)
 {
-    if (json.empty())
+    JsonLineDecoder decoder(json, size);
+    decoder.begin_object();
+    std::string member;
+    if (!decoder.next_member(member))
     {
         return;
     }
 
-    JsonNodeInterface::SPtr root_node;
-    JsonNodeInterface::SPtr child_node;
-
-    {
-        std::lock_guard<std::mutex> lock(json_node_mutex_);
-        json_node_->read_json(json);
-        root_node = json_node_->get_node();
-    }
-
-    if (root_node->has_node("category"))
+    if (member == "result")
     {
-        child_node = root_node->get_node("category");
-        auto category = std::make_shared<SearchCategory>();
-
-        std::vector<std::string> members = child_node->member_names();
-        for (auto& member : members)
+        // Results are by far the most common line, so they are decoded in a single pass:
+        // uri and cat_id are extracted, the remaining members go straight into other_params,
+        // and the result's original text becomes result.json.
+        SearchResult result;
+        auto mark = decoder.mark();
+        decoder.begin_object();
+        std::string name;
+        while (decoder.next_member(name))
         {
-            if (member == "icon")
+            if (name == "uri")
             {
-                category->icon = child_node->get_node(member)->as_string();
+                result.uri = decoder.string_value();
             }
-            else if (member == "id")
+            else if (name == "cat_id")
             {
-                category->id = child_node->get_node(member)->as_string();
+                result.category_id = decoder.string_value();
             }
-            else if (member == "render_template")
-            {
-                category->renderer_template = child_node->get_node(member)->as_string();
-            }
-            else if (member == "title")
+            else
             {
-                category->title = child_node->get_node(member)->as_string();
+                result.other_params[name] = decoder.value();
             }
         }
-        handler.category_handler(category);
+        result.json = decoder.text_since(mark);
+        finish_line(decoder);
+        handler.result_handler(result);
     }
-    else if (root_node->has_node("result"))
+    else if (member == "category")
     {
-        child_node = root_node->get_node("result");
-        SearchResult result;
-        result.json = child_node->to_json_string();
-
-        std::vector<std::string> members = child_node->member_names();
-        for (auto& member : members)
+        auto category = std::make_shared<SearchCategory>();
+        decoder.begin_object();
+        std::string name;
+        while (decoder.next_member(name))
         {
-            if (member == "uri")
+            if (name == "icon")
+            {
+                category->icon = decoder.string_value();
+            }
+            else if (name == "id")
+            {
+                category->id = decoder.string_value();
+            }
+            else if (name == "render_template")
             {
-                result.uri = child_node->get_node(member)->as_string();
+                category->renderer_template = decoder.string_value();
             }
-            else if (member == "cat_id")
+            else if (name == "title")
             {
-                std::string category = child_node->get_node(member)->as_string();
-                result.category_id = category;
+                category->title = decoder.string_value();
             }
             else
             {
-                result.other_params[member] = child_node->get_node(member);
+                decoder.skip_value();
             }
         }
-        handler.result_handler(result);
-    }
-    else if (root_node->has_node("departments"))
-    {
-        auto departments = parse_departments(root_node->get_node("departments"));
-        handler.departments_handler(departments);
-    }
-    else if (root_node->has_node("filter_groups"))
-    {
-        handler.filter_groups = parse_filter_groups(root_node->get_node("filter_groups"));
-    }
-    else if (root_node->has_node("filters"))
-    {
-        auto filters = parse_filters(root_node->get_node("filters"), handler.filter_groups);
-        handler.filters_handler(filters);
+        finish_line(decoder);
+        handler.category_handler(category);
     }
-    else if (root_node->has_node("filter_state"))
+    else if (member == "departments" || member == "filter_groups" || member == "filters" || member == "filter_state")
     {
-        auto filter_state = parse_filter_state(root_node->get_node("filter_state"));
-        handler.filter_state_handler(filter_state);
+        // These arrive at most once per query, so we use a (per-line) JSON tree for them.
+        auto mark = decoder.mark();
+        decoder.skip_value();
+        JsonNodeInterface::SPtr node = std::make_shared<JsonCppNode>(decoder.text_since(mark));
+        finish_line(decoder);
+
+        if (member == "departments")
+        {
+            auto departments = parse_departments(node);
+            handler.departments_handler(departments);
+        }
+        else if (member == "filter_groups")
+        {
+            handler.filter_groups = parse_filter_groups(node);
+        }
+        else if (member == "filters")
+        {
+            auto filters = parse_filters(node, handler.filter_groups);
+            handler.filters_handler(filters);
+        }
+        else
+        {
+            auto filter_state = parse_filter_state(node);
+            handler.filter_state_handler(filter_state);
+        }
     }
 }
 
@@ -736,21 +1050,40 @@ void SmartScopesClient::wait_for_search(unsigned int search_id)
 {
     try
     {
-        HttpResponseHandle::SPtr query_result;
+        std::shared_ptr<SharedSearch> search;
         {
             std::lock_guard<std::mutex> lock(query_results_mutex_);
 
-            auto it = query_results_.find(search_id);
-            if (it == query_results_.end())
+            auto it = search_results_.find(search_id);
+            if (it == search_results_.end())
             {
                 throw unity::LogicException("No search for query " + std::to_string(search_id) + " is active");
             }
 
-            query_result = it->second;
+            search = it->second;
         }
 
-        query_result->wait();
-        query_result->get(); // may throw on error
+        // Wait until the response is complete or this search is cancelled.
+        bool cancelled;
+        std::exception_ptr error;
+        {
+            std::unique_lock<std::mutex> lock(search->mutex);
+            search->cond.wait(lock, [search, search_id]
+            {
+                return search->done || search->subscribers.find(search_id) == search->subscribers.end();
+            });
+            cancelled = search->subscribers.erase(search_id) == 0;
+            error = search->error;
+        }
+
+        if (cancelled)
+        {
+            throw unity::LogicException("Search for query " + std::to_string(search_id) + " was cancelled");
+        }
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
     }
     catch (std::exception const& e)
     {
@@ -760,7 +1093,63 @@ void SmartScopesClient::wait_for_search(unsigned int search_id)
     }
 
     std::lock_guard<std::mutex> lock(query_results_mutex_);
-    query_results_.erase(search_id);
+    search_results_.erase(search_id);
+}
+
+void SmartScopesClient::complete_search(std::shared_ptr<SharedSearch> const& search, std::exception_ptr const& error)
+{
+    // Synchronous searches are woken up and find out for themselves. Asynchronous ones are
+    // done now, so they are unsubscribed here, and their finished handlers called without
+    // holding any locks.
+    std::vector<unsigned int> finished_ids;
+    std::vector<std::function<void(std::exception_ptr const&)>> finished;
+    {
+        std::lock_guard<std::mutex> search_lock(search->mutex);
+        search->done = true;
+        search->error = error;
+        for (auto it = search->subscribers.begin(); it != search->subscribers.end(); )
+        {
+            if (it->second->finished_handler)
+            {
+                finished_ids.push_back(it->first);
+                finished.push_back(it->second->finished_handler);
+                it = search->subscribers.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        finished.insert(finished.end(), search->cancelled.begin(), search->cancelled.end());
+        search->cancelled.clear();
+        search->cond.notify_all();
+    }
+
+    {
+        // Later identical searches need a new request.
+        std::lock_guard<std::mutex> lock(query_results_mutex_);
+        auto it = shared_searches_.find(search->key);
+        if (it != shared_searches_.end() && it->second == search)
+        {
+            shared_searches_.erase(it);
+        }
+        for (auto id : finished_ids)
+        {
+            search_results_.erase(id);
+        }
+    }
+
+    for (auto const& f : finished)
+    {
+        try
+        {
+            f(error);
+        }
+        catch (std::exception const& e)
+        {
+            logger_() << "SmartScopesClient.search(): finished handler threw an exception: " << e.what();
+        }
+    }
 }
 
 std::shared_ptr<DepartmentInfo> SmartScopesClient::parse_departments(JsonNodeInterface::SPtr node)
@@ -872,28 +1261,6 @@ void SmartScopesClient::wait_for_preview(unsigned int preview_id)
     query_results_.erase(preview_id);
 }
 
-std::vector<std::string> SmartScopesClient::extract_json_stream(std::string const& json_stream)
-{
-    std::vector<std::string> jsons;
-
-    unsigned int start_pos = 0;
-
-    while (start_pos < json_stream.size())
-    {
-        int end_pos = json_stream.find("\r\n", start_pos);
-        if (end_pos == -1)
-        {
-            end_pos = json_stream.size();
-        }
-
-        std::string sub_json_str = json_stream.substr(start_pos, end_pos - start_pos);
-        jsons.push_back(sub_json_str);
-        start_pos = end_pos + 2;
-    }
-
-    return jsons;
-}
-
 void SmartScopesClient::cancel_query(unsigned int query_id)
 {
     std::lock_guard<std::mutex> lock(query_results_mutex_);
@@ -904,6 +1271,43 @@ void SmartScopesClient::cancel_query(unsigned int query_id)
         it->second->cancel();
         query_results_.erase(it);
     }
+
+    auto search_it = search_results_.find(query_id);
+    if (search_it != search_results_.end())
+    {
+        auto search = search_it->second;
+        search_results_.erase(search_it);
+
+        // Taking the search's mutex guarantees that the handler is not called once we return.
+        // An asynchronous search is finished once the request completes.
+        bool last;
+        {
+            std::lock_guard<std::mutex> search_lock(search->mutex);
+            auto subscriber = search->subscribers.find(query_id);
+            if (subscriber == search->subscribers.end())
+            {
+                return;  // Already complete
+            }
+            if (subscriber->second->finished_handler)
+            {
+                search->cancelled.push_back(subscriber->second->finished_handler);
+            }
+            search->subscribers.erase(subscriber);
+            last = search->subscribers.empty() && !search->done;
+            search->cond.notify_all();
+        }
+
+        // The request is cancelled only when no other search shares it.
+        if (last)
+        {
+            search->response->cancel();
+            auto shared_it = shared_searches_.find(search->key);
+            if (shared_it != shared_searches_.end() && shared_it->second == search)
+            {
+                shared_searches_.erase(shared_it);
+            }
+        }
+    }
 }
 
 void SmartScopesClient::write_cache(std::string const& scopes_json)
@@ -945,6 +1349,39 @@ std::string SmartScopesClient::read_cache()
     return cached_scopes_;
 }
 
+// Brings the binary cache up to date with the JSON cache, unless it already is.
+
+void SmartScopesClient::write_binary_cache(std::vector<RemoteScope> const& scopes)
+{
+    auto const json_path = c_scopes_cache_dir + c_scopes_cache_filename;
+    auto const path = c_scopes_cache_dir + c_scopes_binary_cache_filename;
+    try
+    {
+        if (!RemoteScopesCache::is_current(path, json_path))
+        {
+            RemoteScopesCache::write(path, json_path, scopes);
+        }
+    }
+    catch (std::exception const& e)
+    {
+        logger_() << "SmartScopesClient.get_remote_scopes(): Failed to write to cache file: " << path << ": " << e.what();
+    }
+}
+
+// Settings rarely change between queries, so we keep the encoded settings of the last query for each scope.
+
+std::string SmartScopesClient::encoded_settings(std::string const& base_url, VariantMap const& settings)
+{
+    std::lock_guard<std::mutex> lock(encoded_settings_mutex_);
+    auto& entry = encoded_settings_[base_url];
+    if (entry.encoded.empty() || entry.settings != settings)
+    {
+        entry.settings = settings;
+        entry.encoded = UriBuilder::percent_encode(stringify_settings(settings));
+    }
+    return entry.encoded;
+}
+
 std::string SmartScopesClient::stringify_settings(VariantMap const& settings)
 {
     std::ostringstream result_str;
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/smartscopes/UriBuilder.h>
+
+#include <clocale>
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace smartscopes
+{
+
+namespace
+{
+
+// Lookup table of the characters that don't need encoding.
+
+struct Unreserved
+{
+    bool table[256];
+
+    Unreserved()
+    {
+        for (int c = 0; c < 256; ++c)
+        {
+            table[c] = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')
+                       || c == '-' || c == '.' || c == '_' || c == '~';
+        }
+    }
+};
+
+Unreserved const unreserved;
+
+char const hex_digits[] = "0123456789ABCDEF";
+
+}  // namespace
+
+UriBuilder::UriBuilder(string const& base, string const& resource)
+    : first_(true)
+{
+    uri_.reserve(256);
+    uri_.append(base).append(resource).push_back('?');
+}
+
+UriBuilder& UriBuilder::param(char const* name, string const& value)
+{
+    begin_param(name);
+    percent_encode(value, uri_);
+    return *this;
+}
+
+UriBuilder& UriBuilder::raw_param(char const* name, string const& value)
+{
+    begin_param(name);
+    uri_.append(value);
+    return *this;
+}
+
+UriBuilder& UriBuilder::param(char const* name, int64_t value)
+{
+    begin_param(name);
+    uri_.append(to_string(value));
+    return *this;
+}
+
+UriBuilder& UriBuilder::param(char const* name, double value, int precision)
+{
+    begin_param(name);
+    char buf[64];
+    int len = snprintf(buf, sizeof(buf), "%.*f", precision, value);
+    if (len < 0 || size_t(len) >= sizeof(buf))
+    {
+        len = snprintf(buf, sizeof(buf), "%g", value);  // LCOV_EXCL_LINE  // Huge value
+    }
+
+    // snprintf() uses the decimal point of the locale, which isn't necessarily ".".
+    char const* point = localeconv()->decimal_point;
+    size_t const point_len = strlen(point);
+    char const* dp = point_len == 0 ? nullptr : strstr(buf, point);
+    if (dp && strcmp(point, ".") != 0)
+    {
+        uri_.append(buf, dp - buf).push_back('.');
+        uri_.append(dp + point_len);
+    }
+    else
+    {
+        uri_.append(buf, len);
+    }
+    return *this;
+}
+
+string const& UriBuilder::str() const noexcept
+{
+    return uri_;
+}
+
+void UriBuilder::percent_encode(string const& s, string& out)
+{
+    out.reserve(out.size() + s.size() + s.size() / 2);
+
+    auto const* p = reinterpret_cast<unsigned char const*>(s.data());
+    auto const* const end = p + s.size();
+    while (p < end)
+    {
+        // Copy runs of unreserved characters in one go.
+        auto const* run = p;
+        while (p < end && unreserved.table[*p])
+        {
+            ++p;
+        }
+        out.append(reinterpret_cast<char const*>(run), p - run);
+        if (p < end)
+        {
+            char const escaped[3] = { '%', hex_digits[*p >> 4], hex_digits[*p & 0xf] };
+            out.append(escaped, 3);
+            ++p;
+        }
+    }
+}
+
+string UriBuilder::percent_encode(string const& s)
+{
+    string out;
+    percent_encode(s, out);
+    return out;
+}
+
+void UriBuilder::begin_param(char const* name)
+{
+    if (!first_)
+    {
+        uri_.push_back('&');
+    }
+    first_ = false;
+    uri_.append(name).push_back('=');
+}
+
+} // namespace smartscopes
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
@@ -36,6 +36,8 @@ namespace internal
 namespace zmq_middleware
 {
 
+atomic<int64_t> ConnectionPool::total_connections_(0);
+
 ConnectionPool::ConnectionPool(zmqpp::context& context, int close_after_idle_seconds)
     : context_(context)
     , reaper_(Reaper::create(1, close_after_idle_seconds))
@@ -47,6 +49,7 @@ ConnectionPool::~ConnectionPool()
 {
     assert([this]() -> bool { lock_guard<mutex> lock(mutex_); return this_thread::get_id() == thread_id_; }());
     reaper_ = nullptr;
+    total_connections_ -= pool_.size();
     pool_.clear();
 }
 
@@ -75,6 +78,7 @@ shared_ptr<zmqpp::socket> ConnectionPool::find(std::string const& endpoint)
     auto ri = reaper_->add([this, endpoint]{ remove(endpoint); });
     PoolEntry entry{endpoint, s, ri};
     pool_.emplace(make_pair(endpoint, entry));
+    ++total_connections_;
     return s;
 }
 
@@ -109,6 +113,7 @@ void ConnectionPool::remove(std::string const& endpoint)
     if (it != pool_.end())
     {
         pool_.erase(it);
+        --total_connections_;
     }
 }
 
@@ -123,7 +128,15 @@ void ConnectionPool::register_socket(std::string const& endpoint,
 
     auto ri = idle_timeout ? reaper_->add([this, endpoint]{ remove(endpoint); }) : nullptr;
     PoolEntry entry{endpoint, socket, ri};
-    pool_.emplace(endpoint, entry);
+    if (pool_.emplace(endpoint, entry).second)
+    {
+        ++total_connections_;
+    }
+}
+
+int64_t ConnectionPool::total_connections() noexcept
+{
+    return total_connections_;
 }
 
 } // namespace zmq_middleware
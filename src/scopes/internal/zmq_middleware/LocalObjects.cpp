@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/zmq_middleware/LocalObjects.h>
+
+#include <unity/scopes/internal/AbstractObject.h>
+#include <unity/scopes/internal/zmq_middleware/ObjectAdapter.h>
+
+#include <cassert>
+
+using namespace std;
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace zmq_middleware
+{
+
+LocalObjects::LocalObjects()
+    : size_(0)
+{
+}
+
+LocalObjects& LocalObjects::instance()
+{
+    static LocalObjects objects;
+    return objects;
+}
+
+void LocalObjects::add(string const& endpoint,
+                       string const& identity,
+                       ZmqMiddleware* mw,
+                       shared_ptr<ObjectAdapter> const& adapter,
+                       shared_ptr<AbstractObject> const& object)
+{
+    assert(mw);
+    assert(adapter);
+    assert(object);
+
+    lock_guard<mutex> lock(mutex_);
+    objects_[key(endpoint, identity)] = Entry{ mw, adapter, object };
+    size_ = objects_.size();
+}
+
+void LocalObjects::remove(string const& endpoint, string const& identity) noexcept
+{
+    lock_guard<mutex> lock(mutex_);
+    objects_.erase(key(endpoint, identity));
+    size_ = objects_.size();
+}
+
+void LocalObjects::remove_all(ZmqMiddleware* mw) noexcept
+{
+    lock_guard<mutex> lock(mutex_);
+    for (auto it = objects_.begin(); it != objects_.end(); )
+    {
+        if (it->second.mw == mw)
+        {
+            it = objects_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    size_ = objects_.size();
+}
+
+LocalObjects::Target LocalObjects::find(string const& endpoint, string const& identity) const
+{
+    if (size_ == 0)
+    {
+        return Target{ nullptr, nullptr, nullptr };  // Common case for a process that hosts no scopes.
+    }
+
+    lock_guard<mutex> lock(mutex_);
+    auto it = objects_.find(key(endpoint, identity));
+    if (it == objects_.end())
+    {
+        return Target{ nullptr, nullptr, nullptr };
+    }
+    Target t{ it->second.mw, it->second.adapter.lock(), it->second.object.lock() };
+    if (!t.adapter || !t.object)
+    {
+        return Target{ nullptr, nullptr, nullptr };
+    }
+    return t;
+}
+
+string LocalObjects::key(string const& endpoint, string const& identity)
+{
+    // Endpoints never contain a newline.
+    return endpoint + '\n' + identity;
+}
+
+} // namespace zmq_middleware
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
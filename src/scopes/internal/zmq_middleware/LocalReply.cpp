@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/zmq_middleware/LocalReply.h>
+
+#include <unity/scopes/internal/ReplyObjectBase.h>
+#include <unity/scopes/internal/RuntimeImpl.h>
+#include <unity/scopes/internal/zmq_middleware/LocalObjects.h>
+#include <unity/scopes/internal/zmq_middleware/ZmqMiddleware.h>
+
+#include <cassert>
+
+using namespace std;
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace zmq_middleware
+{
+
+LocalReply::LocalReply(ZmqMiddleware* mw_base, string const& endpoint, string const& identity, string const& category) :
+    MWObjectProxy(mw_base),
+    ZmqObjectProxy(mw_base, endpoint, identity, category, RequestMode::Oneway),
+    MWReply(mw_base),
+    ZmqReply(mw_base, endpoint, identity, category)
+{
+}
+
+LocalReply::~LocalReply()
+{
+}
+
+void LocalReply::push(VariantMap const& result)
+{
+    if (!invoke_local_([result](ReplyObjectBase& r) { r.push(result); }))
+    {
+        ZmqReply::push(result);
+    }
+}
+
+void LocalReply::finished(CompletionDetails const& details)
+{
+    if (!invoke_local_([details](ReplyObjectBase& r) { r.finished(details); }))
+    {
+        ZmqReply::finished(details);
+    }
+}
+
+void LocalReply::info(OperationInfo const& op_info)
+{
+    if (!invoke_local_([op_info](ReplyObjectBase& r) { r.info(op_info); }))
+    {
+        ZmqReply::info(op_info);
+    }
+}
+
+// Queues the call on the local reply pool of the middleware that hosts the reply object.
+// Like a oneway invocation, this returns without waiting for the reply object to process the call.
+
+template<typename F>
+bool LocalReply::invoke_local_(F f)
+{
+    auto target = LocalObjects::instance().find(endpoint(), identity());
+    if (!target)
+    {
+        return false;
+    }
+    auto reply = dynamic_pointer_cast<ReplyObjectBase>(target.object);
+    assert(reply);
+    try
+    {
+        // The task holds the reply object, so it stays alive until the call completes.
+        target.mw->local_reply_pool()->submit([reply, f] { f(*reply); });
+    }
+    catch (std::exception const& e)
+    {
+        // The client's middleware is shutting down. The reply adapter would drop the message too.
+        UNITY_SCOPES_LOG(mw_base()->runtime()->logger(), LoggerChannel::IPC)
+            << "LocalReply: dropping message for " << identity() << ": " << e.what();
+    }
+    return true;
+}
+
+ZmqReplyProxy make_reply_proxy(ZmqMiddleware* mw_base,
+                               string const& endpoint,
+                               string const& identity,
+                               string const& category)
+{
+    if (LocalObjects::instance().find(endpoint, identity))
+    {
+        return make_shared<LocalReply>(mw_base, endpoint, identity, category);
+    }
+    return make_shared<ZmqReply>(mw_base, endpoint, identity, category);
+}
+
+} // namespace zmq_middleware
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
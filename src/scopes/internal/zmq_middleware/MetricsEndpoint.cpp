@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/zmq_middleware/MetricsEndpoint.h>
+
+#include <unity/scopes/internal/zmq_middleware/Util.h>
+#include <unity/scopes/ScopeExceptions.h>
+
+#include <zmqpp/poller.hpp>
+#include <zmqpp/socket.hpp>
+
+using namespace std;
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace zmq_middleware
+{
+
+MetricsEndpoint::MetricsEndpoint(zmqpp::context* context, string const& endpoint, MetricsRegistry const& metrics)
+    : context_(context)
+    , endpoint_(endpoint)
+    , metrics_(metrics)
+    , stopper_(context, "metrics-stopper-" + endpoint)
+    , thread_state_(NotRunning)
+    , thread_exception_(nullptr)
+{
+    thread_ = thread(&MetricsEndpoint::endpoint_thread, this);
+
+    unique_lock<mutex> lock(mutex_);
+    cond_.wait(lock, [this] { return thread_state_ != NotRunning; });
+
+    if (thread_state_ == Failed)
+    {
+        thread_.join();
+        try
+        {
+            rethrow_exception(thread_exception_);
+        }
+        catch (std::exception const& e)
+        {
+            throw MiddlewareException("MetricsEndpoint(): cannot serve metrics on " + endpoint_ + ": " + e.what());
+        }
+        catch (...)
+        {
+            throw MiddlewareException("MetricsEndpoint(): cannot serve metrics on " + endpoint_);  // LCOV_EXCL_LINE
+        }
+    }
+}
+
+MetricsEndpoint::~MetricsEndpoint()
+{
+    stopper_.stop();
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+}
+
+string MetricsEndpoint::endpoint() const
+{
+    return endpoint_;
+}
+
+void MetricsEndpoint::endpoint_thread()
+{
+    try
+    {
+        zmqpp::socket s(*context_, zmqpp::socket_type::reply);
+        s.set(zmqpp::socket_option::linger, 50);
+        safe_bind(s, endpoint_);
+
+        zmqpp::poller poller;
+        poller.add(s);
+        auto stop = stopper_.subscribe();
+        poller.add(stop);
+
+        {
+            lock_guard<mutex> lock(mutex_);
+            thread_state_ = Running;
+            cond_.notify_all();
+        }
+
+        for (;;)
+        {
+            poller.poll();
+            if (poller.has_input(stop))
+            {
+                break;
+            }
+            if (poller.has_input(s))
+            {
+                // We don't care what's in the request; discard all of its parts.
+                string buf;
+                do
+                {
+                    s.receive(buf);
+                } while (s.has_more_parts());
+                s.send(metrics_.to_string());
+            }
+        }
+    }
+    catch (...)
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (thread_state_ == NotRunning)
+        {
+            thread_exception_ = current_exception();
+            thread_state_ = Failed;
+            cond_.notify_all();
+        }
+        // Once running, there is no-one to report an error to, so we just stop serving.
+    }
+}
+
+} // namespace zmq_middleware
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
@@ -18,6 +18,7 @@
 
 #include <unity/scopes/internal/zmq_middleware/ObjectAdapter.h>
 
+#include <unity/scopes/internal/lttng/UnityScopes_tp.h>
 #include <unity/scopes/internal/RuntimeImpl.h>
 #include <unity/scopes/internal/zmq_middleware/ServantBase.h>
 #include <unity/scopes/internal/zmq_middleware/StopPublisher.h>
@@ -32,6 +33,7 @@
 
 #include <cassert>
 #include <sstream>
+#include <unordered_set>
 
 #include <unistd.h>
 #include <sys/socket.h>
@@ -66,7 +68,10 @@ ObjectAdapter::ObjectAdapter(ZmqMiddleware& mw, string const& name, string const
     mode_(m),
     pool_size_(pool_size),
     idle_timeout_(idle_timeout != -1 ? idle_timeout : zmqpp::poller::wait_forever),
+    local_activity_(false),
+    busy_dispatchers_(0),
     state_(Inactive),
+    map_mutex_(ProfiledMutex::Adapter),
     // Some tests use a nullptr for the run time, so we use different loggers in that case.
     test_logger_(mw.runtime() ? nullptr : new Logger("ObjectAdapter_test_logger"))
 {
@@ -137,8 +142,9 @@ ZmqProxy ObjectAdapter::add(std::string const& id, std::shared_ptr<ServantBase>
         throw InvalidArgumentException("ObjectAdapter::add(): invalid nullptr object (adapter: " + name_ + ")");
     }
 
-    lock(map_mutex_, state_mutex_);
-    lock_guard<mutex> map_lock(map_mutex_, adopt_lock);
+    auto& sh = shard(id);
+    lock(sh.mutex, state_mutex_);
+    lock_guard<ProfiledMutex> map_lock(sh.mutex, adopt_lock);
     {
         lock_guard<mutex> state_lock(state_mutex_, adopt_lock);
         if (state_ == Destroyed || state_ == Failed)
@@ -147,7 +153,7 @@ ZmqProxy ObjectAdapter::add(std::string const& id, std::shared_ptr<ServantBase>
         }
     }
 
-    auto pair = servants_.insert(make_pair(id, obj));
+    auto pair = sh.servants.insert(make_pair(id, obj));
     if (!pair.second)
     {
         ostringstream s;
@@ -161,8 +167,9 @@ void ObjectAdapter::remove(std::string const& id)
 {
     shared_ptr<ServantBase> servant;
     {
-        lock(map_mutex_, state_mutex_);
-        lock_guard<mutex> map_lock(map_mutex_, adopt_lock);
+        auto& sh = shard(id);
+        lock(sh.mutex, state_mutex_);
+        lock_guard<ProfiledMutex> map_lock(sh.mutex, adopt_lock);
         {
             lock_guard<mutex> state_lock(state_mutex_, adopt_lock);
             if (state_ == Destroyed || state_ == Failed)
@@ -171,15 +178,15 @@ void ObjectAdapter::remove(std::string const& id)
             }
         }
 
-        auto it = servants_.find(id);
-        if (it == servants_.end())
+        auto it = sh.servants.find(id);
+        if (it == sh.servants.end())
         {
             ostringstream s;
             s << "ObjectAdapter::remove(): " << "cannot remove id \"" << id << "\": id not present (adapter: " << name_ << ")";
             throw MiddlewareException(s.str());
         }
         servant = it->second;
-        servants_.erase(it);
+        sh.servants.erase(it);
     }
     // Lock released here, so we don't call servant destructor while holding a lock
 
@@ -188,18 +195,12 @@ void ObjectAdapter::remove(std::string const& id)
 
 shared_ptr<ServantBase> ObjectAdapter::find(std::string const& id) const
 {
-    lock(map_mutex_, state_mutex_);
-    lock_guard<mutex> map_lock(map_mutex_, adopt_lock);
-    {
-        lock_guard<mutex> state_lock(state_mutex_, adopt_lock);
-        if (state_ == Destroyed || state_ == Failed)
-        {
-            throw_bad_state("find()", state_);
-        }
-    }
+    throw_if_destroyed("find()");
 
-    auto it = servants_.find(id);
-    if (it != servants_.end())
+    auto& sh = shard(id);
+    lock_guard<ProfiledMutex> map_lock(sh.mutex);
+    auto it = sh.servants.find(id);
+    if (it != sh.servants.end())
     {
         return it->second;
     }
@@ -214,7 +215,7 @@ void ObjectAdapter::add_dflt_servant(std::string const& category, std::shared_pt
     }
 
     lock(map_mutex_, state_mutex_);
-    lock_guard<mutex> map_lock(map_mutex_, adopt_lock);
+    lock_guard<ProfiledMutex> map_lock(map_mutex_, adopt_lock);
     {
         lock_guard<mutex> state_lock(state_mutex_, adopt_lock);
         if (state_ == Destroyed || state_ == Failed)
@@ -238,7 +239,7 @@ void ObjectAdapter::remove_dflt_servant(std::string const& category)
     shared_ptr<ServantBase> servant;
     {
         lock(map_mutex_, state_mutex_);
-        lock_guard<mutex> map_lock(map_mutex_, adopt_lock);
+        lock_guard<ProfiledMutex> map_lock(map_mutex_, adopt_lock);
         {
             lock_guard<mutex> state_lock(state_mutex_, adopt_lock);
             if (state_ == Destroyed || state_ == Failed)
@@ -265,16 +266,9 @@ void ObjectAdapter::remove_dflt_servant(std::string const& category)
 
 shared_ptr<ServantBase> ObjectAdapter::find_dflt_servant(std::string const& category) const
 {
-    lock(map_mutex_, state_mutex_);
-    lock_guard<mutex> map_lock(map_mutex_, adopt_lock);
-    {
-        lock_guard<mutex> state_lock(state_mutex_, adopt_lock);
-        if (state_ == Destroyed || state_ == Failed)
-        {
-            throw_bad_state("find_dflt_servant()", state_);
-        }
-    }
+    throw_if_destroyed("find_dflt_servant()");
 
+    lock_guard<ProfiledMutex> map_lock(map_mutex_);
     auto it = dflt_servants_.find(category);
     if (it != dflt_servants_.end())
     {
@@ -283,6 +277,44 @@ shared_ptr<ServantBase> ObjectAdapter::find_dflt_servant(std::string const& cate
     return shared_ptr<ServantBase>();
 }
 
+void ObjectAdapter::note_activity() noexcept
+{
+    local_activity_ = true;
+}
+
+ThreadPool* ObjectAdapter::local_invoker()
+{
+    lock_guard<mutex> lock(state_mutex_);
+    if (state_ != Active)
+    {
+        throw MiddlewareException("ObjectAdapter::invoke_local(): adapter is not active (adapter: " + name_ + ")");
+    }
+    if (!local_invoker_)
+    {
+        local_invoker_.reset(new ThreadPool(pool_size_));
+    }
+    return local_invoker_.get();
+}
+
+// Direct calls from proxies in this process and requests that arrive via zmq share
+// pool_size_ slots, so a servant of a single-threaded adapter is never called concurrently.
+
+void ObjectAdapter::acquire_dispatch_slot()
+{
+    unique_lock<mutex> lock(dispatch_mutex_);
+    dispatch_slot_freed_.wait(lock, [this]{ return busy_dispatchers_ < pool_size_; });
+    ++busy_dispatchers_;
+}
+
+void ObjectAdapter::release_dispatch_slot() noexcept
+{
+    {
+        lock_guard<mutex> lock(dispatch_mutex_);
+        --busy_dispatchers_;
+    }
+    dispatch_slot_freed_.notify_one();
+}
+
 void ObjectAdapter::activate()
 {
     unique_lock<mutex> lock(state_mutex_);
@@ -409,6 +441,23 @@ void ObjectAdapter::wait_for_shutdown()
     }
 }
 
+// Called without state_mutex_, so dispatch does not contend with state changes
+// and with add() and remove().
+
+void ObjectAdapter::throw_if_destroyed(string const& label) const
+{
+    AdapterState state = state_;
+    if (state == Destroyed || state == Failed)
+    {
+        throw_bad_state(label, state);
+    }
+}
+
+ObjectAdapter::ServantShard& ObjectAdapter::shard(string const& id) const
+{
+    return servant_shards_[hash<string>()(id) % num_servant_shards];
+}
+
 void ObjectAdapter::throw_bad_state(string const& label, AdapterState state) const
 {
     string bad_state;
@@ -523,10 +572,19 @@ void ObjectAdapter::pump(std::promise<void> ready)
         // Start the pump.
         bool shutting_down = false;
         queue<string> ready_workers;
+        bool saturated = false;              // All workers were busy and we stopped reading from the frontend.
+
+        // Requests that are waiting in the frontend aren't visible to us, so we report
+        // how many workers are busy and how often all of them were busy.
+        unordered_set<string> busy_workers;
+        auto& metrics = mw_.metrics();
+        auto& requests_counter = metrics.counter("adapter." + name_ + ".requests");
+        auto& saturated_counter = metrics.counter("adapter." + name_ + ".saturated");
+        auto& busy_gauge = metrics.gauge("adapter." + name_ + ".busy_workers");
 
         for (;;)
         {
-            if (!poller.poll(idle_timeout_))
+            if (!poller.poll(idle_timeout_) && !local_activity_.exchange(false))
             {
                 // Shut down, no activity for the idle timeout period.
                 mw_.stop();
@@ -550,10 +608,19 @@ void ObjectAdapter::pump(std::promise<void> ready)
                 string worker_id;
                 backend.receive(worker_id);          // First frame: worker ID for LRU routing
                 ready_workers.push(worker_id);       // Thread will be ready again in a sec
+                if (busy_workers.erase(worker_id) != 0)
+                {
+                    busy_gauge.add(-1);
+                }
                 if (!shutting_down && ready_workers.size() == 1)
                 {
                     // We poll the front end while there is at least one worker.
                     poller.add(frontend);
+                    if (saturated)
+                    {
+                        simple_tracepoint(unity_scopes, adapter_resumed, name_.c_str());
+                        saturated = false;
+                    }
                 }
                 string buf;
                 backend.receive(buf);                // Second frame: empty delimiter frame
@@ -595,7 +662,13 @@ void ObjectAdapter::pump(std::promise<void> ready)
                 if (ready_workers.size() == 0)  // Stop reading from frontend once all workers are busy.
                 {
                     poller.remove(frontend);
+                    simple_tracepoint(unity_scopes, adapter_saturated, name_.c_str());
+                    saturated_counter.inc();
+                    saturated = true;
                 }
+                busy_workers.insert(worker_id);
+                busy_gauge.add(1);
+                requests_counter.inc();
 
                 // Give incoming request to worker.
                 backend.send(worker_id, zmqpp::socket::send_more);
@@ -805,10 +878,12 @@ void ObjectAdapter::dispatch(zmqpp::socket& pump, string const& client_address)
     capnp::MallocMessageBuilder b;
     auto r = b.initRoot<capnproto::Response>();
     trace_dispatch(current);
+    acquire_dispatch_slot();
     servant->safe_dispatch_(current, in_params, r); // noexcept
+    release_dispatch_slot();
     if (mode_ == RequestMode::Twoway)
     {
-        logger()(LoggerChannel::IPC) << decode_status(b.getRoot<capnproto::Response>());
+        UNITY_SCOPES_LOG(logger(), LoggerChannel::IPC) << decode_status(b.getRoot<capnproto::Response>());
         pump.send(client_address, zmqpp::socket::send_more);
         pump.send("", zmqpp::socket::send_more);
         sender.send(b.getSegmentsForOutput());
@@ -818,13 +893,26 @@ void ObjectAdapter::dispatch(zmqpp::socket& pump, string const& client_address)
 void ObjectAdapter::cleanup()
 {
     join_with_all_threads();
+    unique_ptr<ThreadPool> local_invoker;
+    {
+        lock_guard<mutex> lock(state_mutex_);
+        local_invoker = move(local_invoker_);
+    }
+    local_invoker.reset();  // Waits for a task that is running. Queued tasks are discarded.
     {
         // Need a full fence here to make sure this thread sees up-to-date
-        // memory for servants_ and dflt_servants_.
-        lock_guard<mutex> lock(map_mutex_);
+        // memory for the servant maps.
+        lock_guard<ProfiledMutex> lock(map_mutex_);
+        for (auto const& s : servant_shards_)
+        {
+            lock_guard<ProfiledMutex> shard_lock(s.mutex);
+        }
     }
     // Don't hold a lock while the servant destructors run.
-    servants_.clear();
+    for (auto& s : servant_shards_)
+    {
+        s.servants.clear();
+    }
     dflt_servants_.clear();
 }
 
@@ -858,7 +946,8 @@ unity::scopes::internal::Logger& ObjectAdapter::logger() const
 
 void ObjectAdapter::trace_dispatch(Current const& c)
 {
-    logger()(LoggerChannel::IPC)
+    simple_tracepoint(unity_scopes, request_received, name_.c_str(), c.id.c_str(), c.op_name.c_str());
+    UNITY_SCOPES_LOG(logger(), LoggerChannel::IPC)
         << "received request: "
         << "op = " << c.op_name
         << ", id = " << c.id
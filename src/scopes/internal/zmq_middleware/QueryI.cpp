@@ -19,8 +19,8 @@
 #include <unity/scopes/internal/zmq_middleware/QueryI.h>
 
 #include <scopes/internal/zmq_middleware/capnproto/Query.capnp.h>
+#include <unity/scopes/internal/zmq_middleware/LocalReply.h>
 #include <unity/scopes/internal/zmq_middleware/ObjectAdapter.h>
-#include <unity/scopes/internal/zmq_middleware/ZmqReply.h>
 #include <unity/scopes/internal/QueryObject.h>
 #include <cassert>
 
@@ -66,10 +66,11 @@ void QueryI::run_(Current const& current,
 {
     auto req = in_params.getAs<capnproto::Query::RunRequest>();
     auto proxy = req.getReplyProxy();
-    ZmqReplyProxy reply_proxy(new ZmqReply(current.adapter->mw(),
-                              proxy.getEndpoint().cStr(),
-                              proxy.getIdentity().cStr(),
-                              proxy.getCategory().cStr()));
+    // The reply object may be in this process, in which case the results bypass zmq.
+    auto reply_proxy = make_reply_proxy(current.adapter->mw(),
+                                        proxy.getEndpoint().cStr(),
+                                        proxy.getIdentity().cStr(),
+                                        proxy.getCategory().cStr());
     assert(del());
     auto delegate = dynamic_pointer_cast<QueryObjectBase>(del());
     assert(delegate);
@@ -19,6 +19,7 @@
 #include <unity/scopes/internal/zmq_middleware/ReplyI.h>
 
 #include <scopes/internal/zmq_middleware/capnproto/Reply.capnp.h>
+#include <unity/scopes/internal/CompletionDetailsImpl.h>
 #include <unity/scopes/internal/zmq_middleware/ObjectAdapter.h>
 #include <unity/scopes/internal/zmq_middleware/ZmqReply.h>
 #include <unity/scopes/internal/zmq_middleware/VariantConverter.h>
@@ -106,7 +107,12 @@ void ReplyI::finished_(Current const&,
             status = CompletionDetails::Error; // LCOV_EXCL_LINE
         }
     }
-    delegate->finished(CompletionDetails(status, msg));
+    CompletionDetails details(status, msg);
+    if (req.hasMetrics())
+    {
+        CompletionDetailsImpl::add_metrics(details, to_variant_map(req.getMetrics()));
+    }
+    delegate->finished(details);
 }
 
 void ReplyI::info_(Current const&,
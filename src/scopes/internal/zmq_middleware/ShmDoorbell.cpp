@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/zmq_middleware/ShmDoorbell.h>
+
+#include <unity/scopes/internal/safe_strerror.h>
+#include <unity/scopes/ScopeExceptions.h>
+
+#include <atomic>
+#include <climits>
+#include <iomanip>
+#include <sstream>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace zmq_middleware
+{
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "ShmDoorbell requires address-free 32-bit atomics");
+
+namespace
+{
+
+uint32_t const doorbell_magic = 0x55534442;  // "USDB"
+
+// FNV-1a, so the segment name is the same in every process.
+uint64_t hash(string const& s)
+{
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : s)
+    {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+} // namespace
+
+struct ShmDoorbell::Header
+{
+    uint32_t magic;
+    atomic<uint32_t> sequence;  // Futex word, incremented by every ring()
+    atomic<uint32_t> waiting;   // Non-zero while the consumer is (about to be) asleep
+};
+
+ShmDoorbell::SPtr ShmDoorbell::create(string const& name)
+{
+    // A doorbell left behind by a crashed process with the same endpoint is useless to anyone else.
+    shm_unlink(name.c_str());
+
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if (fd == -1)
+    {
+        throw MiddlewareException("ShmDoorbell::create(): cannot create " + name + ": " + safe_strerror(errno));
+    }
+    if (ftruncate(fd, sizeof(Header)) == -1)
+    {
+        int err = errno;
+        ::close(fd);
+        shm_unlink(name.c_str());
+        throw MiddlewareException("ShmDoorbell::create(): cannot size " + name + ": " + safe_strerror(err));
+    }
+
+    SPtr doorbell;
+    try
+    {
+        doorbell.reset(new ShmDoorbell(name, fd, true));
+    }
+    catch (...)
+    {
+        shm_unlink(name.c_str());
+        throw;
+    }
+    doorbell->header_->sequence.store(0);
+    doorbell->header_->waiting.store(0);
+    atomic_thread_fence(memory_order_release);
+    doorbell->header_->magic = doorbell_magic;
+    return doorbell;
+}
+
+ShmDoorbell::SPtr ShmDoorbell::open(string const& name)
+{
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd == -1)
+    {
+        throw MiddlewareException("ShmDoorbell::open(): cannot open " + name + ": " + safe_strerror(errno));
+    }
+    SPtr doorbell(new ShmDoorbell(name, fd, false));
+    atomic_thread_fence(memory_order_acquire);
+    if (doorbell->header_->magic != doorbell_magic)
+    {
+        throw MiddlewareException("ShmDoorbell::open(): " + name + " is not a compatible doorbell");
+    }
+    return doorbell;
+}
+
+ShmDoorbell::ShmDoorbell(string const& name, int fd, bool owner)
+    : name_(name)
+    , owner_(owner)
+{
+    struct stat st;
+    if (fstat(fd, &st) == -1 || size_t(st.st_size) != sizeof(Header))
+    {
+        ::close(fd);
+        throw MiddlewareException("ShmDoorbell(): invalid segment: " + name);
+    }
+    void* addr = mmap(nullptr, sizeof(Header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int err = errno;
+    ::close(fd);  // The mapping stays valid.
+    if (addr == MAP_FAILED)
+    {
+        throw MiddlewareException("ShmDoorbell(): cannot map " + name + ": " + safe_strerror(err));
+    }
+    header_ = static_cast<Header*>(addr);
+}
+
+ShmDoorbell::~ShmDoorbell()
+{
+    if (owner_)
+    {
+        shm_unlink(name_.c_str());
+    }
+    munmap(header_, sizeof(Header));
+}
+
+string ShmDoorbell::name() const
+{
+    return name_;
+}
+
+// The increment of sequence in ring() and the store to waiting in wait() are sequentially
+// consistent, so either the producer sees waiting != 0 and wakes the consumer, or the
+// consumer sees the new sequence number and does not go to sleep.
+
+void ShmDoorbell::ring() noexcept
+{
+    header_->sequence.fetch_add(1);
+    if (header_->waiting.load())
+    {
+        // Not FUTEX_PRIVATE_FLAG: the futex word is shared between processes.
+        syscall(SYS_futex, &header_->sequence, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    }
+}
+
+uint32_t ShmDoorbell::sequence() const noexcept
+{
+    return header_->sequence.load();
+}
+
+void ShmDoorbell::wait(uint32_t seen_sequence, int64_t timeout_ms) noexcept
+{
+    header_->waiting.store(1);
+    if (header_->sequence.load() == seen_sequence)
+    {
+        struct timespec ts;
+        struct timespec* tsp = nullptr;
+        if (timeout_ms != -1)
+        {
+            ts.tv_sec = timeout_ms / 1000;
+            ts.tv_nsec = (timeout_ms % 1000) * 1000000;
+            tsp = &ts;
+        }
+        // Returns immediately with EAGAIN if sequence no longer equals seen_sequence.
+        syscall(SYS_futex, &header_->sequence, FUTEX_WAIT, seen_sequence, tsp, nullptr, 0);
+    }
+    header_->waiting.store(0);
+}
+
+string ShmDoorbell::doorbell_name(string const& endpoint)
+{
+    ostringstream s;
+    s << "/unity-scopes-" << geteuid() << "-" << hex << setfill('0') << setw(16) << hash(endpoint);
+    return s.str();
+}
+
+} // namespace zmq_middleware
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/zmq_middleware/ShmReplyDispatcher.h>
+
+#include <scopes/internal/zmq_middleware/capnproto/Message.capnp.h>
+#include <unity/scopes/internal/zmq_middleware/ServantBase.h>
+#include <unity/scopes/ScopeExceptions.h>
+
+#include <capnp/serialize.h>
+
+#include <vector>
+
+using namespace std;
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace zmq_middleware
+{
+
+namespace
+{
+
+// Maximum number of messages dispatched from one ring before moving on to the next,
+// so a scope that pushes a lot of results cannot starve the other queries.
+int const max_batch = 16;
+
+// If the doorbell is not rung, we check for shutdown this often.
+int64_t const idle_wait_ms = 1000;
+
+} // namespace
+
+ShmReplyDispatcher::ShmReplyDispatcher(string const& endpoint, Logger& logger)
+    : endpoint_(endpoint)
+    , logger_(logger)
+    , doorbell_(ShmDoorbell::create(ShmDoorbell::doorbell_name(endpoint)))
+    , done_(false)
+{
+    thread_ = thread(&ShmReplyDispatcher::run, this);
+}
+
+ShmReplyDispatcher::~ShmReplyDispatcher()
+{
+    shutdown();
+    if (thread_.get_id() == this_thread::get_id())
+    {
+        // The last reference was dropped by a servant running on our own thread.
+        thread_.detach();
+    }
+    else if (thread_.joinable())
+    {
+        thread_.join();
+    }
+}
+
+void ShmReplyDispatcher::add(string const& id, shared_ptr<ServantBase> const& servant)
+{
+    auto entry = make_shared<Entry>();
+    entry->ring = ShmRing::create(ShmRing::ring_name(endpoint_, id));
+    entry->servant = servant;
+
+    lock_guard<mutex> lock(mutex_);
+    if (done_)
+    {
+        throw MiddlewareException("ShmReplyDispatcher::add(): dispatcher is shut down");
+    }
+    entries_[id] = entry;
+}
+
+void ShmReplyDispatcher::remove(string const& id) noexcept
+{
+    shared_ptr<Entry> entry;
+    {
+        lock_guard<mutex> lock(mutex_);
+        auto it = entries_.find(id);
+        if (it == entries_.end())
+        {
+            return;
+        }
+        entry = it->second;
+        entries_.erase(it);
+    }
+    // The dispatch thread may still hold a reference to the entry; closing the ring makes the
+    // scope stop writing to it immediately. The segment is unlinked once the last reference goes away.
+    entry->ring->close();
+}
+
+void ShmReplyDispatcher::shutdown() noexcept
+{
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (done_)
+        {
+            return;
+        }
+        done_ = true;
+        for (auto& e : entries_)
+        {
+            e.second->ring->close();
+        }
+    }
+    doorbell_->ring();  // Wake up the dispatch thread.
+}
+
+void ShmReplyDispatcher::run()
+{
+    vector<pair<string, shared_ptr<Entry>>> entries;
+    for (;;)
+    {
+        // Read the sequence number before looking at the rings, so we don't miss
+        // a message that arrives after we have checked a ring.
+        uint32_t seq = doorbell_->sequence();
+
+        entries.clear();
+        {
+            lock_guard<mutex> lock(mutex_);
+            if (done_)
+            {
+                return;
+            }
+            entries.assign(entries_.begin(), entries_.end());
+        }
+
+        bool dispatched = false;
+        for (auto const& e : entries)
+        {
+            auto const& id = e.first;
+            auto const& entry = *e.second;
+            try
+            {
+                for (int i = 0; i < max_batch && !entry.ring->closed(); ++i)
+                {
+                    auto const func = [this, &id, &entry](kj::ArrayPtr<capnp::word const> msg)
+                    {
+                        dispatch(id, entry, msg);
+                    };
+                    if (!entry.ring->read(func))
+                    {
+                        break;
+                    }
+                    dispatched = true;
+                }
+            }
+            catch (std::exception const& ex)
+            {
+                logger_() << "ShmReplyDispatcher: cannot read from " << entry.ring->name() << ": " << ex.what();
+                remove(id);
+            }
+        }
+
+        entries.clear();  // Don't keep servants alive while we wait.
+        if (!dispatched)
+        {
+            doorbell_->wait(seq, idle_wait_ms);
+        }
+    }
+}
+
+// Unmarshal the request header and hand the request to the servant, reading the message in place.
+
+void ShmReplyDispatcher::dispatch(string const& id, Entry const& entry, kj::ArrayPtr<capnp::word const> message)
+{
+    capnp::FlatArrayMessageReader reader(message);
+    auto req = reader.getRoot<capnproto::Request>();
+
+    Current current;
+    current.adapter = nullptr;  // Reply servants don't need the adapter.
+    current.id = req.getId().cStr();
+    current.category = req.getCat().cStr();
+    current.op_name = req.getOpName().cStr();
+    if (current.id != id || req.getMode() != capnproto::RequestMode::ONEWAY)
+    {
+        logger_() << "ShmReplyDispatcher: ignoring invalid message (id: " << current.id
+                  << ", op: " << current.op_name << ", ring: " << entry.ring->name() << ")";
+        return;
+    }
+
+    UNITY_SCOPES_LOG(logger_, LoggerChannel::IPC)
+        << "received request (shm): "
+        << "op = " << current.op_name
+        << ", id = " << current.id
+        << ", cat = " << current.category
+        << ", mode = oneway";
+
+    auto in_params = req.getInParams();
+    capnp::MallocMessageBuilder b;
+    auto r = b.initRoot<capnproto::Response>();
+    entry.servant->safe_dispatch_(current, in_params, r); // noexcept
+}
+
+} // namespace zmq_middleware
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
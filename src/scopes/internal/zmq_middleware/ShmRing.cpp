@@ -0,0 +1,383 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/zmq_middleware/ShmRing.h>
+
+#include <unity/scopes/internal/safe_strerror.h>
+#include <unity/scopes/internal/zmq_middleware/ShmDoorbell.h>
+#include <unity/scopes/ScopeExceptions.h>
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace unity
+{
+
+namespace scopes
+{
+
+namespace internal
+{
+
+namespace zmq_middleware
+{
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "ShmRing requires address-free 64-bit atomics");
+
+namespace
+{
+
+uint32_t const ring_magic = 0x55535252;  // "USRR"
+uint32_t const ring_version = 1;
+
+// Each message in the ring is preceded by a frame header. A frame with the wrap
+// flag set marks unused space at the end of the ring; the next frame starts at offset 0.
+struct FrameHeader
+{
+    uint32_t size;      // Payload size in bytes (always a multiple of sizeof(capnp::word))
+    uint32_t wrap;
+};
+
+static_assert(sizeof(FrameHeader) == sizeof(capnp::word), "FrameHeader must be one word");
+
+size_t const word_size = sizeof(capnp::word);
+
+size_t round_up(size_t n, size_t align)
+{
+    return (n + align - 1) / align * align;
+}
+
+// Size in bytes of a message in Cap'n Proto flat array format (segment table followed by the segments).
+size_t flat_size(kj::ArrayPtr<kj::ArrayPtr<capnp::word const> const> segments)
+{
+    size_t table_words = segments.size() / 2 + 1;
+    size_t size = table_words * word_size;
+    for (auto const& s : segments)
+    {
+        size += s.size() * word_size;
+    }
+    return size;
+}
+
+void sleep_until_next_poll(int& poll_count)
+{
+    // Back off gradually; the consumer normally catches up within a few microseconds.
+    if (poll_count++ < 100)
+    {
+        this_thread::yield();
+    }
+    else
+    {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+}
+
+} // namespace
+
+struct ShmRing::Header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;              // Size of the data area in bytes
+    alignas(64) atomic<uint64_t> head;   // Total bytes written; only modified by the producer
+    alignas(64) atomic<uint64_t> tail;   // Total bytes consumed; only modified by the consumer
+    alignas(64) atomic<uint32_t> closed;
+};
+
+ShmRing::SPtr ShmRing::create(string const& name, size_t capacity)
+{
+    assert(capacity % word_size == 0);
+
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if (fd == -1)
+    {
+        throw MiddlewareException("ShmRing::create(): cannot create " + name + ": " + safe_strerror(errno));
+    }
+    size_t size = round_up(sizeof(Header), word_size) + capacity;
+    if (ftruncate(fd, size) == -1)
+    {
+        int err = errno;
+        ::close(fd);
+        shm_unlink(name.c_str());
+        throw MiddlewareException("ShmRing::create(): cannot size " + name + ": " + safe_strerror(err));
+    }
+
+    SPtr ring;
+    try
+    {
+        ring.reset(new ShmRing(name, fd, true));
+    }
+    catch (...)
+    {
+        shm_unlink(name.c_str());
+        throw;
+    }
+    auto h = ring->header_;
+    h->capacity = capacity;
+    ring->capacity_ = capacity;
+    h->head.store(0);
+    h->tail.store(0);
+    h->closed.store(0);
+    h->version = ring_version;
+    atomic_thread_fence(memory_order_release);
+    h->magic = ring_magic;
+    return ring;
+}
+
+ShmRing::SPtr ShmRing::open(string const& name)
+{
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd == -1)
+    {
+        throw MiddlewareException("ShmRing::open(): cannot open " + name + ": " + safe_strerror(errno));
+    }
+    SPtr ring(new ShmRing(name, fd, false));
+    atomic_thread_fence(memory_order_acquire);
+    auto h = ring->header_;
+    // The segment is writable by the other process, so we read the capacity exactly once
+    // and use only the validated copy from here on.
+    uint64_t const capacity = h->capacity;
+    if (h->magic != ring_magic || h->version != ring_version ||
+        capacity % word_size != 0 || capacity < 4 * sizeof(FrameHeader) ||
+        ring->size_ != round_up(sizeof(Header), word_size) + capacity)
+    {
+        throw MiddlewareException("ShmRing::open(): " + name + " is not a compatible ring");
+    }
+    ring->capacity_ = capacity;
+    return ring;
+}
+
+ShmRing::ShmRing(string const& name, int fd, bool owner)
+    : name_(name)
+    , owner_(owner)
+    , size_(0)
+    , capacity_(0)
+    , addr_(MAP_FAILED)
+{
+    struct stat st;
+    if (fstat(fd, &st) == -1 || size_t(st.st_size) < sizeof(Header))
+    {
+        ::close(fd);
+        throw MiddlewareException("ShmRing(): invalid segment: " + name);
+    }
+    size_ = st.st_size;
+    addr_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int err = errno;
+    ::close(fd);  // The mapping stays valid.
+    if (addr_ == MAP_FAILED)
+    {
+        throw MiddlewareException("ShmRing(): cannot map " + name + ": " + safe_strerror(err));
+    }
+    header_ = static_cast<Header*>(addr_);
+    data_ = static_cast<char*>(addr_) + round_up(sizeof(Header), word_size);
+}
+
+ShmRing::~ShmRing()
+{
+    if (owner_)
+    {
+        close();
+        shm_unlink(name_.c_str());
+    }
+    munmap(addr_, size_);
+}
+
+string ShmRing::name() const
+{
+    return name_;
+}
+
+size_t ShmRing::max_message_size() const noexcept
+{
+    // Limiting messages to half the ring guarantees that a message always fits
+    // once the ring has drained, even if the write position requires a wrap.
+    return capacity_ / 2 - sizeof(FrameHeader);
+}
+
+bool ShmRing::write(kj::ArrayPtr<kj::ArrayPtr<capnp::word const> const> segments, int64_t timeout_ms)
+{
+    size_t const payload_size = flat_size(segments);
+    if (payload_size > max_message_size())
+    {
+        return false;
+    }
+    size_t const frame_size = sizeof(FrameHeader) + payload_size;
+    uint64_t const capacity = capacity_;
+
+    auto const deadline = chrono::steady_clock::now() + chrono::milliseconds(timeout_ms);
+    int poll_count = 0;
+
+    uint64_t head = header_->head.load(memory_order_relaxed);
+    for (;;)
+    {
+        if (header_->closed.load(memory_order_acquire))
+        {
+            return false;
+        }
+        uint64_t offset = head % capacity;
+        uint64_t contiguous = capacity - offset;
+        uint64_t needed = frame_size + (contiguous < frame_size ? contiguous : 0);
+        uint64_t tail = header_->tail.load(memory_order_acquire);
+        if (capacity - (head - tail) >= needed)
+        {
+            break;
+        }
+        if (timeout_ms != -1 && chrono::steady_clock::now() >= deadline)
+        {
+            return false;
+        }
+        sleep_until_next_poll(poll_count);
+    }
+
+    uint64_t offset = head % capacity;
+    if (capacity - offset < frame_size)
+    {
+        // Not enough room before the end of the ring; mark the rest as unused and wrap.
+        auto wrap = reinterpret_cast<FrameHeader*>(data_ + offset);
+        wrap->size = 0;
+        wrap->wrap = 1;
+        head += capacity - offset;
+        offset = 0;
+    }
+
+    auto frame = reinterpret_cast<FrameHeader*>(data_ + offset);
+    frame->size = payload_size;
+    frame->wrap = 0;
+
+    // Segment table: number of segments minus one, followed by the size of each segment in words.
+    auto table = reinterpret_cast<uint32_t*>(data_ + offset + sizeof(FrameHeader));
+    size_t table_words = segments.size() / 2 + 1;
+    memset(table, 0, table_words * word_size);
+    table[0] = segments.size() - 1;
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        table[i + 1] = segments[i].size();
+    }
+    char* p = reinterpret_cast<char*>(table) + table_words * word_size;
+    for (auto const& s : segments)
+    {
+        memcpy(p, s.begin(), s.size() * word_size);
+        p += s.size() * word_size;
+    }
+
+    header_->head.store(head + frame_size, memory_order_release);
+    return true;
+}
+
+bool ShmRing::wait_until_empty(int64_t timeout_ms) const
+{
+    auto const deadline = chrono::steady_clock::now() + chrono::milliseconds(timeout_ms);
+    int poll_count = 0;
+    uint64_t const head = header_->head.load(memory_order_relaxed);
+    while (header_->tail.load(memory_order_acquire) != head && !header_->closed.load(memory_order_acquire))
+    {
+        if (timeout_ms != -1 && chrono::steady_clock::now() >= deadline)
+        {
+            return false;
+        }
+        sleep_until_next_poll(poll_count);
+    }
+    return true;
+}
+
+bool ShmRing::read(function<void(kj::ArrayPtr<capnp::word const>)> const& func)
+{
+    uint64_t const capacity = capacity_;
+    uint64_t tail = header_->tail.load(memory_order_relaxed);
+    uint64_t head = header_->head.load(memory_order_acquire);
+    if (tail == head)
+    {
+        return false;
+    }
+    if (head - tail > capacity || tail % word_size != 0)
+    {
+        close();
+        throw MiddlewareException("ShmRing::read(): invalid write position in " + name_);
+    }
+
+    auto frame = reinterpret_cast<FrameHeader const*>(data_ + tail % capacity);
+    if (frame->wrap)
+    {
+        tail += capacity - tail % capacity;
+        header_->tail.store(tail, memory_order_release);
+        if (tail >= head)
+        {
+            // The producer writes the wrap marker and the next frame in one go.
+            close();
+            throw MiddlewareException("ShmRing::read(): invalid wrap marker in " + name_);
+        }
+        frame = reinterpret_cast<FrameHeader const*>(data_);
+    }
+    // The producer can still write to the frame header, so we copy the size once
+    // and use only the checked copy.
+    uint32_t const payload_size = frame->size;
+    size_t const frame_size = sizeof(FrameHeader) + payload_size;
+    if (payload_size > max_message_size() || payload_size % word_size != 0 || tail + frame_size > head)
+    {
+        // Corrupt frame. Close the ring so the producer gives up.
+        close();
+        throw MiddlewareException("ShmRing::read(): invalid frame in " + name_);
+    }
+
+    auto payload = reinterpret_cast<capnp::word const*>(reinterpret_cast<char const*>(frame) + sizeof(FrameHeader));
+    try
+    {
+        func(kj::ArrayPtr<capnp::word const>(payload, payload_size / word_size));
+    }
+    catch (...)
+    {
+        header_->tail.store(tail + frame_size, memory_order_release);
+        throw;
+    }
+    header_->tail.store(tail + frame_size, memory_order_release);
+    return true;
+}
+
+void ShmRing::close() noexcept
+{
+    header_->closed.store(1, memory_order_release);
+}
+
+bool ShmRing::closed() const noexcept
+{
+    return header_->closed.load(memory_order_acquire) != 0;
+}
+
+string ShmRing::ring_name(string const& endpoint, string const& identity)
+{
+    // Rings share the name prefix of the doorbell for the same reply adapter.
+    return ShmDoorbell::doorbell_name(endpoint) + "-" + identity;
+}
+
+} // namespace zmq_middleware
+
+} // namespace internal
+
+} // namespace scopes
+
+} // namespace unity
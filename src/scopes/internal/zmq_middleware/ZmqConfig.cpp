@@ -20,6 +20,7 @@
 
 #include <unity/scopes/internal/DfltConfig.h>
 #include <unity/scopes/ScopeExceptions.h>
+#include <unity/UnityExceptions.h>
 
 #include <stdlib.h>
 #include <unistd.h>
@@ -45,6 +46,8 @@ namespace
     const string child_scopes_timeout_key = "ChildScopes.Timeout";
     const string registry_endpoint_dir_key = "Registry.EndpointDir";
     const string ss_registry_endpoint_dir_key = "Smartscopes.Registry.EndpointDir";
+    const string shm_replies_key = "SharedMemory.Replies";
+    const string metrics_endpoint_key = "Metrics.Endpoint";
 }
 
 ZmqConfig::ZmqConfig(string const& configfile) :
@@ -100,6 +103,24 @@ ZmqConfig::ZmqConfig(string const& configfile) :
     registry_endpoint_dir_ = get_optional_string(zmq_config_group, registry_endpoint_dir_key);
     ss_registry_endpoint_dir_ = get_optional_string(zmq_config_group, ss_registry_endpoint_dir_key);
 
+    try
+    {
+        shm_replies_ = parser()->get_boolean(zmq_config_group, shm_replies_key);
+    }
+    catch (LogicException const&)
+    {
+        shm_replies_ = false;
+    }
+
+    try
+    {
+        metrics_endpoint_ = parser()->get_boolean(zmq_config_group, metrics_endpoint_key);
+    }
+    catch (LogicException const&)
+    {
+        metrics_endpoint_ = false;
+    }
+
     KnownEntries const known_entries = {
                                           {  zmq_config_group,
                                              {
@@ -109,7 +130,9 @@ ZmqConfig::ZmqConfig(string const& configfile) :
                                                 registry_timeout_key,
                                                 child_scopes_timeout_key,
                                                 registry_endpoint_dir_key,
-                                                ss_registry_endpoint_dir_key
+                                                ss_registry_endpoint_dir_key,
+                                                shm_replies_key,
+                                                metrics_endpoint_key
                                              }
                                           }
                                        };
@@ -155,6 +178,16 @@ string ZmqConfig::ss_registry_endpoint_dir() const
     return ss_registry_endpoint_dir_;
 }
 
+bool ZmqConfig::shm_replies() const
+{
+    return shm_replies_;
+}
+
+bool ZmqConfig::metrics_endpoint() const
+{
+    return metrics_endpoint_;
+}
+
 } // namespace internal
 
 } // namespace scopes
@@ -23,12 +23,15 @@
 #include <unity/scopes/internal/RegistryImpl.h>
 #include <unity/scopes/internal/ScopeImpl.h>
 #include <unity/scopes/internal/zmq_middleware/ConnectionPool.h>
+#include <unity/scopes/internal/zmq_middleware/LocalObjects.h>
+#include <unity/scopes/internal/zmq_middleware/MetricsEndpoint.h>
 #include <unity/scopes/internal/zmq_middleware/ObjectAdapter.h>
 #include <unity/scopes/internal/zmq_middleware/QueryI.h>
 #include <unity/scopes/internal/zmq_middleware/QueryCtrlI.h>
 #include <unity/scopes/internal/zmq_middleware/RegistryI.h>
 #include <unity/scopes/internal/zmq_middleware/ReplyI.h>
 #include <unity/scopes/internal/zmq_middleware/ScopeI.h>
+#include <unity/scopes/internal/zmq_middleware/ShmReplyDispatcher.h>
 #include <unity/scopes/internal/zmq_middleware/StateReceiverI.h>
 #include <unity/scopes/internal/zmq_middleware/ZmqConfig.h>
 #include <unity/scopes/internal/zmq_middleware/ZmqPublisher.h>
@@ -43,6 +46,8 @@
 #include <unity/scopes/ScopeExceptions.h>
 #include <unity/UnityExceptions.h>
 
+#include <cstring>
+
 #include <sys/stat.h>
 
 using namespace std;
@@ -68,6 +73,7 @@ char const* reply_suffix = "-r";     // Appended to server_name_ to create reply
 char const* state_suffix = "-s";     // Appended to server_name_ to create state adapter name
 char const* registry_suffix = "-R";  // Appended to server_name_ to create registry (or SS registry) adapter name
 char const* publisher_suffix = "-p"; // Appended to publisher_id to create a publisher endpoint
+char const* metrics_suffix = "-m";   // Appended to server_name_ to create metrics endpoint name
 
 char const* query_category = "Query";       // query adapter category name
 char const* ctrl_category = "QueryCtrl";    // control adapter category name
@@ -76,6 +82,39 @@ char const* state_category = "State";       // state adapter category name
 char const* scope_category = "Scope";       // scope adapter category name
 char const* registry_category = "Registry"; // registry adapter category name
 
+// Twoway operations whose metrics are cached by the middleware.
+// Metrics for any other operation are looked up by name on each call.
+char const* const twoway_op_names[] =
+{
+    "activate",
+    "activate_result_action",
+    "child_scopes",
+    "debug_mode",
+    "get_metadata",
+    "is_scope_running",
+    "list",
+    "locate",
+    "perform_action",
+    "ping",
+    "preview",
+    "search",
+    "set_child_scopes"
+};
+
+constexpr int num_twoway_ops = sizeof(twoway_op_names) / sizeof(twoway_op_names[0]);
+
+int twoway_op_index(char const* op_name) noexcept
+{
+    for (int i = 0; i < num_twoway_ops; ++i)
+    {
+        if (strcmp(op_name, twoway_op_names[i]) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
 // Create a directory with the given mode if it doesn't exist yet.
 
 void create_dir(string const& dir, mode_t mode)
@@ -95,7 +134,11 @@ ZmqMiddleware::ZmqMiddleware(string const& server_name, RuntimeImpl* runtime, st
     shutdown_flag_(false),
     // Some tests use a nullptr for the run time, so we use a different logger in that case.
     test_logger_(runtime ? nullptr : new Logger("ZmqMiddleware_test_logger")),
-    logger_(runtime ? runtime->logger() : *test_logger_)
+    logger_(runtime ? runtime->logger() : *test_logger_),
+    test_metrics_(runtime ? nullptr : new MetricsRegistry),
+    metrics_(runtime ? runtime->metrics() : *test_metrics_),
+    op_metrics_(new OpMetrics[num_twoway_ops]()),
+    oneway_send_failures_(metrics_.counter("oneway.send_failures"))
 {
     assert(!server_name.empty());
 
@@ -107,6 +150,8 @@ ZmqMiddleware::ZmqMiddleware(string const& server_name, RuntimeImpl* runtime, st
         locate_timeout_ = config.locate_timeout();
         registry_timeout_ = config.registry_timeout();
         child_scopes_timeout_ = config.child_scopes_timeout();
+        shm_replies_ = config.shm_replies();
+        serve_metrics_ = runtime && config.metrics_endpoint();  // Not for tests without a run time
         public_endpoint_dir_ = config.endpoint_dir();
         private_endpoint_dir_ = public_endpoint_dir_ + "/priv";
         registry_endpoint_dir_ = public_endpoint_dir_;
@@ -138,6 +183,8 @@ ZmqMiddleware::ZmqMiddleware(string const& server_name, RuntimeImpl* runtime, st
         create_dir(private_endpoint_dir_, 0700 | S_ISVTX);
         create_dir(registry_endpoint_dir_, 0755 | S_ISVTX);
         create_dir(ss_registry_endpoint_dir_, 0755 | S_ISVTX);
+
+        metrics_.gauge_fn("zmq.connection_pool.connections", &ConnectionPool::total_connections);
     }
     catch (...)
     {
@@ -205,7 +252,8 @@ void ZmqMiddleware::start()
                 lock_guard<mutex> lock(data_mutex_);
                 try
                 {
-                    oneway_invoker_.reset(new ThreadPool(1));  // Oneway pool must have a single thread
+                    // Oneway pool must have a single thread
+                    oneway_invoker_.reset(new ThreadPool(1, &metrics_.gauge("zmq.oneway_pool.backlog")));
                     // N.B. We absolutely MUST have AT LEAST 5 two-way invoke threads:
                     // * 3 threads are required to execute a standard scope invocation as both
                     //   rebinding and debug_mode requests could be invoked within a single two-way
@@ -216,7 +264,12 @@ void ZmqMiddleware::start()
                     // * 5 threads therefore, at least allows for an aggregating scope to invoke nested
                     //   aggregators.
                     // (NOTE: To be safe, we should keep some headroom above this 5 thread minimum)
-                    twoway_invokers_.reset(new ThreadPool(8));  // TODO: get pool size from config
+                    // TODO: get pool size from config
+                    twoway_invokers_.reset(new ThreadPool(8, &metrics_.gauge("zmq.twoway_pool.backlog")));
+                    // Invocations on reply and query objects in this process. Single thread each,
+                    // like the reply and query adapters, so invocations are processed in order.
+                    local_reply_invoker_.reset(new ThreadPool(1, &metrics_.gauge("zmq.local_reply_pool.backlog")));
+                    local_query_invoker_.reset(new ThreadPool(1, &metrics_.gauge("zmq.local_query_pool.backlog")));
                 }
                 catch (std::exception const& e)
                 {
@@ -226,6 +279,19 @@ void ZmqMiddleware::start()
                 {
                     throw MiddlewareException("Cannot create outgoing invocation pools: unknown exception");
                 }
+                if (serve_metrics_)
+                {
+                    // Not being able to serve metrics doesn't stop us from working.
+                    try
+                    {
+                        string endpoint = "ipc://" + public_endpoint_dir_ + "/" + server_name_ + metrics_suffix;
+                        metrics_endpoint_.reset(new MetricsEndpoint(&context_, endpoint, metrics_));
+                    }
+                    catch (std::exception const& e)
+                    {
+                        logger_(LoggerSeverity::Warning) << "ZmqMiddleware::start(): " << e.what();
+                    }
+                }
             }
             shutdown_flag_ = false;
             state_ = Started;
@@ -260,13 +326,22 @@ void ZmqMiddleware::stop()
             {
                 twoway_invokers_->destroy();            // Destroy immediately, because invocations can take time.
                 oneway_invoker_->destroy_once_empty();  // Wait for queued oneways to go out first.
+                // The local pools run application code, which may call back into the middleware,
+                // so they are destroyed by wait_for_shutdown(), without holding our locks.
             }
 
+            // Proxies in this process must no longer bypass our adapters.
+            LocalObjects::instance().remove_all(this);
+
             // Initiate shutdown of all adapters
             for (auto& pair : am_)
             {
                 pair.second->shutdown();
             }
+            if (shm_reply_dispatcher_)
+            {
+                shm_reply_dispatcher_->shutdown();
+            }
 
             state_ = Stopping;
             state_changed_.notify_all();
@@ -305,14 +380,27 @@ void ZmqMiddleware::wait_for_shutdown()
 
     // Exactly one thread gets to this point.
     AdapterMap adapter_map;
+    shared_ptr<ShmReplyDispatcher> shm_reply_dispatcher;
+    unique_ptr<ThreadPool> local_reply_invoker;
+    unique_ptr<ThreadPool> local_query_invoker;
+    unique_ptr<MetricsEndpoint> metrics_endpoint;
     {
         lock_guard<mutex> data_lock(data_mutex_);
         adapter_map = move(am_);
+        shm_reply_dispatcher = move(shm_reply_dispatcher_);
+        local_reply_invoker = move(local_reply_invoker_);
+        local_query_invoker = move(local_query_invoker_);
+        metrics_endpoint = move(metrics_endpoint_);
     }
     for (auto&& pair : adapter_map)
     {
         pair.second->wait_for_shutdown();
     }
+    // Like the adapters, we discard invocations that are still queued and wait for the ones in progress.
+    local_reply_invoker = nullptr;
+    local_query_invoker = nullptr;
+    shm_reply_dispatcher = nullptr;  // Joins with the dispatch thread (unless a disconnect function still holds it).
+    metrics_endpoint = nullptr;
 
     unique_lock<mutex> state_lock(state_mutex_);
     state_ = Stopped;
@@ -598,6 +686,7 @@ MWQueryProxy ZmqMiddleware::add_query_object(QueryObjectBase::SPtr const& query)
         auto adapter = find_adapter(server_name_ + query_suffix, private_endpoint_dir_, query_category);
         function<void()> df;
         auto p = safe_add(df, adapter, "", qi);
+        add_local(df, adapter, p, query);
         query->set_disconnect_function(df);
         proxy = ZmqQueryProxy(new ZmqQuery(this, p->endpoint(), p->identity(), query_category));
         adapter->activate();
@@ -665,6 +754,11 @@ MWReplyProxy ZmqMiddleware::add_reply_object(ReplyObjectBase::SPtr const& reply)
         auto adapter = find_adapter(server_name_ + reply_suffix, public_endpoint_dir_, reply_category);
         function<void()> df;
         auto p = safe_add(df, adapter, "", ri);
+        add_local(df, adapter, p, reply);
+        if (shm_replies_)
+        {
+            add_shm_reply(df, p->endpoint(), p->identity(), ri);
+        }
         reply->set_disconnect_function(df);
         proxy = ZmqReplyProxy(new ZmqReply(this, p->endpoint(), p->identity(), reply_category));
         adapter->activate();
@@ -689,6 +783,7 @@ MWScopeProxy ZmqMiddleware::add_scope_object(string const& identity, ScopeObject
         auto adapter = find_adapter(server_name_, private_endpoint_dir_, scope_category, idle_timeout);
         function<void()> df;
         auto p = safe_add(df, adapter, identity, si);
+        add_local(df, adapter, p, scope);
         scope->set_disconnect_function(df);
         proxy = ZmqScopeProxy(new ZmqScope(this, p->endpoint(), p->identity(), scope_category, twoway_timeout_));
         adapter->activate();
@@ -780,6 +875,51 @@ zmqpp::context* ZmqMiddleware::context() const noexcept
     return const_cast<zmqpp::context*>(&context_);
 }
 
+MetricsRegistry& ZmqMiddleware::metrics() const noexcept
+{
+    return metrics_;
+}
+
+// The metrics are created on first use, so operations that are never invoked don't clutter the output.
+// If two threads race to look up the same metric, both get the same reference from the registry.
+
+MetricsRegistry::Histogram& ZmqMiddleware::twoway_latency(char const* op_name)
+{
+    int i = twoway_op_index(op_name);
+    if (i == -1)
+    {
+        return metrics_.histogram(string("twoway.") + op_name + ".latency_us");
+    }
+    auto h = op_metrics_[i].latency.load(memory_order_acquire);
+    if (!h)
+    {
+        h = &metrics_.histogram(string("twoway.") + op_name + ".latency_us");
+        op_metrics_[i].latency.store(h, memory_order_release);
+    }
+    return *h;
+}
+
+MetricsRegistry::Counter& ZmqMiddleware::twoway_timeouts(char const* op_name)
+{
+    int i = twoway_op_index(op_name);
+    if (i == -1)
+    {
+        return metrics_.counter(string("twoway.") + op_name + ".timeouts");
+    }
+    auto c = op_metrics_[i].timeouts.load(memory_order_acquire);
+    if (!c)
+    {
+        c = &metrics_.counter(string("twoway.") + op_name + ".timeouts");
+        op_metrics_[i].timeouts.store(c, memory_order_release);
+    }
+    return *c;
+}
+
+MetricsRegistry::Counter& ZmqMiddleware::oneway_send_failures() const noexcept
+{
+    return oneway_send_failures_;
+}
+
 ThreadPool* ZmqMiddleware::oneway_pool()
 {
     lock(state_mutex_, data_mutex_);
@@ -804,6 +944,30 @@ ThreadPool* ZmqMiddleware::twoway_pool()
     return twoway_invokers_.get();
 }
 
+ThreadPool* ZmqMiddleware::local_reply_pool()
+{
+    lock(state_mutex_, data_mutex_);
+    lock_guard<mutex> state_lock(state_mutex_, std::adopt_lock);
+    lock_guard<mutex> invokers_lock(data_mutex_, std::adopt_lock);
+    if (state_ != Started)
+    {
+        throw MiddlewareException("Cannot invoke operations while middleware is stopped");
+    }
+    return local_reply_invoker_.get();
+}
+
+ThreadPool* ZmqMiddleware::local_query_pool()
+{
+    lock(state_mutex_, data_mutex_);
+    lock_guard<mutex> state_lock(state_mutex_, std::adopt_lock);
+    lock_guard<mutex> invokers_lock(data_mutex_, std::adopt_lock);
+    if (state_ != Started)
+    {
+        throw MiddlewareException("Cannot invoke operations while middleware is stopped");
+    }
+    return local_query_invoker_.get();
+}
+
 int64_t ZmqMiddleware::locate_timeout() const noexcept
 {
     return locate_timeout_;
@@ -819,6 +983,11 @@ int64_t ZmqMiddleware::child_scopes_timeout() const noexcept
     return child_scopes_timeout_;
 }
 
+bool ZmqMiddleware::shm_replies() const noexcept
+{
+    return shm_replies_;
+}
+
 ObjectProxy ZmqMiddleware::make_typed_proxy(string const& endpoint,
                                             string const& identity,
                                             string const& category,
@@ -957,6 +1126,73 @@ ZmqProxy ZmqMiddleware::safe_add(function<void()>& disconnect_func,
     return adapter->add(id, servant);
 }
 
+// Makes the object reachable by proxies in this process without going through zmq.
+
+void ZmqMiddleware::add_local(function<void()>& disconnect_func,
+                              shared_ptr<ObjectAdapter> const& adapter,
+                              ZmqProxy const& proxy,
+                              shared_ptr<AbstractObject> const& object)
+{
+    auto endpoint = proxy->endpoint();
+    auto identity = proxy->identity();
+    LocalObjects::instance().add(endpoint, identity, this, adapter, object);
+
+    auto adapter_disconnect = disconnect_func;
+    disconnect_func = [endpoint, identity, adapter_disconnect]
+    {
+        LocalObjects::instance().remove(endpoint, identity);
+        adapter_disconnect();
+    };
+}
+
+// Makes the reply servant reachable via shared memory in addition to the reply adapter.
+// Failure is not fatal: the scope then simply cannot open the ring and uses zmq.
+
+void ZmqMiddleware::add_shm_reply(function<void()>& disconnect_func,
+                                  string const& endpoint,
+                                  string const& identity,
+                                  shared_ptr<ServantBase> const& servant)
+{
+    shared_ptr<ShmReplyDispatcher> dispatcher;
+    try
+    {
+        lock_guard<mutex> lock(data_mutex_);
+        if (!shm_reply_dispatcher_)
+        {
+            shm_reply_dispatcher_ = make_shared<ShmReplyDispatcher>(endpoint, logger_);
+        }
+        dispatcher = shm_reply_dispatcher_;
+    }
+    catch (std::exception const& e)
+    {
+        logger_() << "cannot create shared memory reply dispatcher, using zmq only: " << e.what();
+        shm_replies_ = false;
+        return;
+    }
+
+    try
+    {
+        dispatcher->add(identity, servant);
+    }
+    catch (std::exception const& e)
+    {
+        logger_() << "cannot create shared memory reply ring, using zmq: " << e.what();
+        return;
+    }
+
+    weak_ptr<ShmReplyDispatcher> weak_dispatcher(dispatcher);
+    auto adapter_disconnect = disconnect_func;
+    disconnect_func = [weak_dispatcher, identity, adapter_disconnect]
+    {
+        auto d = weak_dispatcher.lock();
+        if (d)
+        {
+            d->remove(identity);
+        }
+        adapter_disconnect();
+    };
+}
+
 function<void()> ZmqMiddleware::safe_dflt_add(shared_ptr<ObjectAdapter> const& adapter,
                                               string const& category,
                                               shared_ptr<ServantBase> const& servant)
@@ -18,6 +18,7 @@
 
 #include <unity/scopes/internal/zmq_middleware/ZmqObjectProxy.h>
 
+#include <unity/scopes/internal/lttng/UnityScopes_tp.h>
 #include <unity/scopes/internal/RuntimeImpl.h>
 #include <unity/scopes/internal/zmq_middleware/Util.h>
 #include <unity/scopes/internal/zmq_middleware/ZmqException.h>
@@ -182,6 +183,7 @@ void ZmqObjectProxy::invoke_oneway_(capnp::MessageBuilder& request)
     {
         // If there is nothing at the other end, discard the message and trash the socket.
         pool.remove(endpoint_);
+        mw_base()->oneway_send_failures().inc();
         return;
     }
 }
@@ -254,6 +256,8 @@ ZmqObjectProxy::TwowayOutParams ZmqObjectProxy::invoke_twoway__(capnp::MessageBu
         endpoint = endpoint_;
         assert(mode_ == RequestMode::Twoway);
     }
+    char const* op_name = request.getRoot<capnproto::Request>().getOpName().cStr();
+    auto start_time = chrono::steady_clock::now();
 
     zmqpp::socket s(*mw_base()->context(), zmqpp::socket_type::request);
     // Allow some linger time so we don't hang indefinitely if the other end disappears.
@@ -286,7 +290,7 @@ ZmqObjectProxy::TwowayOutParams ZmqObjectProxy::invoke_twoway__(capnp::MessageBu
 
     if (!p.has_input(s))
     {
-        string op_name = request.getRoot<capnproto::Request>().getOpName().cStr();
+        mw_base()->twoway_timeouts(op_name).inc();
         throw TimeoutException("Request timed out after " + std::to_string(timeout) + " milliseconds (endpoint = " +
                                endpoint + ", op = " + op_name + ")");
     }
@@ -298,6 +302,7 @@ ZmqObjectProxy::TwowayOutParams ZmqObjectProxy::invoke_twoway__(capnp::MessageBu
     auto params = out_params.receiver->receive();
     out_params.reader.reset(new capnp::SegmentArrayMessageReader(params));
     trace_reply_(request, *out_params.reader);
+    mw_base()->twoway_latency(op_name).record(chrono::steady_clock::now() - start_time);
     return out_params;
     // Outgoing twoway socket closed here.
 }
@@ -319,7 +324,11 @@ string ZmqObjectProxy::decode_request_(capnp::MessageBuilder& request)
 
 void ZmqObjectProxy::trace_request_(capnp::MessageBuilder& request)
 {
-    mw_base()->runtime()->logger()(LoggerChannel::IPC)
+    simple_tracepoint(unity_scopes, request_sent,
+                      request.getRoot<capnproto::Request>().getId().cStr(),
+                      request.getRoot<capnproto::Request>().getOpName().cStr(),
+                      request.getRoot<capnproto::Request>().getMode() == capnproto::RequestMode::ONEWAY);
+    UNITY_SCOPES_LOG(mw_base()->runtime()->logger(), LoggerChannel::IPC)
         << "sending request: "
         << decode_request_(request);
 }
@@ -332,7 +341,7 @@ string ZmqObjectProxy::decode_reply_(capnp::MessageBuilder& request, capnp::Mess
 
 void ZmqObjectProxy::trace_reply_(capnp::MessageBuilder& request, capnp::MessageReader& reply)
 {
-    mw_base()->runtime()->logger()(LoggerChannel::IPC)
+    UNITY_SCOPES_LOG(mw_base()->runtime()->logger(), LoggerChannel::IPC)
         << "received reply: "
         << decode_reply_(request, reply);
 }
@@ -19,8 +19,15 @@
 #include <unity/scopes/internal/zmq_middleware/ZmqQuery.h>
 
 #include <scopes/internal/zmq_middleware/capnproto/Query.capnp.h>
+#include <unity/scopes/internal/InvokeInfo.h>
+#include <unity/scopes/internal/QueryObjectBase.h>
+#include <unity/scopes/internal/zmq_middleware/LocalObjects.h>
+#include <unity/scopes/internal/zmq_middleware/ObjectAdapter.h>
+#include <unity/scopes/internal/zmq_middleware/ZmqMiddleware.h>
 #include <unity/scopes/internal/zmq_middleware/ZmqReply.h>
 
+#include <cassert>
+
 using namespace std;
 
 namespace unity
@@ -57,6 +64,23 @@ ZmqQuery::~ZmqQuery()
 
 void ZmqQuery::run(MWReplyProxy const& reply)
 {
+    // The query object normally lives in the same process (ScopeObject creates it and then
+    // calls run() on it), so we usually don't need to marshal the request.
+    auto target = LocalObjects::instance().find(endpoint(), identity());
+    if (target)
+    {
+        auto qo = dynamic_pointer_cast<QueryObjectBase>(target.object);
+        assert(qo);
+        target.adapter->note_activity();
+        auto mw = target.mw;
+        auto id = identity();
+        // The local query pool has a single thread, like the query adapter, so run() calls are dispatched
+        // in order, and a synchronous run() delays later ones exactly as before. The task holds the query
+        // object until run() has been dispatched. If cancel() arrives first, run() does nothing.
+        mw->local_query_pool()->submit([qo, reply, mw, id] { qo->run(reply, InvokeInfo{ id, mw }); });
+        return;
+    }
+
     capnp::MallocMessageBuilder request_builder;
     auto request = make_request_(request_builder, "run");
     auto in_params = request.initInParams().getAs<capnproto::Query::RunRequest>();
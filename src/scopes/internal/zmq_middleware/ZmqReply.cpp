@@ -18,8 +18,11 @@
 
 #include <unity/scopes/internal/zmq_middleware/ZmqReply.h>
 #include <unity/scopes/internal/zmq_middleware/VariantConverter.h>
+#include <unity/scopes/internal/zmq_middleware/ZmqMiddleware.h>
 #include <scopes/internal/zmq_middleware/capnproto/Reply.capnp.h>
 
+#include <capnp/serialize.h>
+
 using namespace std;
 
 namespace unity
@@ -34,6 +37,19 @@ namespace internal
 namespace zmq_middleware
 {
 
+namespace
+{
+
+// Writes to the ring do not wait: like the zmq path, which sends with ZmqSender::DontWait, we drop
+// a message if the client has not made room for it, so a slow client cannot stall the scope.
+//
+// The one exception is a message that is too large for the ring. Before it goes via zmq, we wait for up
+// to shm_drain_timeout_ms for the client to dispatch what is still in the ring, so the client sees the
+// messages in order. This happens at most once per reply object, because all later messages go via zmq.
+int64_t const shm_drain_timeout_ms = 2000;
+
+} // namespace
+
 /*
 
 interface Reply
@@ -47,7 +63,9 @@ interface Reply
 ZmqReply::ZmqReply(ZmqMiddleware* mw_base, string const& endpoint, string const& identity, string const& category) :
     MWObjectProxy(mw_base),
     ZmqObjectProxy(mw_base, endpoint, identity, category, RequestMode::Oneway),
-    MWReply(mw_base)
+    MWReply(mw_base),
+    shm_state_(Untried),
+    bytes_pushed_(0)
 {
 }
 
@@ -55,6 +73,68 @@ ZmqReply::~ZmqReply()
 {
 }
 
+// Delivers the request via the client's shared memory ring, if the client has one for this reply object.
+// Returns false if the request must be sent via zmq instead.
+
+bool ZmqReply::invoke_shm_(capnp::MessageBuilder& request)
+{
+    lock_guard<mutex> lock(shm_mutex_);
+
+    if (shm_state_ == Untried)
+    {
+        shm_state_ = Unavailable;
+        if (!mw_base()->shm_replies())
+        {
+            return false;
+        }
+        try
+        {
+            // Both segments exist only if the client is on this host, runs as the same user, and has
+            // shared memory replies enabled. In all other cases, opening fails and we use zmq.
+            shm_doorbell_ = ShmDoorbell::open(ShmDoorbell::doorbell_name(endpoint()));
+            shm_ring_ = ShmRing::open(ShmRing::ring_name(endpoint(), identity()));
+            shm_state_ = Active;
+        }
+        catch (std::exception const&)
+        {
+            shm_doorbell_ = nullptr;
+            shm_ring_ = nullptr;
+            return false;
+        }
+    }
+    if (shm_state_ != Active)
+    {
+        return false;
+    }
+
+    auto segments = request.getSegmentsForOutput();
+    if (capnp::computeSerializedSizeInWords(request) * sizeof(capnp::word) > shm_ring_->max_message_size())
+    {
+        // Message is too large for the ring. Let the client drain what we have sent so far and
+        // send this message, and all that follow, via zmq, so message order is preserved.
+        shm_ring_->wait_until_empty(shm_drain_timeout_ms);
+        shm_state_ = Unavailable;
+        shm_ring_ = nullptr;
+        shm_doorbell_ = nullptr;
+        return false;
+    }
+
+    trace_request_(request);
+    if (shm_ring_->write(segments, 0))
+    {
+        shm_doorbell_->ring();
+    }
+    else if (!shm_ring_->closed())
+    {
+        // The ring is full because the client isn't keeping up. Drop the message and count
+        // it, the same as the zmq path does when it cannot send without blocking.
+        mw_base()->oneway_send_failures().inc();
+    }
+    // If the ring was closed, the client is no longer interested in this query; the message is
+    // discarded, exactly as the reply adapter would discard it.
+    return true;
+}
+
 void ZmqReply::push(VariantMap const& result)
 {
     capnp::MallocMessageBuilder request_builder;
@@ -63,7 +143,12 @@ void ZmqReply::push(VariantMap const& result)
 
     auto resultBuilder = in_params.getResult();
     to_value_dict(result, resultBuilder);
+    bytes_pushed_ += capnp::computeSerializedSizeInWords(request_builder) * sizeof(capnp::word);
 
+    if (invoke_shm_(request_builder))
+    {
+        return;
+    }
     auto future = mw_base()->oneway_pool()->submit([&] { return this->invoke_oneway_(request_builder); });
     future.get();
 }
@@ -99,7 +184,15 @@ void ZmqReply::finished(CompletionDetails const& details)
     }
     in_params.setStatus(s);
     in_params.setMessage(details.message());
+    auto metrics = details.metrics();
+    metrics["scope_bytes_pushed"] = Variant(int64_t(bytes_pushed_));
+    auto metrics_builder = in_params.initMetrics();
+    to_value_dict(metrics, metrics_builder);
 
+    if (invoke_shm_(request_builder))
+    {
+        return;
+    }
     auto future = mw_base()->oneway_pool()->submit([&] { return this->invoke_oneway_(request_builder); });
     future.get();
 }
@@ -113,6 +206,10 @@ void ZmqReply::info(OperationInfo const& op_info)
     in_params.setCode(static_cast<int16_t>(op_info.code()));
     in_params.setMessage(op_info.message());
 
+    if (invoke_shm_(request_builder))
+    {
+        return;
+    }
     auto future = mw_base()->oneway_pool()->submit([&] { return this->invoke_oneway_(request_builder); });
     future.get();
 }
@@ -20,15 +20,23 @@
 
 #include <scopes/internal/zmq_middleware/capnproto/Scope.capnp.h>
 #include <unity/scopes/CannedQuery.h>
+#include <unity/scopes/internal/ActionMetadataImpl.h>
 #include <unity/scopes/internal/QueryCtrlImpl.h>
+#include <unity/scopes/internal/ResultImpl.h>
 #include <unity/scopes/internal/RuntimeImpl.h>
 #include <unity/scopes/internal/ScopeMetadataImpl.h>
+#include <unity/scopes/internal/ScopeObjectBase.h>
+#include <unity/scopes/internal/SearchMetadataImpl.h>
+#include <unity/scopes/internal/zmq_middleware/LocalObjects.h>
+#include <unity/scopes/internal/zmq_middleware/LocalReply.h>
+#include <unity/scopes/internal/zmq_middleware/ObjectAdapter.h>
 #include <unity/scopes/internal/zmq_middleware/VariantConverter.h>
 #include <unity/scopes/internal/zmq_middleware/ZmqException.h>
 #include <unity/scopes/internal/zmq_middleware/ZmqQueryCtrl.h>
 #include <unity/scopes/internal/zmq_middleware/ZmqReceiver.h>
 #include <unity/scopes/internal/zmq_middleware/ZmqReply.h>
 #include <unity/scopes/Result.h>
+#include <unity/scopes/ScopeExceptions.h>
 
 using namespace std;
 
@@ -84,6 +92,16 @@ QueryCtrlProxy ZmqScope::search(CannedQuery const& query,
                                 VariantMap const& context,
                                 MWReplyProxy const& reply)
 {
+    bool dispatched;
+    auto local_ctrl = invoke_local_("search", reply, [=](ScopeObjectBase& so, MWReplyProxy const& r, InvokeInfo const& info)
+    {
+        return so.search(query, SearchMetadataImpl::create(hints), context, r, info);
+    }, dispatched);
+    if (dispatched)
+    {
+        return local_ctrl;
+    }
+
     capnp::MallocMessageBuilder request_builder;
     auto reply_proxy = dynamic_pointer_cast<ZmqReply>(reply);
     {
@@ -117,6 +135,16 @@ QueryCtrlProxy ZmqScope::search(CannedQuery const& query,
 
 QueryCtrlProxy ZmqScope::activate(VariantMap const& result, VariantMap const& hints, MWReplyProxy const& reply)
 {
+    bool dispatched;
+    auto local_ctrl = invoke_local_("activate", reply, [=](ScopeObjectBase& so, MWReplyProxy const& r, InvokeInfo const& info)
+    {
+        return so.activate(ResultImpl::create_result(result), ActionMetadataImpl::create(hints), r, info);
+    }, dispatched);
+    if (dispatched)
+    {
+        return local_ctrl;
+    }
+
     capnp::MallocMessageBuilder request_builder;
     auto reply_proxy = dynamic_pointer_cast<ZmqReply>(reply);
     {
@@ -148,6 +176,17 @@ QueryCtrlProxy ZmqScope::activate(VariantMap const& result, VariantMap const& hi
 QueryCtrlProxy ZmqScope::perform_action(VariantMap const& result,
         VariantMap const& hints, std::string const& widget_id, std::string const& action_id, MWReplyProxy const& reply)
 {
+    bool dispatched;
+    auto local_ctrl = invoke_local_("perform_action", reply, [=](ScopeObjectBase& so, MWReplyProxy const& r, InvokeInfo const& info)
+    {
+        return so.perform_action(ResultImpl::create_result(result), ActionMetadataImpl::create(hints),
+                                 widget_id, action_id, r, info);
+    }, dispatched);
+    if (dispatched)
+    {
+        return local_ctrl;
+    }
+
     capnp::MallocMessageBuilder request_builder;
     auto reply_proxy = dynamic_pointer_cast<ZmqReply>(reply);
     {
@@ -183,6 +222,17 @@ QueryCtrlProxy ZmqScope::activate_result_action(VariantMap const& result,
         std::string const& action_id,
         MWReplyProxy const& reply)
 {
+    bool dispatched;
+    auto local_ctrl = invoke_local_("activate_result_action", reply, [=](ScopeObjectBase& so, MWReplyProxy const& r, InvokeInfo const& info)
+    {
+        return so.activate_result_action(ResultImpl::create_result(result), ActionMetadataImpl::create(hints),
+                                         action_id, r, info);
+    }, dispatched);
+    if (dispatched)
+    {
+        return local_ctrl;
+    }
+
     capnp::MallocMessageBuilder request_builder;
     auto reply_proxy = dynamic_pointer_cast<ZmqReply>(reply);
     {
@@ -214,6 +264,16 @@ QueryCtrlProxy ZmqScope::activate_result_action(VariantMap const& result,
 
 QueryCtrlProxy ZmqScope::preview(VariantMap const& result, VariantMap const& hints, MWReplyProxy const& reply)
 {
+    bool dispatched;
+    auto local_ctrl = invoke_local_("preview", reply, [=](ScopeObjectBase& so, MWReplyProxy const& r, InvokeInfo const& info)
+    {
+        return so.preview(ResultImpl::create_result(result), ActionMetadataImpl::create(hints), r, info);
+    }, dispatched);
+    if (dispatched)
+    {
+        return local_ctrl;
+    }
+
     capnp::MallocMessageBuilder request_builder;
     auto reply_proxy = dynamic_pointer_cast<ZmqReply>(reply);
     {
@@ -348,6 +408,88 @@ bool ZmqScope::debug_mode()
     return *debug_mode_;
 }
 
+// If the scope is hosted by a middleware in this process, creates the query by calling the scope object
+// directly, without marshaling, and sets dispatched to true. The scope object is passed a LocalReply, so
+// results also bypass zmq. Otherwise, sets dispatched to false and the caller sends the request via zmq.
+//
+// The call runs on the scope adapter's own threads, so the scope sees the same concurrency as for a request
+// that arrives via zmq, and the wait is subject to the same timeout as a remote call.
+
+QueryCtrlProxy ZmqScope::invoke_local_(string const& op_name,
+                                       MWReplyProxy const& reply,
+                                       LocalQueryFunc const& create_query,
+                                       bool& dispatched)
+{
+    dispatched = false;
+    auto target = LocalObjects::instance().find(endpoint(), identity());
+    if (!target)
+    {
+        return nullptr;
+    }
+    auto so = dynamic_pointer_cast<ScopeObjectBase>(target.object);
+    assert(so);
+    dispatched = true;
+
+    auto reply_proxy = dynamic_pointer_cast<ZmqReply>(reply);
+    // The scope gets a reply proxy that belongs to its own middleware, as if the request had arrived via zmq.
+    MWReplyProxy local_reply = make_shared<LocalReply>(target.mw,
+                                                       reply_proxy->endpoint(),
+                                                       reply_proxy->identity(),
+                                                       reply_proxy->target_category());
+
+    // The task may outlive this call if the wait times out, so it captures everything by value.
+    string const id = identity();
+    ZmqMiddleware* mw = target.mw;
+    std::future<MWQueryCtrlProxy> ctrl_future;
+    try
+    {
+        ctrl_future = target.adapter->invoke_local([so, local_reply, create_query, id, mw]() -> MWQueryCtrlProxy
+        {
+            try
+            {
+                return create_query(*so, local_reply, InvokeInfo{ id, mw });
+            }
+            catch (std::exception const& e)
+            {
+                // Report errors the same way as throw_if_runtime_exception() for a remote scope.
+                throw MiddlewareException(e.what());
+            }
+            catch (...)
+            {
+                throw MiddlewareException("unknown exception");
+            }
+        });
+    }
+    catch (std::runtime_error const& e)
+    {
+        throw MiddlewareException("ZmqScope::" + op_name + "(): cannot dispatch locally: " + e.what());
+    }
+
+    // A scope in debug mode may be stopped in a debugger, so we wait for it indefinitely.
+    int64_t const t = so->debug_mode() ? -1 : timeout();
+    if (t != -1 && ctrl_future.wait_for(chrono::milliseconds(t)) != future_status::ready)
+    {
+        throw TimeoutException("Request timed out after " + std::to_string(t) + " milliseconds (endpoint = " +
+                               endpoint() + ", op = " + op_name + ")");
+    }
+    MWQueryCtrlProxy result;
+    try
+    {
+        result = ctrl_future.get();
+    }
+    catch (future_error const&)
+    {
+        // The adapter was shut down before the task ran.
+        throw MiddlewareException("ZmqScope::" + op_name + "(): scope adapter was shut down (endpoint = " +
+                                  endpoint() + ")");
+    }
+    auto ctrl = dynamic_pointer_cast<ZmqObjectProxy>(result);
+    assert(ctrl);
+
+    ZmqQueryCtrlProxy p(new ZmqQueryCtrl(mw_base(), ctrl->endpoint(), ctrl->identity(), ctrl->target_category()));
+    return make_shared<QueryCtrlImpl>(p, reply_proxy);
+}
+
 ZmqObjectProxy::TwowayOutParams ZmqScope::invoke_scope_(capnp::MessageBuilder& in_params)
 {
     return invoke_scope_(in_params, timeout());
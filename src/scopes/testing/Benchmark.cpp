@@ -18,6 +18,9 @@
 
 #include <unity/scopes/testing/Benchmark.h>
 
+#include <unity/scopes/Variant.h>
+#include <unity/Exception.h>
+
 #include <boost/serialization/serialization.hpp>
 #include <boost/serialization/split_free.hpp>
 #include <boost/serialization/vector.hpp>
@@ -28,7 +31,11 @@
 #include <boost/archive/xml_iarchive.hpp>
 #include <boost/archive/xml_oarchive.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <iterator>
+#include <stdexcept>
 
 namespace
 {
@@ -146,6 +153,165 @@ void unity::scopes::testing::Benchmark::Result::save_to(std::ostream& out)
     }
 }
 
+namespace
+{
+typedef unity::scopes::testing::Benchmark::Result Result;
+typedef unity::scopes::testing::Benchmark::Result::Timing Timing;
+
+unity::scopes::Variant timing_to_variant(const Timing& timing)
+{
+    unity::scopes::VariantMap m;
+    m["min"] = unity::scopes::Variant{timing.min.count()};
+    m["max"] = unity::scopes::Variant{timing.max.count()};
+    m["mean"] = unity::scopes::Variant{timing.mean.count()};
+    m["std_dev"] = unity::scopes::Variant{timing.std_dev.count()};
+    m["kurtosis"] = unity::scopes::Variant{timing.kurtosis.count()};
+    m["skewness"] = unity::scopes::Variant{timing.skewness.count()};
+
+    // The percentiles are for the benefit of readers of the file; they are not loaded
+    // because they can be computed from the sample.
+    if (!timing.sample.empty())
+    {
+        m["p50"] = unity::scopes::Variant{timing.percentile(50).count()};
+        m["p90"] = unity::scopes::Variant{timing.percentile(90).count()};
+        m["p99"] = unity::scopes::Variant{timing.percentile(99).count()};
+        m["p999"] = unity::scopes::Variant{timing.percentile(99.9).count()};
+    }
+
+    unity::scopes::VariantArray sample;
+    for (const auto& observation : timing.sample)
+        sample.push_back(unity::scopes::Variant{observation.count()});
+    m["sample"] = unity::scopes::Variant{sample};
+
+    unity::scopes::VariantArray histogram;
+    for (const auto& bin : timing.histogram)
+        histogram.push_back(unity::scopes::Variant{unity::scopes::VariantArray
+        {
+            unity::scopes::Variant{bin.first.count()},
+            unity::scopes::Variant{bin.second}
+        }});
+    m["histogram"] = unity::scopes::Variant{histogram};
+
+    return unity::scopes::Variant{m};
+}
+
+// JSON does not distinguish between integral and floating-point numbers.
+double to_double(const unity::scopes::Variant& v)
+{
+    switch (v.which())
+    {
+    case unity::scopes::Variant::Int:
+        return v.get_int();
+    case unity::scopes::Variant::Int64:
+        return v.get_int64_t();
+    default:
+        return v.get_double();
+    }
+}
+
+Timing::Seconds to_seconds(const unity::scopes::Variant& v)
+{
+    return Timing::Seconds{to_double(v)};
+}
+
+void timing_from_variant(const unity::scopes::Variant& v, Timing& timing)
+{
+    auto const m = v.get_dict();
+    timing.min = to_seconds(m.at("min"));
+    timing.max = to_seconds(m.at("max"));
+    timing.mean = to_seconds(m.at("mean"));
+    timing.std_dev = to_seconds(m.at("std_dev"));
+    timing.kurtosis = to_seconds(m.at("kurtosis"));
+    timing.skewness = to_seconds(m.at("skewness"));
+
+    timing.sample.clear();
+    for (const auto& observation : m.at("sample").get_array())
+        timing.sample.push_back(to_seconds(observation));
+
+    timing.histogram.clear();
+    for (const auto& bin : m.at("histogram").get_array())
+    {
+        auto const pair = bin.get_array();
+        timing.histogram.push_back(std::make_pair(to_seconds(pair.at(0)), to_double(pair.at(1))));
+    }
+}
+
+unity::scopes::Variant result_to_variant(const Result& result)
+{
+    unity::scopes::VariantMap m;
+    m["sample_size"] = unity::scopes::Variant{static_cast<int64_t>(result.sample_size)};
+    m["timing"] = timing_to_variant(result.timing);
+    return unity::scopes::Variant{m};
+}
+
+void result_from_variant(const unity::scopes::Variant& v, Result& result)
+{
+    auto const m = v.get_dict();
+    result.sample_size = static_cast<std::size_t>(to_double(m.at("sample_size")));
+    timing_from_variant(m.at("timing"), result.timing);
+}
+
+unity::scopes::Variant read_json(std::istream& in)
+{
+    std::string json{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+    return unity::scopes::Variant::deserialize_json(json);
+}
+}
+
+void unity::scopes::testing::Benchmark::Result::load_from_json(std::istream& in)
+{
+    try
+    {
+        result_from_variant(read_json(in), *this);
+    } catch(const unity::Exception& e)
+    {
+        throw std::runtime_error(std::string{"Benchmark::Result::load_from_json: "} + e.what());
+    } catch(const std::out_of_range& e)
+    {
+        throw std::runtime_error(std::string{"Benchmark::Result::load_from_json: missing entry: "} + e.what());
+    }
+}
+
+void unity::scopes::testing::Benchmark::Result::save_to_json(std::ostream& out)
+{
+    out << result_to_variant(*this).serialize_json();
+    if (!out)
+        throw std::runtime_error("Benchmark::Result::save_to_json: cannot write result");
+}
+
+void unity::scopes::testing::Benchmark::LoadResult::load_from_json(std::istream& in)
+{
+    try
+    {
+        auto const m = read_json(in).get_dict();
+        result_from_variant(m.at("finished"), finished);
+        result_from_variant(m.at("first_result"), first_result);
+        queries_per_second = to_double(m.at("queries_per_second"));
+        results_per_second = to_double(m.at("results_per_second"));
+        timeouts = static_cast<std::size_t>(to_double(m.at("timeouts")));
+    } catch(const unity::Exception& e)
+    {
+        throw std::runtime_error(std::string{"Benchmark::LoadResult::load_from_json: "} + e.what());
+    } catch(const std::out_of_range& e)
+    {
+        throw std::runtime_error(std::string{"Benchmark::LoadResult::load_from_json: missing entry: "} + e.what());
+    }
+}
+
+void unity::scopes::testing::Benchmark::LoadResult::save_to_json(std::ostream& out)
+{
+    unity::scopes::VariantMap m;
+    m["finished"] = result_to_variant(finished);
+    m["first_result"] = result_to_variant(first_result);
+    m["queries_per_second"] = unity::scopes::Variant{queries_per_second};
+    m["results_per_second"] = unity::scopes::Variant{results_per_second};
+    m["timeouts"] = unity::scopes::Variant{static_cast<int64_t>(timeouts)};
+
+    out << unity::scopes::Variant{m}.serialize_json();
+    if (!out)
+        throw std::runtime_error("Benchmark::LoadResult::save_to_json: cannot write result");
+}
+
 unity::scopes::testing::Sample::SizeType unity::scopes::testing::Benchmark::Result::Timing::get_size() const
 {
    return sample.size();
@@ -167,6 +333,19 @@ void unity::scopes::testing::Benchmark::Result::Timing::enumerate(const unity::s
        enumerator(observation.count());
 }
 
+unity::scopes::testing::Benchmark::Result::Timing::Seconds unity::scopes::testing::Benchmark::Result::Timing::percentile(double p) const
+{
+    if (sample.empty())
+        throw std::logic_error{"Benchmark::Result::Timing::percentile: sample is empty."};
+    if (!(p > 0 && p <= 100))
+        throw std::logic_error{"Benchmark::Result::Timing::percentile: percentile must be in the range (0, 100]."};
+
+    std::vector<Seconds> sorted(sample);
+    std::sort(sorted.begin(), sorted.end());
+    auto rank = static_cast<std::size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::max<std::size_t>(rank, 1) - 1];
+}
+
 bool unity::scopes::testing::Benchmark::Result::Timing::is_significantly_faster_than_reference(
         const unity::scopes::testing::Benchmark::Result::Timing& reference,
         double alpha) const
@@ -268,14 +447,30 @@ bool unity::scopes::testing::operator==(const unity::scopes::testing::Benchmark:
             lhs.timing.histogram == rhs.timing.histogram;
 }
 
+bool unity::scopes::testing::operator==(const unity::scopes::testing::Benchmark::LoadResult& lhs, const unity::scopes::testing::Benchmark::LoadResult& rhs)
+{
+    return lhs.finished == rhs.finished &&
+            lhs.first_result == rhs.first_result &&
+            lhs.queries_per_second == rhs.queries_per_second &&
+            lhs.results_per_second == rhs.results_per_second &&
+            lhs.timeouts == rhs.timeouts;
+}
+
 std::ostream& unity::scopes::testing::operator<<(std::ostream& out, const unity::scopes::testing::Benchmark::Result& result)
 {
     out << "{"
         << "sample_size: " << result.sample_size << ", "
         << "timing: {"
         << "µ: " << result.timing.mean.count() << " [µs], "
-        << "σ: " << result.timing.std_dev.count() << " [µs]"
-        << "}}";
+        << "σ: " << result.timing.std_dev.count() << " [µs]";
+    if (!result.timing.sample.empty())
+    {
+        out << ", p50: " << result.timing.percentile(50).count() << " [µs], "
+            << "p90: " << result.timing.percentile(90).count() << " [µs], "
+            << "p99: " << result.timing.percentile(99).count() << " [µs], "
+            << "p999: " << result.timing.percentile(99.9).count() << " [µs]";
+    }
+    out << "}}";
 
     return out;
 }
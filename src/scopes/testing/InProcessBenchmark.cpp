@@ -37,12 +37,16 @@
 #include <boost/accumulators/statistics/stats.hpp>
 #include <boost/accumulators/statistics/variance.hpp>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cmath>
 #include <condition_variable>
 #include <mutex>
+#include <stdexcept>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 namespace acc = boost::accumulators;
 
@@ -219,6 +223,25 @@ struct DevNullSearchReply : public unity::scopes::SearchReply, public WaitableRe
     }
 };
 
+// Records when the first result arrived and how many results there were.
+struct CountingSearchReply : public DevNullSearchReply
+{
+    std::atomic<std::size_t> result_count{0};
+    std::chrono::high_resolution_clock::time_point first_result{};
+
+    bool push(unity::scopes::CategorisedResult const&) override
+    {
+        if (result_count.load() == 0)
+        {
+            std::lock_guard<std::mutex> lg(guard);
+            if (first_result == std::chrono::high_resolution_clock::time_point{})
+                first_result = std::chrono::high_resolution_clock::now();
+        }
+        ++result_count;
+        return true;
+    }
+};
+
 typedef std::chrono::high_resolution_clock Clock;
 typedef unity::scopes::testing::Benchmark::Result::Timing::Seconds Resolution;
 
@@ -236,46 +259,97 @@ typedef acc::accumulator_set<
     >
 > Statistics;
 
-void fill_results_from_statistics(unity::scopes::testing::Benchmark::Result& result,
-                                  const Statistics& stats)
+void fill_timing_from_statistics(unity::scopes::testing::Benchmark::Result::Timing& timing,
+                                 const Statistics& stats)
 {
-    result.sample_size = acc::count(stats);
-
     auto histogram = acc::density(stats);
 
     for (const auto& bin : histogram)
     {
-        result.timing.histogram.push_back(
+        timing.histogram.push_back(
                     std::make_pair(
                         Resolution(bin.first),
                         bin.second));
     }
 
-    result.timing.min = Resolution
+    timing.min = Resolution
     {
         static_cast<Resolution::rep>(acc::min(stats))
     };
-    result.timing.max = Resolution
+    timing.max = Resolution
     {
         static_cast<Resolution::rep>(acc::max(stats))
     };
-    result.timing.kurtosis = Resolution
+    timing.kurtosis = Resolution
     {
         static_cast<Resolution::rep>(acc::kurtosis(stats))
     };
-    result.timing.skewness = Resolution
+    timing.skewness = Resolution
     {
         static_cast<Resolution::rep>(acc::skewness(stats))
     };
-    result.timing.mean = Resolution
+    timing.mean = Resolution
     {
         static_cast<Resolution::rep>(acc::mean(stats))
     };
-    result.timing.std_dev = Resolution
+    timing.std_dev = Resolution
     {
         static_cast<Resolution::rep>(std::sqrt(acc::variance(stats)))
     };
 }
+
+void fill_results_from_statistics(unity::scopes::testing::Benchmark::Result& result,
+                                  const Statistics& stats)
+{
+    result.sample_size = acc::count(stats);
+    fill_timing_from_statistics(result.timing, stats);
+}
+
+// The outcome of a single query run by for_query_load().
+struct QueryOutcome
+{
+    bool finished{false};
+    Resolution duration{};
+    bool has_first_result{false};
+    Resolution first_result{};
+    std::size_t result_count{0};
+};
+
+QueryOutcome run_query(const std::shared_ptr<unity::scopes::ScopeBase>& scope,
+                       const unity::scopes::testing::Benchmark::LoadConfiguration& config,
+                       Clock::time_point start)
+{
+    auto reply = std::make_shared<CountingSearchReply>();
+
+    auto sample = config.sampler();
+    std::shared_ptr<unity::scopes::SearchQueryBase> q{scope->search(sample.first, sample.second)};
+
+    // The proxy keeps the reply and the query alive, so a query that times out
+    // can still push into the reply once we have stopped waiting for it.
+    q->run(unity::scopes::SearchReplyProxy
+    {
+        reply.get(),
+        [reply, q](unity::scopes::SearchReply* r)
+        {
+            r->finished();
+        }
+    });
+
+    QueryOutcome outcome;
+    outcome.finished = reply->wait_for_finished_for(config.trial_configuration.per_trial_timeout);
+    if (!outcome.finished)
+        return outcome;
+
+    outcome.duration = std::chrono::duration_cast<Resolution>(Clock::now() - start);
+    outcome.result_count = reply->result_count.load();
+    std::lock_guard<std::mutex> lg(reply->guard);
+    if (reply->first_result != Clock::time_point{})
+    {
+        outcome.has_first_result = true;
+        outcome.first_result = std::chrono::duration_cast<Resolution>(reply->first_result - start);
+    }
+    return outcome;
+}
 }
 
 /// @cond
@@ -428,4 +502,101 @@ unity::scopes::testing::Benchmark::Result unity::scopes::testing::InProcessBench
     return benchmark_result;
 }
 
+unity::scopes::testing::Benchmark::LoadResult unity::scopes::testing::InProcessBenchmark::for_query_load(
+        const std::shared_ptr<unity::scopes::ScopeBase>& scope,
+        unity::scopes::testing::Benchmark::LoadConfiguration config)
+{
+    if (!config.sampler)
+        throw std::logic_error("Benchmark::for_query_load: no sampler configured.");
+    if (config.trial_configuration.trial_count == 0)
+        throw std::logic_error("Benchmark::for_query_load: trial count must be greater than zero.");
+    if (config.concurrency == 0)
+        throw std::logic_error("Benchmark::for_query_load: concurrency must be greater than zero.");
+    if (config.mode == LoadConfiguration::Mode::open_loop && !(config.target_qps > 0))
+        throw std::logic_error("Benchmark::for_query_load: target QPS must be greater than zero.");
+
+    auto const query_count = config.trial_configuration.trial_count;
+    std::vector<QueryOutcome> outcomes(query_count);
+
+    std::mutex error_guard;
+    std::exception_ptr error;
+
+    // In closed_loop mode, a worker starts its next query as soon as the previous one has finished.
+    // In open_loop mode, query i is due at begin + i * interval. A worker that picks up a query
+    // early waits until it is due; a worker that picks it up late starts it at once, and the
+    // latency is still measured from the time it was due.
+    Resolution const interval{config.mode == LoadConfiguration::Mode::open_loop ? 1.0 / config.target_qps : 0};
+    std::atomic<std::size_t> next{0};
+    auto const begin = Clock::now();
+    auto worker = [&]()
+    {
+        for (std::size_t i = next++; i < query_count; i = next++)
+        {
+            try
+            {
+                auto start = Clock::now();
+                if (config.mode == LoadConfiguration::Mode::open_loop)
+                {
+                    start = begin + std::chrono::duration_cast<Clock::duration>(interval * i);
+                    std::this_thread::sleep_until(start);
+                }
+                outcomes[i] = run_query(scope, config, start);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lg(error_guard);
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (std::size_t w = 0; w < std::min(config.concurrency, query_count); w++)
+        workers.emplace_back(worker);
+    for (auto& t : workers)
+        t.join();
+    auto const elapsed = std::chrono::duration_cast<Resolution>(Clock::now() - begin);
+
+    if (error)
+        std::rethrow_exception(error);
+
+    auto const& statistics_configuration = config.trial_configuration.statistics_configuration;
+    Statistics stats(
+                acc::tag::density::num_bins = statistics_configuration.histogram_bin_count,
+                acc::tag::density::cache_size = 10);
+    Statistics first_result_stats(
+                acc::tag::density::num_bins = statistics_configuration.histogram_bin_count,
+                acc::tag::density::cache_size = 10);
+
+    unity::scopes::testing::Benchmark::LoadResult load_result;
+    std::size_t result_count = 0;
+    for (const auto& outcome : outcomes)
+    {
+        if (!outcome.finished)
+        {
+            load_result.timeouts++;
+            continue;
+        }
+        stats(outcome.duration.count());
+        load_result.finished.timing.sample.push_back(outcome.duration);
+        if (outcome.has_first_result)
+        {
+            first_result_stats(outcome.first_result.count());
+            load_result.first_result.timing.sample.push_back(outcome.first_result);
+        }
+        result_count += outcome.result_count;
+    }
+
+    if (!load_result.finished.timing.sample.empty())
+        fill_results_from_statistics(load_result.finished, stats);
+    if (!load_result.first_result.timing.sample.empty())
+        fill_results_from_statistics(load_result.first_result, first_result_stats);
+
+    load_result.queries_per_second = load_result.finished.timing.sample.size() / elapsed.count();
+    load_result.results_per_second = result_count / elapsed.count();
+
+    return load_result;
+}
+
 /// @endcond
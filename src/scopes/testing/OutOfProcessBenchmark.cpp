@@ -165,4 +165,39 @@ unity::scopes::testing::Benchmark::Result unity::scopes::testing::OutOfProcessBe
     return result;
 }
 
+unity::scopes::testing::Benchmark::LoadResult unity::scopes::testing::OutOfProcessBenchmark::for_query_load(
+        const std::shared_ptr<unity::scopes::ScopeBase>& scope,
+        unity::scopes::testing::Benchmark::LoadConfiguration config)
+{
+    auto child = core::posix::fork([this, config, scope]()
+    {
+        InProcessBenchmark::for_query_load(scope, config).save_to_json(std::cout);
+        return core::posix::exit::Status::success;
+    },
+    core::posix::StandardStream::stdout);
+
+    unity::scopes::testing::Benchmark::LoadResult result;
+    result.load_from_json(child.cout());
+
+    auto wait_result = child.wait_for(core::posix::wait::Flags::untraced);
+
+    switch(wait_result.status)
+    {
+    case core::posix::wait::Result::Status::signaled:
+    case core::posix::wait::Result::Status::stopped:
+        throw std::runtime_error("unity::scopes::testing::Benchmark::for_query_load: "
+                                 "Trial terminated with error, bailing out now. "
+                                 "Please see the detailed error output and backtrace.");
+    default:
+        break;
+    }
+
+    if (wait_result.detail.if_exited.status != core::posix::exit::Status::success)
+        throw std::runtime_error("unity::scopes::testing::Benchmark::for_query_load: "
+                                 "Trial exited with failure, bailing out now. "
+                                 "Please see the detailed error output and backtrace.");
+
+    return result;
+}
+
 /// @endcond
@@ -125,6 +125,17 @@ public:
             EXPECT_EQ("Partial results returned due to poor internet connection.", details.info_list()[1].message());
         }
 
+        auto metrics = details.metrics();
+        ASSERT_EQ(1u, metrics.count("push_count"));
+        ASSERT_EQ(1u, metrics.count("scope_push_count"));
+        EXPECT_EQ(metrics["scope_push_count"].get_int64_t(), metrics["push_count"].get_int64_t());
+        EXPECT_GE(metrics["push_count"].get_int64_t(), 3);
+        ASSERT_EQ(1u, metrics.count("first_push_ms"));
+        ASSERT_EQ(1u, metrics.count("finished_ms"));
+        EXPECT_LE(metrics["first_push_ms"].get_double(), metrics["finished_ms"].get_double());
+        EXPECT_EQ(1u, metrics.count("scope_queue_ms"));
+        EXPECT_EQ(1u, metrics.count("scope_run_ms"));
+
         // Signal that the query has completed.
         unique_lock<mutex> lock(mutex_);
         query_complete_ = true;
@@ -0,0 +1,319 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <ScopesWatcher.h>
+
+#include <unity/scopes/internal/RegistryConfig.h>
+#include <unity/scopes/internal/RegistryObject.h>
+#include <unity/scopes/internal/RuntimeImpl.h>
+#include <unity/scopes/internal/ScopeImpl.h>
+#include <unity/scopes/internal/ScopeMetadataImpl.h>
+
+#include <boost/filesystem.hpp>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wctor-dtor-privacy"
+#include <gtest/gtest.h>
+#pragma GCC diagnostic pop
+
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <thread>
+
+using namespace std;
+using namespace scoperegistry;
+using namespace unity::scopes;
+using namespace unity::scopes::internal;
+
+namespace fs = boost::filesystem;
+
+namespace
+{
+
+string const runtime_ini = TEST_DIR "/Runtime.ini";
+string const install_dir = TEST_DIR "/scopes";
+
+auto const batch_window = chrono::milliseconds(300);
+auto const wait_time = chrono::seconds(5);
+
+struct Scope
+{
+    Scope()
+        : trap(core::posix::trap_signals_for_all_subsequent_threads({core::posix::Signal::sig_chld})),
+          death_observer(core::posix::ChildProcess::DeathObserver::create_once_with_signal_trap(trap)),
+          worker([this]() { trap->run(); })
+    {
+    }
+
+    ~Scope()
+    {
+        trap->stop();
+
+        if (worker.joinable())
+            worker.join();
+    }
+
+    std::shared_ptr<core::posix::SignalTrap> trap;
+    std::unique_ptr<core::posix::ChildProcess::DeathObserver> death_observer;
+    std::thread worker;
+} scope;
+
+// Installs the scope by creating its directory and writing its .ini file.
+// Writing the file again for an installed scope modifies the .ini file.
+
+void write_ini(string const& scope_id)
+{
+    fs::create_directory(install_dir + "/" + scope_id);
+    ofstream f(install_dir + "/" + scope_id + "/" + scope_id + ".ini");
+    f << "[ScopeConfig]\nDisplayName = " << scope_id << "\nDescription = test\nAuthor = test\n";
+}
+
+void remove_scope(string const& scope_id)
+{
+    fs::remove_all(install_dir + "/" + scope_id);
+}
+
+class ScopesWatcherTest : public ::testing::Test
+{
+public:
+    ScopesWatcherTest()
+    {
+        fs::remove_all(install_dir);
+        fs::create_directory(install_dir);
+
+        runtime_ = RuntimeImpl::create("ScopesWatcherTest", runtime_ini);
+        string identity = runtime_->registry_identity();
+        RegistryConfig c(identity, runtime_->registry_configfile());
+        middleware_ = runtime_->factory()->create(identity, c.mw_kind(), c.mw_configfile());
+        registry_ = make_shared<RegistryObject>(*scope.death_observer, make_shared<Executor>(), middleware_);
+
+        subscriber_ = middleware_->create_subscriber(identity);
+        subscriber_->message_received().connect([this](string const&)
+        {
+            lock_guard<mutex> lock(mutex_);
+            ++notifications_;
+            cond_.notify_all();
+        });
+
+        // Subscriptions take a moment to reach the publisher. Keep updating the registry
+        // until the subscriber sees an update, so no notification goes missing during the test.
+        for (int i = 0; i < 50 && notifications() == 0; ++i)
+        {
+            registry_->add_local_scope("warmup", make_meta("warmup"), RegistryObject::ScopeExecData());
+            unique_lock<mutex> lock(mutex_);
+            cond_.wait_for(lock, chrono::milliseconds(100), [this]{ return notifications_ > 0; });
+        }
+        EXPECT_GT(notifications(), 0);
+        this_thread::sleep_for(chrono::milliseconds(200));
+        reset_notifications();
+
+        watcher_.reset(new ScopesWatcher(registry_,
+                                         [this](pair<string, string> const& scope)
+                                         {
+                                             {
+                                                 lock_guard<mutex> lock(mutex_);
+                                                 ++installs_[scope.first];
+                                             }
+                                             registry_->add_local_scope(scope.first,
+                                                                        make_meta(scope.first),
+                                                                        RegistryObject::ScopeExecData());
+                                         },
+                                         runtime_->logger(),
+                                         batch_window));
+        watcher_->add_install_dir(install_dir);
+    }
+
+    ~ScopesWatcherTest()
+    {
+        watcher_.reset();
+        fs::remove_all(install_dir);
+    }
+
+    ScopeMetadata make_meta(string const& scope_id)
+    {
+        unique_ptr<ScopeMetadataImpl> mi(new ScopeMetadataImpl(middleware_.get()));
+        mi->set_scope_id(scope_id);
+        mi->set_display_name("display name " + scope_id);
+        mi->set_description("description " + scope_id);
+        mi->set_author("author " + scope_id);
+        mi->set_scope_directory(install_dir + "/" + scope_id);
+        auto proxy = middleware_->create_scope_proxy(scope_id, "ipc:///tmp/" + scope_id);
+        mi->set_proxy(ScopeImpl::create(proxy, scope_id));
+        return ScopeMetadataImpl::create(move(mi));
+    }
+
+    // Waits for at least n notifications. Then waits for a few more batch windows,
+    // so any surplus notifications show up in the returned count.
+    int wait_for_notifications(int n)
+    {
+        {
+            unique_lock<mutex> lock(mutex_);
+            EXPECT_TRUE(cond_.wait_for(lock, wait_time, [this, n]{ return notifications_ >= n; }));
+        }
+        this_thread::sleep_for(batch_window * 3);
+        return notifications();
+    }
+
+    int notifications()
+    {
+        lock_guard<mutex> lock(mutex_);
+        return notifications_;
+    }
+
+    void reset_notifications()
+    {
+        lock_guard<mutex> lock(mutex_);
+        notifications_ = 0;
+    }
+
+    int installs(string const& scope_id)
+    {
+        lock_guard<mutex> lock(mutex_);
+        return installs_[scope_id];
+    }
+
+    bool is_registered(string const& scope_id)
+    {
+        return registry_->list().count(scope_id) == 1;
+    }
+
+protected:
+    // Declared first, so they outlive the subscriber and watcher threads that use them.
+    mutex mutex_;
+    condition_variable cond_;
+    int notifications_ = 0;
+    map<string, int> installs_;
+
+    RuntimeImpl::UPtr runtime_;
+    MiddlewareBase::SPtr middleware_;
+    RegistryObject::SPtr registry_;
+    MWSubscriber::UPtr subscriber_;
+    unique_ptr<ScopesWatcher> watcher_;
+};
+
+} // namespace
+
+// Changes that arrive within the batch window are applied together, with a single notification.
+
+TEST_F(ScopesWatcherTest, single_batch)
+{
+    write_ini("scope-a");
+    write_ini("scope-b");
+    write_ini("scope-c");
+
+    EXPECT_EQ(1, wait_for_notifications(1));
+    EXPECT_EQ(1, installs("scope-a"));
+    EXPECT_EQ(1, installs("scope-b"));
+    EXPECT_EQ(1, installs("scope-c"));
+    EXPECT_TRUE(is_registered("scope-a"));
+    EXPECT_TRUE(is_registered("scope-b"));
+    EXPECT_TRUE(is_registered("scope-c"));
+
+    remove_scope("scope-a");
+    remove_scope("scope-b");
+
+    EXPECT_EQ(2, wait_for_notifications(2));
+    EXPECT_FALSE(is_registered("scope-a"));
+    EXPECT_FALSE(is_registered("scope-b"));
+    EXPECT_TRUE(is_registered("scope-c"));
+}
+
+// Only the net change for each scope is applied.
+
+TEST_F(ScopesWatcherTest, net_change)
+{
+    write_ini("scope-a");
+    EXPECT_EQ(1, wait_for_notifications(1));
+    EXPECT_EQ(1, installs("scope-a"));
+    reset_notifications();
+
+    // Within a single batch, scope-a is removed and installed again,
+    // and scope-b is installed and removed again.
+    remove_scope("scope-a");
+    write_ini("scope-a");
+    write_ini("scope-b");
+    remove_scope("scope-b");
+
+    EXPECT_EQ(1, wait_for_notifications(1));
+    EXPECT_EQ(2, installs("scope-a"));
+    EXPECT_EQ(0, installs("scope-b"));
+    EXPECT_TRUE(is_registered("scope-a"));
+    EXPECT_FALSE(is_registered("scope-b"));
+
+    // An uninstall that cancels out an install in the same batch changes nothing,
+    // so there is no notification.
+    reset_notifications();
+    write_ini("scope-d");
+    remove_scope("scope-d");
+    EXPECT_EQ(0, wait_for_notifications(0));
+    EXPECT_EQ(0, installs("scope-d"));
+    EXPECT_FALSE(is_registered("scope-d"));
+}
+
+// Renaming a scope's .ini file within a batch removes the old scope and installs the new one.
+
+TEST_F(ScopesWatcherTest, rename_ini)
+{
+    write_ini("scope-a");
+    EXPECT_EQ(1, wait_for_notifications(1));
+    EXPECT_TRUE(is_registered("scope-a"));
+    reset_notifications();
+
+    fs::rename(install_dir + "/scope-a/scope-a.ini", install_dir + "/scope-a/scope-b.ini");
+
+    EXPECT_EQ(1, wait_for_notifications(1));
+    EXPECT_EQ(1, installs("scope-b"));
+    EXPECT_FALSE(is_registered("scope-a"));
+    EXPECT_TRUE(is_registered("scope-b"));
+}
+
+// Changes that are superseded by a later change for the same scope are counted.
+
+TEST_F(ScopesWatcherTest, suppressed_events)
+{
+    write_ini("scope-a");
+    EXPECT_EQ(1, wait_for_notifications(1));
+    reset_notifications();
+
+    auto const before = watcher_->suppressed_events();
+    int const num_writes = 5;
+    for (int i = 0; i < num_writes; ++i)
+    {
+        write_ini("scope-a");
+    }
+
+    EXPECT_EQ(1, wait_for_notifications(1));
+    EXPECT_EQ(2, installs("scope-a"));
+    EXPECT_GE(watcher_->suppressed_events() - before, num_writes - 1);
+}
+
+// The window is bounded, so a steady stream of changes cannot hold up the registry indefinitely.
+
+TEST_F(ScopesWatcherTest, max_batch_delay)
+{
+    auto const start = chrono::steady_clock::now();
+    auto const max_delay = batch_window * 10;
+    while (notifications() == 0 && chrono::steady_clock::now() < start + max_delay * 2)
+    {
+        write_ini("scope-a");
+        this_thread::sleep_for(batch_window / 3);
+    }
+    EXPECT_GT(notifications(), 0);
+    EXPECT_TRUE(is_registered("scope-a"));
+}
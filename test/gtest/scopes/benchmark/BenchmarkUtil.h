@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#pragma once
+
+#include <unity/scopes/testing/Benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Helpers shared by the benchmarks in this directory.
+
+namespace benchmark_util
+{
+
+typedef unity::scopes::testing::Benchmark::Result BenchmarkResult;
+typedef BenchmarkResult::Timing::Seconds Seconds;
+
+// Returns a result with the sample and the statistics we report for it.
+// (Histogram, kurtosis and skewness are not filled in. Percentiles are computed
+// from the sample by Timing::percentile().)
+
+inline BenchmarkResult make_result(std::vector<Seconds> const& sample)
+{
+    BenchmarkResult r;
+    r.sample_size = sample.size();
+    r.timing.sample = sample;
+    if (sample.empty())
+    {
+        return r;
+    }
+
+    std::vector<Seconds> sorted(sample);
+    std::sort(sorted.begin(), sorted.end());
+
+    r.timing.min = sorted.front();
+    r.timing.max = sorted.back();
+    r.timing.mean = std::accumulate(sorted.begin(), sorted.end(), Seconds{0}) / sorted.size();
+    double sum_sq = 0;
+    for (auto const& s : sorted)
+    {
+        double const d = (s - r.timing.mean).count();
+        sum_sq += d * d;
+    }
+    r.timing.std_dev = Seconds{sorted.size() > 1 ? std::sqrt(sum_sq / (sorted.size() - 1)) : 0};
+    return r;
+}
+
+// Calls trial(iterations) to time that many iterations of an operation. The number of iterations
+// is doubled until a trial takes at least min_trial_time, which also warms up caches and the allocator.
+// Returns the time per iteration of each of num_trials trials.
+
+inline std::vector<Seconds> measure(std::function<Seconds(long iterations)> const& trial,
+                                    int num_trials,
+                                    std::chrono::milliseconds min_trial_time)
+{
+    long iterations = 1;
+    while (trial(iterations) < min_trial_time)
+    {
+        iterations *= 2;
+    }
+
+    std::vector<Seconds> sample;
+    for (int i = 0; i < num_trials; ++i)
+    {
+        sample.push_back(trial(iterations) / iterations);
+    }
+    return sample;
+}
+
+// Calls op(thread_index, iteration) for iterations iterations in each of num_threads threads.
+// Returns the elapsed time divided by num_threads, so the time per iteration that measure()
+// reports for it is the inverse of the throughput.
+
+inline Seconds time_concurrently(int num_threads, long iterations, std::function<void(int, long)> const& op)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t)
+    {
+        threads.emplace_back([&op, t, iterations]
+        {
+            for (long i = 0; i < iterations; ++i)
+            {
+                op(t, i);
+            }
+        });
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    return std::chrono::duration_cast<Seconds>(std::chrono::steady_clock::now() - start) / num_threads;
+}
+
+// Prints the column headings for print_row().
+
+inline void print_header()
+{
+    printf("%-40s %12s %12s %12s %12s\n", "benchmark (ns/op)", "p50", "p90", "p99", "mean");
+}
+
+// Prints the percentiles and the mean of the result for a scenario in ns.
+
+inline void print_row(std::string const& scenario, BenchmarkResult const& r)
+{
+    auto ns = [](Seconds s) { return s.count() * 1e9; };
+    printf("%-40s %12.0f %12.0f %12.0f %12.0f\n",
+           scenario.c_str(), ns(r.timing.percentile(50)), ns(r.timing.percentile(90)), ns(r.timing.percentile(99)),
+           ns(r.timing.mean));
+}
+
+// Writes the result for a scenario to <dir>/<scenario>.json.
+
+inline void save_result(std::string const& dir, std::string const& scenario, BenchmarkResult& r)
+{
+    std::ofstream out(dir + "/" + scenario + ".json");
+    r.save_to_json(out);
+    out.close();
+    if (!out)
+    {
+        throw std::runtime_error("cannot write result for " + scenario + " to " + dir);
+    }
+}
+
+}  // namespace benchmark_util
@@ -0,0 +1,345 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#pragma once
+
+#include <unity/scopes/testing/Benchmark.h>
+#include <unity/scopes/testing/Statistics.h>
+#include <unity/scopes/Variant.h>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Compares benchmark results against a baseline.
+//
+// A baseline is a single json file that maps each scenario name to its
+// Benchmark::Result, as written by Result::save_to_json(). The benchmarks
+// write one <scenario>.json per scenario into a results directory;
+// read_results() collects these, and save_baseline() turns them into a baseline.
+
+namespace benchmark_util
+{
+
+typedef unity::scopes::testing::Benchmark::Result BenchmarkResult;
+
+struct GateConfiguration
+{
+    double threshold = 0.05;          // Relative slowdown (of the mean or median) that counts as a regression.
+    double alpha = 0.05;              // Critical value for the t-test.
+    std::size_t min_sample_size = 10; // Smaller samples are not compared.
+};
+
+struct Comparison
+{
+    enum Verdict
+    {
+        Unchanged,
+        Faster,
+        Slower,         // Significantly slower, but by less than the threshold.
+        Regressed,
+        Inconclusive,   // Sample too small to compare.
+        New,            // No baseline for this scenario.
+        Missing         // Scenario in baseline, but not in the results.
+    };
+
+    std::string scenario;
+    Verdict verdict = Unchanged;
+    double baseline = 0;              // Compared statistic (mean or median) in seconds.
+    double current = 0;
+    double change = 0;                // (current - baseline) / baseline
+    bool normal = false;              // True if both samples are normal, so we compared means with the t-test.
+};
+
+inline char const* verdict_name(Comparison::Verdict v)
+{
+    switch (v)
+    {
+        case Comparison::Unchanged:
+            return "ok";
+        case Comparison::Faster:
+            return "faster";
+        case Comparison::Slower:
+            return "slower";
+        case Comparison::Regressed:
+            return "REGRESSED";
+        case Comparison::Inconclusive:
+            return "inconclusive";
+        case Comparison::New:
+            return "new";
+        case Comparison::Missing:
+            return "MISSING";
+        default:
+            return "unknown";  // LCOV_EXCL_LINE
+    }
+}
+
+// Mann-Whitney U test for the case that at least one sample is not normally distributed.
+// Returns the one-sided p-value for the hypothesis that timings in current tend to be
+// larger than those in reference (normal approximation, with tie correction).
+
+inline double mann_whitney_p_slower(BenchmarkResult::Timing const& reference, BenchmarkResult::Timing const& current)
+{
+    std::vector<std::pair<double, bool>> all;  // (timing, is in current)
+    for (auto const& s : reference.sample)
+    {
+        all.push_back(std::make_pair(s.count(), false));
+    }
+    for (auto const& s : current.sample)
+    {
+        all.push_back(std::make_pair(s.count(), true));
+    }
+    std::sort(all.begin(), all.end());
+
+    double const n1 = reference.sample.size();
+    double const n2 = current.sample.size();
+    double const n = n1 + n2;
+    double rank_sum = 0;   // Sum of the ranks of current
+    double ties = 0;       // Sum of t^3 - t over all groups of t tied timings
+    for (std::size_t i = 0; i < all.size();)
+    {
+        std::size_t j = i;
+        while (j < all.size() && all[j].first == all[i].first)
+        {
+            ++j;
+        }
+        double const t = j - i;
+        double const rank = (i + 1 + j) / 2.0;  // Tied timings get the mean of their ranks.
+        for (std::size_t k = i; k < j; ++k)
+        {
+            rank_sum += all[k].second ? rank : 0;
+        }
+        ties += t * t * t - t;
+        i = j;
+    }
+
+    double const u = rank_sum - n2 * (n2 + 1) / 2;
+    double const variance = n1 * n2 / 12 * ((n + 1) - ties / (n * (n - 1)));
+    if (variance <= 0)
+    {
+        return 0.5;  // All timings are the same.
+    }
+    double const z = (u - n1 * n2 / 2) / std::sqrt(variance);
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+// Compares the timing of a scenario with its baseline.
+//
+// If both samples pass the Anderson-Darling test for normality, we compare the means with the
+// Student's t-test (via Timing::is_significantly_slower_than_reference()). Otherwise, the t-test
+// does not apply, so we compare the medians and use the Mann-Whitney U test instead.
+// A scenario regressed if it is significantly slower, and slower by more than the threshold.
+
+inline Comparison compare(std::string const& scenario,
+                          BenchmarkResult const& baseline,
+                          BenchmarkResult const& current,
+                          GateConfiguration const& config = GateConfiguration())
+{
+    Comparison c;
+    c.scenario = scenario;
+
+    auto const& ref = baseline.timing;
+    auto const& t = current.timing;
+    if (ref.sample.size() < config.min_sample_size || t.sample.size() < config.min_sample_size)
+    {
+        c.verdict = Comparison::Inconclusive;
+        c.baseline = ref.mean.count();
+        c.current = t.mean.count();
+        c.change = c.baseline > 0 ? (c.current - c.baseline) / c.baseline : 0;
+        return c;
+    }
+
+    bool slower;
+    bool faster;
+    try
+    {
+        slower = t.is_significantly_slower_than_reference(ref, config.alpha);
+        faster = t.is_significantly_faster_than_reference(ref, config.alpha);
+        c.normal = true;
+        c.baseline = ref.mean.count();
+        c.current = t.mean.count();
+    }
+    catch (std::runtime_error const&)
+    {
+        // At least one of the samples is not normally distributed.
+        double const p = mann_whitney_p_slower(ref, t);
+        slower = p < config.alpha;
+        faster = 1 - p < config.alpha;
+        c.baseline = ref.percentile(50).count();
+        c.current = t.percentile(50).count();
+    }
+    c.change = c.baseline > 0 ? (c.current - c.baseline) / c.baseline : 0;
+
+    if (slower)
+    {
+        c.verdict = c.change > config.threshold ? Comparison::Regressed : Comparison::Slower;
+    }
+    else if (faster)
+    {
+        c.verdict = Comparison::Faster;
+    }
+    return c;
+}
+
+inline BenchmarkResult result_from_variant(unity::scopes::Variant const& v)
+{
+    std::istringstream s(v.serialize_json());
+    BenchmarkResult r;
+    r.load_from_json(s);
+    return r;
+}
+
+inline unity::scopes::Variant read_json(std::string const& path)
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        throw std::runtime_error("cannot open " + path);
+    }
+    std::string json{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+    try
+    {
+        return unity::scopes::Variant::deserialize_json(json);
+    }
+    catch (std::exception const& e)
+    {
+        throw std::runtime_error(path + ": " + e.what());
+    }
+}
+
+// Returns the results in dir, indexed by scenario name.
+
+inline unity::scopes::VariantMap read_results(std::string const& dir)
+{
+    namespace fs = boost::filesystem;
+
+    unity::scopes::VariantMap results;
+    if (!fs::is_directory(dir))
+    {
+        throw std::runtime_error("cannot open results directory " + dir);
+    }
+    for (fs::directory_iterator it(dir); it != fs::directory_iterator(); ++it)
+    {
+        fs::path const p = it->path();
+        if (p.extension() == ".json" && fs::is_regular_file(p))
+        {
+            results[p.stem().string()] = read_json(p.string());
+        }
+    }
+    return results;
+}
+
+inline unity::scopes::VariantMap load_baseline(std::string const& path)
+{
+    auto const v = read_json(path);
+    if (v.which() != unity::scopes::Variant::Dict)
+    {
+        throw std::runtime_error(path + ": not a baseline file");
+    }
+    return v.get_dict();
+}
+
+inline void save_baseline(std::string const& path, unity::scopes::VariantMap const& results)
+{
+    std::ofstream out(path);
+    out << unity::scopes::Variant(results).serialize_json();
+    out.close();
+    if (!out)
+    {
+        throw std::runtime_error("cannot write baseline " + path);
+    }
+}
+
+// Compares every scenario in the baseline with its result. Scenarios in the results that
+// are not in the baseline are reported as New. Only scenarios whose name contains
+// one of the filter strings are compared; an empty filter compares all scenarios.
+
+inline std::vector<Comparison> compare_all(unity::scopes::VariantMap const& baseline,
+                                           unity::scopes::VariantMap const& results,
+                                           GateConfiguration const& config = GateConfiguration(),
+                                           std::vector<std::string> const& filter = std::vector<std::string>())
+{
+    auto tracked = [&filter](std::string const& scenario)
+    {
+        if (filter.empty())
+        {
+            return true;
+        }
+        for (auto const& f : filter)
+        {
+            if (scenario.find(f) != std::string::npos)
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    std::vector<Comparison> comparisons;
+    for (auto const& b : baseline)
+    {
+        if (!tracked(b.first))
+        {
+            continue;
+        }
+        auto it = results.find(b.first);
+        if (it == results.end())
+        {
+            Comparison c;
+            c.scenario = b.first;
+            c.verdict = Comparison::Missing;
+            comparisons.push_back(c);
+            continue;
+        }
+        comparisons.push_back(compare(b.first, result_from_variant(b.second), result_from_variant(it->second), config));
+    }
+    for (auto const& r : results)
+    {
+        if (tracked(r.first) && baseline.find(r.first) == baseline.end())
+        {
+            Comparison c;
+            c.scenario = r.first;
+            c.verdict = Comparison::New;
+            comparisons.push_back(c);
+        }
+    }
+    return comparisons;
+}
+
+inline bool failed(std::vector<Comparison> const& comparisons)
+{
+    for (auto const& c : comparisons)
+    {
+        if (c.verdict == Comparison::Regressed || c.verdict == Comparison::Missing)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace benchmark_util
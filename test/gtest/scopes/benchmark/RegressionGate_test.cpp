@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include "BenchmarkUtil.h"
+#include "RegressionGate.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+using namespace std;
+using namespace benchmark_util;
+
+namespace
+{
+
+// Returns a result with n normally distributed timings, in microseconds.
+
+BenchmarkResult normal_result(double mean_us, double std_dev_us, unsigned seed, size_t n = 50)
+{
+    mt19937 gen(seed);
+    normal_distribution<double> dist(mean_us, std_dev_us);
+    vector<Seconds> sample;
+    for (size_t i = 0; i < n; ++i)
+    {
+        sample.push_back(Seconds(dist(gen) * 1e-6));
+    }
+    return make_result(sample);
+}
+
+// Returns a result with a long tail: most timings are fast, every fifth one is ten times slower.
+
+BenchmarkResult skewed_result(double fast_us, size_t n = 50)
+{
+    vector<Seconds> sample;
+    for (size_t i = 0; i < n; ++i)
+    {
+        double const us = i % 5 == 0 ? fast_us * 10 : fast_us + i % 3;
+        sample.push_back(Seconds(us * 1e-6));
+    }
+    return make_result(sample);
+}
+
+} // namespace
+
+TEST(RegressionGate, unchanged)
+{
+    auto const base = normal_result(100, 2, 1);
+    auto const cur = normal_result(100, 2, 2);
+    auto c = compare("s", base, cur);
+    EXPECT_EQ("s", c.scenario);
+    EXPECT_TRUE(c.normal);
+    EXPECT_NE(Comparison::Regressed, c.verdict);
+    EXPECT_NE(Comparison::Faster, c.verdict);
+    EXPECT_LT(abs(c.change), 0.05);
+}
+
+TEST(RegressionGate, regressed)
+{
+    auto const base = normal_result(100, 2, 1);
+    auto const cur = normal_result(120, 2, 2);
+    auto c = compare("s", base, cur);
+    EXPECT_TRUE(c.normal);
+    EXPECT_EQ(Comparison::Regressed, c.verdict);
+    EXPECT_NEAR(0.2, c.change, 0.02);
+}
+
+TEST(RegressionGate, below_threshold)
+{
+    // Significantly slower, but by less than the threshold.
+    auto const base = normal_result(100, 0.5, 1);
+    auto const cur = normal_result(102, 0.5, 2);
+    auto c = compare("s", base, cur);
+    EXPECT_TRUE(c.normal);
+    EXPECT_EQ(Comparison::Slower, c.verdict);
+
+    GateConfiguration config;
+    config.threshold = 0.01;
+    EXPECT_EQ(Comparison::Regressed, compare("s", base, cur, config).verdict);
+}
+
+TEST(RegressionGate, faster)
+{
+    auto const base = normal_result(100, 2, 1);
+    auto const cur = normal_result(80, 2, 2);
+    auto c = compare("s", base, cur);
+    EXPECT_EQ(Comparison::Faster, c.verdict);
+    EXPECT_LT(c.change, 0);
+}
+
+TEST(RegressionGate, not_normal)
+{
+    // The t-test does not apply, so we compare medians.
+    auto const base = skewed_result(100);
+    auto c = compare("s", base, skewed_result(100));
+    EXPECT_FALSE(c.normal);
+    EXPECT_EQ(Comparison::Unchanged, c.verdict);
+    EXPECT_EQ(base.timing.percentile(50).count(), c.baseline);
+
+    c = compare("s", base, skewed_result(150));
+    EXPECT_FALSE(c.normal);
+    EXPECT_EQ(Comparison::Regressed, c.verdict);
+
+    c = compare("s", base, skewed_result(50));
+    EXPECT_EQ(Comparison::Faster, c.verdict);
+}
+
+TEST(RegressionGate, small_sample)
+{
+    auto const base = normal_result(100, 2, 1);
+    auto const cur = normal_result(200, 2, 2, 5);
+    EXPECT_EQ(Comparison::Inconclusive, compare("s", base, cur).verdict);
+}
+
+TEST(RegressionGate, compare_all)
+{
+    unity::scopes::VariantMap baseline;
+    unity::scopes::VariantMap results;
+
+    auto add = [](unity::scopes::VariantMap& m, string const& scenario, BenchmarkResult r)
+    {
+        ostringstream s;
+        r.save_to_json(s);
+        m[scenario] = unity::scopes::Variant::deserialize_json(s.str());
+    };
+    add(baseline, "a.same", normal_result(100, 2, 1));
+    add(results, "a.same", normal_result(100, 2, 2));
+    add(baseline, "b.slow", normal_result(100, 2, 3));
+    add(results, "b.slow", normal_result(150, 2, 4));
+    add(baseline, "c.gone", normal_result(100, 2, 5));
+    add(results, "d.new", normal_result(100, 2, 6));
+
+    auto comparisons = compare_all(baseline, results);
+    ASSERT_EQ(4u, comparisons.size());
+    EXPECT_EQ("a.same", comparisons[0].scenario);
+    EXPECT_NE(Comparison::Regressed, comparisons[0].verdict);
+    EXPECT_EQ("b.slow", comparisons[1].scenario);
+    EXPECT_EQ(Comparison::Regressed, comparisons[1].verdict);
+    EXPECT_EQ("c.gone", comparisons[2].scenario);
+    EXPECT_EQ(Comparison::Missing, comparisons[2].verdict);
+    EXPECT_EQ("d.new", comparisons[3].scenario);
+    EXPECT_EQ(Comparison::New, comparisons[3].verdict);
+    EXPECT_TRUE(failed(comparisons));
+
+    // Only track scenarios that contain "a." or "new".
+    comparisons = compare_all(baseline, results, GateConfiguration(), { "a.", "new" });
+    ASSERT_EQ(2u, comparisons.size());
+    EXPECT_EQ("a.same", comparisons[0].scenario);
+    EXPECT_EQ("d.new", comparisons[1].scenario);
+    EXPECT_FALSE(failed(comparisons));
+}
+
+TEST(RegressionGate, save_and_load)
+{
+    namespace fs = boost::filesystem;
+
+    fs::path const dir = fs::temp_directory_path() / fs::unique_path("RegressionGate-%%%%-%%%%");
+    fs::create_directories(dir / "results");
+
+    auto r = normal_result(100, 2, 1);
+    save_result((dir / "results").string(), "x.y", r);
+    auto results = read_results((dir / "results").string());
+    ASSERT_EQ(1u, results.size());
+
+    string const baseline_file = (dir / "baseline.json").string();
+    save_baseline(baseline_file, results);
+    auto baseline = load_baseline(baseline_file);
+    ASSERT_EQ(1u, baseline.size());
+    EXPECT_TRUE(result_from_variant(baseline["x.y"]) == r);
+
+    auto comparisons = compare_all(baseline, results);
+    ASSERT_EQ(1u, comparisons.size());
+    EXPECT_EQ(Comparison::Unchanged, comparisons[0].verdict);
+    EXPECT_EQ(0, comparisons[0].change);
+
+    EXPECT_THROW(load_baseline((dir / "nonexistent.json").string()), runtime_error);
+    EXPECT_THROW(read_results((dir / "nonexistent").string()), runtime_error);
+
+    fs::remove_all(dir);
+}
@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+// Benchmarks for request dispatch through the zmq ObjectAdapter: twoway requests from one
+// and from several clients, with and without another thread adding and removing servants
+// (as happens for reply objects during a burst of queries), and servant lookup on its own.
+//
+// Each benchmark runs a number of trials of enough iterations to take at least
+// 10 ms, and reports the per-request time of the trials in ns. With several clients,
+// this is the elapsed time divided by the total number of requests, that is, the
+// inverse of the throughput. Each benchmark's result is also written as a
+// testing::Benchmark::Result in JSON format to <results dir>/<name>.json.
+//
+// Usage: adapter-benchmark [results dir] [name filter]
+
+#include <unity/scopes/internal/RuntimeImpl.h>
+#include <unity/scopes/internal/zmq_middleware/ObjectAdapter.h>
+#include <unity/scopes/internal/zmq_middleware/ServantBase.h>
+#include <unity/scopes/internal/zmq_middleware/ZmqMiddleware.h>
+#include <unity/scopes/internal/zmq_middleware/ZmqReceiver.h>
+#include <unity/scopes/internal/zmq_middleware/ZmqSender.h>
+
+#include <scopes/internal/zmq_middleware/capnproto/Message.capnp.h>
+
+#include "BenchmarkUtil.h"
+
+#include <boost/filesystem.hpp>
+#include <capnp/serialize.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <thread>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace unity::scopes;
+using namespace unity::scopes::internal;
+using namespace unity::scopes::internal::zmq_middleware;
+
+namespace
+{
+
+typedef chrono::steady_clock Clock;
+using benchmark_util::Seconds;
+
+int const trials = 25;
+chrono::milliseconds const min_trial_time(10);
+
+int const num_workers = 4;      // Adapter threads
+int const num_servants = 64;    // Long-lived servants that the clients invoke
+
+// The build directory may be too long for an ipc endpoint path.
+string const endpoint = "ipc:///tmp/adapter-benchmark-" + to_string(getpid());
+
+string results_dir = "results";
+string filter;
+
+class Delegate : public AbstractObject
+{
+};
+
+class Servant : public ServantBase
+{
+public:
+    Servant() :
+        ServantBase(make_shared<Delegate>(), { { "op", bind(&Servant::op, this,
+                                                            placeholders::_1,
+                                                            placeholders::_2,
+                                                            placeholders::_3) } })
+    {
+    }
+
+    void op(Current const&, capnp::AnyPointer::Reader&, capnproto::Response::Builder& r)
+    {
+        r.setStatus(capnproto::ResponseStatus::SUCCESS);
+    }
+};
+
+// A client with its own socket, which sends twoway requests to one of the servants.
+
+class Client
+{
+public:
+    Client(zmqpp::context& c, string const& servant_id)
+        : s_(c, zmqpp::socket_type::request)
+        , sender_(s_)
+        , receiver_(s_)
+    {
+        s_.set(zmqpp::socket_option::linger, 0);
+        s_.connect(endpoint);
+        auto request = b_.initRoot<capnproto::Request>();
+        request.setMode(capnproto::RequestMode::TWOWAY);
+        request.setId(servant_id);
+        request.setCat("cat");
+        request.setOpName("op");
+    }
+
+    void invoke()
+    {
+        sender_.send(b_.getSegmentsForOutput());
+        capnp::SegmentArrayMessageReader reader(receiver_.receive());
+        if (reader.getRoot<capnproto::Response>().getStatus() != capnproto::ResponseStatus::SUCCESS)
+        {
+            throw runtime_error("request to adapter failed");
+        }
+    }
+
+private:
+    zmqpp::socket s_;
+    ZmqSender sender_;
+    ZmqReceiver receiver_;
+    capnp::MallocMessageBuilder b_;
+};
+
+// Adds and removes a servant in a loop for as long as it exists.
+
+class Churner
+{
+public:
+    Churner(ObjectAdapter& a)
+        : done_(false)
+        , t_([this, &a]
+          {
+              auto o = make_shared<Servant>();
+              for (long i = 0; !done_; ++i)
+              {
+                  string id = "churn_" + to_string(i);
+                  a.add(id, o);
+                  a.remove(id);
+              }
+          })
+    {
+    }
+
+    ~Churner()
+    {
+        done_ = true;
+        t_.join();
+    }
+
+private:
+    atomic_bool done_;
+    thread t_;
+};
+
+// Runs the trials for a scenario. trial(iterations) returns the elapsed time for that many
+// iterations (per client, if there are several).
+
+void run(string const& name, function<Seconds(long)> const& trial)
+{
+    if (name.find(filter) == string::npos)
+    {
+        return;
+    }
+
+    auto r = benchmark_util::make_result(benchmark_util::measure(trial, trials, min_trial_time));
+    benchmark_util::save_result(results_dir, name, r);
+    benchmark_util::print_row(name, r);
+}
+
+// Sends iterations requests from each client. Several clients send their requests concurrently.
+
+Seconds time_dispatch(vector<unique_ptr<Client>>& clients, long iterations)
+{
+    if (clients.size() == 1)
+    {
+        auto start = Clock::now();
+        for (long i = 0; i < iterations; ++i)
+        {
+            clients[0]->invoke();
+        }
+        return chrono::duration_cast<Seconds>(Clock::now() - start);
+    }
+    return benchmark_util::time_concurrently(clients.size(), iterations, [&clients](int t, long)
+    {
+        clients[t]->invoke();
+    });
+}
+
+void bench_dispatch(ZmqMiddleware& mw, ObjectAdapter& a)
+{
+    auto make_clients = [&mw](int n)
+    {
+        vector<unique_ptr<Client>> clients;
+        for (int i = 0; i < n; ++i)
+        {
+            clients.emplace_back(new Client(*mw.context(), "servant_" + to_string(i % num_servants)));
+        }
+        return clients;
+    };
+
+    auto one = make_clients(1);
+    auto many = make_clients(num_workers * 2);
+
+    run("adapter.dispatch", [&](long n) { return time_dispatch(one, n); });
+    run("adapter.dispatch_" + to_string(many.size()) + "_clients", [&](long n) { return time_dispatch(many, n); });
+    {
+        Churner churner(a);
+        run("adapter.dispatch_churn", [&](long n) { return time_dispatch(one, n); });
+        run("adapter.dispatch_" + to_string(many.size()) + "_clients_churn",
+            [&](long n) { return time_dispatch(many, n); });
+    }
+}
+
+void bench_find(ObjectAdapter& a)
+{
+    vector<string> ids;
+    for (int i = 0; i < num_servants; ++i)
+    {
+        ids.push_back("servant_" + to_string(i));
+    }
+
+    auto time_find = [&](long iterations)
+    {
+        size_t found = 0;
+        auto start = Clock::now();
+        for (long i = 0; i < iterations; ++i)
+        {
+            found += a.find(ids[i % num_servants]) != nullptr;
+        }
+        auto elapsed = chrono::duration_cast<Seconds>(Clock::now() - start);
+        if (found != size_t(iterations))
+        {
+            throw runtime_error("servant not found");
+        }
+        return elapsed;
+    };
+
+    run("adapter.find", time_find);
+    Churner churner(a);
+    run("adapter.find_churn", time_find);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+    {
+        results_dir = argv[1];
+    }
+    if (argc > 2)
+    {
+        filter = argv[2];
+    }
+
+    try
+    {
+        boost::filesystem::create_directories(results_dir);
+
+        auto rt = RuntimeImpl::create("adapter-benchmark", TEST_RUNTIME_FILE);
+        ZmqMiddleware mw("adapter-benchmark", rt.get(), TEST_RUNTIME_PATH "/Zmq.ini");
+        ObjectAdapter a(mw, "adapter-benchmark", endpoint, RequestMode::Twoway, num_workers);
+        a.activate();
+
+        vector<shared_ptr<Servant>> servants;
+        for (int i = 0; i < num_servants; ++i)
+        {
+            servants.push_back(make_shared<Servant>());
+            a.add("servant_" + to_string(i), servants.back());
+        }
+
+        benchmark_util::print_header();
+        bench_dispatch(mw, a);
+        bench_find(a);
+
+        a.shutdown();
+        a.wait_for_shutdown();
+    }
+    catch (std::exception const& e)
+    {
+        cerr << "adapter-benchmark: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
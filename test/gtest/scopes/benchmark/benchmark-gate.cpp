@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+// Saves benchmark results as a baseline, or compares benchmark results against a baseline.
+//
+// Usage: benchmark-gate save <results dir> <baseline file>
+//        benchmark-gate compare [-t threshold_percent] [-a alpha] <results dir> <baseline file> [scenario...]
+//
+// "compare" prints a report and exits with status 1 if a tracked scenario regressed by more
+// than the threshold (default 5%), or if a scenario in the baseline has no result.
+// The alpha value (default 0.05) must be greater than 0 and less than 1.
+// Scenarios are tracked if their name contains one of the scenario arguments; without
+// scenario arguments, all scenarios in the baseline are tracked.
+
+#include "RegressionGate.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+using namespace benchmark_util;
+
+namespace
+{
+
+void print_usage()
+{
+    cerr << "usage: benchmark-gate save <results dir> <baseline file>" << endl
+         << "       benchmark-gate compare [-t threshold_percent] [-a alpha] <results dir> <baseline file> [scenario...]"
+         << endl;
+    exit(2);
+}
+
+double to_number(char const* s)
+{
+    char* end;
+    double d = strtod(s, &end);
+    if (*s == '\0' || *end != '\0' || d <= 0)
+    {
+        print_usage();
+    }
+    return d;
+}
+
+void print_report(vector<Comparison> const& comparisons, GateConfiguration const& config)
+{
+    printf("%-40s %12s %12s %9s  %-6s %s\n", "scenario", "baseline(us)", "current(us)", "change", "stat", "verdict");
+    for (auto const& c : comparisons)
+    {
+        if (c.verdict == Comparison::New || c.verdict == Comparison::Missing)
+        {
+            printf("%-40s %12s %12s %9s  %-6s %s\n", c.scenario.c_str(), "-", "-", "-", "-", verdict_name(c.verdict));
+            continue;
+        }
+        printf("%-40s %12.3f %12.3f %+8.1f%%  %-6s %s\n",
+               c.scenario.c_str(),
+               c.baseline * 1e6,
+               c.current * 1e6,
+               c.change * 100,
+               c.normal ? "mean" : "median",
+               verdict_name(c.verdict));
+    }
+
+    int regressed = 0;
+    int missing = 0;
+    for (auto const& c : comparisons)
+    {
+        regressed += c.verdict == Comparison::Regressed;
+        missing += c.verdict == Comparison::Missing;
+    }
+    printf("%zu scenario(s) compared, threshold %.1f%%, alpha %g: %d regressed, %d missing\n",
+           comparisons.size(), config.threshold * 100, config.alpha, regressed, missing);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        print_usage();
+    }
+    string const mode = argv[1];
+
+    GateConfiguration config;
+    vector<string> args;
+    for (int i = 2; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (mode == "compare" && (arg == "-t" || arg == "-a"))
+        {
+            if (++i == argc)
+            {
+                print_usage();
+            }
+            if (arg == "-t")
+            {
+                config.threshold = to_number(argv[i]) / 100;
+            }
+            else
+            {
+                config.alpha = to_number(argv[i]);
+                if (config.alpha >= 1)
+                {
+                    print_usage();
+                }
+            }
+        }
+        else if (!arg.empty() && arg[0] == '-')
+        {
+            print_usage();
+        }
+        else
+        {
+            args.push_back(arg);
+        }
+    }
+
+    try
+    {
+        if (mode == "save" && args.size() == 2)
+        {
+            auto const results = read_results(args[0]);
+            if (results.empty())
+            {
+                cerr << "benchmark-gate: no results in " << args[0] << endl;
+                return 1;
+            }
+            save_baseline(args[1], results);
+            cout << "benchmark-gate: saved " << results.size() << " scenario(s) to " << args[1] << endl;
+            return 0;
+        }
+        if (mode == "compare" && args.size() >= 2)
+        {
+            auto const results = read_results(args[0]);
+            auto const baseline = load_baseline(args[1]);
+            vector<string> const filter(args.begin() + 2, args.end());
+            auto const comparisons = compare_all(baseline, results, config, filter);
+            print_report(comparisons, config);
+            return failed(comparisons) ? 1 : 0;
+        }
+    }
+    catch (std::exception const& e)
+    {
+        cerr << "benchmark-gate: " << e.what() << endl;
+        return 1;
+    }
+    print_usage();
+}
@@ -0,0 +1,361 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+// End-to-end benchmark of the middleware. A registry runs the scopes in the scopes
+// directory in scoperunner processes, and the benchmark measures from the client side.
+//
+// Each scenario writes its result as a testing::Benchmark::Result in JSON format to
+// <results dir>/<scenario>.json, and the client's own middleware metrics (including
+// the per-operation twoway latencies) go to <results dir>/client-metrics.txt.
+//
+// Usage: scopes-benchmark [gtest options] [results dir]
+
+#include <unity/scopes/CategorisedResult.h>
+#include <unity/scopes/internal/Metrics.h>
+#include <unity/scopes/internal/RuntimeImpl.h>
+#include <unity/scopes/QueryCtrl.h>
+#include <unity/scopes/Registry.h>
+#include <unity/scopes/SearchListenerBase.h>
+#include <unity/scopes/SearchMetadata.h>
+
+#include "BenchmarkUtil.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wctor-dtor-privacy"
+#include <gtest/gtest.h>
+#pragma GCC diagnostic pop
+
+#include <boost/filesystem.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace unity::scopes;
+using namespace unity::scopes::internal;
+
+namespace
+{
+
+typedef chrono::steady_clock Clock;
+using benchmark_util::BenchmarkResult;
+using benchmark_util::Seconds;
+
+string results_dir = TEST_RUNTIME_PATH "/results";
+
+int const iterations = 200;
+
+class Receiver : public SearchListenerBase
+{
+public:
+    Receiver()
+        : query_complete_(false)
+        , result_count_(0)
+    {
+    }
+
+    virtual void push(CategorisedResult /* result */) override
+    {
+        if (result_count_++ == 0)
+        {
+            lock_guard<mutex> lock(mutex_);
+            note_reply();
+        }
+    }
+
+    virtual void finished(CompletionDetails const& details) override
+    {
+        EXPECT_EQ(CompletionDetails::OK, details.status()) << details.message();
+        lock_guard<mutex> lock(mutex_);
+        note_reply();
+        finished_ = Clock::now();
+        query_complete_ = true;
+        cond_.notify_one();
+    }
+
+    void wait_until_finished()
+    {
+        unique_lock<mutex> lock(mutex_);
+        cond_.wait(lock, [this] { return query_complete_; });
+    }
+
+    // Time at which the first result (or, if there were none, the completion) arrived.
+    Clock::time_point first_reply()
+    {
+        lock_guard<mutex> lock(mutex_);
+        return first_reply_;
+    }
+
+    Clock::time_point finished_time()
+    {
+        lock_guard<mutex> lock(mutex_);
+        return finished_;
+    }
+
+    int result_count() const
+    {
+        return result_count_;
+    }
+
+private:
+    void note_reply()
+    {
+        if (first_reply_ == Clock::time_point())
+        {
+            first_reply_ = Clock::now();
+        }
+    }
+
+    bool query_complete_;
+    Clock::time_point first_reply_;
+    Clock::time_point finished_;
+    atomic_int result_count_;
+    mutex mutex_;
+    condition_variable cond_;
+};
+
+// Runs a query to completion and returns the number of results.
+
+int run_query(ScopeProxy const& scope, string const& query_string)
+{
+    auto receiver = make_shared<Receiver>();
+    scope->search(query_string, SearchMetadata("C", "desktop"), receiver);
+    receiver->wait_until_finished();
+    return receiver->result_count();
+}
+
+template<typename F>
+Seconds time_it(F&& f)
+{
+    auto start = Clock::now();
+    f();
+    return chrono::duration_cast<Seconds>(Clock::now() - start);
+}
+
+// Writes the sample for a scenario as a Benchmark::Result and prints a summary.
+
+BenchmarkResult report(string const& scenario, vector<Seconds> const& sample, double results_per_second = 0)
+{
+    auto r = benchmark_util::make_result(sample);
+    EXPECT_NO_THROW(benchmark_util::save_result(results_dir, scenario, r));
+
+    cout << scenario << ": n = " << r.sample_size
+         << ", mean = " << long(r.timing.mean.count() * 1000000) << " us"
+         << ", p50 = " << long(r.timing.percentile(50).count() * 1000000) << " us"
+         << ", p99 = " << long(r.timing.percentile(99).count() * 1000000) << " us";
+    if (results_per_second > 0)
+    {
+        cout << ", " << long(results_per_second) << " results/sec";
+    }
+    cout << endl;
+    return r;
+}
+
+class MiddlewareBenchmark : public ::testing::Test
+{
+public:
+    static void SetUpTestCase()
+    {
+        runtime_ = RuntimeImpl::create("", TEST_RUNTIME_FILE);
+    }
+
+    static void TearDownTestCase()
+    {
+        ofstream out(results_dir + "/client-metrics.txt");
+        out << runtime_->metrics().to_string();
+        runtime_.reset();
+    }
+
+    RegistryProxy registry() const
+    {
+        return runtime_->registry();
+    }
+
+private:
+    static RuntimeImpl::UPtr runtime_;
+};
+
+RuntimeImpl::UPtr MiddlewareBenchmark::runtime_;
+
+}  // namespace
+
+// Registry lookup followed by a query, as a client does it for a scope it hasn't used before.
+
+TEST_F(MiddlewareBenchmark, locate_and_search)
+{
+    auto reg = registry();
+    run_query(reg->get_metadata("Leaf").proxy(), "20");  // Make sure the scope is running.
+
+    vector<Seconds> sample;
+    for (int i = 0; i < iterations; ++i)
+    {
+        sample.push_back(time_it([&]
+        {
+            EXPECT_EQ(20, run_query(reg->get_metadata("Leaf").proxy(), "20"));
+        }));
+    }
+    report("locate_and_search", sample);
+}
+
+// Latency of individual twoway operations, measured by the client.
+//
+// search() returns as soon as the request is queued, so timing the call itself measures
+// nothing useful. For search, we measure from the call until the first result arrives
+// and until the query has finished. (The twoway latency of the search request itself is in
+// the client's middleware metrics.)
+
+TEST_F(MiddlewareBenchmark, twoway_ops)
+{
+    auto reg = registry();
+    auto leaf = reg->get_metadata("Leaf").proxy();
+    run_query(leaf, "0");
+
+    vector<Seconds> get_metadata, list, is_scope_running, search_first_reply, search_finished;
+    for (int i = 0; i < iterations; ++i)
+    {
+        get_metadata.push_back(time_it([&] { reg->get_metadata("Leaf"); }));
+        list.push_back(time_it([&] { reg->list(); }));
+        is_scope_running.push_back(time_it([&] { EXPECT_TRUE(reg->is_scope_running("Leaf")); }));
+
+        auto receiver = make_shared<Receiver>();
+        auto start = Clock::now();
+        leaf->search("1", SearchMetadata("C", "desktop"), receiver);
+        receiver->wait_until_finished();
+        EXPECT_EQ(1, receiver->result_count());
+        search_first_reply.push_back(chrono::duration_cast<Seconds>(receiver->first_reply() - start));
+        search_finished.push_back(chrono::duration_cast<Seconds>(receiver->finished_time() - start));
+    }
+    report("twoway.get_metadata", get_metadata);
+    report("twoway.list", list);
+    report("twoway.is_scope_running", is_scope_running);
+    report("search.first_reply", search_first_reply);
+    report("search.finished", search_finished);
+}
+
+// Rate at which a scope can push results to the client.
+
+TEST_F(MiddlewareBenchmark, push_throughput)
+{
+    int const results_per_query = 5000;
+    int const queries = 10;
+
+    auto leaf = registry()->get_metadata("Leaf").proxy();
+    run_query(leaf, "0");
+
+    vector<Seconds> sample;
+    for (int i = 0; i < queries; ++i)
+    {
+        sample.push_back(time_it([&] { EXPECT_EQ(results_per_query, run_query(leaf, to_string(results_per_query))); }));
+    }
+    auto total = accumulate(sample.begin(), sample.end(), Seconds{0});
+    report("oneway.push", sample, results_per_query * queries / total.count());
+}
+
+// Cost of an aggregator that fans out each query to three subsearches, compared
+// to a query that goes directly to the leaf scope.
+
+TEST_F(MiddlewareBenchmark, aggregator_fan_out)
+{
+    auto reg = registry();
+    auto leaf = reg->get_metadata("Leaf").proxy();
+    auto aggregator = reg->get_metadata("Aggregator").proxy();
+    run_query(leaf, "0");
+    run_query(aggregator, "0");
+
+    vector<Seconds> direct, aggregated;
+    for (int i = 0; i < iterations; ++i)
+    {
+        direct.push_back(time_it([&] { EXPECT_EQ(20, run_query(leaf, "20")); }));
+        aggregated.push_back(time_it([&] { EXPECT_EQ(60, run_query(aggregator, "20")); }));
+    }
+    auto d = report("leaf.search", direct);
+    auto a = report("aggregator.search", aggregated);
+    cout << "aggregator fan-out cost (p50): "
+         << long((a.timing.percentile(50) - d.timing.percentile(50)).count() * 1000000) << " us" << endl;
+}
+
+// Time for the first query on a scope that isn't running, including the time for
+// the registry to start the scope. The ColdStart scope has an idle timeout of one second.
+
+TEST_F(MiddlewareBenchmark, cold_start)
+{
+    int const starts = 10;  // The regression gate ignores samples with fewer than 10 entries.
+
+    auto reg = registry();
+    auto cold = reg->get_metadata("ColdStart").proxy();
+
+    vector<Seconds> sample;
+    for (int i = 0; i < starts; ++i)
+    {
+        // Wait for the scope to shut down.
+        auto deadline = Clock::now() + chrono::seconds(10);
+        while (reg->is_scope_running("ColdStart") && Clock::now() < deadline)
+        {
+            this_thread::sleep_for(chrono::milliseconds(100));
+        }
+        ASSERT_FALSE(reg->is_scope_running("ColdStart"));
+
+        sample.push_back(time_it([&] { EXPECT_EQ(20, run_query(cold, "20")); }));
+    }
+    report("cold_start", sample);
+}
+
+int main(int argc, char* argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    if (argc > 1)
+    {
+        results_dir = argv[1];
+    }
+    boost::filesystem::create_directories(results_dir);
+
+    int rc = 0;
+    auto rpid = fork();
+    if (rpid == 0)
+    {
+        const char* const args[] = {"scoperegistry [Benchmark]", TEST_RUNTIME_FILE, nullptr};
+        if (execv(TEST_REGISTRY_PATH "/scoperegistry", const_cast<char* const*>(args)) < 0)
+        {
+            perror("Error starting scoperegistry:");
+        }
+        return 1;
+    }
+    else if (rpid > 0)
+    {
+        rc = RUN_ALL_TESTS();
+
+        kill(rpid, SIGTERM);
+        waitpid(rpid, nullptr, 0);
+    }
+    else
+    {
+        perror("Failed to fork:");
+    }
+
+    return rc;
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/CategorisedResult.h>
+#include <unity/scopes/ScopeBase.h>
+#include <unity/scopes/SearchReply.h>
+
+#include <unity/UnityExceptions.h>
+
+#include <atomic>
+
+using namespace std;
+using namespace unity::scopes;
+
+namespace
+{
+
+int const fan_out = 3;  // Number of subsearches per query, all of them on scope "Leaf".
+
+// Forwards results from a subsearch. The last receiver to finish finishes the upstream query.
+
+class Receiver : public SearchListenerBase
+{
+public:
+    Receiver(SearchReplyProxy const& upstream, shared_ptr<atomic_int> const& outstanding)
+        : upstream_(upstream)
+        , outstanding_(outstanding)
+    {
+    }
+
+    virtual void push(Category::SCPtr const& category) override
+    {
+        try
+        {
+            upstream_->register_category(category);
+        }
+        catch (unity::InvalidArgumentException const&)
+        {
+            // Category was registered by another subsearch already.
+        }
+    }
+
+    virtual void push(CategorisedResult result) override
+    {
+        upstream_->push(std::move(result));
+    }
+
+    virtual void finished(CompletionDetails const& /* details */) override
+    {
+        if (--*outstanding_ == 0)
+        {
+            upstream_->finished();
+        }
+    }
+
+private:
+    SearchReplyProxy upstream_;
+    shared_ptr<atomic_int> outstanding_;
+};
+
+class AggregatorQuery : public SearchQueryBase
+{
+public:
+    AggregatorQuery(CannedQuery const& query, SearchMetadata const& metadata, ScopeProxy const& leaf_proxy)
+        : SearchQueryBase(query, metadata)
+        , leaf_proxy_(leaf_proxy)
+    {
+    }
+
+    virtual void cancelled() override
+    {
+    }
+
+    virtual void run(SearchReplyProxy const& reply) override
+    {
+        auto outstanding = make_shared<atomic_int>(fan_out);
+        for (int i = 0; i < fan_out; ++i)
+        {
+            subsearch(leaf_proxy_, query().query_string(), make_shared<Receiver>(reply, outstanding));
+        }
+    }
+
+private:
+    ScopeProxy leaf_proxy_;
+};
+
+class AggregatorScope : public ScopeBase
+{
+public:
+    virtual void start(string const&) override
+    {
+        leaf_proxy_ = registry()->get_metadata("Leaf").proxy();
+    }
+
+    virtual SearchQueryBase::UPtr search(CannedQuery const& query, SearchMetadata const& metadata) override
+    {
+        return SearchQueryBase::UPtr(new AggregatorQuery(query, metadata, leaf_proxy_));
+    }
+
+    virtual PreviewQueryBase::UPtr preview(Result const&, ActionMetadata const&) override
+    {
+        return nullptr;  // unused
+    }
+
+private:
+    ScopeProxy leaf_proxy_;
+};
+
+}  // namespace
+
+extern "C" {
+
+ScopeBase*
+// cppcheck-suppress unusedFunction
+UNITY_SCOPE_CREATE_FUNCTION()
+{
+    return new AggregatorScope;
+}
+
+void
+// cppcheck-suppress unusedFunction
+UNITY_SCOPE_DESTROY_FUNCTION(ScopeBase* scope_base)
+{
+    delete scope_base;
+}
+}
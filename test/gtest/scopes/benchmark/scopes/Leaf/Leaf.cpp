@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/CategorisedResult.h>
+#include <unity/scopes/ScopeBase.h>
+#include <unity/scopes/SearchReply.h>
+
+#include <cstdlib>
+
+using namespace std;
+using namespace unity::scopes;
+
+namespace
+{
+
+// Pushes as many results as the query string says (20 if the query string is empty).
+
+class LeafQuery : public SearchQueryBase
+{
+public:
+    LeafQuery(CannedQuery const& query, SearchMetadata const& metadata)
+        : SearchQueryBase(query, metadata)
+    {
+    }
+
+    virtual void cancelled() override
+    {
+    }
+
+    virtual void run(SearchReplyProxy const& reply) override
+    {
+        string const& q = query().query_string();
+        int const count = q.empty() ? 20 : atoi(q.c_str());
+
+        auto cat = reply->register_category("cat1", "Category 1", "");
+        for (int i = 0; i < count; ++i)
+        {
+            CategorisedResult res(cat);
+            res.set_uri("uri" + to_string(i));
+            res.set_title("title " + to_string(i));
+            res.set_art("art");
+            res.set_dnd_uri("dnd_uri");
+            if (!reply->push(res))
+            {
+                return;
+            }
+        }
+    }
+};
+
+class LeafScope : public ScopeBase
+{
+public:
+    virtual SearchQueryBase::UPtr search(CannedQuery const& query, SearchMetadata const& metadata) override
+    {
+        return SearchQueryBase::UPtr(new LeafQuery(query, metadata));
+    }
+
+    virtual PreviewQueryBase::UPtr preview(Result const&, ActionMetadata const&) override
+    {
+        return nullptr;  // unused
+    }
+};
+
+}  // namespace
+
+extern "C" {
+
+ScopeBase*
+// cppcheck-suppress unusedFunction
+UNITY_SCOPE_CREATE_FUNCTION()
+{
+    return new LeafScope;
+}
+
+void
+// cppcheck-suppress unusedFunction
+UNITY_SCOPE_DESTROY_FUNCTION(ScopeBase* scope_base)
+{
+    delete scope_base;
+}
+}
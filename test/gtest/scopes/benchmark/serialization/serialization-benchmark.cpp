@@ -0,0 +1,429 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+// Microbenchmarks for the serialization code on the query hot path: results, categories
+// and filters to and from VariantMap, VariantMap to and from capnproto, and JSON.
+// Also measures the cost of an IPC trace statement, with the IPC channel disabled and enabled,
+// the decoding of the lines of a streamed smart scopes server response, and building a search URI.
+//
+// Each benchmark runs a number of trials of enough iterations to take at least
+// 10 ms, and reports the per-operation time of the trials in ns. Each benchmark's
+// result is also written as a testing::Benchmark::Result in JSON format to
+// <results dir>/<name>.json.
+//
+// Usage: serialization-benchmark [results dir] [name filter]
+
+#include <unity/scopes/CategorisedResult.h>
+#include <unity/scopes/CategoryRenderer.h>
+#include <unity/scopes/internal/CategorisedResultImpl.h>
+#include <unity/scopes/internal/CategoryRegistry.h>
+#include <unity/scopes/internal/FilterBaseImpl.h>
+#include <unity/scopes/internal/JsonCppNode.h>
+#include <unity/scopes/internal/Logger.h>
+#include <unity/scopes/internal/smartscopes/HttpClientNetCpp.h>
+#include <unity/scopes/internal/smartscopes/JsonLineDecoder.h>
+#include <unity/scopes/internal/smartscopes/UriBuilder.h>
+#include <unity/scopes/internal/zmq_middleware/VariantConverter.h>
+#include <unity/scopes/OptionSelectorFilter.h>
+#include <unity/scopes/RangeInputFilter.h>
+#include <unity/scopes/RatingFilter.h>
+
+#include <scopes/internal/zmq_middleware/capnproto/ValueDict.capnp.h>
+
+#include "BenchmarkUtil.h"
+
+#include <boost/filesystem.hpp>
+#include <capnp/message.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+using namespace std;
+using namespace unity::scopes;
+using namespace unity::scopes::internal;
+using namespace unity::scopes::internal::smartscopes;
+using namespace unity::scopes::internal::zmq_middleware;
+
+namespace
+{
+
+typedef chrono::steady_clock Clock;
+using benchmark_util::Seconds;
+
+int const trials = 25;
+chrono::milliseconds const min_trial_time(10);
+
+string results_dir = "results";
+string filter;
+
+volatile size_t sink;  // Keeps the compiler from optimizing away the benchmarked operations.
+
+Seconds time_iterations(function<void()> const& op, long iterations)
+{
+    auto start = Clock::now();
+    for (long i = 0; i < iterations; ++i)
+    {
+        op();
+    }
+    return chrono::duration_cast<Seconds>(Clock::now() - start);
+}
+
+void run_trials(string const& name, function<Seconds(long)> const& trial)
+{
+    if (name.find(filter) == string::npos)
+    {
+        return;
+    }
+
+    auto r = benchmark_util::make_result(benchmark_util::measure(trial, trials, min_trial_time));
+    benchmark_util::save_result(results_dir, name, r);
+    benchmark_util::print_row(name, r);
+}
+
+void run(string const& name, function<void()> const& op)
+{
+    run_trials(name, [&op](long iterations) { return time_iterations(op, iterations); });
+}
+
+// Runs op(thread_index, iteration) in num_threads threads at once. The reported time per operation
+// is the inverse of the throughput.
+
+void run_concurrently(string const& name, int num_threads, function<void(int, long)> const& op)
+{
+    run_trials(name, [num_threads, &op](long iterations)
+    {
+        return benchmark_util::time_concurrently(num_threads, iterations, op);
+    });
+}
+
+string text(size_t len)
+{
+    string s;
+    while (s.size() < len)
+    {
+        s += "The quick brown fox jumps over the lazy dog. ";
+    }
+    return s.substr(0, len);
+}
+
+// Result shapes, from a bare result to one with many and nested attributes.
+
+CategorisedResult small_result(Category::SCPtr const& cat)
+{
+    CategorisedResult r(cat);
+    r.set_uri("http://www.example.com/item/12345");
+    r.set_title("Item 12345");
+    return r;
+}
+
+CategorisedResult medium_result(Category::SCPtr const& cat)
+{
+    CategorisedResult r(cat);
+    r.set_uri("http://www.example.com/item/12345");
+    r.set_title("Item 12345");
+    r.set_art("http://www.example.com/images/12345.jpg");
+    r.set_dnd_uri("http://www.example.com/item/12345?dnd");
+    r["subtitle"] = Variant("by Some Author");
+    r["description"] = Variant(text(200));
+    r["price"] = Variant(12.99);
+    r["rating"] = Variant(4);
+    return r;
+}
+
+CategorisedResult rich_result(Category::SCPtr const& cat)
+{
+    CategorisedResult r = medium_result(cat);
+    for (int i = 0; i < 10; ++i)
+    {
+        r["string_attr" + to_string(i)] = Variant(text(40));
+        r["int_attr" + to_string(i)] = Variant(i * 1000);
+        r["bool_attr" + to_string(i)] = Variant(i % 2 == 0);
+    }
+    return r;
+}
+
+CategorisedResult nested_result(Category::SCPtr const& cat)
+{
+    CategorisedResult r = medium_result(cat);
+
+    VariantArray attributes;
+    for (int i = 0; i < 5; ++i)
+    {
+        VariantMap attr;
+        attr["value"] = Variant(text(20));
+        attr["icon"] = Variant("http://www.example.com/icons/" + to_string(i) + ".png");
+        attributes.push_back(Variant(attr));
+    }
+    r["attributes"] = Variant(attributes);
+
+    VariantMap level3;
+    level3["tags"] = Variant(VariantArray{ Variant("a"), Variant("b"), Variant("c"), Variant(1), Variant(2.5) });
+    level3["note"] = Variant(text(60));
+    VariantMap level2;
+    level2["level3"] = Variant(level3);
+    level2["count"] = Variant(int64_t(1) << 40);
+    VariantMap level1;
+    level1["level2"] = Variant(level2);
+    level1["emblem"] = Variant("http://www.example.com/emblem.png");
+    r["details"] = Variant(level1);
+    return r;
+}
+
+Filters make_filters()
+{
+    Filters filters;
+
+    auto departments = OptionSelectorFilter::create("dept", "Department", true);
+    for (int i = 0; i < 10; ++i)
+    {
+        departments->add_option("dept" + to_string(i), "Department " + to_string(i));
+    }
+    filters.push_back(move(departments));
+
+    auto rating = experimental::RatingFilter::create("rating", "Rating", 5);
+    filters.push_back(move(rating));
+
+    filters.push_back(RangeInputFilter::create("price", "From", "", "to", "", ""));
+    return filters;
+}
+
+void bench_result(string const& shape, CategoryRegistry const& reg, CategorisedResult const& result)
+{
+    string const prefix = "result." + shape + ".";
+
+    run(prefix + "serialize", [&] { sink += result.serialize().size(); });
+
+    VariantMap const vm = result.serialize();
+    run(prefix + "deserialize", [&] { sink += CategorisedResultImpl(reg, vm).uri().size(); });
+
+    run(prefix + "to_value_dict", [&]
+    {
+        capnp::MallocMessageBuilder message;
+        auto dict = message.initRoot<capnproto::ValueDict>();
+        to_value_dict(vm, dict);
+        sink += message.getSegmentsForOutput().size();
+    });
+
+    capnp::MallocMessageBuilder message;
+    auto dict = message.initRoot<capnproto::ValueDict>();
+    to_value_dict(vm, dict);
+    auto reader = dict.asReader();
+    run(prefix + "to_variant_map", [&] { sink += to_variant_map(reader).size(); });
+
+    Variant const v(vm);
+    run(prefix + "serialize_json", [&] { sink += v.serialize_json().size(); });
+
+    string const json = v.serialize_json();
+    run(prefix + "deserialize_json", [&] { sink += Variant::deserialize_json(json).get_dict().size(); });
+}
+
+// A trace statement such as the IPC trace in ZmqObjectProxy. With the channel disabled,
+// the message is formatted eagerly (as with l(channel) << ...) and lazily (as with UNITY_SCOPES_LOG).
+
+void bench_logger()
+{
+    ostream null_stream(nullptr);  // Discards everything
+    Logger l("bench", null_stream);
+    string const op_name = "search";
+    string const id = "c5b8bd02-7e5a-4d1c-a0a7-d2f0ae6a7b4f";
+
+    auto decode = [&]
+    {
+        stringstream s;
+        s << "op = " << op_name << ", id = " << id << ", cat = " << "" << ", mode = " << "twoway";
+        return s.str();
+    };
+
+    run("logger.ipc_trace_disabled_eager", [&] { l(LoggerChannel::IPC) << "sending request: " << decode(); });
+    run("logger.ipc_trace_disabled", [&]
+    {
+        UNITY_SCOPES_LOG(l, LoggerChannel::IPC) << "sending request: " << decode();
+    });
+    l.set_channel(LoggerChannel::IPC, true);
+    run("logger.ipc_trace_enabled", [&]
+    {
+        UNITY_SCOPES_LOG(l, LoggerChannel::IPC) << "sending request: " << decode();
+    });
+}
+
+// Extracts the result from each line of a recorded smart scopes server response in several threads
+// at once, as concurrent queries in smartscopesproxy do: first with a single JsonCppNode behind
+// a mutex (as SmartScopesClient::handle_line() used to), then with a JsonLineDecoder per line.
+
+void bench_json_lines()
+{
+    vector<string> lines;
+    {
+        ifstream f(RECORDED_SEARCH_FILE);
+        string line;
+        while (getline(f, line))
+        {
+            lines.push_back(line);
+        }
+    }
+    if (lines.empty())
+    {
+        throw runtime_error("cannot read " RECORDED_SEARCH_FILE);
+    }
+    int const num_threads = 4;
+
+    mutex m;
+    JsonCppNode shared_node;
+    run_concurrently("json_line.shared_json_cpp_node", num_threads, [&](int, long i)
+    {
+        JsonNodeInterface::SPtr root;
+        {
+            lock_guard<mutex> lock(m);
+            shared_node.read_json(lines[i % lines.size()]);
+            root = shared_node.get_node();
+        }
+        if (root->has_node("result"))
+        {
+            auto result = root->get_node("result");
+            VariantMap params;
+            sink += result->to_json_string().size();
+            for (auto const& member : result->member_names())
+            {
+                params[member] = result->get_node(member)->to_variant();
+            }
+            sink += params.size();
+        }
+    });
+
+    run_concurrently("json_line.decoder", num_threads, [&](int, long i)
+    {
+        JsonLineDecoder d(lines[i % lines.size()]);
+        d.begin_object();
+        string name;
+        if (d.next_member(name) && name == "result")
+        {
+            auto mark = d.mark();
+            d.begin_object();
+            VariantMap params;
+            while (d.next_member(name))
+            {
+                params[name] = d.value();
+            }
+            sink += d.text_since(mark).size() + params.size();
+        }
+        else
+        {
+            d.skip_value();
+        }
+    });
+}
+
+// Builds a typical search URI, the way SmartScopesClient::search() used to (with a locale-imbued
+// ostringstream and the HTTP client's encoder), and with UriBuilder.
+
+void bench_search_uri()
+{
+    HttpClientNetCpp http_client(20000);
+
+    string const base_url = "https://dash.ubuntu.com/smartscopes/v2/scopes/com.canonical.scopes.amazon";
+    string const query = "the quick brown fox";
+    string const session_id = "c5b8bd02-7e5a-4d1c-a0a7-d2f0ae6a7b4f";
+    string const settings = "{\"units\":\"metric\",\"days\":7,\"safe_search\":true}";
+    string const filters = "{\"dept\":[\"books\",\"music\"],\"rating\":4}";
+    int64_t query_id = 0;
+
+    run("search_uri.ostringstream", [&]
+    {
+        ostringstream uri;
+        uri.imbue(locale::classic());
+        uri << base_url << "/search" << "?";
+        uri << "q=" << http_client.to_percent_encoding(query);
+        uri << "&session_id=" << http_client.to_percent_encoding(session_id);
+        uri << "&query_id=" << to_string(++query_id);
+        uri << "&platform=" << "phone";
+        uri << "&settings=" << http_client.to_percent_encoding(settings);
+        uri << "&locale=" << "en_GB";
+        uri << "&country=" << "GB";
+        uri << fixed << setprecision(5) << "&latitude=" << 51.507312 << "&longitude=" << -0.127634;
+        uri << "&filters=" << http_client.to_percent_encoding(filters);
+        sink += uri.str().size();
+    });
+
+    // As in SmartScopesClient, the encoded settings are reused from one query to the next.
+    string const encoded_settings = UriBuilder::percent_encode(settings);
+    run("search_uri.uri_builder", [&]
+    {
+        UriBuilder uri(base_url, "/search");
+        uri.param("q", query);
+        uri.param("session_id", session_id);
+        uri.param("query_id", ++query_id);
+        uri.raw_param("platform", "phone");
+        uri.raw_param("settings", encoded_settings);
+        uri.raw_param("locale", "en_GB");
+        uri.raw_param("country", "GB");
+        uri.param("latitude", 51.507312, 5);
+        uri.param("longitude", -0.127634, 5);
+        uri.param("filters", filters);
+        sink += uri.str().size();
+    });
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+    {
+        results_dir = argv[1];
+    }
+    if (argc > 2)
+    {
+        filter = argv[2];
+    }
+
+    try
+    {
+        boost::filesystem::create_directories(results_dir);
+
+        CategoryRegistry reg;
+        auto cat = reg.register_category("cat1", "Category 1", "icon", nullptr, CategoryRenderer());
+
+        benchmark_util::print_header();
+
+        bench_result("small", reg, small_result(cat));
+        bench_result("medium", reg, medium_result(cat));
+        bench_result("rich", reg, rich_result(cat));
+        bench_result("nested", reg, nested_result(cat));
+
+        run("category.serialize", [&] { sink += cat->serialize().size(); });
+
+        Filters const filters = make_filters();
+        run("filters.serialize_filters", [&] { sink += FilterBaseImpl::serialize_filters(filters).size(); });
+
+        bench_logger();
+        bench_json_lines();
+        bench_search_uri();
+    }
+    catch (std::exception const& e)
+    {
+        cerr << "serialization-benchmark: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
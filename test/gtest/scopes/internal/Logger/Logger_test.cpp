@@ -27,6 +27,9 @@
 
 #include <unity/UnityExceptions.h>
 
+#include <condition_variable>
+#include <thread>
+
 using namespace std;
 using namespace unity::scopes::internal;
 
@@ -102,9 +105,53 @@ TEST(Logger, channel)
         EXPECT_FALSE(l.set_channel("IPC", true));
         l(LoggerChannel::IPC) << "x";
         EXPECT_TRUE(boost::ends_with(s.str(), "] IPC: me: x\n")) << s.str();
+
+        EXPECT_FALSE(l.set_channel("Profile", true));
+        l(LoggerChannel::Profile) << "p";
+        EXPECT_TRUE(boost::ends_with(s.str(), "] Profile: me: p\n")) << s.str();
     }
 }
 
+TEST(Logger, enabled)
+{
+    ostringstream s;
+    Logger l("me", s);
+
+    EXPECT_TRUE(l.enabled(LoggerSeverity::Info));
+    EXPECT_TRUE(l.enabled(LoggerChannel::DefaultChannel));
+    EXPECT_FALSE(l.enabled(LoggerChannel::IPC));
+
+    l.set_severity_threshold(LoggerSeverity::Error);
+    EXPECT_FALSE(l.enabled(LoggerSeverity::Warning));
+    EXPECT_TRUE(l.enabled(LoggerSeverity::Error));
+    EXPECT_TRUE(l.enabled(LoggerSeverity::Fatal));
+
+    // Operands are evaluated only if the message is logged.
+    int calls = 0;
+    auto expensive = [&calls] { ++calls; return "x"; };
+
+    UNITY_SCOPES_LOG(l, LoggerChannel::IPC) << expensive();
+    UNITY_SCOPES_LOG(l, LoggerSeverity::Info) << expensive();
+    EXPECT_EQ(0, calls);
+    EXPECT_TRUE(s.str().empty()) << s.str();
+
+    l.set_channel(LoggerChannel::IPC, true);
+    UNITY_SCOPES_LOG(l, LoggerChannel::IPC) << "a" << expensive();
+    EXPECT_EQ(1, calls);
+    EXPECT_TRUE(boost::ends_with(s.str(), "] IPC: me: ax\n")) << s.str();
+
+    UNITY_SCOPES_LOG(l, LoggerSeverity::Error) << "b" << expensive();
+    EXPECT_EQ(2, calls);
+    EXPECT_TRUE(boost::ends_with(s.str(), "] ERROR: me: bx\n")) << s.str();
+
+    // The macro is a single statement.
+    if (calls == 0)
+        UNITY_SCOPES_LOG(l, LoggerSeverity::Error) << "not logged";
+    else
+        ++calls;
+    EXPECT_EQ(3, calls);
+}
+
 TEST(Logger, move)
 {
     // Logger move constructor.
@@ -170,3 +217,157 @@ TEST(Logger, bad_channel)
         }
     }
 }
+
+TEST(Logger, timestamp)
+{
+    string ts = Logger::timestamp();
+    ASSERT_EQ(23u, ts.size()) << ts;
+    EXPECT_EQ('-', ts[4]);
+    EXPECT_EQ(' ', ts[10]);
+    EXPECT_EQ(':', ts[16]);
+    EXPECT_EQ('.', ts[19]);
+    EXPECT_TRUE(isdigit(ts[22]));
+}
+
+TEST(Logger, async)
+{
+    ostringstream s;
+    Logger l("me", s);
+    l.flush();  // No-op for a synchronous logger
+    l.enable_async(16);
+    EXPECT_THROW(l.enable_async(16), unity::LogicException);
+
+    l() << "hello";
+    l(LoggerSeverity::Warning) << "world";
+    l.flush();
+    vector<string> lines;
+    string output = s.str();
+    boost::split(lines, output, boost::is_any_of("\n"));
+    ASSERT_EQ(3u, lines.size()) << output;
+    EXPECT_TRUE(boost::ends_with(lines[0], "] ERROR: me: hello")) << output;
+    EXPECT_TRUE(boost::ends_with(lines[1], "] WARNING: me: world")) << output;
+    EXPECT_EQ("", lines[2]);
+
+    // Messages written before the logger goes away still appear.
+    {
+        ostringstream s2;
+        {
+            Logger l2("me", s2);
+            l2.enable_async(16);
+            l2() << "last words";
+        }
+        EXPECT_TRUE(boost::ends_with(s2.str(), "] ERROR: me: last words\n")) << s2.str();
+    }
+}
+
+TEST(Logger, async_threads)
+{
+    int const num_threads = 8;
+    int const num_msgs = 2000;
+
+    ostringstream s;
+    Logger l("me", s);
+    l.enable_async(num_msgs);  // Large enough for nothing to be dropped
+
+    vector<thread> threads;
+    for (int i = 0; i < num_threads; ++i)
+    {
+        threads.emplace_back([&l, i]
+        {
+            for (int j = 0; j < num_msgs; ++j)
+            {
+                l() << i << " " << j;
+            }
+        });
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    l.flush();
+
+    // Every message must be complete, and messages from each thread must be in order.
+    vector<int> next(num_threads, 0);
+    istringstream in(s.str());
+    string line;
+    while (getline(in, line))
+    {
+        auto pos = line.find("] ERROR: me: ");
+        ASSERT_NE(string::npos, pos) << line;
+        istringstream msg(line.substr(pos + strlen("] ERROR: me: ")));
+        int i, j;
+        msg >> i >> j;
+        ASSERT_TRUE(i >= 0 && i < num_threads) << line;
+        ASSERT_EQ(next[i], j) << line;
+        ++next[i];
+    }
+    for (int i = 0; i < num_threads; ++i)
+    {
+        EXPECT_EQ(num_msgs, next[i]);
+    }
+}
+
+namespace
+{
+
+// Stream buffer that blocks the first write until release() is called.
+
+class BlockingBuf : public stringbuf
+{
+public:
+    void wait_until_blocked()
+    {
+        unique_lock<mutex> lock(m_);
+        c_.wait(lock, [this] { return blocked_; });
+    }
+
+    void release()
+    {
+        lock_guard<mutex> lock(m_);
+        released_ = true;
+        c_.notify_all();
+    }
+
+protected:
+    streamsize xsputn(char const* s, streamsize n) override
+    {
+        {
+            unique_lock<mutex> lock(m_);
+            blocked_ = true;
+            c_.notify_all();
+            c_.wait(lock, [this] { return released_; });
+        }
+        return stringbuf::xsputn(s, n);
+    }
+
+private:
+    mutex m_;
+    condition_variable c_;
+    bool blocked_ = false;
+    bool released_ = false;
+};
+
+}  // namespace
+
+TEST(Logger, async_overflow)
+{
+    BlockingBuf buf;
+    ostream s(&buf);
+    Logger l("me", s);
+    l.enable_async(16);
+
+    l() << "first";
+    buf.wait_until_blocked();  // The flusher is stuck writing the first message.
+
+    for (int i = 0; i < 100; ++i)
+    {
+        l() << "msg " << i;
+    }
+    buf.release();
+    l.flush();
+
+    string output = buf.str();
+    EXPECT_NE(string::npos, output.find("] ERROR: me: msg 15\n")) << output;
+    EXPECT_EQ(string::npos, output.find("] ERROR: me: msg 16\n")) << output;
+    EXPECT_NE(string::npos, output.find("] WARNING: me: log queue overflow: 84 message(s) dropped\n")) << output;
+}
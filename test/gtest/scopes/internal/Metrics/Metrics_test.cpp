@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/Metrics.h>
+
+#include <unity/UnityExceptions.h>
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace unity::scopes::internal;
+
+TEST(Metrics, counter)
+{
+    MetricsRegistry m;
+    auto& c = m.counter("c");
+    EXPECT_EQ(0, c.value());
+    c.inc();
+    c.inc(5);
+    EXPECT_EQ(6, c.value());
+    EXPECT_EQ(&c, &m.counter("c"));  // Same name, same counter
+}
+
+TEST(Metrics, gauge)
+{
+    MetricsRegistry m;
+    auto& g = m.gauge("g");
+    g.set(10);
+    g.add(-3);
+    EXPECT_EQ(7, g.value());
+    EXPECT_EQ(&g, &m.gauge("g"));
+
+    int64_t v = 42;
+    m.gauge_fn("f", [&v]{ return v; });
+    EXPECT_EQ("gauge f 42\ngauge g 7\n", m.to_string());
+    v = 1;
+    EXPECT_EQ("gauge f 1\ngauge g 7\n", m.to_string());
+
+    m.gauge_fn("f", []{ return int64_t(99); });  // Replaces the previous function
+    EXPECT_EQ("gauge f 99\ngauge g 7\n", m.to_string());
+}
+
+TEST(Metrics, name_clash)
+{
+    MetricsRegistry m;
+    m.counter("x");
+    try
+    {
+        m.gauge("x");
+        FAIL();
+    }
+    catch (unity::LogicException const& e)
+    {
+        EXPECT_STREQ("unity::LogicException: MetricsRegistry: cannot add gauge \"x\": "
+                     "name is in use for a different metric",
+                     e.what());
+    }
+    EXPECT_THROW(m.histogram("x"), unity::LogicException);
+    EXPECT_THROW(m.gauge_fn("x", []{ return int64_t(0); }), unity::LogicException);
+
+    m.gauge_fn("y", []{ return int64_t(0); });
+    EXPECT_THROW(m.counter("y"), unity::LogicException);
+}
+
+TEST(Metrics, buckets)
+{
+    typedef MetricsRegistry::Histogram H;
+
+    // Small values have a bucket each.
+    for (int64_t v = 0; v < 8; ++v)
+    {
+        EXPECT_EQ(v, H::bucket_index(v));
+        EXPECT_EQ(v, H::bucket_upper_bound(H::bucket_index(v)));
+    }
+    EXPECT_EQ(0, H::bucket_index(-1));
+
+    // Every value lies in its bucket, and buckets are contiguous and
+    // no wider than 1/8 of their lower bound.
+    for (int64_t v : { int64_t(8), int64_t(9), int64_t(15), int64_t(16), int64_t(100), int64_t(1000),
+                       int64_t(123456), int64_t(1) << 40, (int64_t(1) << 40) + 12345, INT64_MAX })
+    {
+        int i = H::bucket_index(v);
+        ASSERT_LT(i, H::num_buckets);
+        int64_t upper = H::bucket_upper_bound(i);
+        int64_t lower = H::bucket_upper_bound(i - 1) + 1;
+        EXPECT_LE(lower, v);
+        EXPECT_GE(upper, v);
+        EXPECT_LE(upper - lower + 1, lower / 8 + 1);
+    }
+    EXPECT_EQ(H::num_buckets - 1, H::bucket_index(INT64_MAX));
+    EXPECT_EQ(INT64_MAX, H::bucket_upper_bound(H::num_buckets - 1));
+
+    // The buckets cover all values without gaps.
+    for (int i = 1; i < H::num_buckets; ++i)
+    {
+        ASSERT_EQ(i, H::bucket_index(H::bucket_upper_bound(i - 1) + 1));
+    }
+}
+
+TEST(Metrics, histogram)
+{
+    MetricsRegistry m;
+    auto& h = m.histogram("h");
+    EXPECT_EQ(0, h.count());
+    EXPECT_EQ(0, h.percentile(50));
+
+    for (int v = 1; v <= 1000; ++v)
+    {
+        h.record(int64_t(v));
+    }
+    EXPECT_EQ(1000, h.count());
+    EXPECT_EQ(500500, h.sum());
+    EXPECT_EQ(1000, h.max());
+
+    // Percentiles are accurate to within the bucket width.
+    for (double p : { 1.0, 50.0, 90.0, 99.0 })
+    {
+        int64_t expected = int64_t(p * 10);
+        int64_t actual = h.percentile(p);
+        EXPECT_GE(actual, expected);
+        EXPECT_LE(actual, expected + expected / 8 + 1);
+    }
+    EXPECT_EQ(1000, h.percentile(100));  // Capped at the largest value
+    EXPECT_EQ(1, h.percentile(0));
+
+    h.record(int64_t(-5));  // Counts as zero
+    EXPECT_EQ(1001, h.count());
+    EXPECT_EQ(500500, h.sum());
+
+    h.record(chrono::milliseconds(2));
+    EXPECT_EQ(2000, h.max());
+
+    {
+        MetricsRegistry::Timer t(h);
+    }
+    EXPECT_EQ(1003, h.count());
+}
+
+TEST(Metrics, to_string)
+{
+    MetricsRegistry m;
+    m.counter("b.count").inc(3);
+    m.gauge("a.gauge").set(-2);
+    auto& h = m.histogram("c.latency_us");
+    h.record(int64_t(4));
+    h.record(int64_t(6));
+
+    EXPECT_EQ("gauge a.gauge -2\n"
+              "counter b.count 3\n"
+              "histogram c.latency_us count=2 mean=5 p50=4 p90=6 p99=6 max=6\n",
+              m.to_string());
+}
+
+TEST(Metrics, threads)
+{
+    MetricsRegistry m;
+    int const num_threads = 8;
+    int const iterations = 100000;
+
+    vector<thread> threads;
+    for (int i = 0; i < num_threads; ++i)
+    {
+        threads.emplace_back([&m, i]
+        {
+            // Each thread looks up the metrics by name, as callers on different threads would.
+            auto& c = m.counter("c");
+            auto& h = m.histogram("h");
+            for (int j = 0; j < iterations; ++j)
+            {
+                c.inc();
+                h.record(int64_t(i));
+            }
+        });
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    EXPECT_EQ(num_threads * iterations, m.counter("c").value());
+    EXPECT_EQ(num_threads * iterations, m.histogram("h").count());
+    EXPECT_EQ(num_threads - 1, m.histogram("h").max());
+}
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/Profiling.h>
+
+#include <gtest/gtest.h>
+
+#include <condition_variable>
+#include <future>
+#include <thread>
+#include <type_traits>
+
+using namespace std;
+using namespace unity::scopes::internal;
+
+namespace
+{
+
+class ProfilingTest : public ::testing::Test
+{
+protected:
+    void TearDown() override
+    {
+        QueryProfile::enable(false);
+    }
+};
+
+// Locks m on another thread and keeps it locked for hold_time, then calls m.lock().
+
+void lock_contended(ProfiledMutex& m, chrono::milliseconds hold_time)
+{
+    promise<void> locked;
+    thread t([&]
+    {
+        lock_guard<ProfiledMutex> lock(m);
+        locked.set_value();
+        this_thread::sleep_for(hold_time);
+    });
+    locked.get_future().wait();
+    {
+        lock_guard<ProfiledMutex> lock(m);
+    }
+    t.join();
+}
+
+} // namespace
+
+TEST_F(ProfilingTest, disabled)
+{
+    EXPECT_FALSE(QueryProfile::enabled());
+
+    ProfiledMutex m(ProfiledMutex::Reply);
+    auto const waits = ProfiledMutex::waits(ProfiledMutex::Reply);
+
+    QueryProfile p;
+    {
+        QueryProfile::Recorder r(p);
+        lock_contended(m, chrono::milliseconds(20));
+        QueryProfile::count_allocation(100);
+    }
+    EXPECT_FALSE(p.recorded());
+    EXPECT_EQ(0, p.lock_waits());
+    EXPECT_EQ(0, p.allocations());
+    EXPECT_EQ(waits, ProfiledMutex::waits(ProfiledMutex::Reply));
+}
+
+TEST_F(ProfilingTest, lock_wait)
+{
+    QueryProfile::enable(true);
+
+    ProfiledMutex m(ProfiledMutex::Adapter);
+    auto const waits = ProfiledMutex::waits(ProfiledMutex::Adapter);
+    auto const wait_us = ProfiledMutex::wait_us(ProfiledMutex::Adapter);
+
+    QueryProfile p;
+    {
+        QueryProfile::Recorder r(p);
+
+        // Uncontended locks don't count.
+        m.lock();
+        m.unlock();
+        EXPECT_TRUE(m.try_lock());
+        m.unlock();
+
+        lock_contended(m, chrono::milliseconds(50));
+    }
+    EXPECT_TRUE(p.recorded());
+    if (!ProfiledMutex::compiled_in())
+    {
+        // ProfiledMutex is a plain std::mutex.
+        EXPECT_EQ(0, p.lock_waits());
+        EXPECT_EQ(waits, ProfiledMutex::waits(ProfiledMutex::Adapter));
+        return;
+    }
+    EXPECT_EQ(1, p.lock_waits());
+    EXPECT_GE(p.lock_wait_time(), chrono::milliseconds(30));
+
+    EXPECT_EQ(waits + 1, ProfiledMutex::waits(ProfiledMutex::Adapter));
+    EXPECT_GE(ProfiledMutex::wait_us(ProfiledMutex::Adapter), wait_us + 30000);
+
+    // Waits without a recorder count only for the lock.
+    lock_contended(m, chrono::milliseconds(20));
+    EXPECT_EQ(1, p.lock_waits());
+    EXPECT_EQ(waits + 2, ProfiledMutex::waits(ProfiledMutex::Adapter));
+}
+
+TEST_F(ProfilingTest, allocations)
+{
+    QueryProfile::enable(true);
+
+    EXPECT_FALSE(QueryProfile::allocation_counting());  // We don't replace operator new in this test.
+
+    QueryProfile p;
+    QueryProfile::count_allocation(1000);  // No recorder, doesn't count
+    {
+        QueryProfile::Recorder r(p);
+        QueryProfile::count_allocation(100);
+        QueryProfile::count_allocation(20);
+    }
+    QueryProfile::count_allocation(1000);
+    EXPECT_EQ(2, p.allocations());
+    EXPECT_EQ(120, p.allocated_bytes());
+}
+
+TEST_F(ProfilingTest, nested)
+{
+    QueryProfile::enable(true);
+
+    QueryProfile outer;
+    QueryProfile inner;
+    {
+        QueryProfile::Recorder r1(outer);
+        QueryProfile::count_allocation(1);
+        {
+            QueryProfile::Recorder r2(inner);
+            QueryProfile::count_allocation(10);
+        }
+        QueryProfile::count_allocation(100);
+    }
+    EXPECT_EQ(2, outer.allocations());
+    EXPECT_EQ(101, outer.allocated_bytes());
+    EXPECT_EQ(1, inner.allocations());
+    EXPECT_EQ(10, inner.allocated_bytes());
+}
+
+TEST_F(ProfilingTest, compiled_in)
+{
+#ifdef UNITY_SCOPES_PROFILING
+    EXPECT_TRUE(ProfiledMutex::compiled_in());
+    EXPECT_FALSE((is_base_of<mutex, ProfiledMutex>::value));
+#else
+    EXPECT_FALSE(ProfiledMutex::compiled_in());
+    EXPECT_TRUE((is_base_of<mutex, ProfiledMutex>::value));
+    EXPECT_TRUE((is_same<condition_variable, ProfiledCondition>::value));
+#endif
+}
+
+TEST_F(ProfilingTest, names)
+{
+    EXPECT_STREQ("reply", ProfiledMutex::name(ProfiledMutex::Reply));
+    EXPECT_STREQ("reaper", ProfiledMutex::name(ProfiledMutex::Reaper));
+    EXPECT_STREQ("proxy", ProfiledMutex::name(ProfiledMutex::Proxy));
+    EXPECT_STREQ("adapter", ProfiledMutex::name(ProfiledMutex::Adapter));
+}
+
+TEST_F(ProfilingTest, condition_variable)
+{
+    QueryProfile::enable(true);
+
+    ProfiledMutex m1(ProfiledMutex::Reaper);
+    ProfiledMutex m2(ProfiledMutex::Reaper);
+    {
+        lock(m1, m2);
+        lock_guard<ProfiledMutex> l1(m1, adopt_lock);
+        lock_guard<ProfiledMutex> l2(m2, adopt_lock);
+    }
+
+    ProfiledCondition cond;
+    bool ready = false;
+    thread t([&]
+    {
+        lock_guard<ProfiledMutex> lock(m1);
+        ready = true;
+        cond.notify_all();
+    });
+    {
+        ProfiledLock lock(m1);
+        cond.wait(lock, [&ready] { return ready; });
+    }
+    t.join();
+    EXPECT_TRUE(ready);
+}
@@ -55,6 +55,9 @@ TEST_F(RuntimeConfigTest, basic)
     EXPECT_EQ(DFLT_REAP_EXPIRY, c.reap_expiry());
     EXPECT_EQ(DFLT_REAP_INTERVAL, c.reap_interval());
     EXPECT_TRUE(c.trace_channels().empty());
+    EXPECT_FALSE(c.log_async());
+    EXPECT_EQ(DFLT_LOG_ASYNC_QUEUE_SIZE, c.log_async_queue_size());
+    EXPECT_FALSE(c.profiling());
 }
 
 TEST_F(RuntimeConfigTest, complete)
@@ -72,6 +75,9 @@ TEST_F(RuntimeConfigTest, complete)
     EXPECT_EQ("AppD", c.app_directory());
     EXPECT_EQ("ConfigD", c.config_directory());
     EXPECT_EQ(vector<string>{ "IPC" }, c.trace_channels());
+    EXPECT_TRUE(c.log_async());
+    EXPECT_EQ(64, c.log_async_queue_size());
+    EXPECT_TRUE(c.profiling());
 }
 
 TEST_F(RuntimeConfigTest, _default_cache_dir)
@@ -185,6 +191,18 @@ TEST_F(RuntimeConfigTest, exceptions)
                      e.what());
     }
 
+    try
+    {
+        RuntimeConfig c(TEST_DIR "/BadLogQueueSize.ini");
+        FAIL();
+    }
+    catch (ConfigException const& e)
+    {
+        EXPECT_STREQ("unity::scopes::ConfigException: \"" TEST_DIR "/BadLogQueueSize.ini\": Illegal value (8) for "
+                     "Log.Async.QueueSize: value must be 16-65536",
+                     e.what());
+    }
+
     try
     {
         unsetenv("HOME");
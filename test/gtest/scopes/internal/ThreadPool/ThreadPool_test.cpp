@@ -262,3 +262,37 @@ TEST(ThreadPool, destroy_while_waiting)
     fut2.wait();
     p.wait_for_destroy();
 }
+
+TEST(ThreadPool, backlog)
+{
+    MetricsRegistry::Gauge backlog;
+    {
+        ThreadPool p(1, &backlog);
+
+        promise<void> go;
+        auto go_future = go.get_future().share();
+        auto blocked_task = [go_future]{ go_future.wait(); };
+        p.submit(blocked_task);
+        this_thread::sleep_for(chrono::milliseconds(100));  // Give the first task time to start.
+        EXPECT_EQ(0, backlog.value());
+
+        p.submit(blocked_task);
+        p.submit(blocked_task);
+        EXPECT_EQ(2, backlog.value());
+
+        go.set_value();
+        p.destroy_once_empty();
+        EXPECT_EQ(0, backlog.value());
+    }
+
+    // Tasks that are discarded by destroy() no longer count.
+    {
+        ThreadPool p(1, &backlog);
+        auto slow_task = []{ this_thread::sleep_for(chrono::milliseconds(200)); };
+        p.submit(slow_task);
+        p.submit(slow_task);
+        p.submit(slow_task);
+        p.destroy();
+        EXPECT_EQ(0, backlog.value());
+    }
+}
@@ -26,8 +26,11 @@
 #include <gtest/gtest.h>
 #pragma GCC diagnostic pop
 
+#include <iostream>
 #include <memory>
+#include <sstream>
 #include <thread>
+#include <vector>
 
 using namespace testing;
 using namespace unity::scopes::internal::smartscopes;
@@ -155,6 +158,92 @@ TEST_F(HttpClientTest, cancel_get)
     EXPECT_THROW(response->get(), unity::Exception);
 }
 
+TEST(HttpClientKeepAlive, connection_reuse)
+{
+    RaiiServer server(KEEP_ALIVE_SERVER_PATH);
+    std::string const url = c_test_url + ":" + std::to_string(server.port_);
+
+    // At most two requests at a time, so the burst below has to wait for and reuse connections.
+    auto http_client = std::make_shared<HttpClientNetCpp>(20000, 2, 10);
+
+    // Sequential requests all go over the same connection.
+    int const sequential = 10;
+    for (int i = 0; i < sequential; ++i)
+    {
+        auto response = http_client->get(url + "/" + std::to_string(i));
+        response->wait();
+        EXPECT_NO_THROW(response->get());
+    }
+
+    int const concurrent = 10;
+    std::vector<HttpResponseHandle::SPtr> responses;
+    for (int i = 0; i < concurrent; ++i)
+    {
+        responses.push_back(http_client->get(url + "/burst" + std::to_string(i)));
+    }
+    for (auto const& r : responses)
+    {
+        r->wait();
+        EXPECT_NO_THROW(r->get());
+    }
+
+    auto stats = http_client->stats();
+    EXPECT_EQ(uint64_t(sequential + concurrent), stats.requests);
+    EXPECT_GT(stats.queued, 0u);
+    EXPECT_LE(stats.max_active, 2u);
+    EXPECT_EQ(1u, stats.hosts);
+
+    std::string server_stats;
+    auto response = http_client->get(url + "/stats", [&server_stats](std::string const& s) { server_stats += s; });
+    response->wait();
+    ASSERT_NO_THROW(response->get());
+
+    std::istringstream is(server_stats);
+    int requests, connections;
+    is >> requests >> connections;
+    EXPECT_EQ(sequential + concurrent, requests);
+    EXPECT_LT(connections, requests / 2);
+
+    std::cout << "HttpClient: " << requests << " requests over " << connections << " connections, reuse ratio "
+              << double(requests - connections) / requests << std::endl;
+}
+
+TEST(HttpClientKeepAlive, unlimited_requests)
+{
+    RaiiServer server(KEEP_ALIVE_SERVER_PATH);
+    std::string const url = c_test_url + ":" + std::to_string(server.port_);
+
+    auto http_client = std::make_shared<HttpClientNetCpp>(20000, 1, 10);
+
+    // Unlimited requests run side by side and bypass the limiter.
+    int const concurrent = 10;
+    std::vector<HttpResponseHandle::SPtr> responses;
+    for (int i = 0; i < concurrent; ++i)
+    {
+        responses.push_back(http_client->get(url + "/search" + std::to_string(i),
+                                             [](std::string const&) {},
+                                             HttpHeaders(),
+                                             nullptr,
+                                             HttpConcurrency::Unlimited));
+    }
+    for (auto const& r : responses)
+    {
+        r->wait();
+        EXPECT_NO_THROW(r->get());
+    }
+
+    auto stats = http_client->stats();
+    EXPECT_EQ(0u, stats.requests);
+    EXPECT_EQ(0u, stats.queued);
+    EXPECT_EQ(0u, stats.max_active);
+
+    // A limited request still goes through the limiter.
+    auto response = http_client->get(url + "/preview");
+    response->wait();
+    EXPECT_NO_THROW(response->get());
+    EXPECT_EQ(1u, http_client->stats().requests);
+}
+
 TEST_F(HttpClientTest, percent_encoding)
 {
     std::string encoded_str = http_client_->to_percent_encoding(" \"%<>\\^`{|}!*'();:@&=+$,/?#[]");
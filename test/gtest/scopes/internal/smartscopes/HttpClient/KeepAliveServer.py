@@ -0,0 +1,73 @@
+#!/usr/bin/env python
+
+#
+# Copyright (C) 2016 Canonical Ltd
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License version 3 as
+# published by the Free Software Foundation.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Authored by: agent <agent@local>
+#
+
+# HTTP/1.1 server that keeps connections open, and counts requests and connections.
+# GET /stats returns "<requests> <connections>" for the requests before it.
+
+from BaseHTTPServer import HTTPServer, BaseHTTPRequestHandler
+from SocketServer import ThreadingMixIn
+from random import randint
+import sys
+import threading
+import time
+
+lock = threading.Lock()
+requests = 0
+connections = set()
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+
+    def do_GET(self):
+        global requests
+        if self.path == '/stats':
+            with lock:
+                body = '%d %d' % (requests, len(connections))
+        else:
+            with lock:
+                requests += 1
+                connections.add(self.client_address)
+            time.sleep(0.05)
+            body = 'Hello there'
+        self.send_response(200)
+        self.send_header('Content-Type', 'text/plain')
+        self.send_header('Content-Length', str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def log_message(self, format, *args):
+        pass
+
+class Server(ThreadingMixIn, HTTPServer):
+    daemon_threads = True
+
+serving = False
+port = randint(49152, 65535)
+while serving == False:
+    try:
+        httpd = Server(('127.0.0.1', port), Handler)
+        serving = True
+    except:
+        port = randint(49152, 65535)
+
+print(str(port))
+sys.stdout.flush()
+
+httpd.serve_forever()
@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/smartscopes/HttpHostLimiter.h>
+#include <unity/UnityExceptions.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace unity::scopes::internal::smartscopes;
+
+TEST(HttpHostLimiter, host_of)
+{
+    EXPECT_EQ("http://127.0.0.1:8000", HttpHostLimiter::host_of("http://127.0.0.1:8000/demo/search?q=a"));
+    EXPECT_EQ("https://dash.ubuntu.com", HttpHostLimiter::host_of("https://Dash.Ubuntu.com/smartscopes/v2"));
+    EXPECT_EQ("http://host", HttpHostLimiter::host_of("http://host?q=a"));
+    EXPECT_EQ("http://host", HttpHostLimiter::host_of("http://host"));
+}
+
+TEST(HttpHostLimiter, exceptions)
+{
+    EXPECT_THROW(HttpHostLimiter(0, chrono::minutes(1)), unity::InvalidArgumentException);
+    EXPECT_THROW(HttpHostLimiter(1, chrono::minutes(1), 0), unity::InvalidArgumentException);
+    EXPECT_THROW(HttpHostLimiter(1, chrono::minutes(1), -2), unity::InvalidArgumentException);
+}
+
+TEST(HttpHostLimiter, limit)
+{
+    HttpHostLimiter limiter(2, chrono::minutes(1));
+
+    vector<int> started;
+    for (int i = 0; i < 5; ++i)
+    {
+        limiter.submit("http://a", [&started, i] { started.push_back(i); return true; });
+    }
+    // Other hosts have their own limit.
+    limiter.submit("http://b", [&started] { started.push_back(100); return true; });
+    EXPECT_EQ((vector<int>{ 0, 1, 100 }), started);
+
+    // Waiting requests start in order, one per release.
+    limiter.release("http://a");
+    EXPECT_EQ((vector<int>{ 0, 1, 100, 2 }), started);
+    limiter.release("http://a");
+    limiter.release("http://a");
+    EXPECT_EQ((vector<int>{ 0, 1, 100, 2, 3, 4 }), started);
+
+    auto stats = limiter.stats();
+    EXPECT_EQ(6u, stats.requests);
+    EXPECT_EQ(3u, stats.queued);
+    EXPECT_EQ(2u, stats.max_active);
+    EXPECT_EQ(2u, stats.hosts);
+
+    // Both slots are in use until released.
+    limiter.submit("http://a", [&started] { started.push_back(5); return true; });
+    EXPECT_EQ(6u, started.size());
+    limiter.release("http://a");
+    EXPECT_EQ(7u, started.size());
+    limiter.release("http://a");
+    limiter.release("http://a");
+
+    // With both slots free, a request starts immediately.
+    limiter.submit("http://a", [&started] { started.push_back(6); return true; });
+    EXPECT_EQ(8u, started.size());
+    EXPECT_EQ(4u, limiter.stats().queued);
+}
+
+TEST(HttpHostLimiter, release_from_start)
+{
+    // A request that fails straight away releases its slot from within start().
+    HttpHostLimiter limiter(1, chrono::minutes(1));
+    int count = 0;
+    function<bool()> start = [&limiter, &count] { ++count; limiter.release("http://a"); return true; };
+    for (int i = 0; i < 3; ++i)
+    {
+        limiter.submit("http://a", start);
+    }
+    EXPECT_EQ(3, count);
+    EXPECT_EQ(0u, limiter.stats().queued);
+}
+
+TEST(HttpHostLimiter, abandoned)
+{
+    // Requests that were abandoned while waiting pass the slot on without starting. There may be
+    // any number of them in a row, so release() must not recurse.
+    HttpHostLimiter limiter(1, chrono::minutes(1));
+    limiter.submit("http://a", [] { return true; });
+
+    int const abandoned = 100000;
+    int skipped = 0;
+    for (int i = 0; i < abandoned; ++i)
+    {
+        limiter.submit("http://a", [&skipped] { ++skipped; return false; });
+    }
+    bool started = false;
+    limiter.submit("http://a", [&started] { started = true; return true; });
+
+    limiter.release("http://a");
+    EXPECT_EQ(abandoned, skipped);
+    EXPECT_TRUE(started);
+
+    // The slot is still held by the last request.
+    bool next = false;
+    limiter.submit("http://a", [&next] { next = true; return true; });
+    EXPECT_FALSE(next);
+    limiter.release("http://a");
+    EXPECT_TRUE(next);
+    limiter.release("http://a");
+
+    // A request that is abandoned immediately doesn't keep the slot either.
+    limiter.submit("http://a", [] { return false; });
+    limiter.submit("http://a", [&next] { next = false; return true; });
+    EXPECT_FALSE(next);
+    limiter.release("http://a");
+}
+
+TEST(HttpHostLimiter, queue_timeout)
+{
+    HttpHostLimiter limiter(1, chrono::minutes(1), 1);
+    limiter.submit("http://a", [] { return true; });
+
+    atomic<bool> started(false);
+    atomic<bool> timed_out(false);
+    limiter.submit("http://a",
+                   [&started] { started = true; return true; },
+                   [&timed_out] { timed_out = true; });
+
+    // The reaper runs once a second, so the timeout expires after 1 - 2 seconds.
+    auto const deadline = chrono::steady_clock::now() + chrono::seconds(5);
+    while (!timed_out && chrono::steady_clock::now() < deadline)
+    {
+        this_thread::sleep_for(chrono::milliseconds(50));
+    }
+    EXPECT_TRUE(timed_out);
+    EXPECT_EQ(1u, limiter.stats().timed_out);
+
+    // A request that timed out never starts.
+    limiter.release("http://a");
+    EXPECT_FALSE(started);
+
+    // A request that starts in time doesn't time out.
+    limiter.submit("http://a", [] { return true; });
+    timed_out = false;
+    limiter.submit("http://a",
+                   [&started] { started = true; return true; },
+                   [&timed_out] { timed_out = true; });
+    limiter.release("http://a");
+    EXPECT_TRUE(started);
+    this_thread::sleep_for(chrono::milliseconds(2500));
+    EXPECT_FALSE(timed_out);
+    EXPECT_EQ(1u, limiter.stats().timed_out);
+    limiter.release("http://a");
+}
+
+TEST(HttpHostLimiter, idle_expiry)
+{
+    HttpHostLimiter limiter(1, chrono::milliseconds(100));
+    limiter.submit("http://a", [] { return true; });
+    limiter.submit("http://b", [] { return true; });
+    limiter.release("http://a");
+    EXPECT_EQ(2u, limiter.stats().hosts);
+
+    this_thread::sleep_for(chrono::milliseconds(200));
+
+    // a is idle and forgotten, but b still has a request running.
+    limiter.submit("http://c", [] { return true; });
+    EXPECT_EQ(2u, limiter.stats().hosts);
+    limiter.release("http://b");
+    limiter.release("http://c");
+}
+
+TEST(HttpHostLimiter, threads)
+{
+    HttpHostLimiter limiter(3, chrono::minutes(1));
+    atomic<int> active(0);
+    atomic<int> max_active(0);
+    atomic<int> done(0);
+
+    vector<thread> threads;
+    for (int i = 0; i < 8; ++i)
+    {
+        threads.emplace_back([&]
+        {
+            for (int j = 0; j < 50; ++j)
+            {
+                // Each request runs on a thread of its own, as it would in the HTTP client.
+                limiter.submit("http://a", [&]
+                {
+                    thread([&]
+                    {
+                        int now = ++active;
+                        int prev = max_active.load();
+                        while (now > prev && !max_active.compare_exchange_weak(prev, now))
+                        {
+                        }
+                        this_thread::sleep_for(chrono::microseconds(100));
+                        --active;
+                        limiter.release("http://a");
+                        ++done;
+                    }).detach();
+                    return true;
+                });
+            }
+        });
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    while (done < 400)
+    {
+        this_thread::sleep_for(chrono::milliseconds(10));
+    }
+    EXPECT_LE(max_active.load(), 3);
+    EXPECT_EQ(400u, limiter.stats().requests);
+    EXPECT_LE(limiter.stats().max_active, 3u);
+}
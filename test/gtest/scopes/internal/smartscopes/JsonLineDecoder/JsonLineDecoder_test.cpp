@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/JsonCppNode.h>
+#include <unity/scopes/internal/smartscopes/JsonLineDecoder.h>
+#include <unity/UnityExceptions.h>
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+using namespace std;
+using namespace unity;
+using namespace unity::scopes;
+using namespace unity::scopes::internal;
+using namespace unity::scopes::internal::smartscopes;
+
+namespace
+{
+
+// Response recorded from a smart scopes server search, one JSON object per line.
+vector<string> recorded_lines()
+{
+    ifstream f(TEST_DIR "/recorded_search.json");
+    EXPECT_TRUE(f.good());
+    vector<string> lines;
+    string line;
+    while (getline(f, line))
+    {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+Variant decode(string const& json)
+{
+    JsonLineDecoder d(json);
+    Variant v = d.value();
+    d.finish();
+    return v;
+}
+
+} // namespace
+
+TEST(JsonLineDecoder, members)
+{
+    string json = "{\"result\": {\"uri\": \"URI\", \"n\": 5, \"o\": {\"a\": [1, 2]}}, \"x\": null}\r";
+    JsonLineDecoder d(json);
+    d.begin_object();
+
+    string name;
+    ASSERT_TRUE(d.next_member(name));
+    EXPECT_EQ("result", name);
+    auto mark = d.mark();
+    d.begin_object();
+    ASSERT_TRUE(d.next_member(name));
+    EXPECT_EQ("uri", name);
+    EXPECT_EQ("URI", d.string_value());
+    ASSERT_TRUE(d.next_member(name));
+    EXPECT_EQ("n", name);
+    EXPECT_EQ(Variant(5), d.value());
+    ASSERT_TRUE(d.next_member(name));
+    EXPECT_EQ("o", name);
+    d.skip_value();
+    EXPECT_FALSE(d.next_member(name));
+    EXPECT_EQ("{\"uri\": \"URI\", \"n\": 5, \"o\": {\"a\": [1, 2]}}", d.text_since(mark));
+
+    ASSERT_TRUE(d.next_member(name));
+    EXPECT_EQ("x", name);
+    EXPECT_TRUE(d.value().is_null());
+    EXPECT_FALSE(d.next_member(name));
+    d.finish();
+}
+
+TEST(JsonLineDecoder, values)
+{
+    EXPECT_EQ(Variant(true), decode("true"));
+    EXPECT_EQ(Variant(false), decode(" false "));
+    EXPECT_TRUE(decode("null").is_null());
+    EXPECT_EQ(Variant(0), decode("0"));
+    EXPECT_EQ(Variant(-2147483647 - 1), decode("-2147483648"));
+    EXPECT_EQ(Variant(int64_t(2147483648)), decode("2147483648"));
+    EXPECT_EQ(Variant(int64_t(1234567890123456789)), decode("1234567890123456789"));
+    EXPECT_EQ(Variant(INT64_MAX), decode("9223372036854775807"));
+    EXPECT_EQ(Variant(INT64_MIN), decode("-9223372036854775808"));
+    EXPECT_EQ(Variant(int64_t(-1000000000000000000)), decode("-1000000000000000000"));
+    EXPECT_EQ(Variant(9223372036854775808.0), decode("9223372036854775808"));
+    EXPECT_EQ(Variant(-9223372036854775809.0), decode("-9223372036854775809"));
+    EXPECT_EQ(Variant(1e20), decode("100000000000000000000"));
+    EXPECT_EQ(Variant(1.5), decode("1.5"));
+    EXPECT_EQ(Variant(-150.0), decode("-1.5E2"));
+    EXPECT_EQ(Variant(VariantArray()), decode("[ ]"));
+    EXPECT_EQ(Variant(VariantMap()), decode("{ }"));
+
+    EXPECT_EQ(Variant("a\"b\\c/d\b\f\n\r\t"), decode("\"a\\\"b\\\\c\\/d\\b\\f\\n\\r\\t\""));
+    EXPECT_EQ(Variant("caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80"), decode("\"caf\\u00e9 \\u20AC \\ud83d\\ude00\""));
+    EXPECT_EQ(Variant("caf\xc3\xa9"), decode("\"caf\xc3\xa9\""));
+
+    VariantMap vm;
+    vm["a"] = Variant(VariantArray{ Variant(1), Variant("x"), Variant::null() });
+    vm["b"] = Variant(VariantMap{ { "c", Variant(true) } });
+    EXPECT_EQ(Variant(vm), decode("{\"a\": [1, \"x\", null], \"b\": {\"c\": true}}"));
+}
+
+TEST(JsonLineDecoder, errors)
+{
+    vector<string> bad =
+    {
+        "",
+        "{",
+        "{\"a\" 1}",
+        "{\"a\": 1,}",
+        "{a: 1}",
+        "[1 2]",
+        "tru",
+        "nul",
+        "-",
+        "1.",
+        "1e",
+        "\"abc",
+        "\"a\nb\"",
+        "\"\\x\"",
+        "\"\\u12\"",
+        "\"\\ud800\"",
+        "\"\\udc00\"",
+        "{} x",
+        string(1000, '['),
+    };
+    for (auto const& json : bad)
+    {
+        EXPECT_THROW(decode(json), unity::ResourceException) << json;
+    }
+
+    JsonLineDecoder d("[1]");
+    EXPECT_THROW(d.begin_object(), unity::ResourceException);
+
+    JsonLineDecoder d2("{\"a\": 1}");
+    d2.begin_object();
+    string name;
+    ASSERT_TRUE(d2.next_member(name));
+    EXPECT_THROW(d2.string_value(), unity::ResourceException);
+}
+
+// Every line of the recorded response must decode to the same Variant that JsonCppNode produces.
+
+TEST(JsonLineDecoder, same_as_json_cpp_node)
+{
+    auto lines = recorded_lines();
+    ASSERT_GT(lines.size(), 0u);
+    for (auto const& line : lines)
+    {
+        EXPECT_EQ(JsonCppNode(line).to_variant(), decode(line)) << line;
+    }
+}
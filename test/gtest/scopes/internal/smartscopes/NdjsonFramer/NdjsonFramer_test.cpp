@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/smartscopes/NdjsonFramer.h>
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+using namespace std;
+using namespace unity::scopes::internal::smartscopes;
+
+namespace
+{
+
+string const response =
+    "{\"category\": {\"id\": \"cat1\", \"title\": \"Category 1\"}}\r\n"
+    "{\"result\": {\"cat_id\": \"cat1\", \"uri\": \"URI\", \"title\": \"Stuff\"}}\r\n"
+    "\r\n"
+    "{\"result\": {\"cat_id\": \"cat1\", \"uri\": \"URI2\", \"title\": \"Things\"}}\n"
+    "{\"result\": {\"cat_id\": \"cat1\", \"uri\": \"URI3\", \"title\": \"No newline\"}}";
+
+vector<string> const expected =
+{
+    "{\"category\": {\"id\": \"cat1\", \"title\": \"Category 1\"}}",
+    "{\"result\": {\"cat_id\": \"cat1\", \"uri\": \"URI\", \"title\": \"Stuff\"}}",
+    "{\"result\": {\"cat_id\": \"cat1\", \"uri\": \"URI2\", \"title\": \"Things\"}}",
+    "{\"result\": {\"cat_id\": \"cat1\", \"uri\": \"URI3\", \"title\": \"No newline\"}}",
+};
+
+NdjsonFramer::LineHandler collect(vector<string>& lines)
+{
+    return [&lines](char const* line, size_t size)
+    {
+        lines.push_back(string(line, size));
+    };
+}
+
+} // namespace
+
+TEST(NdjsonFramer, single_chunk)
+{
+    vector<string> lines;
+    NdjsonFramer f(collect(lines));
+    f.feed(response);
+    EXPECT_EQ(vector<string>(expected.begin(), expected.end() - 1), lines);
+    EXPECT_EQ(expected.back().size(), f.buffered());
+
+    f.feed("");
+    EXPECT_EQ(expected, lines);
+    EXPECT_EQ(0u, f.buffered());
+
+    // End of response with nothing buffered doesn't call the handler.
+    f.feed("");
+    EXPECT_EQ(expected.size(), lines.size());
+}
+
+TEST(NdjsonFramer, lines_are_not_copied)
+{
+    string const chunk = "{\"a\": 1}\r\n{\"b\": 2}\r\n{\"c\":";
+    vector<char const*> addresses;
+    NdjsonFramer f([&addresses](char const* line, size_t)
+    {
+        addresses.push_back(line);
+    });
+    f.feed(chunk);
+    ASSERT_EQ(2u, addresses.size());
+    EXPECT_EQ(chunk.data(), addresses[0]);
+    EXPECT_EQ(chunk.data() + 10, addresses[1]);
+    EXPECT_EQ(5u, f.buffered());
+}
+
+// Split the response into two chunks at every offset, and into three chunks at every pair of offsets.
+
+TEST(NdjsonFramer, every_boundary)
+{
+    for (size_t i = 0; i <= response.size(); ++i)
+    {
+        vector<string> lines;
+        NdjsonFramer f(collect(lines));
+        string const first = response.substr(0, i);
+        string const second = response.substr(i);
+        if (!first.empty())
+        {
+            f.feed(first);
+        }
+        if (!second.empty())
+        {
+            f.feed(second);
+        }
+        f.feed("");
+        ASSERT_EQ(expected, lines) << "split at " << i;
+    }
+
+    for (size_t i = 1; i < response.size(); ++i)
+    {
+        for (size_t j = i + 1; j < response.size(); ++j)
+        {
+            vector<string> lines;
+            NdjsonFramer f(collect(lines));
+            f.feed(response.substr(0, i));
+            f.feed(response.substr(i, j - i));
+            f.feed(response.substr(j));
+            f.feed("");
+            ASSERT_EQ(expected, lines) << "split at " << i << " and " << j;
+        }
+    }
+}
+
+TEST(NdjsonFramer, byte_at_a_time)
+{
+    vector<string> lines;
+    NdjsonFramer f(collect(lines));
+    for (auto c : response)
+    {
+        f.feed(string(1, c));
+    }
+    f.feed("");
+    EXPECT_EQ(expected, lines);
+}
+
+TEST(NdjsonFramer, handler_throws)
+{
+    vector<string> lines;
+    NdjsonFramer f([&lines](char const* line, size_t size)
+    {
+        string l(line, size);
+        if (l == "bad")
+        {
+            throw runtime_error("bad line");
+        }
+        lines.push_back(l);
+    });
+
+    f.feed("one\r\ntw");
+    EXPECT_THROW(f.feed("o\r\nbad\r\nlost\r\npart"), runtime_error);
+
+    // The rest of the chunk was discarded, but the framer still works.
+    EXPECT_EQ(0u, f.buffered());
+    f.feed("three\r\n");
+    EXPECT_EQ((vector<string>{ "one", "two", "three" }), lines);
+}
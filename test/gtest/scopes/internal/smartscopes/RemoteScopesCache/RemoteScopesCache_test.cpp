@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/smartscopes/RemoteScopesCache.h>
+
+#include <unity/UnityExceptions.h>
+
+#include <boost/filesystem/operations.hpp>
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+using namespace std;
+using namespace unity::scopes;
+using namespace unity::scopes::internal::smartscopes;
+
+namespace
+{
+
+string const json_path = string(TEST_CACHE_DIR) + "/remote-scopes.json";
+string const bin_path = string(TEST_CACHE_DIR) + "/remote-scopes.bin";
+
+vector<RemoteScope> make_scopes()
+{
+    vector<RemoteScope> scopes;
+
+    RemoteScope plain;
+    plain.id = "dummy.scope";
+    plain.name = "Dummy Demo Scope";
+    plain.description = "Dummy demo scope.";
+    plain.author = "Mr Fake";
+    plain.base_url = "http://127.0.0.1/demo";
+    plain.version = 0;
+    scopes.push_back(plain);
+
+    RemoteScope full;
+    full.id = "dummy.scope.2";
+    full.name = "Dummy Demo Scope 2";
+    full.description = "Dummy demo scope 2.";
+    full.author = "Mr Fake";
+    full.base_url = "http://127.0.0.1/demo2";
+    full.icon = make_shared<string>("icon");
+    full.art = make_shared<string>("");
+    VariantMap appearance;
+    appearance["background"] = "#ffffff";
+    appearance["logo-overlay"] = true;
+    full.appearance = make_shared<VariantMap>(appearance);
+    full.settings = make_shared<string>("[{\"id\":\"loc\",\"type\":\"string\"}]");
+    full.needs_location_data = make_shared<bool>(false);
+    full.invisible = true;
+    full.version = 3;
+    full.keywords = { "music", "video", "" };
+    full.results_ttl_type = ScopeMetadata::ResultsTtlType::Large;
+    scopes.push_back(full);
+
+    return scopes;
+}
+
+void write_json(string const& contents)
+{
+    ofstream(json_path) << contents;
+}
+
+class RemoteScopesCacheTest : public ::testing::Test
+{
+public:
+    RemoteScopesCacheTest()
+    {
+        boost::filesystem::remove_all(TEST_CACHE_DIR);
+        boost::filesystem::create_directories(TEST_CACHE_DIR);
+        write_json("[]");
+    }
+};
+
+} // namespace
+
+TEST_F(RemoteScopesCacheTest, round_trip)
+{
+    auto const scopes = make_scopes();
+    RemoteScopesCache::write(bin_path, json_path, scopes);
+    EXPECT_TRUE(RemoteScopesCache::is_current(bin_path, json_path));
+
+    vector<RemoteScope> read_scopes;
+    ASSERT_TRUE(RemoteScopesCache::read(bin_path, json_path, read_scopes));
+    EXPECT_EQ(scopes, read_scopes);
+    EXPECT_EQ(nullptr, read_scopes[0].icon);
+    EXPECT_EQ(nullptr, read_scopes[0].needs_location_data);
+    ASSERT_NE(nullptr, read_scopes[1].needs_location_data);
+    EXPECT_FALSE(*read_scopes[1].needs_location_data);
+
+    // No scopes is fine too.
+    RemoteScopesCache::write(bin_path, json_path, vector<RemoteScope>());
+    ASSERT_TRUE(RemoteScopesCache::read(bin_path, json_path, read_scopes));
+    EXPECT_TRUE(read_scopes.empty());
+}
+
+TEST_F(RemoteScopesCacheTest, stale)
+{
+    RemoteScopesCache::write(bin_path, json_path, make_scopes());
+
+    // Rewriting the JSON cache invalidates the binary cache.
+    write_json("[{}]");
+    EXPECT_FALSE(RemoteScopesCache::is_current(bin_path, json_path));
+    vector<RemoteScope> scopes;
+    EXPECT_FALSE(RemoteScopesCache::read(bin_path, json_path, scopes));
+    EXPECT_TRUE(scopes.empty());
+
+    // So does removing it.
+    RemoteScopesCache::write(bin_path, json_path, make_scopes());
+    EXPECT_TRUE(RemoteScopesCache::is_current(bin_path, json_path));
+    boost::filesystem::remove(json_path);
+    EXPECT_FALSE(RemoteScopesCache::is_current(bin_path, json_path));
+    EXPECT_FALSE(RemoteScopesCache::read(bin_path, json_path, scopes));
+
+    // We can't write a binary cache without the JSON cache.
+    EXPECT_THROW(RemoteScopesCache::write(bin_path, json_path, make_scopes()), unity::ResourceException);
+}
+
+TEST_F(RemoteScopesCacheTest, damaged)
+{
+    vector<RemoteScope> scopes;
+    EXPECT_FALSE(RemoteScopesCache::is_current(bin_path, json_path));
+    EXPECT_FALSE(RemoteScopesCache::read(bin_path, json_path, scopes));
+
+    RemoteScopesCache::write(bin_path, json_path, make_scopes());
+    string contents;
+    {
+        ifstream f(bin_path, ios::binary);
+        contents.assign(istreambuf_iterator<char>(f), istreambuf_iterator<char>());
+    }
+    auto rewrite = [](string const& s)
+    {
+        ofstream(bin_path, ios::binary | ios::trunc) << s;
+    };
+
+    // Truncated
+    rewrite(contents.substr(0, contents.size() - 1));
+    EXPECT_FALSE(RemoteScopesCache::is_current(bin_path, json_path));
+    EXPECT_FALSE(RemoteScopesCache::read(bin_path, json_path, scopes));
+    rewrite(contents.substr(0, 10));
+    EXPECT_FALSE(RemoteScopesCache::read(bin_path, json_path, scopes));
+
+    // Bad magic
+    string bad = contents;
+    bad[0] = 'X';
+    rewrite(bad);
+    EXPECT_FALSE(RemoteScopesCache::read(bin_path, json_path, scopes));
+
+    // Different version
+    bad = contents;
+    bad[12] ^= 0x7f;
+    rewrite(bad);
+    EXPECT_FALSE(RemoteScopesCache::read(bin_path, json_path, scopes));
+
+    // A string length that runs past the end of the file
+    bad = contents;
+    bad[bad.size() - 9] = '\x7f';
+    rewrite(bad);
+    EXPECT_FALSE(RemoteScopesCache::read(bin_path, json_path, scopes));
+
+    EXPECT_TRUE(scopes.empty());
+
+    rewrite(contents);
+    EXPECT_TRUE(RemoteScopesCache::read(bin_path, json_path, scopes));
+    EXPECT_EQ(make_scopes(), scopes);
+}
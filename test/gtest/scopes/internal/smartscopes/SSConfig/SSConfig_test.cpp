@@ -38,17 +38,27 @@ TEST(SSConfig, basic)
         // No config, defaults apply.
         SSConfig c("");
         EXPECT_EQ(DFLT_SS_HTTP_TIMEOUT, c.http_reply_timeout());
+        EXPECT_EQ(DFLT_SS_HTTP_CONNECTIONS_PER_HOST, c.http_connections_per_host());
+        EXPECT_EQ(DFLT_SS_HTTP_QUEUE_TIMEOUT, c.http_queue_timeout());
         EXPECT_EQ(DFLT_SS_REG_REFRESH_RATE, c.reg_refresh_rate());
         EXPECT_EQ(DFLT_SS_REG_REFRESH_FAIL_TIMEOUT, c.reg_refresh_fail_timeout());
         EXPECT_EQ(DFLT_SS_SCOPE_IDENTITY, c.scope_identity());
+        EXPECT_EQ(DFLT_SS_SEARCH_CACHE_SIZE, c.search_cache_size());
+        EXPECT_EQ("", c.search_cache_dir());
+        EXPECT_EQ(DFLT_SS_SEARCH_CACHE_DIR_SIZE, c.search_cache_dir_size());
     }
 
     {
         // Values in configfile apply.
         SSConfig c(TEST_SSREGISTRY_PATH);
         EXPECT_EQ(2, c.http_reply_timeout());
+        EXPECT_EQ(3, c.http_connections_per_host());
+        EXPECT_EQ(5, c.http_queue_timeout());
         EXPECT_EQ(77333, c.reg_refresh_rate());
         EXPECT_EQ(17, c.reg_refresh_fail_timeout());
         EXPECT_EQ("Fred", c.scope_identity());
+        EXPECT_EQ(7, c.search_cache_size());
+        EXPECT_EQ("/tmp/search-cache", c.search_cache_dir());
+        EXPECT_EQ(50, c.search_cache_dir_size());
     }
 }
@@ -0,0 +1,353 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/smartscopes/SearchCache.h>
+#include <unity/scopes/OptionSelectorFilter.h>
+
+#include <boost/filesystem/operations.hpp>
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <thread>
+
+using namespace std;
+using namespace unity::scopes;
+using namespace unity::scopes::internal::smartscopes;
+
+namespace
+{
+
+SearchRecording::SPtr make_recording(string const& uri)
+{
+    auto rec = make_shared<SearchRecording>();
+
+    auto cat = make_shared<SearchCategory>();
+    cat->id = "cat1";
+    cat->title = "Category 1";
+    cat->renderer_template = "{}";
+    rec->add(cat);
+
+    SearchResult result;
+    result.json = "{\"uri\": \"" + uri + "\", \"cat_id\": \"cat1\", \"title\": \"Stuff\"}";
+    result.uri = uri;
+    result.category_id = "cat1";
+    result.other_params["title"] = "Stuff";
+    result.other_params["rating"] = 4.5;
+    rec->add(result);
+
+    auto dept = make_shared<DepartmentInfo>();
+    dept->label = "All";
+    dept->canned_query = "scope://dummy.scope?q=";
+    dept->has_subdepartments = true;
+    auto subdept = make_shared<DepartmentInfo>();
+    subdept->label = "Books";
+    subdept->alternate_label = "All books";
+    subdept->canned_query = "scope://dummy.scope?dep=books";
+    dept->subdepartments.push_back(subdept);
+    rec->add(dept);
+
+    auto filter = OptionSelectorFilter::create("f1", "Options");
+    filter->add_option("o1", "Option 1");
+    rec->add(Filters{ move(filter) });
+
+    FilterState state;
+    OptionSelectorFilter::update_state(state, "f1", "o1", true);
+    rec->add(state);
+
+    return rec;
+}
+
+// Replays rec and returns a description of the replies, in order.
+
+vector<string> replay(SearchRecording const& rec)
+{
+    vector<string> replies;
+    SearchReplyHandler handler;
+    handler.category_handler = [&replies](shared_ptr<SearchCategory> const& cat)
+    {
+        replies.push_back("category " + cat->id + " " + cat->title + " " + cat->renderer_template);
+    };
+    handler.result_handler = [&replies](SearchResult const& result)
+    {
+        replies.push_back("result " + result.uri + " " + result.category_id + " " + result.json + " " +
+                          Variant(result.other_params).serialize_json());
+    };
+    handler.departments_handler = [&replies](shared_ptr<DepartmentInfo> const& dept)
+    {
+        replies.push_back("departments " + dept->label + " " + dept->canned_query + " " +
+                          to_string(dept->subdepartments.size()) + " " + dept->subdepartments[0]->alternate_label);
+    };
+    handler.filters_handler = [&replies](Filters const& filters)
+    {
+        replies.push_back("filters " + filters.front()->id() + " " + filters.front()->filter_type());
+    };
+    handler.filter_state_handler = [&replies](FilterState const& state)
+    {
+        replies.push_back("filter_state " + Variant(state.serialize()).serialize_json());
+    };
+    rec.replay(handler);
+    return replies;
+}
+
+string key(string const& query)
+{
+    return SearchCache::make_key("http://127.0.0.1/demo", query, "", "phone", VariantMap(), VariantMap(),
+                                 "en", LocationInfo(), "", 0);
+}
+
+} // namespace
+
+TEST(SearchCache, ttl)
+{
+    EXPECT_EQ(chrono::seconds(0), SearchCache::ttl(ScopeMetadata::ResultsTtlType::None));
+    EXPECT_EQ(chrono::seconds(60), SearchCache::ttl(ScopeMetadata::ResultsTtlType::Small));
+    EXPECT_EQ(chrono::seconds(300), SearchCache::ttl(ScopeMetadata::ResultsTtlType::Medium));
+    EXPECT_EQ(chrono::seconds(3600), SearchCache::ttl(ScopeMetadata::ResultsTtlType::Large));
+}
+
+TEST(SearchCache, key)
+{
+    EXPECT_EQ(key("a"), key("a"));
+    EXPECT_NE(key("a"), key("b"));
+
+    LocationInfo here;
+    here.has_location = true;
+    here.country_code = "GB";
+    here.latitude = 51.50731;
+    here.longitude = -0.12763;
+    LocationInfo nearby = here;
+    nearby.latitude = 51.50749;
+    LocationInfo elsewhere = here;
+    elsewhere.latitude = 51.6;
+
+    auto key_at = [](LocationInfo const& loc)
+    {
+        return SearchCache::make_key("http://127.0.0.1/demo", "a", "", "phone", VariantMap(), VariantMap(),
+                                     "en", loc, "", 0);
+    };
+    EXPECT_EQ(key_at(here), key_at(nearby));
+    EXPECT_NE(key_at(here), key_at(elsewhere));
+    EXPECT_NE(key("a"), key_at(here));
+}
+
+TEST(SearchCache, record_and_replay)
+{
+    auto rec = make_recording("URI");
+    auto replies = replay(*rec);
+    ASSERT_EQ(5u, replies.size());
+
+    // Recording a handler passes the replies on, and records them in the same order.
+    vector<string> passed_on;
+    SearchReplyHandler handler;
+    handler.category_handler = [&passed_on](shared_ptr<SearchCategory> const& cat)
+    {
+        passed_on.push_back(cat->id);
+    };
+    handler.result_handler = [&passed_on](SearchResult const& result)
+    {
+        passed_on.push_back(result.uri);
+    };
+    auto recorded = SearchRecording::record(handler);
+    rec->replay(handler);
+    EXPECT_EQ((vector<string>{ "cat1", "URI" }), passed_on);
+    EXPECT_EQ(replies, replay(*recorded));
+
+    // Serialization round-trips.
+    auto copy = SearchRecording::deserialize(Variant::deserialize_json(rec->serialize().serialize_json()));
+    EXPECT_EQ(replies, replay(*copy));
+}
+
+TEST(SearchCache, lru)
+{
+    SearchCache cache(2);
+
+    EXPECT_EQ(nullptr, cache.find(key("a")));
+    cache.add(key("a"), make_recording("a"), chrono::seconds(60));
+    cache.add(key("b"), make_recording("b"), chrono::seconds(60));
+    EXPECT_NE(nullptr, cache.find(key("a")));
+
+    // b is the least recently used entry.
+    cache.add(key("c"), make_recording("c"), chrono::seconds(60));
+    EXPECT_EQ(nullptr, cache.find(key("b")));
+    EXPECT_NE(nullptr, cache.find(key("a")));
+    EXPECT_NE(nullptr, cache.find(key("c")));
+
+    auto stats = cache.stats();
+    EXPECT_EQ(3u, stats.hits);
+    EXPECT_EQ(2u, stats.misses);
+    EXPECT_EQ(1u, stats.evictions);
+    EXPECT_EQ(2u, stats.entries);
+    EXPECT_GT(stats.bytes, 0u);
+
+    // Replacing an entry doesn't change the byte count if the replies are the same size.
+    cache.add(key("c"), make_recording("d"), chrono::seconds(60));
+    EXPECT_EQ(stats.bytes, cache.stats().bytes);
+    EXPECT_EQ("result d", replay(*cache.find(key("c")))[1].substr(0, 8));
+}
+
+TEST(SearchCache, ttl_none)
+{
+    SearchCache cache(10);
+    cache.add(key("a"), make_recording("a"), chrono::seconds(0));
+    EXPECT_EQ(nullptr, cache.find(key("a")));
+    EXPECT_EQ(0u, cache.stats().entries);
+    EXPECT_EQ(0u, cache.stats().bytes);
+}
+
+TEST(SearchCache, expiry)
+{
+    SearchCache cache(10);
+    cache.add(key("a"), make_recording("a"), chrono::seconds(1));
+    EXPECT_NE(nullptr, cache.find(key("a")));
+    this_thread::sleep_for(chrono::milliseconds(1100));
+    EXPECT_EQ(nullptr, cache.find(key("a")));
+    EXPECT_EQ(0u, cache.stats().entries);
+    EXPECT_EQ(0u, cache.stats().bytes);
+}
+
+TEST(SearchCache, disk)
+{
+    boost::filesystem::remove_all(TEST_CACHE_DIR);
+
+    auto rec = make_recording("URI");
+    {
+        SearchCache cache(1, TEST_CACHE_DIR);
+        cache.add(key("a"), rec, chrono::seconds(60));
+        cache.add(key("b"), make_recording("b"), chrono::seconds(60));
+
+        // a was evicted from memory, but is still on disk.
+        EXPECT_EQ(1u, cache.stats().evictions);
+        auto found = cache.find(key("a"));
+        ASSERT_NE(nullptr, found);
+        EXPECT_EQ(replay(*rec), replay(*found));
+    }
+
+    {
+        // A new cache (as after a restart) finds the entries written by the old one.
+        SearchCache cache(10, TEST_CACHE_DIR);
+        auto found = cache.find(key("a"));
+        ASSERT_NE(nullptr, found);
+        EXPECT_EQ(replay(*rec), replay(*found));
+        EXPECT_EQ(1u, cache.stats().hits);
+        EXPECT_EQ(1u, cache.stats().entries);
+    }
+
+    // Corrupt files are ignored and removed.
+    int files = 0;
+    for (boost::filesystem::directory_iterator it(TEST_CACHE_DIR), end; it != end; ++it)
+    {
+        ofstream(it->path().string()) << "{\"key\":";
+        ++files;
+    }
+    EXPECT_EQ(2, files);
+    {
+        SearchCache cache(10, TEST_CACHE_DIR);
+        EXPECT_EQ(nullptr, cache.find(key("a")));
+        EXPECT_EQ(nullptr, cache.find(key("b")));
+        EXPECT_EQ(2u, cache.stats().misses);
+    }
+    EXPECT_TRUE(boost::filesystem::is_empty(TEST_CACHE_DIR));
+}
+
+namespace
+{
+
+// Returns the number of files in dir with the given extension.
+
+int count_files(string const& dir, string const& extension)
+{
+    int count = 0;
+    for (boost::filesystem::directory_iterator it(dir), end; it != end; ++it)
+    {
+        if (it->path().extension() == extension)
+        {
+            ++count;
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+TEST(SearchCache, disk_limit)
+{
+    boost::filesystem::remove_all(TEST_CACHE_DIR);
+
+    {
+        SearchCache cache(1, TEST_CACHE_DIR, 10);
+        for (int i = 0; i < 25; ++i)
+        {
+            cache.add(key(to_string(i)), make_recording(to_string(i)), chrono::seconds(60 + i));
+            EXPECT_LE(count_files(TEST_CACHE_DIR, ".json"), 10);
+        }
+        // The entries that expire last are kept.
+        EXPECT_NE(nullptr, cache.find(key("24")));
+        EXPECT_NE(nullptr, cache.find(key("23")));
+        EXPECT_EQ(nullptr, cache.find(key("0")));
+    }
+
+    // Expired files and left-over temporary files are removed on construction.
+    ofstream(string(TEST_CACHE_DIR) + "/0123456789abcdef.json.1234-1.tmp") << "{";
+    int files = 0;
+    for (boost::filesystem::directory_iterator it(TEST_CACHE_DIR), end; it != end; ++it)
+    {
+        if (it->path().extension() == ".json" && files++ < 3)
+        {
+            boost::filesystem::last_write_time(it->path(), time(nullptr) - 1);
+        }
+    }
+    int const before = count_files(TEST_CACHE_DIR, ".json");
+    {
+        SearchCache cache(1, TEST_CACHE_DIR, 10);
+        EXPECT_EQ(before - 3, count_files(TEST_CACHE_DIR, ".json"));
+        EXPECT_EQ(0, count_files(TEST_CACHE_DIR, ".tmp"));
+    }
+}
+
+TEST(SearchCache, concurrent_writers)
+{
+    boost::filesystem::remove_all(TEST_CACHE_DIR);
+
+    // Identical searches that finish together write the same key at the same time.
+    {
+        SearchCache cache(10, TEST_CACHE_DIR);
+        vector<thread> threads;
+        for (int i = 0; i < 4; ++i)
+        {
+            threads.emplace_back([&cache, i]
+            {
+                auto rec = make_recording("thread" + to_string(i));
+                for (int j = 0; j < 50; ++j)
+                {
+                    cache.add(key("a"), rec, chrono::seconds(60));
+                }
+            });
+        }
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+    }
+
+    EXPECT_EQ(1, count_files(TEST_CACHE_DIR, ".json"));
+    EXPECT_EQ(0, count_files(TEST_CACHE_DIR, ".tmp"));
+    SearchCache cache(10, TEST_CACHE_DIR);
+    auto found = cache.find(key("a"));
+    ASSERT_NE(nullptr, found);
+    EXPECT_EQ("result thread", replay(*found)[1].substr(0, 13));
+}
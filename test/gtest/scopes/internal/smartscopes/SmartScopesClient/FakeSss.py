@@ -28,7 +28,6 @@ def response(environ, start_response):
     global preview1_complete, outfile
     status = '200 OK'
     response_headers = [('Content-Type', 'application/json')]
-    start_response(status, response_headers)
 
     if outfile != '':
         f = open(outfile, 'a')
@@ -38,8 +37,17 @@ def response(environ, start_response):
             f.writelines(["%s : \n" % (environ['PATH_INFO'])])
 
     if environ['PATH_INFO'] == '/remote-scopes' and (environ['QUERY_STRING'] == '' or environ['QUERY_STRING'] == 'locale=test_TEST'):
+        response_headers.append(('ETag', remote_scopes_etag))
+        if environ.get('HTTP_IF_NONE_MATCH', '') == remote_scopes_etag:
+            if outfile != '':
+                f.writelines(["304 Not Modified\n"])
+            start_response('304 Not Modified', response_headers)
+            return ['']
+        start_response(status, response_headers)
         return [remote_scopes_response]
 
+    start_response(status, response_headers)
+
     if environ['PATH_INFO'] == '/demo/search' and environ['QUERY_STRING'].find('test_user_agent_header') >= 0:
         return [search_response + '\r\n{"result": {"cat_id": "cat1", "art": "https://dash.ubuntu.com/imgs/cat.png", "uri": "URI", "title": "' + environ['HTTP_USER_AGENT'] + '"}}']
 
@@ -49,6 +57,9 @@ def response(environ, start_response):
     if environ['PATH_INFO'] == '/demo/search' and environ['QUERY_STRING'] != '':
         return [search_response]
 
+    if environ['PATH_INFO'] == '/demo2/search' and environ['QUERY_STRING'] != '':
+        return [search_response]
+
     if environ['PATH_INFO'] == '/demo3/search' and ('settings=%7B%22age%22%3A23%2C%22enabled%22%3Atrue%2C%22location%22%3A%22London%22%2C%22unitTemp%22%3A1%7D' in environ['QUERY_STRING']):
         return [search_response]
 
@@ -62,6 +73,9 @@ def response(environ, start_response):
         if preview1_complete == True:
             return [preview_response2]
 
+    if environ['PATH_INFO'] == '/bad_widget/preview' and environ['QUERY_STRING'] != '':
+        return [preview_response_bad_widget]
+
     if environ['PATH_INFO'] == '/demo3/preview' and ('settings=%7B%22age%22%3A23%2C%22enabled%22%3Atrue%2C%22location%22%3A%22London%22%2C%22unitTemp%22%3A1%7D' in environ['QUERY_STRING']):
         return [preview_response]
 
@@ -92,7 +106,7 @@ remote_scopes_response = '[\
 \
 {"base_url": "http://127.0.0.1:' + str(port) + '/fail2", "name": "Fail Scope 2", "description": "Fails due to no id.", "author": "Mr.Fake", "icon": "icon" },\
 \
-{"base_url": "http://127.0.0.1:' + str(port) + '/demo2", "id" : "dummy.scope.2", "name": "Dummy Demo Scope 2", "description": "Dummy demo scope 2.", "author": "Mr.Fake", "art": "art", "invisible": true, "version": 2,\
+{"base_url": "http://127.0.0.1:' + str(port) + '/demo2", "id" : "dummy.scope.2", "name": "Dummy Demo Scope 2", "description": "Dummy demo scope 2.", "author": "Mr.Fake", "art": "art", "invisible": true, "version": 2, "results_ttl_type": "small",\
 "appearance":\
     {\
         "background": "#00BEEF",\
@@ -163,6 +177,8 @@ remote_scopes_response = '[\
 {"base_url": "http://127.0.0.1:' + str(port) + '/demo", "id" : "fail.scope.4", "name": "Fail Scope 4", "description": "Fails due to negative version.", "author": "Mr.Fake", "icon": "icon", "version": -1 }\
 ]'
 
+remote_scopes_etag = '"remote-scopes-1"'
+
 search_response = '\
 {"departments": {"label": "All", "canned_query": "scope://foo?q=&dep=", "alternate_label": "Foo", "subdepartments": [{"label":"A", "canned_query":"scope://foo?q=&dep=a", "subdepartments":[{"label":"Broken department"},{"label":"C", "canned_query":"scope://foo?q=&dep=c", "has_subdepartments":false}]},{"label":"B", "canned_query":"scope://foo?q=&dep=b", "has_subdepartments":false}]}}\r\n\
 {"filters": [{"display_hints": "primary", "multi_select": false, "id": "sorting_primary_filter", "filter_type": "option_selector", "label": "Label", "options": [{"id": "titlerank", "label": "Title rank"}, {"id": "-titlerank", "label": "Reversed title rank"}, {"id": "salesrank", "label": "Bestselling"}]}]}\r\n\
@@ -185,6 +201,11 @@ preview_response = '\
 {"widget": {"id": "widget_id_B", "type": "text", "title": "Widget B", "text": "Second widget."}}\r\n\
 {"widget": {"id": "widget_id_C", "type": "text", "title": "Widget C", "text": "Third widget."}}'
 
+preview_response_bad_widget = '\
+{"widget": {"id": "widget_id_A", "type": "text", "title": "Widget A", "text": "First widget."}}\r\n\
+{"widget": {"id": "widget_id_B", "type": 42, "title": "Widget B has an invalid type"}}\r\n\
+{"widget": {"id": "widget_id_C", "type": "text", "title": "Widget C", "text": "Third widget."}}'
+
 preview_response2 = '\
 {"widget": {"id": "widget_id_A", "type": "text", "title": "Widget A", "text": "First widget."}}\r\n\
 {"widget": {"id": "widget_id_B", "type": "text", "title": "Widget B", "text": "Second widget."}}'
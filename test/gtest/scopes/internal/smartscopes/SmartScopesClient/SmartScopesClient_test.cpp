@@ -34,6 +34,7 @@
 #include <gtest/gtest.h>
 #pragma GCC diagnostic pop
 
+#include <future>
 #include <memory>
 #include <thread>
 
@@ -74,6 +75,21 @@ public:
         return false;
     }
 
+    int count_string(std::string const &s)
+    {
+        std::stringstream str(unity::util::read_text_file(FAKE_SSS_LOG));
+        std::string line;
+        int count = 0;
+        while (std::getline(str, line))
+        {
+            if (line.find(s) != std::string::npos)
+            {
+                ++count;
+            }
+        }
+        return count;
+    }
+
 protected:
     std::string sss_url_;
     HttpClientInterface::SPtr http_client_;
@@ -110,6 +126,7 @@ TEST_F(SmartScopesClientTest, remote_scopes)
     EXPECT_EQ(nullptr, scopes[0].appearance);
     EXPECT_EQ(nullptr, scopes[0].settings);
     EXPECT_TRUE(scopes[0].keywords.empty());
+    EXPECT_EQ(ScopeMetadata::ResultsTtlType::None, scopes[0].results_ttl_type);
 
     EXPECT_EQ("dummy.scope.2", scopes[1].id);
     EXPECT_EQ("Dummy Demo Scope 2", scopes[1].name);
@@ -124,6 +141,7 @@ TEST_F(SmartScopesClientTest, remote_scopes)
     EXPECT_EQ("logo.png", (*scopes[1].appearance)["PageHeader"].get_dict()["logo"].get_string());
     EXPECT_EQ(nullptr, scopes[1].settings);
     EXPECT_TRUE(scopes[1].keywords.empty());
+    EXPECT_EQ(ScopeMetadata::ResultsTtlType::Small, scopes[1].results_ttl_type);
 
     EXPECT_EQ("dummy.scope.3", scopes[2].id);
     EXPECT_EQ("Dummy Demo Scope 3", scopes[2].name);
@@ -178,6 +196,25 @@ TEST_F(SmartScopesClientTest, remote_scopes)
     EXPECT_TRUE(grep_string("/remote-scopes : partner=Partner%20String"));
 }
 
+TEST_F(SmartScopesClientTest, remote_scopes_not_modified)
+{
+    std::vector<RemoteScope> scopes;
+    EXPECT_TRUE(ssc_->get_remote_scopes(scopes, "test_TEST", false));
+    ASSERT_EQ(4u, scopes.size());
+    EXPECT_EQ(0, count_string("304 Not Modified"));
+
+    // The second request is conditional, and the server replies that nothing changed.
+    std::vector<RemoteScope> scopes2;
+    EXPECT_TRUE(ssc_->get_remote_scopes(scopes2, "test_TEST", false));
+    EXPECT_EQ(1, count_string("304 Not Modified"));
+    EXPECT_EQ(scopes, scopes2);
+
+    // A request for a different locale is not conditional.
+    EXPECT_TRUE(ssc_->get_remote_scopes(scopes2, "", false));
+    EXPECT_EQ(1, count_string("304 Not Modified"));
+    EXPECT_EQ(scopes, scopes2);
+}
+
 TEST_F(SmartScopesClientTest, remote_scopes_no_partner)
 {
     std::vector<RemoteScope> scopes;
@@ -218,10 +255,10 @@ TEST_F(SmartScopesClientTest, search)
     ASSERT_EQ(1u, categories.size());
 
     EXPECT_EQ("URI", results[0].uri);
-    EXPECT_EQ(nullptr, results[0].other_params["dnd_uri"]);
-    EXPECT_EQ("Stuff", results[0].other_params["title"]->as_string());
-    EXPECT_EQ(nullptr, results[0].other_params["icon"]);
-    EXPECT_EQ("https://dash.ubuntu.com/imgs/amazon.png", results[0].other_params["art"]->as_string());
+    EXPECT_EQ(0u, results[0].other_params.count("dnd_uri"));
+    EXPECT_EQ("Stuff", results[0].other_params["title"].get_string());
+    EXPECT_EQ(0u, results[0].other_params.count("icon"));
+    EXPECT_EQ("https://dash.ubuntu.com/imgs/amazon.png", results[0].other_params["art"].get_string());
     EXPECT_EQ("cat1", results[0].category_id);
 
     EXPECT_EQ("cat1", categories[0]->id);
@@ -230,17 +267,17 @@ TEST_F(SmartScopesClientTest, search)
     EXPECT_EQ("{}", categories[0]->renderer_template);
 
     EXPECT_EQ("URI2", results[1].uri);
-    EXPECT_EQ(nullptr, results[1].other_params["dnd_uri"]);
-    EXPECT_EQ("Things", results[1].other_params["title"]->as_string());
-    EXPECT_EQ("https://dash.ubuntu.com/imgs/google.png", results[1].other_params["icon"]->as_string());
-    EXPECT_EQ(nullptr, results[1].other_params["art"]);
+    EXPECT_EQ(0u, results[1].other_params.count("dnd_uri"));
+    EXPECT_EQ("Things", results[1].other_params["title"].get_string());
+    EXPECT_EQ("https://dash.ubuntu.com/imgs/google.png", results[1].other_params["icon"].get_string());
+    EXPECT_EQ(0u, results[1].other_params.count("art"));
     EXPECT_EQ("cat1", results[1].category_id);
 
     EXPECT_EQ("URI3", results[2].uri);
-    EXPECT_EQ(nullptr, results[2].other_params["dnd_uri"]);
-    EXPECT_EQ("Category Fail", results[2].other_params["title"]->as_string());
-    EXPECT_EQ(nullptr, results[2].other_params["icon"]);
-    EXPECT_EQ("https://dash.ubuntu.com/imgs/cat_fail.png", results[2].other_params["art"]->as_string());
+    EXPECT_EQ(0u, results[2].other_params.count("dnd_uri"));
+    EXPECT_EQ("Category Fail", results[2].other_params["title"].get_string());
+    EXPECT_EQ(0u, results[2].other_params.count("icon"));
+    EXPECT_EQ("https://dash.ubuntu.com/imgs/cat_fail.png", results[2].other_params["art"].get_string());
 
     // check departments
     EXPECT_TRUE(dept != nullptr);
@@ -376,16 +413,18 @@ TEST_F(SmartScopesClientTest, userAgentHeader)
     ASSERT_EQ(4u, results.size());
 
     // user agent string is expected in the result title
-    EXPECT_EQ("ThisIsUserAgentHeader", results[3].other_params["title"]->as_string());
+    EXPECT_EQ("ThisIsUserAgentHeader", results[3].other_params["title"].get_string());
 }
 
 TEST_F(SmartScopesClientTest, preview)
 {
     PreviewReplyHandler handler;
     PreviewHandle::Columns columns;
-    std::vector<std::string> widgets;
-    handler.widget_handler = [&widgets](std::string const& widget_json) {
-        widgets.push_back(widget_json);
+    std::vector<PreviewWidget> widgets;
+    unsigned int batches = 0;
+    handler.widgets_handler = [&widgets, &batches](PreviewWidgetList const& batch) {
+        widgets.insert(widgets.end(), batch.begin(), batch.end());
+        ++batches;
     };
     handler.columns_handler = [&columns](PreviewHandle::Columns const &cols) {
         columns = cols;
@@ -424,32 +463,68 @@ TEST_F(SmartScopesClientTest, preview)
     EXPECT_EQ("widget_id_C", columns[2][2][0]);
 
     ASSERT_EQ(3u, widgets.size());
+    // The widgets arrive in a single response, so they are not passed on one at a time.
+    EXPECT_LT(batches, widgets.size());
     {
-        auto json = widgets[0];
-        JsonCppNode node(json);
-        EXPECT_EQ("widget_id_A", node.get_node("id")->as_string());
-        EXPECT_EQ("First widget.", node.get_node("text")->as_string());
-        EXPECT_EQ("Widget A", node.get_node("title")->as_string());
-        EXPECT_EQ("text", node.get_node("type")->as_string());
+        auto const& widget = widgets[0];
+        EXPECT_EQ("widget_id_A", widget.id());
+        EXPECT_EQ("First widget.", widget.attribute_values()["text"].get_string());
+        EXPECT_EQ("Widget A", widget.attribute_values()["title"].get_string());
+        EXPECT_EQ("text", widget.widget_type());
     }
     {
-        auto json = widgets[1];
-        JsonCppNode node(json);
-        EXPECT_EQ("widget_id_B", node.get_node("id")->as_string());
-        EXPECT_EQ("Second widget.", node.get_node("text")->as_string());
-        EXPECT_EQ("Widget B", node.get_node("title")->as_string());
-        EXPECT_EQ("text", node.get_node("type")->as_string());
+        auto const& widget = widgets[1];
+        EXPECT_EQ("widget_id_B", widget.id());
+        EXPECT_EQ("Second widget.", widget.attribute_values()["text"].get_string());
+        EXPECT_EQ("Widget B", widget.attribute_values()["title"].get_string());
+        EXPECT_EQ("text", widget.widget_type());
     }
     {
-        auto json = widgets[2];
-        JsonCppNode node(json);
-        EXPECT_EQ("widget_id_C", node.get_node("id")->as_string());
-        EXPECT_EQ("Third widget.", node.get_node("text")->as_string());
-        EXPECT_EQ("Widget C", node.get_node("title")->as_string());
-        EXPECT_EQ("text", node.get_node("type")->as_string());
+        auto const& widget = widgets[2];
+        EXPECT_EQ("widget_id_C", widget.id());
+        EXPECT_EQ("Third widget.", widget.attribute_values()["text"].get_string());
+        EXPECT_EQ("Widget C", widget.attribute_values()["title"].get_string());
+        EXPECT_EQ("text", widget.widget_type());
     }
 }
 
+TEST_F(SmartScopesClientTest, preview_invalid_widget)
+{
+    PreviewReplyHandler handler;
+    std::vector<PreviewWidget> widgets;
+    handler.widgets_handler = [&widgets](PreviewWidgetList const& batch) {
+        widgets.insert(widgets.end(), batch.begin(), batch.end());
+    };
+    handler.columns_handler = [](PreviewHandle::Columns const&) {};
+
+    // widget_id_B is invalid; it is dropped, but the widgets either side of it still arrive.
+    auto preview_handle = ssc_->preview(handler, sss_url_ + "/bad_widget", "result", "session_id", "platform", 0);
+    preview_handle->wait();
+
+    ASSERT_EQ(2u, widgets.size());
+    EXPECT_EQ("widget_id_A", widgets[0].id());
+    EXPECT_EQ("widget_id_C", widgets[1].id());
+
+    // If the handler rejects a batch, the widgets are passed on one at a time,
+    // so only the widget the handler cannot take is lost.
+    widgets.clear();
+    handler.widgets_handler = [&widgets](PreviewWidgetList const& batch) {
+        for (auto const& w : batch)
+        {
+            if (w.id() == "widget_id_A")
+            {
+                throw unity::InvalidArgumentException("widget_id_A rejected");
+            }
+        }
+        widgets.insert(widgets.end(), batch.begin(), batch.end());
+    };
+    preview_handle = ssc_->preview(handler, sss_url_ + "/bad_widget", "result", "session_id", "platform", 0);
+    preview_handle->wait();
+
+    ASSERT_EQ(1u, widgets.size());
+    EXPECT_EQ("widget_id_C", widgets[0].id());
+}
+
 TEST_F(SmartScopesClientTest, consecutive_searches)
 {
     SearchReplyHandler handler1, handler2, handler3, handler4, handler5;
@@ -490,6 +565,118 @@ TEST_F(SmartScopesClientTest, consecutive_searches)
     EXPECT_EQ(3u, results5.size());
 }
 
+TEST_F(SmartScopesClientTest, coalesced_searches)
+{
+    SearchReplyHandler handler1, handler2, handler3, handler4;
+    std::vector<SearchResult> results1, results2, results3, results4;
+    std::vector<std::shared_ptr<SearchCategory>> categories3;
+
+    handler1.filters_handler = [](Filters const &) {};
+    handler1.filter_state_handler = [](FilterState const&) {};
+    handler1.category_handler = [](std::shared_ptr<SearchCategory> const&) {};
+    handler1.departments_handler = [](std::shared_ptr<DepartmentInfo> const&) {};
+
+    handler2 = handler3 = handler4 = handler1;
+
+    handler1.result_handler = [&results1](SearchResult const& result) { results1.push_back(result); };
+    handler2.result_handler = [&results2](SearchResult const& result) { results2.push_back(result); };
+    handler3.result_handler = [&results3](SearchResult const& result) { results3.push_back(result); };
+    handler3.category_handler = [&categories3](std::shared_ptr<SearchCategory> const& cat) { categories3.push_back(cat); };
+    handler4.result_handler = [&results4](SearchResult const& result) { results4.push_back(result); };
+
+    // Identical searches share a single request, even if one of them is cancelled.
+    auto search_handle1 = ssc_->search(handler1, sss_url_ + "/demo", "stuff", "", "session_id", 7, "platform");
+    auto search_handle2 = ssc_->search(handler2, sss_url_ + "/demo", "stuff", "", "session_id", 7, "platform");
+    auto search_handle3 = ssc_->search(handler3, sss_url_ + "/demo", "stuff", "", "session_id", 7, "platform");
+    search_handle2->cancel_search();
+
+    // A different query ID is a different request.
+    auto search_handle4 = ssc_->search(handler4, sss_url_ + "/demo", "stuff", "", "session_id", 8, "platform");
+
+    search_handle1->wait();
+    EXPECT_EQ(3u, results1.size());
+    EXPECT_THROW(search_handle2->wait(), std::exception);
+    search_handle3->wait();
+    EXPECT_EQ(3u, results3.size());
+    EXPECT_EQ(1u, categories3.size());
+    search_handle4->wait();
+    EXPECT_EQ(3u, results4.size());
+
+    EXPECT_EQ(2, count_string("/demo/search"));
+
+    // Once the shared request is complete, the next identical search makes a new one.
+    results1.clear();
+    search_handle1 = ssc_->search(handler1, sss_url_ + "/demo", "stuff", "", "session_id", 7, "platform");
+    search_handle1->wait();
+    EXPECT_EQ(3u, results1.size());
+    EXPECT_EQ(3, count_string("/demo/search"));
+
+    // Cancelling every search that shares a request cancels the request.
+    search_handle1 = ssc_->search(handler1, sss_url_ + "/demo", "stuff", "", "session_id", 9, "platform");
+    search_handle2 = ssc_->search(handler2, sss_url_ + "/demo", "stuff", "", "session_id", 9, "platform");
+    search_handle1->cancel_search();
+    search_handle2->cancel_search();
+    EXPECT_THROW(search_handle1->wait(), std::exception);
+    EXPECT_THROW(search_handle2->wait(), std::exception);
+}
+
+TEST_F(SmartScopesClientTest, async_searches)
+{
+    SearchReplyHandler async_handler, sync_handler;
+    std::vector<SearchResult> async_results, sync_results;
+
+    async_handler.filters_handler = [](Filters const &) {};
+    async_handler.filter_state_handler = [](FilterState const&) {};
+    async_handler.category_handler = [](std::shared_ptr<SearchCategory> const&) {};
+    async_handler.departments_handler = [](std::shared_ptr<DepartmentInfo> const&) {};
+    sync_handler = async_handler;
+
+    async_handler.result_handler = [&async_results](SearchResult const& result) { async_results.push_back(result); };
+    sync_handler.result_handler = [&sync_results](SearchResult const& result) { sync_results.push_back(result); };
+
+    auto finished = std::make_shared<std::promise<std::exception_ptr>>();
+    async_handler.finished_handler = [&finished](std::exception_ptr const& error) { finished->set_value(error); };
+
+    // An asynchronous search needs no wait(), and can share its request with a synchronous one.
+    auto async_handle = ssc_->search(async_handler, sss_url_ + "/demo", "stuff", "", "session_id", 11, "platform");
+    auto sync_handle = ssc_->search(sync_handler, sss_url_ + "/demo", "stuff", "", "session_id", 11, "platform");
+    EXPECT_EQ(nullptr, finished->get_future().get());
+    EXPECT_EQ(3u, async_results.size());
+    sync_handle->wait();
+    EXPECT_EQ(3u, sync_results.size());
+    EXPECT_EQ(1, count_string("/demo/search"));
+
+    // Once finished, the search is no longer active.
+    EXPECT_THROW(async_handle->wait(), unity::LogicException);
+
+    // A cancelled asynchronous search still finishes, with an error.
+    finished = std::make_shared<std::promise<std::exception_ptr>>();
+    async_handle = ssc_->search(async_handler, sss_url_ + "/demo", "stuff", "", "session_id", 12, "platform");
+    async_handle->cancel_search();
+    EXPECT_NE(nullptr, finished->get_future().get());
+
+    // A failed asynchronous search finishes with the error.
+    finished = std::make_shared<std::promise<std::exception_ptr>>();
+    async_handle = ssc_->search(async_handler, "http://127.0.0.1:1", "stuff", "", "session_id", 13, "platform");
+    EXPECT_NE(nullptr, finished->get_future().get());
+}
+
+TEST_F(SmartScopesClientTest, async_preview)
+{
+    PreviewReplyHandler handler;
+    std::vector<PreviewWidget> widgets;
+    handler.widgets_handler = [&widgets](PreviewWidgetList const& batch) {
+        widgets.insert(widgets.end(), batch.begin(), batch.end());
+    };
+    handler.columns_handler = [](PreviewHandle::Columns const&) {};
+    std::promise<std::exception_ptr> finished;
+    handler.finished_handler = [&finished](std::exception_ptr const& error) { finished.set_value(error); };
+
+    auto preview_handle = ssc_->preview(handler, sss_url_ + "/demo", "result", "session_id", "platform", 0);
+    EXPECT_EQ(nullptr, finished.get_future().get());
+    EXPECT_FALSE(widgets.empty());
+}
+
 TEST_F(SmartScopesClientTest, consecutive_cancels)
 {
     SearchReplyHandler handler;
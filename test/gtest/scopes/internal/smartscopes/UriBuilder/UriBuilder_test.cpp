@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/smartscopes/HttpClientNetCpp.h>
+#include <unity/scopes/internal/smartscopes/UriBuilder.h>
+
+#include <gtest/gtest.h>
+
+#include <clocale>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+using namespace unity::scopes::internal::smartscopes;
+
+TEST(UriBuilder, percent_encode)
+{
+    EXPECT_EQ("", UriBuilder::percent_encode(""));
+    EXPECT_EQ("AZaz09-._~", UriBuilder::percent_encode("AZaz09-._~"));
+    EXPECT_EQ("a%20b%26c%3Dd%25%2F%3F%23%2B", UriBuilder::percent_encode("a b&c=d%/?#+"));
+    EXPECT_EQ("%7B%22a%22%3A1%7D", UriBuilder::percent_encode("{\"a\":1}"));
+    EXPECT_EQ("%C3%A9t%C3%A9", UriBuilder::percent_encode("\xc3\xa9t\xc3\xa9"));
+    EXPECT_EQ("%00%FF", UriBuilder::percent_encode(string("\0\xff", 2)));
+
+    // Appends to what is there already.
+    string out = "x=";
+    UriBuilder::percent_encode("a b", out);
+    EXPECT_EQ("x=a%20b", out);
+}
+
+// The encoding must be the same as that of the HTTP client, so the URIs don't change.
+
+TEST(UriBuilder, same_as_http_client)
+{
+    HttpClientNetCpp http_client(20000);
+
+    string all_bytes;
+    for (int c = 0; c < 256; ++c)
+    {
+        all_bytes += char(c);
+    }
+    EXPECT_EQ(http_client.to_percent_encoding(all_bytes), UriBuilder::percent_encode(all_bytes));
+}
+
+TEST(UriBuilder, params)
+{
+    UriBuilder uri("http://127.0.0.1/demo", "/search");
+    EXPECT_EQ("http://127.0.0.1/demo/search?", uri.str());
+
+    uri.param("q", "a b").param("query_id", int64_t(-3)).raw_param("locale", "en_GB");
+    uri.param("latitude", 51.507312, 5).param("longitude", -0.127634, 5);
+    EXPECT_EQ("http://127.0.0.1/demo/search?q=a%20b&query_id=-3&locale=en_GB&latitude=51.50731&longitude=-0.12763",
+              uri.str());
+}
+
+TEST(UriBuilder, decimal_point)
+{
+    // Look for an installed locale that uses a comma as the decimal point.
+    char const* old_locale = setlocale(LC_NUMERIC, nullptr);
+    string const saved = old_locale ? old_locale : "C";
+    bool have_comma_locale = false;
+    for (auto name : { "de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8", "fr_FR.utf8", "de_DE", "fr_FR" })
+    {
+        if (setlocale(LC_NUMERIC, name) && string(localeconv()->decimal_point) == ",")
+        {
+            have_comma_locale = true;
+            break;
+        }
+    }
+    if (!have_comma_locale)
+    {
+        cout << "No locale with a comma as the decimal point, skipping" << endl;
+        return;
+    }
+
+    UriBuilder uri("http://127.0.0.1/demo", "/search");
+    uri.param("latitude", 1.5, 2);
+    setlocale(LC_NUMERIC, saved.c_str());
+    EXPECT_EQ("http://127.0.0.1/demo/search?latitude=1.50", uri.str());
+}
+
+// A typical search URI must be the same as the one SmartScopesClient::search() used to build
+// with a locale-imbued ostringstream and the HTTP client's encoder.
+// (serialization-benchmark in test/gtest/scopes/benchmark compares the time it takes.)
+
+TEST(UriBuilder, same_as_ostringstream)
+{
+    HttpClientNetCpp http_client(20000);
+
+    string const base_url = "https://dash.ubuntu.com/smartscopes/v2/scopes/com.canonical.scopes.amazon";
+    string const query = "the quick brown fox";
+    string const session_id = "c5b8bd02-7e5a-4d1c-a0a7-d2f0ae6a7b4f";
+    string const settings = "{\"units\":\"metric\",\"days\":7,\"safe_search\":true}";
+    string const filters = "{\"dept\":[\"books\",\"music\"],\"rating\":4}";
+
+    ostringstream old_uri;
+    old_uri.imbue(locale::classic());
+    old_uri << base_url << "/search" << "?";
+    old_uri << "q=" << http_client.to_percent_encoding(query);
+    old_uri << "&session_id=" << http_client.to_percent_encoding(session_id);
+    old_uri << "&query_id=" << to_string(42);
+    old_uri << "&platform=" << "phone";
+    old_uri << "&settings=" << http_client.to_percent_encoding(settings);
+    old_uri << "&locale=" << "en_GB";
+    old_uri << "&country=" << "GB";
+    old_uri << fixed << setprecision(5) << "&latitude=" << 51.507312 << "&longitude=" << -0.127634;
+    old_uri << "&filters=" << http_client.to_percent_encoding(filters);
+
+    UriBuilder uri(base_url, "/search");
+    uri.param("q", query);
+    uri.param("session_id", session_id);
+    uri.param("query_id", int64_t(42));
+    uri.raw_param("platform", "phone");
+    uri.raw_param("settings", UriBuilder::percent_encode(settings));
+    uri.raw_param("locale", "en_GB");
+    uri.raw_param("country", "GB");
+    uri.param("latitude", 51.507312, 5);
+    uri.param("longitude", -0.127634, 5);
+    uri.param("filters", filters);
+
+    EXPECT_EQ(old_uri.str(), uri.str());
+}
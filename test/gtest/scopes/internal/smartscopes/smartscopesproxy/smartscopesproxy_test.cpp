@@ -31,7 +31,11 @@
 
 #include "../RaiiServer.h"
 
+#include <atomic>
+#include <fstream>
+#include <iostream>
 #include <memory>
+#include <thread>
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wctor-dtor-privacy"
@@ -313,6 +317,45 @@ TEST_F(smartscopesproxytest, search)
     reply->wait_until_finished();
 }
 
+TEST_F(smartscopesproxytest, search_cache)
+{
+    auto cache = reg_->get_search_cache();
+
+    // dummy.scope has a results TTL of none, so its replies are not cached.
+    auto reply = std::make_shared<Receiver>();
+    ScopeMetadata meta = reg_->get_metadata("dummy.scope");
+    meta.proxy()->search("search_string", SearchMetadata("en", "phone"), reply);
+    reply->wait_until_finished();
+    EXPECT_EQ(0u, cache->stats().entries);
+    EXPECT_EQ(0u, cache->stats().misses);
+
+    // dummy.scope.2 has a small results TTL, so the second search is answered from the cache.
+    meta = reg_->get_metadata("dummy.scope.2");
+    EXPECT_EQ(ScopeMetadata::ResultsTtlType::Small, meta.results_ttl_type());
+
+    reply = std::make_shared<Receiver>();
+    meta.proxy()->search("search_string", SearchMetadata("en", "phone"), reply);
+    reply->wait_until_finished();
+    EXPECT_EQ(0u, cache->stats().hits);
+    EXPECT_EQ(1u, cache->stats().misses);
+    EXPECT_EQ(1u, cache->stats().entries);
+    EXPECT_GT(cache->stats().bytes, 0u);
+
+    reply = std::make_shared<Receiver>();
+    meta.proxy()->search("search_string", SearchMetadata("en", "phone"), reply);
+    reply->wait_until_finished();
+    EXPECT_EQ(1u, cache->stats().hits);
+    EXPECT_EQ(1u, cache->stats().misses);
+
+    // A different query string is a different key.
+    auto other = std::make_shared<Receiver>();
+    meta.proxy()->search("other_string", SearchMetadata("en", "phone"), other);
+    other->wait_until_finished();
+    EXPECT_EQ(1u, cache->stats().hits);
+    EXPECT_EQ(2u, cache->stats().misses);
+    EXPECT_EQ(2u, cache->stats().entries);
+}
+
 TEST_F(smartscopesproxytest, consecutive_queries)
 {
     ScopeMetadata meta = reg_->get_metadata("dummy.scope");
@@ -332,6 +375,68 @@ TEST_F(smartscopesproxytest, consecutive_queries)
     }
 }
 
+int thread_count()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, 8, "Threads:") == 0)
+        {
+            return std::stoi(line.substr(8));
+        }
+    }
+    return 0;
+}
+
+TEST_F(smartscopesproxytest, concurrent_queries)
+{
+    // Remote queries don't park a thread each while their HTTP requests are in flight,
+    // so the number of threads stays flat no matter how many queries are running.
+    ScopeMetadata meta = reg_->get_metadata("dummy.scope");
+    std::vector<std::shared_ptr<Receiver>> replies;
+
+    const int iterations = 500;
+    int const threads_before = thread_count();
+
+    std::atomic<bool> sampling(true);
+    std::atomic<int> max_threads(threads_before);
+    std::thread sampler([&sampling, &max_threads]
+    {
+        while (sampling)
+        {
+            int n = thread_count();
+            if (n > max_threads)
+            {
+                max_threads = n;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    });
+
+    auto const start = std::chrono::steady_clock::now();
+
+    // Different query strings, so the searches don't share HTTP requests.
+    for (int i = 0; i < iterations; ++i)
+    {
+        replies.push_back(std::make_shared<Receiver>());
+        meta.proxy()->search("search_string_" + std::to_string(i), SearchMetadata("en", "phone"), replies.back());
+    }
+    for (int i = 0; i < iterations; ++i)
+    {
+        replies[i]->wait_until_finished();
+    }
+
+    auto const elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    sampling = false;
+    sampler.join();
+
+    // The sampler accounts for one of the additional threads.
+    EXPECT_LT(max_threads - threads_before, 20);
+    std::cout << "smartscopesproxy: " << iterations << " concurrent queries in " << elapsed.count() << " ms, "
+              << "threads before: " << threads_before << ", max: " << max_threads << std::endl;
+}
+
 class PreviewerWithCols : public PreviewListenerBase
 {
 public:
@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/zmq_middleware/MetricsEndpoint.h>
+#include <unity/scopes/ScopeExceptions.h>
+
+#include <zmqpp/poller.hpp>
+#include <zmqpp/socket.hpp>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wctor-dtor-privacy"
+#include <gtest/gtest.h>
+#pragma GCC diagnostic pop
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+using namespace std;
+using namespace unity::scopes;
+using namespace unity::scopes::internal;
+using namespace unity::scopes::internal::zmq_middleware;
+
+namespace
+{
+
+string const endpoint_dir = TEST_DIR;
+
+string query(zmqpp::context& c, string const& endpoint)
+{
+    zmqpp::socket s(c, zmqpp::socket_type::request);
+    s.set(zmqpp::socket_option::linger, 0);
+    s.connect(endpoint);
+    s.send("");
+
+    zmqpp::poller p;
+    p.add(s);
+    p.poll(2000);
+    EXPECT_TRUE(p.has_input(s));
+    string metrics;
+    if (p.has_input(s))
+    {
+        s.receive(metrics);
+    }
+    return metrics;
+}
+
+// Runs scopes-metrics with the given arguments and returns its exit status.
+// Standard output and standard error are returned in out.
+
+int run_tool(string const& args, string& out)
+{
+    string cmd = string(SCOPES_METRICS) + " " + args + " 2>&1";
+    FILE* f = popen(cmd.c_str(), "r");
+    EXPECT_NE(nullptr, f);
+    out.clear();
+    char buf[1024];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+    {
+        out.append(buf, n);
+    }
+    int status = pclose(f);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+} // namespace
+
+TEST(MetricsEndpoint, basic)
+{
+    zmqpp::context c;
+    MetricsRegistry r;
+    auto& requests = r.counter("requests");
+    requests.inc();
+
+    string endpoint = "ipc://" + endpoint_dir + "/basic-m";
+    MetricsEndpoint e(&c, endpoint, r);
+    EXPECT_EQ(endpoint, e.endpoint());
+
+    EXPECT_EQ(r.to_string(), query(c, endpoint));
+    EXPECT_EQ("counter requests 1\n", query(c, endpoint));
+
+    // Each request sees the current values.
+    requests.inc(2);
+    r.gauge("depth").set(5);
+    EXPECT_EQ("counter requests 3\ngauge depth 5\n", query(c, endpoint));
+}
+
+TEST(MetricsEndpoint, multipart_request)
+{
+    zmqpp::context c;
+    MetricsRegistry r;
+    r.counter("x").inc();
+
+    string endpoint = "ipc://" + endpoint_dir + "/multipart-m";
+    MetricsEndpoint e(&c, endpoint, r);
+
+    // All parts of the request are discarded, and there is still a single reply.
+    zmqpp::socket s(c, zmqpp::socket_type::request);
+    s.set(zmqpp::socket_option::linger, 0);
+    s.connect(endpoint);
+    s.send("a", zmqpp::socket::send_more);
+    s.send("b");
+    string metrics;
+    s.receive(metrics);
+    EXPECT_EQ("counter x 1\n", metrics);
+    EXPECT_FALSE(s.has_more_parts());
+}
+
+TEST(MetricsEndpoint, restart)
+{
+    zmqpp::context c;
+    MetricsRegistry r;
+    string endpoint = "ipc://" + endpoint_dir + "/restart-m";
+
+    // The destructor stops the endpoint thread, even if no-one ever asked for the metrics,
+    // and the endpoint can be reused straight away.
+    for (int i = 0; i < 10; ++i)
+    {
+        MetricsEndpoint e(&c, endpoint, r);
+    }
+    MetricsEndpoint e(&c, endpoint, r);
+    EXPECT_EQ("", query(c, endpoint));
+}
+
+TEST(MetricsEndpoint, exceptions)
+{
+    zmqpp::context c;
+    MetricsRegistry r;
+
+    string endpoint = "ipc://" + endpoint_dir + "/no_such_dir/x-m";
+    try
+    {
+        MetricsEndpoint e(&c, endpoint, r);
+        FAIL();
+    }
+    catch (MiddlewareException const& e)
+    {
+        string msg = e.what();
+        string expected = "unity::scopes::MiddlewareException: MetricsEndpoint(): cannot serve metrics on " + endpoint + ": ";
+        EXPECT_EQ(expected, msg.substr(0, expected.size())) << msg;
+    }
+
+    // The second endpoint uses a separate context, so only the bind fails.
+    endpoint = "ipc://" + endpoint_dir + "/busy-m";
+    MetricsEndpoint e(&c, endpoint, r);
+    zmqpp::context c2;
+    try
+    {
+        MetricsEndpoint e2(&c2, endpoint, r);
+        FAIL();
+    }
+    catch (MiddlewareException const& e)
+    {
+        string msg = e.what();
+        EXPECT_NE(string::npos, msg.find("safe_bind(): address in use: " + endpoint)) << msg;
+    }
+}
+
+TEST(ScopesMetrics, dump)
+{
+    // Separate directory, so there are no endpoints from other tests.
+    string dir = endpoint_dir + "/dump";
+    mkdir(dir.c_str(), 0700);
+
+    zmqpp::context c;
+    MetricsRegistry r1;
+    r1.counter("one").inc();
+    MetricsRegistry r2;
+    r2.gauge("two").set(2);
+
+    MetricsEndpoint e1(&c, "ipc://" + dir + "/tool1-m", r1);
+    MetricsEndpoint e2(&c, "ipc://" + dir + "/tool2-m", r2);
+
+    string out;
+    EXPECT_EQ(0, run_tool("-d " + dir + " tool2 tool1", out));
+    EXPECT_EQ("== tool2\ngauge two 2\n== tool1\ncounter one 1\n", out);
+
+    // Without ids, all endpoints in the directory are dumped, sorted by id.
+    EXPECT_EQ(0, run_tool("-d " + dir, out));
+    EXPECT_EQ("== tool1\ncounter one 1\n== tool2\ngauge two 2\n", out);
+}
+
+TEST(ScopesMetrics, no_response)
+{
+    zmqpp::context c;
+    MetricsRegistry r;
+    r.counter("live").inc();
+    MetricsEndpoint e(&c, "ipc://" + endpoint_dir + "/live-m", r);
+
+    // An id without an endpoint doesn't stop the other ids from being dumped, but sets the exit status.
+    string out;
+    EXPECT_EQ(1, run_tool("-d " + endpoint_dir + " -t 200 no_such_id live", out));
+    EXPECT_NE(string::npos, out.find("scopes-metrics: no_such_id: no response\n")) << out;
+    EXPECT_NE(string::npos, out.find("== live\ncounter live 1\n")) << out;
+}
+
+TEST(ScopesMetrics, usage)
+{
+    string out;
+    EXPECT_EQ(2, run_tool("-x", out));
+    EXPECT_EQ("usage: scopes-metrics [-d endpoint_dir] [-t timeout_ms] [id...]\n", out);
+
+    EXPECT_EQ(2, run_tool("-t 0 id", out));
+    EXPECT_EQ(2, run_tool("-d", out));
+
+    EXPECT_EQ(1, run_tool("-d " + endpoint_dir + "/no_such_dir", out));
+    EXPECT_EQ(0u, out.find("scopes-metrics: cannot open " + endpoint_dir + "/no_such_dir: ")) << out;
+
+    char const* xdg_runtime_dir = getenv("XDG_RUNTIME_DIR");
+    string saved = xdg_runtime_dir ? xdg_runtime_dir : "";
+    unsetenv("XDG_RUNTIME_DIR");
+    EXPECT_EQ(1, run_tool("", out));
+    EXPECT_EQ("scopes-metrics: XDG_RUNTIME_DIR is not set, use -d to specify the endpoint directory\n", out);
+    if (xdg_runtime_dir)
+    {
+        setenv("XDG_RUNTIME_DIR", saved.c_str(), 1);
+    }
+}
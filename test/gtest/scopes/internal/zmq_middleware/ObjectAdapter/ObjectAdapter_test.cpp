@@ -339,6 +339,85 @@ TEST(ObjectAdapter, add_remove_find)
     EXPECT_EQ(nullptr, a.find("fred").get());
 }
 
+// Concurrent lookups of long-lived servants while another thread adds and removes
+// short-lived servants, as happens for reply objects during a burst of queries.
+// The lookups must always find the long-lived servants, and a removed servant must
+// no longer be found. (See test/gtest/scopes/benchmark/adapter for the performance.)
+
+TEST(ObjectAdapter, find_with_churn)
+{
+    auto rt = RuntimeImpl::create("testscope", runtime_ini);
+    ZmqMiddleware mw("testscope", rt.get(), zmq_ini);
+
+    wait();
+    ObjectAdapter a(mw, "testscope", "ipc://testscope", RequestMode::Twoway, 5);
+
+    int const num_servants = 64;
+    vector<shared_ptr<MyServant>> servants;
+    for (int i = 0; i < num_servants; ++i)
+    {
+        servants.push_back(make_shared<MyServant>());
+        a.add("servant_" + to_string(i), servants.back());
+    }
+
+    atomic_bool done(false);
+    atomic<long> failures(0);
+    atomic<long> churn_failures(0);
+    long churn_ops = 0;
+
+    thread churner([&]
+    {
+        auto o = make_shared<MyServant>();
+        for (long i = 0; !done; ++i)
+        {
+            string id = "churn_" + to_string(i);
+            a.add(id, o);
+            if (a.find(id) != o)
+            {
+                ++churn_failures;
+            }
+            a.remove(id);
+            if (a.find(id) != nullptr)
+            {
+                ++churn_failures;
+            }
+            ++churn_ops;
+        }
+    });
+
+    int const num_readers = 4;
+    int const num_lookups = 20000;
+    vector<thread> readers;
+    for (int r = 0; r < num_readers; ++r)
+    {
+        readers.emplace_back([&, r]
+        {
+            for (int n = 0; n < num_lookups; ++n)
+            {
+                int const i = (r + n) % num_servants;
+                if (a.find("servant_" + to_string(i)) != servants[i])
+                {
+                    ++failures;
+                }
+            }
+        });
+    }
+    for (auto& t : readers)
+    {
+        t.join();
+    }
+    done = true;
+    churner.join();
+
+    EXPECT_EQ(0, failures.load());
+    EXPECT_EQ(0, churn_failures.load());
+    EXPECT_GT(churn_ops, 0);
+    for (int i = 0; i < num_servants; ++i)
+    {
+        EXPECT_EQ(servants[i], a.find("servant_" + to_string(i)));
+    }
+}
+
 TEST(ObjectAdapter, dispatch_oneway_to_twoway)
 {
     ZmqMiddleware mw("testscope", nullptr, zmq_ini);
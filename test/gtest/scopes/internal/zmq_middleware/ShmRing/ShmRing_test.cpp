@@ -0,0 +1,309 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+#include <unity/scopes/internal/zmq_middleware/ShmDoorbell.h>
+#include <unity/scopes/internal/zmq_middleware/ShmRing.h>
+
+#include <scopes/internal/zmq_middleware/capnproto/Message.capnp.h>
+#include <unity/scopes/ScopeExceptions.h>
+
+#include <capnp/serialize.h>
+
+#include <thread>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wctor-dtor-privacy"
+#include <gtest/gtest.h>
+#pragma GCC diagnostic pop
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace unity;
+using namespace unity::scopes;
+using namespace unity::scopes::internal::zmq_middleware;
+
+namespace
+{
+
+string const endpoint = "ipc:///tmp/ShmRing_test-" + to_string(getpid());
+
+void make_request(capnp::MessageBuilder& b, string const& id, string const& op_name)
+{
+    auto request = b.initRoot<capnproto::Request>();
+    request.setMode(capnproto::RequestMode::ONEWAY);
+    request.setId(id.c_str());
+    request.setCat("Reply");
+    request.setOpName(op_name.c_str());
+}
+
+bool write(ShmRing::SPtr const& ring, string const& id, string const& op_name, int64_t timeout = -1)
+{
+    capnp::MallocMessageBuilder b;
+    make_request(b, id, op_name);
+    return ring->write(b.getSegmentsForOutput(), timeout);
+}
+
+string read_op_name(ShmRing::SPtr const& ring)
+{
+    string op_name;
+    bool got_message = ring->read([&op_name](kj::ArrayPtr<capnp::word const> msg)
+    {
+        capnp::FlatArrayMessageReader reader(msg);
+        op_name = reader.getRoot<capnproto::Request>().getOpName().cStr();
+    });
+    EXPECT_TRUE(got_message);
+    return op_name;
+}
+
+// Maps the segment of a ring so a test can play the part of a misbehaving peer.
+// The offsets mirror the segment layout in ShmRing.cpp.
+
+class RawSegment
+{
+public:
+    RawSegment(string const& name)
+    {
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        EXPECT_NE(-1, fd);
+        size_ = lseek(fd, 0, SEEK_END);
+        addr_ = static_cast<char*>(mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+        close(fd);
+        EXPECT_NE(MAP_FAILED, static_cast<void*>(addr_));
+    }
+
+    ~RawSegment()
+    {
+        munmap(addr_, size_);
+    }
+
+    uint64_t& capacity()
+    {
+        return *reinterpret_cast<uint64_t*>(addr_ + 8);
+    }
+
+    uint32_t& first_frame_size()
+    {
+        return *reinterpret_cast<uint32_t*>(addr_ + data_offset);
+    }
+
+private:
+    static constexpr size_t data_offset = 256;
+
+    char* addr_;
+    size_t size_;
+};
+
+} // namespace
+
+TEST(ShmRing, basic)
+{
+    auto consumer = ShmRing::create(ShmRing::ring_name(endpoint, "basic"));
+    auto producer = ShmRing::open(ShmRing::ring_name(endpoint, "basic"));
+    EXPECT_EQ(consumer->name(), producer->name());
+    EXPECT_FALSE(producer->closed());
+
+    EXPECT_FALSE(consumer->read([](kj::ArrayPtr<capnp::word const>) { FAIL(); }));
+
+    EXPECT_TRUE(write(producer, "basic", "push"));
+    EXPECT_TRUE(write(producer, "basic", "finished"));
+    EXPECT_EQ("push", read_op_name(consumer));
+    EXPECT_EQ("finished", read_op_name(consumer));
+    EXPECT_TRUE(producer->wait_until_empty(0));
+}
+
+TEST(ShmRing, open_nonexistent)
+{
+    try
+    {
+        ShmRing::open(ShmRing::ring_name(endpoint, "no_such_ring"));
+        FAIL();
+    }
+    catch (MiddlewareException const& e)
+    {
+        EXPECT_NE(string::npos, string(e.what()).find("ShmRing::open(): cannot open"));
+    }
+}
+
+TEST(ShmRing, wrap_around)
+{
+    // Small ring, so messages of varying size wrap many times.
+    auto consumer = ShmRing::create(ShmRing::ring_name(endpoint, "wrap"), 1024);
+    auto producer = ShmRing::open(consumer->name());
+
+    int const num_messages = 10000;
+    thread t([producer, num_messages]
+    {
+        for (int i = 0; i < num_messages; ++i)
+        {
+            ASSERT_TRUE(write(producer, "wrap", string(i % 97, 'x') + to_string(i)));
+        }
+    });
+
+    for (int i = 0; i < num_messages; )
+    {
+        string op_name;
+        if (consumer->read([&op_name](kj::ArrayPtr<capnp::word const> msg)
+            {
+                capnp::FlatArrayMessageReader reader(msg);
+                op_name = reader.getRoot<capnproto::Request>().getOpName().cStr();
+            }))
+        {
+            ASSERT_EQ(string(i % 97, 'x') + to_string(i), op_name);
+            ++i;
+        }
+        else
+        {
+            this_thread::yield();
+        }
+    }
+    t.join();
+}
+
+TEST(ShmRing, full)
+{
+    auto consumer = ShmRing::create(ShmRing::ring_name(endpoint, "full"), 1024);
+    auto producer = ShmRing::open(consumer->name());
+
+    int count = 0;
+    while (write(producer, "full", "push", 0))
+    {
+        ++count;
+    }
+    EXPECT_GT(count, 0);
+    EXPECT_FALSE(producer->wait_until_empty(10));
+
+    // After draining one message, there is room again.
+    EXPECT_EQ("push", read_op_name(consumer));
+    EXPECT_TRUE(write(producer, "full", "push", 0));
+}
+
+TEST(ShmRing, too_large)
+{
+    auto consumer = ShmRing::create(ShmRing::ring_name(endpoint, "too_large"), 1024);
+    auto producer = ShmRing::open(consumer->name());
+
+    EXPECT_FALSE(write(producer, "too_large", string(producer->max_message_size(), 'x'), -1));
+    EXPECT_FALSE(consumer->read([](kj::ArrayPtr<capnp::word const>) { FAIL(); }));
+}
+
+TEST(ShmRing, closed)
+{
+    auto consumer = ShmRing::create(ShmRing::ring_name(endpoint, "closed"), 1024);
+    auto producer = ShmRing::open(consumer->name());
+
+    consumer->close();
+    EXPECT_TRUE(producer->closed());
+    EXPECT_FALSE(write(producer, "closed", "push", -1));
+
+    // Once the owner goes away, the segment can no longer be opened.
+    auto name = consumer->name();
+    consumer = nullptr;
+    EXPECT_THROW(ShmRing::open(name), MiddlewareException);
+}
+
+TEST(ShmDoorbell, ring_and_wait)
+{
+    auto consumer = ShmDoorbell::create(ShmDoorbell::doorbell_name(endpoint));
+    auto producer = ShmDoorbell::open(consumer->name());
+
+    // No ring() since we read the sequence number: wait() times out.
+    auto seq = consumer->sequence();
+    auto start = chrono::steady_clock::now();
+    consumer->wait(seq, 50);
+    EXPECT_GE(chrono::steady_clock::now() - start, chrono::milliseconds(40));
+
+    // ring() before wait() must not be lost.
+    seq = consumer->sequence();
+    producer->ring();
+    start = chrono::steady_clock::now();
+    consumer->wait(seq, 5000);
+    EXPECT_LT(chrono::steady_clock::now() - start, chrono::milliseconds(1000));
+
+    // ring() from another thread wakes up the consumer.
+    seq = consumer->sequence();
+    thread t([producer]
+    {
+        this_thread::sleep_for(chrono::milliseconds(50));
+        producer->ring();
+    });
+    start = chrono::steady_clock::now();
+    consumer->wait(seq, 5000);
+    EXPECT_LT(chrono::steady_clock::now() - start, chrono::milliseconds(2000));
+    EXPECT_NE(seq, consumer->sequence());
+    t.join();
+}
+
+TEST(ShmDoorbell, names)
+{
+    EXPECT_EQ(ShmDoorbell::doorbell_name("ipc:///a"), ShmDoorbell::doorbell_name("ipc:///a"));
+    EXPECT_NE(ShmDoorbell::doorbell_name("ipc:///a"), ShmDoorbell::doorbell_name("ipc:///b"));
+    EXPECT_EQ('/', ShmDoorbell::doorbell_name("ipc:///a")[0]);
+    EXPECT_EQ(0u, ShmRing::ring_name("ipc:///a", "id").find(ShmDoorbell::doorbell_name("ipc:///a")));
+}
+
+TEST(ShmRing, ignores_capacity_change)
+{
+    auto consumer = ShmRing::create(ShmRing::ring_name(endpoint, "capacity"), 1024);
+    auto producer = ShmRing::open(consumer->name());
+    RawSegment raw(consumer->name());
+
+    // The capacity is validated once, when the ring is opened. Changing it afterwards has no effect.
+    raw.capacity() = 1 << 30;
+    EXPECT_EQ(size_t(1024 / 2 - 8), consumer->max_message_size());
+    EXPECT_EQ(size_t(1024 / 2 - 8), producer->max_message_size());
+    EXPECT_TRUE(write(producer, "capacity", "push"));
+    EXPECT_EQ("push", read_op_name(consumer));
+
+    // A ring with a bad capacity cannot be opened.
+    EXPECT_THROW(ShmRing::open(consumer->name()), MiddlewareException);
+}
+
+TEST(ShmRing, invalid_frame)
+{
+    auto consumer = ShmRing::create(ShmRing::ring_name(endpoint, "invalid_frame"), 1024);
+    auto producer = ShmRing::open(consumer->name());
+    RawSegment raw(consumer->name());
+
+    ASSERT_TRUE(write(producer, "invalid_frame", "push"));
+    raw.first_frame_size() = 1 << 20;
+    EXPECT_THROW(consumer->read([](kj::ArrayPtr<capnp::word const>) { FAIL(); }), MiddlewareException);
+    EXPECT_TRUE(producer->closed());
+}
+
+// The frame size is read once, so changing it while the consumer is using the message
+// does not change the size of the message that was passed to the consumer.
+
+TEST(ShmRing, frame_size_read_once)
+{
+    auto consumer = ShmRing::create(ShmRing::ring_name(endpoint, "frame_size"), 1024);
+    auto producer = ShmRing::open(consumer->name());
+    RawSegment raw(consumer->name());
+
+    ASSERT_TRUE(write(producer, "frame_size", "push"));
+    ASSERT_TRUE(write(producer, "frame_size", "second"));
+    uint32_t const size = raw.first_frame_size();
+    EXPECT_TRUE(consumer->read([&raw, size](kj::ArrayPtr<capnp::word const> msg)
+    {
+        raw.first_frame_size() = 1 << 20;
+        EXPECT_EQ(size / sizeof(capnp::word), msg.size());
+    }));
+    EXPECT_EQ("second", read_op_name(consumer));
+}
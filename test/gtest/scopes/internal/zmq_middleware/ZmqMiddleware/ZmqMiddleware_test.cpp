@@ -19,8 +19,19 @@
 #include <unity/scopes/internal/zmq_middleware/ZmqMiddleware.h>
 
 #include <unity/scopes/internal/RuntimeImpl.h>
+#include <unity/scopes/internal/InvokeInfo.h>
 #include <unity/scopes/internal/MWObjectProxy.h>
+#include <unity/scopes/internal/MWQuery.h>
+#include <unity/scopes/internal/QueryObjectBase.h>
+#include <unity/scopes/internal/ReplyObjectBase.h>
+#include <unity/scopes/internal/zmq_middleware/LocalObjects.h>
+#include <unity/scopes/internal/zmq_middleware/LocalReply.h>
+#include <unity/scopes/internal/zmq_middleware/ShmRing.h>
 #include <unity/scopes/internal/zmq_middleware/ZmqObjectProxy.h>
+#include <unity/scopes/internal/zmq_middleware/ZmqQueryCtrl.h>
+#include <unity/scopes/internal/zmq_middleware/ZmqReply.h>
+#include <unity/scopes/internal/zmq_middleware/ZmqScope.h>
+#include <unity/scopes/CannedQuery.h>
 #include <unity/scopes/ScopeExceptions.h>
 
 #pragma GCC diagnostic push
@@ -35,6 +46,7 @@ using namespace unity::scopes::internal::zmq_middleware;
 
 string const runtime_ini = TEST_DIR "/Runtime.ini";
 string const zmq_ini = TEST_DIR "/Zmq.ini";
+string const zmq_shm_ini = TEST_DIR "/ZmqShm.ini";
 
 // Basic test.
 
@@ -525,3 +537,365 @@ TEST(ZmqMiddleware, shutdown_after_start_with_adapter)
     }
     mw.wait_for_shutdown();
 }
+
+class MyReplyObject : public ReplyObjectBase
+{
+public:
+    virtual void push(VariantMap const& result) noexcept override
+    {
+        lock_guard<mutex> lock(mutex_);
+        received_.push_back(result.at("n").get_int());
+    }
+
+    virtual void finished(CompletionDetails const&) noexcept override
+    {
+        lock_guard<mutex> lock(mutex_);
+        finished_ = true;
+        cond_.notify_all();
+    }
+
+    virtual void info(OperationInfo const&) noexcept override
+    {
+    }
+
+    vector<int> wait_for_finished()
+    {
+        unique_lock<mutex> lock(mutex_);
+        EXPECT_TRUE(cond_.wait_for(lock, chrono::seconds(5), [this] { return finished_; }));
+        return received_;
+    }
+
+private:
+    vector<int> received_;
+    bool finished_ = false;
+    mutex mutex_;
+    condition_variable cond_;
+};
+
+// Replies to a reply object in the same process are delivered in order, without going through zmq.
+
+TEST(ZmqMiddleware, local_reply)
+{
+    ZmqMiddleware mw("testscope", nullptr, zmq_ini);
+    mw.start();
+
+    auto ro = make_shared<MyReplyObject>();
+    auto proxy = mw.add_reply_object(ro);
+    ASSERT_TRUE(LocalObjects::instance().find(proxy->endpoint(), proxy->identity()));
+
+    auto reply = make_reply_proxy(&mw, proxy->endpoint(), proxy->identity(), proxy->target_category());
+    ASSERT_NE(nullptr, dynamic_pointer_cast<LocalReply>(reply));
+
+    int const num_pushes = 1000;
+    for (int i = 0; i < num_pushes; ++i)
+    {
+        reply->push(VariantMap{ { "n", Variant(i) } });
+    }
+    reply->finished(CompletionDetails(CompletionDetails::OK));
+
+    auto received = ro->wait_for_finished();
+    ASSERT_EQ(size_t(num_pushes), received.size());
+    for (int i = 0; i < num_pushes; ++i)
+    {
+        EXPECT_EQ(i, received[i]);
+    }
+
+    // Once the middleware stops, proxies no longer bypass it.
+    mw.stop();
+    EXPECT_FALSE(LocalObjects::instance().find(proxy->endpoint(), proxy->identity()));
+    mw.wait_for_shutdown();
+}
+
+// Replies from a scope in another middleware on the same host are delivered via the shared memory ring.
+
+TEST(ZmqMiddleware, shm_reply)
+{
+    ZmqMiddleware client_mw("testclient", nullptr, zmq_shm_ini);
+    client_mw.start();
+    ZmqMiddleware scope_mw("testscope", nullptr, zmq_shm_ini);
+    scope_mw.start();
+
+    auto ro = make_shared<MyReplyObject>();
+    auto proxy = client_mw.add_reply_object(ro);
+
+    // The client has created a ring for the reply object.
+    EXPECT_NO_THROW(ShmRing::open(ShmRing::ring_name(proxy->endpoint(), proxy->identity())));
+
+    // Talk to the reply object the way a scope in another process would, bypassing LocalObjects.
+    auto reply = make_shared<ZmqReply>(&scope_mw, proxy->endpoint(), proxy->identity(), proxy->target_category());
+
+    int const num_pushes = 1000;
+    for (int i = 0; i < num_pushes; ++i)
+    {
+        reply->push(VariantMap{ { "n", Variant(i) } });
+    }
+    reply->finished(CompletionDetails(CompletionDetails::OK));
+
+    auto received = ro->wait_for_finished();
+    ASSERT_EQ(size_t(num_pushes), received.size());
+    for (int i = 0; i < num_pushes; ++i)
+    {
+        EXPECT_EQ(i, received[i]);
+    }
+
+    scope_mw.stop();
+    scope_mw.wait_for_shutdown();
+    client_mw.stop();
+    client_mw.wait_for_shutdown();
+}
+
+// A message that doesn't fit into the ring switches the reply proxy to zmq without reordering messages.
+
+TEST(ZmqMiddleware, shm_reply_fallback)
+{
+    ZmqMiddleware client_mw("testclient", nullptr, zmq_shm_ini);
+    client_mw.start();
+    ZmqMiddleware scope_mw("testscope", nullptr, zmq_shm_ini);
+    scope_mw.start();
+
+    auto ro = make_shared<MyReplyObject>();
+    auto proxy = client_mw.add_reply_object(ro);
+    auto reply = make_shared<ZmqReply>(&scope_mw, proxy->endpoint(), proxy->identity(), proxy->target_category());
+
+    string const large(ShmRing::default_capacity, 'x');
+    reply->push(VariantMap{ { "n", Variant(0) } });                                 // Via the ring
+    reply->push(VariantMap{ { "n", Variant(1) }, { "pad", Variant(large) } });      // Via zmq
+    reply->push(VariantMap{ { "n", Variant(2) } });                                 // Via zmq
+    reply->finished(CompletionDetails(CompletionDetails::OK));
+
+    EXPECT_EQ(vector<int>({ 0, 1, 2 }), ro->wait_for_finished());
+
+    scope_mw.stop();
+    scope_mw.wait_for_shutdown();
+    client_mw.stop();
+    client_mw.wait_for_shutdown();
+}
+
+// Without SharedMemory.Replies, the client does not create a ring.
+
+TEST(ZmqMiddleware, shm_reply_disabled)
+{
+    ZmqMiddleware client_mw("testclient", nullptr, zmq_ini);
+    client_mw.start();
+
+    auto proxy = client_mw.add_reply_object(make_shared<MyReplyObject>());
+    EXPECT_THROW(ShmRing::open(ShmRing::ring_name(proxy->endpoint(), proxy->identity())), MiddlewareException);
+
+    client_mw.stop();
+    client_mw.wait_for_shutdown();
+}
+
+TEST(ZmqMiddleware, local_objects)
+{
+    ZmqMiddleware mw("testscope", nullptr, zmq_ini);
+
+    auto so = make_shared<MyScopeObject>();
+    auto proxy = mw.add_scope_object("fred", so);
+
+    auto& objects = LocalObjects::instance();
+    auto target = objects.find(proxy->endpoint(), "fred");
+    ASSERT_TRUE(target);
+    EXPECT_EQ(&mw, target.mw);
+    EXPECT_EQ(so, target.object);
+    EXPECT_EQ(proxy->endpoint(), target.adapter->endpoint());
+    target = LocalObjects::Target{ nullptr, nullptr, nullptr };
+
+    EXPECT_FALSE(objects.find(proxy->endpoint(), "no_such_object"));
+    EXPECT_FALSE(objects.find("ipc:///no/such/endpoint", "fred"));
+
+    // A proxy for a remote reply object is a plain ZmqReply.
+    auto reply = make_reply_proxy(&mw, "ipc:///no/such/endpoint", "fred", "Reply");
+    EXPECT_EQ(nullptr, dynamic_pointer_cast<LocalReply>(reply));
+
+    // Entries don't keep objects alive.
+    so.reset();
+    EXPECT_FALSE(objects.find(proxy->endpoint(), "fred"));
+
+    mw.stop();
+    mw.wait_for_shutdown();
+}
+
+class MyQueryObject : public QueryObjectBase
+{
+public:
+    MyQueryObject(int n, vector<int>& order, mutex& m, condition_variable& c) :
+        n_(n),
+        order_(order),
+        mutex_(m),
+        cond_(c)
+    {
+    }
+
+    virtual void run(MWReplyProxy const&, InvokeInfo const& info) noexcept override
+    {
+        EXPECT_EQ(nullptr, info.mw->runtime());
+        lock_guard<mutex> lock(mutex_);
+        EXPECT_NE(caller_, this_thread::get_id());  // run() must not be dispatched synchronously.
+        order_.push_back(n_);
+        cond_.notify_all();
+    }
+
+    virtual void cancel(InvokeInfo const&) override
+    {
+    }
+
+    virtual bool pushable(InvokeInfo const&) const noexcept override
+    {
+        return true;
+    }
+
+    virtual int cardinality(InvokeInfo const&) const noexcept override
+    {
+        return 0;
+    }
+
+    virtual void set_self(SPtr const&) noexcept override
+    {
+    }
+
+    thread::id caller_ = this_thread::get_id();
+
+private:
+    int n_;
+    vector<int>& order_;
+    mutex& mutex_;
+    condition_variable& cond_;
+};
+
+// run() on a query object in the same process is dispatched on the local query pool, in order.
+
+TEST(ZmqMiddleware, local_query_run)
+{
+    ZmqMiddleware mw("testscope", nullptr, zmq_ini);
+    mw.start();
+
+    vector<int> order;
+    mutex m;
+    condition_variable c;
+
+    auto reply = mw.add_reply_object(make_shared<MyReplyObject>());
+
+    int const num_queries = 100;
+    vector<shared_ptr<MyQueryObject>> queries;
+    vector<MWQueryProxy> proxies;
+    for (int i = 0; i < num_queries; ++i)
+    {
+        queries.push_back(make_shared<MyQueryObject>(i, order, m, c));
+        proxies.push_back(mw.add_query_object(queries.back()));
+    }
+    for (auto const& p : proxies)
+    {
+        p->run(reply);
+    }
+
+    {
+        unique_lock<mutex> lock(m);
+        EXPECT_TRUE(c.wait_for(lock, chrono::seconds(5), [&order] { return order.size() == size_t(num_queries); }));
+        for (int i = 0; i < num_queries; ++i)
+        {
+            EXPECT_EQ(i, order[i]);
+        }
+    }
+
+    mw.stop();
+    mw.wait_for_shutdown();
+}
+
+class SlowScopeObject : public MyScopeObject
+{
+public:
+    SlowScopeObject(chrono::milliseconds delay) :
+        delay_(delay),
+        running_(0),
+        max_running_(0)
+    {
+    }
+
+    virtual MWQueryCtrlProxy search(CannedQuery const&,
+                                    SearchMetadata const&,
+                                    VariantMap const&,
+                                    MWReplyProxy const&,
+                                    InvokeInfo const& info) override
+    {
+        {
+            lock_guard<mutex> lock(mutex_);
+            max_running_ = max(max_running_, ++running_);
+        }
+        this_thread::sleep_for(delay_);
+        {
+            lock_guard<mutex> lock(mutex_);
+            --running_;
+        }
+        auto mw = dynamic_cast<ZmqMiddleware*>(info.mw);
+        return make_shared<ZmqQueryCtrl>(mw, "ipc:///tmp/no_such_endpoint", "ctrl", "QueryCtrl");
+    }
+
+    int max_running()
+    {
+        lock_guard<mutex> lock(mutex_);
+        return max_running_;
+    }
+
+private:
+    chrono::milliseconds delay_;
+    int running_;
+    int max_running_;
+    mutex mutex_;
+};
+
+// Direct calls to a scope in the same process are dispatched by the scope's adapter,
+// so search() is never called concurrently, just as for requests that arrive via zmq.
+
+TEST(ZmqMiddleware, local_search_serialized)
+{
+    ZmqMiddleware mw("testscope", nullptr, zmq_ini);
+    mw.start();
+
+    auto so = make_shared<SlowScopeObject>(chrono::milliseconds(50));
+    auto proxy = mw.add_scope_object("fred", so);
+    auto scope = make_shared<ZmqScope>(&mw, proxy->endpoint(), "fred", "Scope", 5000);
+    auto reply = mw.add_reply_object(make_shared<MyReplyObject>());
+
+    vector<thread> threads;
+    for (int i = 0; i < 4; ++i)
+    {
+        threads.push_back(thread([&]
+        {
+            EXPECT_NO_THROW(scope->search(CannedQuery("fred"), VariantMap(), VariantMap(), reply));
+        }));
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    EXPECT_EQ(1, so->max_running());
+
+    mw.stop();
+    mw.wait_for_shutdown();
+}
+
+// Direct calls to a scope in the same process time out like remote calls.
+
+TEST(ZmqMiddleware, local_search_timeout)
+{
+    ZmqMiddleware mw("testscope", nullptr, zmq_ini);
+    mw.start();
+
+    auto so = make_shared<SlowScopeObject>(chrono::milliseconds(1000));
+    auto proxy = mw.add_scope_object("fred", so);
+    auto scope = make_shared<ZmqScope>(&mw, proxy->endpoint(), "fred", "Scope", 100);
+    auto reply = mw.add_reply_object(make_shared<MyReplyObject>());
+
+    try
+    {
+        scope->search(CannedQuery("fred"), VariantMap(), VariantMap(), reply);
+        FAIL();
+    }
+    catch (TimeoutException const& e)
+    {
+        EXPECT_NE(string::npos, string(e.what()).find("op = search")) << e.what();
+    }
+
+    mw.stop();
+    mw.wait_for_shutdown();
+}
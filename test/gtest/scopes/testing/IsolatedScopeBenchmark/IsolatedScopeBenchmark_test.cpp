@@ -37,6 +37,8 @@
 #include <cstdio>
 #include <fstream>
 #include <random>
+#include <sstream>
+#include <stdexcept>
 
 namespace
 {
@@ -185,6 +187,80 @@ TEST(BenchmarkResultXml, saving_and_loading_works)
     }
 }
 
+TEST(BenchmarkResultJson, saving_and_loading_works)
+{
+    const std::string fn{"test.result"};
+    std::remove(fn.c_str());
+
+    unity::scopes::testing::Benchmark::Result reference;
+    reference.sample_size = 2;
+    reference.timing.sample = {unity::scopes::testing::Benchmark::Result::Timing::Seconds{0.5},
+                               unity::scopes::testing::Benchmark::Result::Timing::Seconds{0.25}};
+    reference.timing.mean = unity::scopes::testing::Benchmark::Result::Timing::Seconds{0.375};
+
+    {
+        std::ofstream out{fn.c_str()};
+        ASSERT_NO_THROW(reference.save_to_json(out));
+    }
+
+    {
+        unity::scopes::testing::Benchmark::Result result;
+        std::ifstream in{fn.c_str()};
+        ASSERT_NO_THROW(result.load_from_json(in));
+        EXPECT_EQ(reference, result);
+    }
+
+    {
+        unity::scopes::testing::Benchmark::Result result;
+        std::istringstream in{"{\"sample_size\": 1}"};
+        EXPECT_THROW(result.load_from_json(in), std::runtime_error);
+    }
+}
+
+TEST(BenchmarkLoadResultJson, saving_and_loading_works)
+{
+    unity::scopes::testing::Benchmark::LoadResult reference;
+    reference.finished.sample_size = 2;
+    reference.finished.timing.sample = {unity::scopes::testing::Benchmark::Result::Timing::Seconds{0.5},
+                                        unity::scopes::testing::Benchmark::Result::Timing::Seconds{0.25}};
+    reference.first_result.sample_size = 1;
+    reference.first_result.timing.sample = {unity::scopes::testing::Benchmark::Result::Timing::Seconds{0.125}};
+    reference.queries_per_second = 8;
+    reference.results_per_second = 16.5;
+    reference.timeouts = 1;
+
+    std::stringstream s;
+    ASSERT_NO_THROW(reference.save_to_json(s));
+
+    unity::scopes::testing::Benchmark::LoadResult result;
+    ASSERT_NO_THROW(result.load_from_json(s));
+    EXPECT_EQ(reference, result);
+
+    std::istringstream in{"{\"finished\": {}}"};
+    EXPECT_THROW(result.load_from_json(in), std::runtime_error);
+}
+
+TEST(BenchmarkResultTiming, percentile)
+{
+    typedef unity::scopes::testing::Benchmark::Result::Timing::Seconds Seconds;
+
+    unity::scopes::testing::Benchmark::Result::Timing timing;
+    EXPECT_THROW(timing.percentile(50), std::logic_error);
+
+    for (int i = 100; i >= 1; i--)
+        timing.sample.push_back(Seconds{i / 1000.0});
+
+    EXPECT_EQ(Seconds{0.001}, timing.percentile(0.1));
+    EXPECT_EQ(Seconds{0.050}, timing.percentile(50));
+    EXPECT_EQ(Seconds{0.090}, timing.percentile(90));
+    EXPECT_EQ(Seconds{0.099}, timing.percentile(99));
+    EXPECT_EQ(Seconds{0.100}, timing.percentile(99.9));
+    EXPECT_EQ(Seconds{0.100}, timing.percentile(100));
+
+    EXPECT_THROW(timing.percentile(0), std::logic_error);
+    EXPECT_THROW(timing.percentile(100.1), std::logic_error);
+}
+
 // This test relies on real world benchmarking data from previous runs to
 // ensure that the performance of the system does not degrade. For that, we work
 // under the hypothesis that a change will not result in any significant change in
@@ -410,3 +486,137 @@ TEST_F(BenchmarkScopeFixture, benchmarking_a_scope_action_performance_works)
                      reference.first.count(),
                      reference.second.count()));
 }
+
+namespace
+{
+void expect_consistent_percentiles(const unity::scopes::testing::Benchmark::Result::Timing& timing)
+{
+    EXPECT_LE(timing.min, timing.percentile(50));
+    EXPECT_LE(timing.percentile(50), timing.percentile(90));
+    EXPECT_LE(timing.percentile(90), timing.percentile(99));
+    EXPECT_LE(timing.percentile(99), timing.percentile(99.9));
+    EXPECT_LE(timing.percentile(99.9), timing.max);
+}
+
+unity::scopes::testing::Benchmark::LoadConfiguration load_configuration(const std::string& query_string)
+{
+    unity::scopes::CannedQuery query{scope_id};
+    query.set_query_string(query_string);
+
+    unity::scopes::SearchMetadata meta_data{default_locale, default_form_factor};
+
+    unity::scopes::testing::Benchmark::LoadConfiguration config;
+    config.sampler = [query, meta_data]()
+    {
+        return std::make_pair(query, meta_data);
+    };
+    return config;
+}
+}
+
+TEST_F(BenchmarkScopeFixture, benchmarking_a_scope_query_load_closed_loop_works)
+{
+    unity::scopes::testing::InProcessBenchmark benchmark;
+
+    auto config = load_configuration(scope_query_string);
+    config.mode = unity::scopes::testing::Benchmark::LoadConfiguration::Mode::closed_loop;
+    config.concurrency = 4;
+    config.trial_configuration.trial_count = 20;
+
+    auto result = benchmark.for_query_load(scope, config);
+
+    EXPECT_EQ(20u, result.finished.sample_size);
+    EXPECT_EQ(20u, result.finished.timing.sample.size());
+    EXPECT_EQ(0u, result.timeouts);
+    expect_consistent_percentiles(result.finished.timing);
+
+    // The scope takes mean seconds per query, and four queries run at a time.
+    double const mean_seconds = std::chrono::duration<double>(mean).count();
+    EXPECT_GT(result.queries_per_second, 2 / mean_seconds);
+    EXPECT_LT(result.queries_per_second, 4 / (mean_seconds / 2));
+
+    // This query does not push any results.
+    EXPECT_TRUE(result.first_result.timing.sample.empty());
+    EXPECT_EQ(0, result.results_per_second);
+}
+
+TEST_F(BenchmarkScopeFixture, benchmarking_a_scope_query_load_with_results_works)
+{
+    unity::scopes::testing::InProcessBenchmark benchmark;
+
+    auto config = load_configuration(testing::pushing_query_string);
+    config.mode = unity::scopes::testing::Benchmark::LoadConfiguration::Mode::closed_loop;
+    config.concurrency = 4;
+    config.trial_configuration.trial_count = 20;
+
+    auto result = benchmark.for_query_load(scope, config);
+
+    EXPECT_EQ(0u, result.timeouts);
+    ASSERT_EQ(20u, result.first_result.timing.sample.size());
+    EXPECT_EQ(20u, result.first_result.sample_size);
+    expect_consistent_percentiles(result.first_result.timing);
+
+    // The scope pushes its results first, and then takes mean seconds to finish.
+    EXPECT_LT(result.first_result.timing.percentile(50), result.finished.timing.percentile(50));
+    EXPECT_LT(result.first_result.timing.max, std::chrono::duration<double>(mean) / 2);
+
+    EXPECT_DOUBLE_EQ(testing::results_per_query * result.queries_per_second, result.results_per_second);
+}
+
+TEST_F(BenchmarkScopeFixture, benchmarking_a_scope_query_load_open_loop_works)
+{
+    unity::scopes::testing::InProcessBenchmark benchmark;
+
+    auto config = load_configuration(scope_query_string);
+    config.mode = unity::scopes::testing::Benchmark::LoadConfiguration::Mode::open_loop;
+    config.target_qps = 50;
+    config.concurrency = 8;
+    config.trial_configuration.trial_count = 20;
+
+    auto result = benchmark.for_query_load(scope, config);
+
+    EXPECT_EQ(20u, result.finished.timing.sample.size());
+    EXPECT_EQ(0u, result.timeouts);
+    expect_consistent_percentiles(result.finished.timing);
+    EXPECT_GT(result.finished.timing.percentile(50), std::chrono::duration<double>(mean) / 2);
+}
+
+TEST_F(BenchmarkScopeFixture, benchmarking_a_scope_query_load_open_loop_counts_delayed_start)
+{
+    unity::scopes::testing::InProcessBenchmark benchmark;
+
+    // Queries are due every 10 ms, but a single worker needs about 100 ms per query,
+    // so each query starts later than the one before, and its latency includes the delay.
+    auto config = load_configuration(scope_query_string);
+    config.mode = unity::scopes::testing::Benchmark::LoadConfiguration::Mode::open_loop;
+    config.target_qps = 100;
+    config.concurrency = 1;
+    config.trial_configuration.trial_count = 10;
+
+    auto result = benchmark.for_query_load(scope, config);
+
+    ASSERT_EQ(10u, result.finished.timing.sample.size());
+    EXPECT_GT(result.finished.timing.sample.back(), result.finished.timing.sample.front() * 4);
+    EXPECT_GT(result.finished.timing.max, std::chrono::duration<double>(mean) * 5);
+}
+
+TEST_F(BenchmarkScopeFixture, benchmarking_a_scope_query_load_rejects_bad_configuration)
+{
+    unity::scopes::testing::InProcessBenchmark benchmark;
+
+    unity::scopes::testing::Benchmark::LoadConfiguration config;
+    EXPECT_THROW(benchmark.for_query_load(scope, config), std::logic_error);
+
+    config.sampler = []()
+    {
+        return std::make_pair(unity::scopes::CannedQuery{scope_id},
+                              unity::scopes::SearchMetadata{default_locale, default_form_factor});
+    };
+    config.concurrency = 0;
+    EXPECT_THROW(benchmark.for_query_load(scope, config), std::logic_error);
+
+    config.concurrency = 1;
+    config.mode = unity::scopes::testing::Benchmark::LoadConfiguration::Mode::open_loop;
+    config.target_qps = 0;
+    EXPECT_THROW(benchmark.for_query_load(scope, config), std::logic_error);
+}
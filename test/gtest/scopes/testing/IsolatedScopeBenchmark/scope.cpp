@@ -28,11 +28,15 @@
 
 #include "scope.h"
 
+#include <mutex>
 #include <thread>
 
 namespace testing
 {
 
+// Queries may run concurrently (see Benchmark::for_query_load()), but the generator is shared.
+static std::mutex gen_mutex;
+
 struct ActivationShowingDash : public unity::scopes::ActivationQueryBase
 {
     std::mt19937& gen;
@@ -106,13 +110,27 @@ struct Query : public unity::scopes::SearchQueryBase
     {
     }
 
-    void run(unity::scopes::SearchReplyProxy const&) override
+    void run(unity::scopes::SearchReplyProxy const& reply) override
     {
-        std::this_thread::sleep_for(
-                    std::chrono::milliseconds
-                    {
-                        static_cast<std::chrono::milliseconds::rep>(normal(gen))
-                    });
+        if (query().query_string() == pushing_query_string)
+        {
+            auto category = reply->register_category("cat", "Category", "");
+            for (int i = 0; i < results_per_query; i++)
+            {
+                unity::scopes::CategorisedResult result{category};
+                result.set_uri("uri" + std::to_string(i));
+                result.set_dnd_uri("dnd_uri" + std::to_string(i));
+                result.set_title("title" + std::to_string(i));
+                reply->push(result);
+            }
+        }
+
+        std::chrono::milliseconds::rep delay;
+        {
+            std::lock_guard<std::mutex> lg(gen_mutex);
+            delay = static_cast<std::chrono::milliseconds::rep>(normal(gen));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds{delay});
     }
 };
 
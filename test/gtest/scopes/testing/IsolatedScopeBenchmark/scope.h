@@ -21,10 +21,16 @@
 
 #include <chrono>
 #include <random>
+#include <string>
 
 namespace testing
 {
 
+// Queries with this query string push results_per_query results before they sleep.
+// Other queries push no results.
+static const std::string pushing_query_string{"push.results"};
+static constexpr int results_per_query{3};
+
 class Scope : public unity::scopes::ScopeBase
 {
 public:
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: agent <agent@local>
+ */
+
+// Dumps the metrics of scopes and clients (and the registry) that serve them on
+// the metrics endpoint (ipc://<endpoint dir>/<id>-m, see Metrics.Endpoint in CONFIGFILES).
+//
+// Usage: scopes-metrics [-d endpoint_dir] [-t timeout_ms] [id...]
+//
+// Without an id, the metrics of every endpoint in the endpoint directory are shown.
+
+#include <zmqpp/context.hpp>
+#include <zmqpp/poller.hpp>
+#include <zmqpp/socket.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <string.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace
+{
+
+char const* metrics_suffix = "-m";
+
+void print_usage()
+{
+    cerr << "usage: scopes-metrics [-d endpoint_dir] [-t timeout_ms] [id...]" << endl;
+    exit(2);
+}
+
+bool ends_with(string const& s, string const& suffix)
+{
+    return s.size() > suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Returns the ids of all metrics endpoints in dir, sorted.
+
+vector<string> find_ids(string const& dir)
+{
+    vector<string> ids;
+    DIR* d = opendir(dir.c_str());
+    if (!d)
+    {
+        cerr << "scopes-metrics: cannot open " << dir << ": " << strerror(errno) << endl;
+        exit(1);
+    }
+    while (struct dirent* entry = readdir(d))
+    {
+        string name = entry->d_name;
+        struct stat st;
+        if (ends_with(name, metrics_suffix)
+            && stat((dir + "/" + name).c_str(), &st) == 0
+            && S_ISSOCK(st.st_mode))
+        {
+            ids.push_back(name.substr(0, name.size() - strlen(metrics_suffix)));
+        }
+    }
+    closedir(d);
+    sort(ids.begin(), ids.end());
+    return ids;
+}
+
+// Returns false if the endpoint doesn't respond in time. (The endpoint
+// may be left over from a process that did not shut down cleanly.)
+
+bool dump(zmqpp::context& context, string const& endpoint, int timeout, string& metrics)
+{
+    zmqpp::socket s(context, zmqpp::socket_type::request);
+    s.set(zmqpp::socket_option::linger, 0);
+    s.connect(endpoint);
+    s.send("");
+
+    zmqpp::poller p;
+    p.add(s);
+    p.poll(timeout);
+    if (!p.has_input(s))
+    {
+        return false;
+    }
+    s.receive(metrics);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    string dir;
+    int timeout = 1000;
+    vector<string> ids;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "-d" || arg == "-t")
+        {
+            if (++i == argc)
+            {
+                print_usage();
+            }
+            if (arg == "-d")
+            {
+                dir = argv[i];
+            }
+            else
+            {
+                timeout = atoi(argv[i]);
+                if (timeout <= 0)
+                {
+                    print_usage();
+                }
+            }
+        }
+        else if (!arg.empty() && arg[0] == '-')
+        {
+            print_usage();
+        }
+        else
+        {
+            ids.push_back(arg);
+        }
+    }
+
+    if (dir.empty())
+    {
+        char const* xdg_runtime_dir = getenv("XDG_RUNTIME_DIR");
+        if (!xdg_runtime_dir || *xdg_runtime_dir == '\0')
+        {
+            cerr << "scopes-metrics: XDG_RUNTIME_DIR is not set, use -d to specify the endpoint directory" << endl;
+            return 1;
+        }
+        dir = string(xdg_runtime_dir) + "/zmq";
+    }
+    if (ids.empty())
+    {
+        ids = find_ids(dir);
+    }
+
+    int rc = 0;
+    try
+    {
+        zmqpp::context context;
+        for (auto const& id : ids)
+        {
+            string metrics;
+            if (dump(context, "ipc://" + dir + "/" + id + metrics_suffix, timeout, metrics))
+            {
+                cout << "== " << id << endl << metrics;
+            }
+            else
+            {
+                cerr << "scopes-metrics: " << id << ": no response" << endl;
+                rc = 1;
+            }
+        }
+    }
+    catch (std::exception const& e)
+    {
+        cerr << "scopes-metrics: " << e.what() << endl;
+        rc = 1;
+    }
+    return rc;
+}